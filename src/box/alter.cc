@@ -127,6 +127,11 @@ index_def_check_sequence(struct index_def *index_def, const char *space_name)
 			  space_name, "sequence cannot be used with "
 			  "a non-integer key");
 	}
+	if (index_def->key_def->parts[0].path != NULL) {
+		tnt_raise(ClientError, ER_MODIFY_INDEX, index_def->name,
+			  space_name, "sequence cannot be used with "
+			  "a JSON path key");
+	}
 }
 
 /**
@@ -1804,6 +1809,11 @@ on_replace_dd_space(struct trigger * /* trigger */, void *event)
 				  space_name(old_space),
 				  "can not convert a space to "
 				  "a view and vice versa");
+		if (def->opts.defer_deletes !=
+		    old_space->def->opts.defer_deletes)
+			tnt_raise(ClientError, ER_ALTER_SPACE,
+				  space_name(old_space),
+				  "can not change defer_deletes flag");
 		/*
 		 * Allow change of space properties, but do it
 		 * in WAL-error-safe mode.
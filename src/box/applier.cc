@@ -39,6 +39,7 @@
 #include "coio_buf.h"
 #include "xstream.h"
 #include "wal.h"
+#include "txn.h"
 #include "xrow.h"
 #include "replication.h"
 #include "iproto_constants.h"
@@ -358,6 +359,191 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/** A row of a transaction received from the master. */
+struct applier_tx_row {
+	/** Link in the list of transaction rows. */
+	struct stailq_entry next;
+	/** The row itself. */
+	struct xrow_header row;
+};
+
+/**
+ * Read the next row from the master and update the applier
+ * lag. Raise an exception on error.
+ */
+static void
+applier_read_row(struct applier *applier, struct xrow_header *row)
+{
+	struct ev_io *coio = &applier->io;
+	struct ibuf *ibuf = &applier->ibuf;
+	/*
+	 * Tarantool < 1.7.7 does not send periodic heartbeat
+	 * messages so we can't assume that if we haven't heard
+	 * from the master for quite a while the connection is
+	 * broken - the master might just be idle.
+	 */
+	if (applier->version_id < version_id(1, 7, 7)) {
+		coio_read_xrow(coio, ibuf, row);
+	} else {
+		double timeout = replication_disconnect_timeout();
+		coio_read_xrow_timeout_xc(coio, ibuf, row, timeout);
+	}
+
+	if (iproto_type_is_error(row->type))
+		xrow_decode_error_xc(row);  /* error */
+	/* Replication request. */
+	if (row->replica_id == REPLICA_ID_NIL ||
+	    row->replica_id >= VCLOCK_MAX) {
+		/*
+		 * A safety net, this can only occur
+		 * if we're fed a strangely broken xlog.
+		 */
+		tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
+			  int2str(row->replica_id),
+			  tt_uuid_str(&REPLICASET_UUID));
+	}
+
+	applier->lag = ev_now(loop()) - row->tm;
+	applier->last_row_time = ev_monotonic_now(loop());
+}
+
+/**
+ * Read all rows of the next transaction from the master to
+ * the list of struct applier_tx_row allocated on the fiber
+ * region. Masters which don't send transaction boundaries
+ * are handled as if every row were a transaction of its own.
+ */
+static void
+applier_read_tx(struct applier *applier, struct stailq *rows)
+{
+	struct region *region = &fiber()->gc;
+	int64_t tsn = 0;
+	stailq_create(rows);
+	while (true) {
+		struct applier_tx_row *tx_row =
+			region_alloc_object(region, struct applier_tx_row);
+		if (tx_row == NULL)
+			tnt_raise(OutOfMemory, sizeof(*tx_row),
+				  "region", "struct applier_tx_row");
+		struct xrow_header *row = &tx_row->row;
+		applier_read_row(applier, row);
+		if (row->lsn == 0 && !stailq_empty(rows)) {
+			/*
+			 * A heartbeat sent by the master while
+			 * it was sending the transaction.
+			 */
+			continue;
+		}
+		if (stailq_empty(rows)) {
+			tsn = row->tsn;
+		} else if (row->tsn != tsn) {
+			tnt_raise(ClientError, ER_PROTOCOL,
+				  "Transaction id must be equal to "
+				  "LSN of the first row in the transaction.");
+		}
+		stailq_add_tail_entry(rows, tx_row, next);
+		if (row->is_commit)
+			break;
+		/*
+		 * The row body points into the input buffer,
+		 * which may be relocated when the next row of
+		 * the transaction is read, so copy it.
+		 */
+		if (row->bodycnt != 0) {
+			assert(row->bodycnt == 1);
+			size_t size = row->body[0].iov_len;
+			void *body = region_alloc(region, size);
+			if (body == NULL)
+				tnt_raise(OutOfMemory, size, "region",
+					  "xrow body");
+			memcpy(body, row->body[0].iov_base, size);
+			row->body[0].iov_base = body;
+		}
+	}
+}
+
+/**
+ * Apply a row within the current transaction, if any.
+ * Silently skip ER_TUPLE_FOUND error if such option is set
+ * in config.
+ */
+static int
+applier_apply_row(struct applier *applier, struct xrow_header *row)
+{
+	if (xstream_write(applier->subscribe_stream, row) == 0)
+		return 0;
+	struct error *e = diag_last_error(diag_get());
+	if (e->type == &type_ClientError &&
+	    box_error_code(e) == ER_TUPLE_FOUND &&
+	    replication_skip_conflict) {
+		diag_clear(diag_get());
+		return 0;
+	}
+	return -1;
+}
+
+/**
+ * Apply all rows of a transaction received from the master
+ * as a single local transaction, so that it is written to
+ * WAL at once.
+ */
+static int
+applier_apply_tx(struct applier *applier, struct stailq *rows)
+{
+	struct xrow_header *first_row =
+		&stailq_first_entry(rows, struct applier_tx_row, next)->row;
+	struct xrow_header *last_row =
+		&stailq_last_entry(rows, struct applier_tx_row, next)->row;
+	if (vclock_get(&replicaset.vclock, first_row->replica_id) >=
+	    first_row->lsn)
+		return 0;
+	/**
+	 * Promote the replica set vclock before
+	 * applying the transaction. If there is an
+	 * exception (conflict) applying it, the
+	 * transaction is skipped when the replication
+	 * is resumed.
+	 */
+	vclock_follow(&replicaset.vclock, last_row->replica_id,
+		      last_row->lsn);
+	struct replica *replica = replica_by_id(first_row->replica_id);
+	struct latch *latch = (replica ? &replica->order_latch :
+			       &replicaset.applier.order_latch);
+	/*
+	 * In a full mesh topology, the same set
+	 * of changes may arrive via two
+	 * concurrently running appliers. Thanks
+	 * to vclock_follow() above, the first row
+	 * in the set will be skipped - but the
+	 * remaining may execute out of order,
+	 * when the following xstream_write()
+	 * yields on WAL. Hence we need a latch to
+	 * strictly order all changes which belong
+	 * to the same server id.
+	 */
+	latch_lock(latch);
+	int rc;
+	if (first_row == last_row) {
+		/* Single-statement transaction, autocommit. */
+		rc = applier_apply_row(applier, first_row);
+	} else {
+		struct txn *txn = txn_begin(false);
+		rc = txn != NULL ? 0 : -1;
+		struct applier_tx_row *item;
+		stailq_foreach_entry(item, rows, next) {
+			if (rc != 0)
+				break;
+			rc = applier_apply_row(applier, &item->row);
+		}
+		if (rc == 0)
+			rc = txn_commit(txn);
+		else if (txn != NULL)
+			txn_rollback();
+	}
+	latch_unlock(latch);
+	return rc;
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -441,7 +627,7 @@ applier_subscribe(struct applier *applier)
 	applier->lag = TIMEOUT_INFINITY;
 
 	/*
-	 * Process a stream of rows from the binary log.
+	 * Process a stream of transactions from the binary log.
 	 */
 	while (true) {
 		if (applier->state == APPLIER_FINAL_JOIN &&
@@ -465,78 +651,10 @@ applier_subscribe(struct applier *applier)
 			applier_set_state(applier, APPLIER_FOLLOW);
 		}
 
-		/*
-		 * Tarantool < 1.7.7 does not send periodic heartbeat
-		 * messages so we can't assume that if we haven't heard
-		 * from the master for quite a while the connection is
-		 * broken - the master might just be idle.
-		 */
-		if (applier->version_id < version_id(1, 7, 7)) {
-			coio_read_xrow(coio, ibuf, &row);
-		} else {
-			double timeout = replication_disconnect_timeout();
-			coio_read_xrow_timeout_xc(coio, ibuf, &row, timeout);
-		}
-
-		if (iproto_type_is_error(row.type))
-			xrow_decode_error_xc(&row);  /* error */
-		/* Replication request. */
-		if (row.replica_id == REPLICA_ID_NIL ||
-		    row.replica_id >= VCLOCK_MAX) {
-			/*
-			 * A safety net, this can only occur
-			 * if we're fed a strangely broken xlog.
-			 */
-			tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
-				  int2str(row.replica_id),
-				  tt_uuid_str(&REPLICASET_UUID));
-		}
-
-		applier->lag = ev_now(loop()) - row.tm;
-		applier->last_row_time = ev_monotonic_now(loop());
-
-		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn) {
-			/**
-			 * Promote the replica set vclock before
-			 * applying the row. If there is an
-			 * exception (conflict) applying the row,
-			 * the row is skipped when the replication
-			 * is resumed.
-			 */
-			vclock_follow(&replicaset.vclock, row.replica_id,
-				      row.lsn);
-			struct replica *replica = replica_by_id(row.replica_id);
-			struct latch *latch = (replica ? &replica->order_latch :
-					       &replicaset.applier.order_latch);
-			/*
-			 * In a full mesh topology, the same set
-			 * of changes may arrive via two
-			 * concurrently running appliers. Thanks
-			 * to vclock_follow() above, the first row
-			 * in the set will be skipped - but the
-			 * remaining may execute out of order,
-			 * when the following xstream_write()
-			 * yields on WAL. Hence we need a latch to
-			 * strictly order all changes which belong
-			 * to the same server id.
-			 */
-			latch_lock(latch);
-			int res = xstream_write(applier->subscribe_stream, &row);
-			latch_unlock(latch);
-			if (res != 0) {
-				struct error *e = diag_last_error(diag_get());
-				/**
-				 * Silently skip ER_TUPLE_FOUND error if such
-				 * option is set in config.
-				 */
-				if (e->type == &type_ClientError &&
-				    box_error_code(e) == ER_TUPLE_FOUND &&
-				    replication_skip_conflict)
-					diag_clear(diag_get());
-				else
-					diag_raise();
-			}
-		}
+		struct stailq rows;
+		applier_read_tx(applier, &rows);
+		if (applier_apply_tx(applier, &rows) != 0)
+			diag_raise();
 		if (applier->state == APPLIER_SYNC ||
 		    applier->state == APPLIER_FOLLOW)
 			fiber_cond_signal(&applier->writer_cond);
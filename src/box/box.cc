@@ -50,6 +50,7 @@
 #include "schema.h"
 #include "engine.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
 #include "sysview.h"
 #include "vinyl.h"
 #include "space.h"
@@ -543,6 +544,23 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static void
+box_check_wal_group_commit(void)
+{
+	if (cfg_getd("wal_group_commit_delay") < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_delay",
+			  "the value must not be less than 0");
+	}
+	if (cfg_geti64("wal_group_commit_max_rows") < 1) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_max_rows",
+			  "the value must not be less than one");
+	}
+	if (cfg_geti64("wal_group_commit_max_size") < 1) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_max_size",
+			  "the value must not be less than one");
+	}
+}
+
 static int64_t
 box_check_memtx_memory(int64_t memory)
 {
@@ -563,6 +581,38 @@ box_check_vinyl_memory(int64_t memory)
 	return memory;
 }
 
+static int
+box_check_vinyl_max_subcompactions(int max_subcompactions)
+{
+	if (max_subcompactions < 1) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_max_subcompactions",
+			  "must be greater than or equal to 1");
+	}
+	return max_subcompactions;
+}
+
+static int
+box_check_memtx_sort_threads(int threads)
+{
+	if (threads < 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_sort_threads",
+			  "must be greater than or equal to 0");
+	}
+	return threads;
+}
+
+static int
+box_check_iproto_threads(int threads)
+{
+	if (threads < 1 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("must be greater than or equal to 1 "
+				     "and less than or equal to %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -575,6 +625,8 @@ box_check_vinyl_options(void)
 	double bloom_fpr = cfg_getd("vinyl_bloom_fpr");
 
 	box_check_vinyl_memory(cfg_geti64("vinyl_memory"));
+	box_check_vinyl_max_subcompactions(
+		cfg_geti("vinyl_max_subcompactions"));
 
 	if (read_threads < 1) {
 		tnt_raise(ClientError, ER_CFG, "vinyl_read_threads",
@@ -613,6 +665,7 @@ box_check_config()
 	struct tt_uuid uuid;
 	box_check_say();
 	box_check_uri(cfg_gets("listen"), "listen");
+	box_check_iproto_threads(cfg_geti("iproto_threads"));
 	box_check_instance_uuid(&uuid);
 	box_check_replicaset_uuid(&uuid);
 	box_check_replication();
@@ -625,8 +678,10 @@ box_check_config()
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_group_commit();
 	box_check_memtx_memory(cfg_geti64("memtx_memory"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_sort_threads(cfg_geti("memtx_sort_threads"));
 	box_check_vinyl_options();
 }
 
@@ -794,6 +849,16 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_sort_threads(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_sort_threads(memtx,
+		box_check_memtx_sort_threads(cfg_geti("memtx_sort_threads")));
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -850,6 +915,26 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, cfg_geti64("vinyl_page_cache"));
+}
+
+void
+box_set_vinyl_max_subcompactions(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_max_subcompactions(vinyl,
+		box_check_vinyl_max_subcompactions(
+			cfg_geti("vinyl_max_subcompactions")));
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -859,13 +944,23 @@ box_set_vinyl_timeout(void)
 	vinyl_engine_set_timeout(vinyl,	cfg_getd("vinyl_timeout"));
 }
 
+void
+box_set_wal_group_commit(void)
+{
+	box_check_wal_group_commit();
+	wal_set_group_commit(cfg_getd("wal_group_commit_delay"),
+			     cfg_geti64("wal_group_commit_max_rows"),
+			     cfg_geti64("wal_group_commit_max_size"));
+}
+
 void
 box_set_net_msg_max(void)
 {
 	int new_iproto_msg_max = cfg_geti("net_msg_max");
 	iproto_set_msg_max(new_iproto_msg_max);
+	/* The limit applies to each network thread. */
 	fiber_pool_set_max_size(&tx_fiber_pool,
-				new_iproto_msg_max *
+				new_iproto_msg_max * iproto_threads_count *
 				IPROTO_FIBER_POOL_SIZE_FACTOR);
 }
 
@@ -1047,8 +1142,8 @@ box_select(uint32_t space_id, uint32_t index_id,
 	if (txn_begin_ro_stmt(space, &txn) != 0)
 		return -1;
 
-	struct iterator *it = index_create_iterator(index, type,
-						    key, part_count);
+	struct iterator *it = index_create_iterator_with_offset(index, type,
+						key, part_count, offset);
 	if (it == NULL) {
 		txn_rollback_stmt();
 		return -1;
@@ -1062,10 +1157,6 @@ box_select(uint32_t space_id, uint32_t index_id,
 		rc = iterator_next(it, &tuple);
 		if (rc != 0 || tuple == NULL)
 			break;
-		if (offset > 0) {
-			offset--;
-			continue;
-		}
 		rc = port_tuple_add(port, tuple);
 		if (rc != 0)
 			break;
@@ -1655,6 +1746,7 @@ engine_init()
 	 * so it must be registered first.
 	 */
 	struct memtx_engine *memtx;
+	memtx_tx_manager_use_mvcc_engine = cfg_getb("memtx_use_mvcc_engine");
 	memtx = memtx_engine_new_xc(cfg_gets("memtx_dir"),
 				    cfg_geti("force_recovery"),
 				    cfg_getd("memtx_memory"),
@@ -1662,6 +1754,7 @@ engine_init()
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_sort_threads();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -1675,6 +1768,8 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
+	box_set_vinyl_max_subcompactions();
 	box_set_vinyl_timeout();
 }
 
@@ -1990,7 +2085,7 @@ box_cfg_xc(void)
 	schema_init();
 	replication_init();
 	port_init();
-	iproto_init();
+	iproto_init(box_check_iproto_threads(cfg_geti("iproto_threads")));
 	sql_init();
 	wal_thread_start();
 
@@ -2059,6 +2154,7 @@ box_cfg_xc(void)
 		      &replicaset.vclock, wal_max_rows, wal_max_size)) {
 		diag_raise();
 	}
+	box_set_wal_group_commit();
 
 	rmean_cleanup(rmean_box);
 
@@ -115,7 +115,6 @@ box_c_call(struct func *func, struct call_request *request, struct port *port)
 
 	/* Clear all previous errors */
 	diag_clear(&fiber()->diag);
-	assert(!in_txn()); /* transaction is not started */
 
 	/* Call function from the shared library */
 	int rc = func_call(func, &ctx, request->args, request->args_end);
@@ -163,6 +162,11 @@ box_process_call(struct call_request *request, struct port *port)
 	assert(name != NULL);
 	uint32_t name_len = mp_decode_strl(&name);
 
+	/*
+	 * A request of an iproto stream may be executed in
+	 * an open transaction, which must survive the call.
+	 */
+	struct txn *txn = in_txn();
 	struct func *func = NULL;
 	/**
 	 * Sic: func == NULL means that perhaps the user has a global
@@ -208,11 +212,12 @@ box_process_call(struct call_request *request, struct port *port)
 		fiber_set_user(fiber(), orig_credentials);
 
 	if (rc != 0) {
-		txn_rollback();
+		if (txn == NULL)
+			txn_rollback();
 		return -1;
 	}
 
-	if (in_txn()) {
+	if (txn == NULL && in_txn()) {
 		diag_set(ClientError, ER_FUNCTION_TX_ACTIVE);
 		txn_rollback();
 		return -1;
@@ -228,12 +233,15 @@ box_process_eval(struct call_request *request, struct port *port)
 	/* Check permissions */
 	if (access_check_universe(PRIV_X) != 0)
 		return -1;
+	/* See the comment in box_process_call(). */
+	struct txn *txn = in_txn();
 	if (box_lua_eval(request, port) != 0) {
-		txn_rollback();
+		if (txn == NULL)
+			txn_rollback();
 		return -1;
 	}
 
-	if (in_txn()) {
+	if (txn == NULL && in_txn()) {
 		diag_set(ClientError, ER_FUNCTION_TX_ACTIVE);
 		txn_rollback();
 		return -1;
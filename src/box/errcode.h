@@ -219,6 +219,10 @@ struct errcode_record {
 	/*164 */_(ER_NO_SUCH_GROUP,		"Replication group '%s' does not exist") \
 	/*165 */_(ER_NO_SUCH_MODULE,		"Module '%s' does not exist") \
 	/*166 */_(ER_NO_SUCH_COLLATION,		"Collation '%s' does not exist") \
+	/*167 */_(ER_UNABLE_PROCESS_OUT_OF_STREAM, "Unable to process %s request out of stream") \
+	/*168 */_(ER_INDEX_PATH_ROOT_TYPE,	"Field %s indexed by a JSON path must be a map or an array, but has type '%s'") \
+	/*169 */_(ER_FIELD_PATH_TYPE,		"Tuple field %s type does not match one required by operation: expected %s") \
+	/*170 */_(ER_FIELD_PATH_MISSING,	"Tuple field %s required by an index is missing") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
@@ -258,6 +258,57 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	return 0;
 }
 
+int
+box_index_get_multi(uint32_t space_id, uint32_t index_id, const char *keys,
+		    const char *keys_end, box_tuple_t **result)
+{
+	assert(keys != NULL && keys_end != NULL && result != NULL);
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	if (!index->def->opts.is_unique) {
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t key_count = mp_decode_array(&keys);
+	const char **key_parts = (const char **)
+		region_alloc(region, key_count * sizeof(*key_parts));
+	if (key_parts == NULL) {
+		diag_set(OutOfMemory, key_count * sizeof(*key_parts),
+			 "region", "keys");
+		return -1;
+	}
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key = keys;
+		mp_next(&keys);
+		mp_tuple_assert(key, keys);
+		uint32_t part_count = mp_decode_array(&key);
+		if (exact_key_validate(index->def->key_def, key, part_count))
+			goto fail;
+		key_parts[i] = key;
+	}
+	assert(keys == keys_end);
+	/* Start transaction in the engine. */
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		goto fail;
+	if (index_get_multi(index, key_parts, key_count, result) != 0) {
+		txn_rollback_stmt();
+		goto fail;
+	}
+	txn_commit_ro_stmt(txn);
+	region_truncate(region, region_svp);
+	/* Count statistics. */
+	rmean_collect(rmean_box, IPROTO_SELECT, key_count);
+	return 0;
+fail:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
 int
 box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 	      const char *key_end, box_tuple_t **result)
@@ -547,8 +598,7 @@ index_build(struct index *index, struct index *pk)
 	if (rc != 0)
 		return -1;
 
-	index_end_build(index);
-	return 0;
+	return index_end_build(index);
 }
 
 /* }}} */
@@ -670,6 +720,25 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_multi(struct index *index, const char **keys,
+			uint32_t key_count, struct tuple **result)
+{
+	uint32_t part_count = index->def->key_def->part_count;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (index_get(index, keys[i], part_count, &result[i]) != 0) {
+			for (uint32_t j = 0; j < i; j++) {
+				if (result[j] != NULL)
+					tuple_unref(result[j]);
+			}
+			return -1;
+		}
+		if (result[i] != NULL)
+			tuple_ref(result[i]);
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -683,6 +752,28 @@ generic_index_replace(struct index *index, struct tuple *old_tuple,
 	return -1;
 }
 
+struct iterator *
+generic_index_create_iterator_with_offset(struct index *index,
+					  enum iterator_type type,
+					  const char *key, uint32_t part_count,
+					  uint32_t offset)
+{
+	struct iterator *it = index_create_iterator(index, type,
+						    key, part_count);
+	if (it == NULL)
+		return NULL;
+	struct tuple *tuple;
+	for (; offset > 0; offset--) {
+		if (iterator_next(it, &tuple) != 0) {
+			iterator_delete(it);
+			return NULL;
+		}
+		if (tuple == NULL)
+			break;
+	}
+	return it;
+}
+
 struct snapshot_iterator *
 generic_index_create_snapshot_iterator(struct index *index)
 {
@@ -728,9 +819,10 @@ generic_index_build_next(struct index *index, struct tuple *tuple)
 	return index_replace(index, NULL, tuple, DUP_INSERT, &unused);
 }
 
-void
+int
 generic_index_end_build(struct index *)
 {
+	return 0;
 }
 
 /* }}} */
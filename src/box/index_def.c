@@ -298,8 +298,12 @@ index_def_is_valid(struct index_def *index_def, const char *space_name)
 			 * Courtesy to a user who could have made
 			 * a typo.
 			 */
-			if (index_def->key_def->parts[i].fieldno ==
-			    index_def->key_def->parts[j].fieldno) {
+			const struct key_part *part_i =
+				&index_def->key_def->parts[i];
+			const struct key_part *part_j =
+				&index_def->key_def->parts[j];
+			if (part_i->fieldno == part_j->fieldno &&
+			    key_part_path_cmp(part_i, part_j) == 0) {
 				diag_set(ClientError, ER_MODIFY_INDEX,
 					 index_def->name, space_name,
 					 "same key part is indexed twice");
@@ -52,13 +52,18 @@
 #include "port.h"
 #include "box.h"
 #include "call.h"
+#include "tuple.h"
 #include "tuple_convert.h"
 #include "session.h"
 #include "xrow.h"
 #include "schema.h" /* schema_version */
 #include "replication.h" /* instance_uuid */
 #include "iproto_constants.h"
+#include "txn.h"
+#include "assoc.h"
 #include "rmean.h"
+#include "latency.h"
+#include "info.h"
 #include "execute.h"
 #include "errinj.h"
 
@@ -213,64 +218,218 @@ struct iproto_msg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/** The stream the request belongs to, NULL if none. */
+	struct iproto_stream *stream;
+	/** Link in iproto_stream::pending_requests. */
+	struct stailq_entry in_stream;
+	/** Result set of a SELECT request. */
+	struct port port;
+	/**
+	 * True if the tuples of the SELECT result set are sent
+	 * to the client right from the tuple memory rather than
+	 * copied to the output buffer, see tx_process_select().
+	 * The tuples stay referenced by the port until the
+	 * iproto thread writes them to the socket.
+	 */
+	bool is_zero_copy;
+	/**
+	 * Zero-copy send progress: the next tuple to write and
+	 * the number of its bytes already written.
+	 */
+	struct port_tuple_entry *zero_copy_next;
+	size_t zero_copy_offset;
+	/** Link in iproto_connection::zero_copy_queue. */
+	struct stailq_entry in_zero_copy;
+	/**
+	 * Request type to account the request latency to,
+	 * IPROTO_OK if the request is not accounted.
+	 */
+	uint32_t stat_type;
+	/** Monotonic time the request was read from the socket. */
+	double start_time;
+	/** Monotonic time the tx thread started processing it. */
+	double tx_time;
 };
 
-static struct mempool iproto_msg_pool;
+struct iproto_thread;
+
+/**
+ * A stream of requests of a connection, identified by
+ * IPROTO_STREAM_ID header key. Requests of a stream are
+ * processed one by one in order of arrival. A stream may
+ * have an open transaction which spans multiple requests,
+ * see IPROTO_BEGIN, IPROTO_COMMIT and IPROTO_ROLLBACK.
+ *
+ * A stream is created by the iproto thread on the first
+ * request and is deleted as soon as it has no requests in
+ * progress and no open transaction.
+ */
+struct iproto_stream {
+	/** Stream id, unique within a connection. */
+	uint64_t id;
+	/** The connection the stream belongs to. */
+	struct iproto_connection *connection;
+	/**
+	 * Requests waiting for the request being processed
+	 * by the tx thread to complete, linked by
+	 * iproto_msg::in_stream.
+	 */
+	struct stailq pending_requests;
+	/** True if a request of the stream is in the tx thread. */
+	bool is_busy;
+	/**
+	 * The following fields are used exclusively by the tx
+	 * thread. The iproto thread may only look at them when
+	 * no request of the stream is in the tx thread.
+	 */
+	struct {
+		/**
+		 * Fiber which executes requests of the stream
+		 * while a transaction is open. The transaction
+		 * lives in the fiber. NULL if there is no
+		 * transaction.
+		 */
+		struct fiber *fiber;
+		/** Next request for the stream fiber. */
+		struct iproto_msg *msg;
+		/** Set on disconnect to let the fiber exit. */
+		bool is_closed;
+		/** Link in iproto_connection::tx::streams. */
+		struct rlist in_connection;
+	} tx;
+};
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con);
 
 /**
- * Resume stopped connections, if any.
+ * Resume stopped connections of a network thread, if any.
  */
 static void
-iproto_resume();
+iproto_resume(struct iproto_thread *iproto_thread);
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input);
 
 static inline void
-iproto_msg_delete(struct iproto_msg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
-
-/**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
- */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
+iproto_msg_delete(struct iproto_msg *msg);
 
-/**
- * Network thread.
- */
-static struct cord net_cord;
-
-/**
- * Slab cache used for allocating memory for output network buffers
- * in the tx thread.
- */
-static struct slab_cache net_slabc;
-
-struct rmean *rmean_net;
+enum {
+	/**
+	 * Minimal size of a SELECT result set sent to the client
+	 * bypassing the output buffer.
+	 */
+	IPROTO_ZERO_COPY_MIN_SIZE = 16 * 1024,
+	/**
+	 * Minimal average tuple size in a SELECT result set sent
+	 * bypassing the output buffer.
+	 */
+	IPROTO_ZERO_COPY_MIN_TUPLE_SIZE = 256,
+};
 
 enum rmean_net_name {
 	IPROTO_SENT,
 	IPROTO_RECEIVED,
+	IPROTO_CONNECTIONS,
 	IPROTO_LAST,
 };
 
-const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
+const char *rmean_net_strings[IPROTO_LAST] = {
+	"SENT", "RECEIVED", "CONNECTIONS"
+};
+
+/**
+ * A network thread. Each thread serves its own share of client
+ * connections: it does all socket I/O and request parsing for
+ * them and talks to the tx thread via its own pair of pipes,
+ * so that network-bound throughput scales with the number of
+ * threads. All threads accept connections on the same listening
+ * socket, so a new connection goes to whichever thread gets to
+ * it first, which is usually the least loaded one.
+ */
+struct iproto_thread {
+	/** Thread number, index in iproto_threads array. */
+	int id;
+	/** Network thread. */
+	struct cord net_cord;
+	/**
+	 * A single queue for all requests in all connections of
+	 * the thread. All requests from all connections are
+	 * processed concurrently. Is also used as a queue for
+	 * just established connections and to execute disconnect
+	 * triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect
+	 *   trigger failure must lead to connection close.
+	 * - on_connect trigger must be processed before any
+	 *   other request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	/** A pipe from the tx thread to the network thread. */
+	struct cpipe net_pipe;
+	/**
+	 * Slab cache used for allocating memory for output
+	 * network buffers in the tx thread.
+	 */
+	struct slab_cache net_slabc;
+	/** Memory pools for objects of the thread. */
+	struct mempool iproto_msg_pool;
+	struct mempool iproto_connection_pool;
+	struct mempool iproto_stream_pool;
+	/** Connections stopped due to net_msg_max limit. */
+	struct rlist stopped_connections;
+	/** Network statistics of the thread. */
+	struct rmean *rmean;
+	/**
+	 * Time from reading a request to queuing its reply for
+	 * write, by request type. Written by the network thread
+	 * only, summed over all threads on read.
+	 */
+	struct latency latency[IPROTO_TYPE_STAT_MAX];
+	/**
+	 * Time from the tx thread accepting a request to its
+	 * reply reaching the network thread.
+	 */
+	struct latency tx_latency;
+	/**
+	 * Binary protocol listener. Only the first thread listens
+	 * and accepts connections, see iproto_on_accept().
+	 */
+	struct evio_service binary;
+	/**
+	 * A pipe from the first network thread to this one, used
+	 * to hand accepted connections over.
+	 */
+	struct cpipe accept_pipe;
+	/**
+	 * Number of connections accepted by the first thread,
+	 * used to pick the thread to serve the next one.
+	 */
+	unsigned accept_count;
+	/**
+	 * Message routes. A route has to know the pipe to the
+	 * thread a request came from, so each thread has its
+	 * own copy of them.
+	 */
+	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop push_route[2];
+	struct cmsg_hop connect_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop call_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	struct cmsg_hop join_route[2];
+	struct cmsg_hop subscribe_route[2];
+	struct cmsg_hop error_route[2];
+	struct cmsg_hop zero_copy_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+};
+
+/** Network threads, box.cfg.iproto_threads of them. */
+static struct iproto_thread *iproto_threads;
+int iproto_threads_count;
 
 static void
 tx_process_disconnect(struct cmsg *m);
@@ -278,11 +437,6 @@ tx_process_disconnect(struct cmsg *m);
 static void
 net_finish_disconnect(struct cmsg *m);
 
-static const struct cmsg_hop disconnect_route[] = {
-	{ tx_process_disconnect, &net_pipe },
-	{ net_finish_disconnect, NULL },
-};
-
 /**
  * Kharon is in the dead world (iproto). Schedule an event to
  * flush new obuf as reflected in the fresh wpos.
@@ -300,12 +454,6 @@ iproto_process_push(struct cmsg *m);
 static void
 tx_end_push(struct cmsg *m);
 
-static const struct cmsg_hop push_route[] = {
-	{ iproto_process_push, &tx_pipe },
-	{ tx_end_push, NULL }
-};
-
-
 /* }}} */
 
 /* {{{ iproto_connection - declaration and definition */
@@ -394,11 +542,29 @@ struct iproto_connection
 	 * connections.
 	 */
 	int long_poll_count;
+	/** Streams of the connection, by id. */
+	struct mh_i64ptr_t *streams;
+	/**
+	 * Zero-copy SELECT responses waiting for their tuples
+	 * to be written to the socket, in order of their position
+	 * in the output, linked by iproto_msg::in_zero_copy.
+	 * A response header is stored in the output buffer and
+	 * its tuples are written right after it.
+	 */
+	struct stailq zero_copy_queue;
+	/**
+	 * Number of zero-copy responses which haven't been
+	 * released by the tx thread yet. Such a response
+	 * refers to the connection.
+	 */
+	int zero_copy_count;
 	struct ev_io input;
 	struct ev_io output;
 	/** Logical session. */
 	struct session *session;
 	ev_loop *loop;
+	/** Network thread serving the connection. */
+	struct iproto_thread *iproto_thread;
 	/* Pre-allocated disconnect msg. */
 	struct cmsg disconnect;
 	/** True if disconnect message is sent. Debug-only. */
@@ -450,32 +616,34 @@ struct iproto_connection
 		 * return.
 		 */
 		bool is_push_pending;
+		/**
+		 * Streams having an open transaction, linked by
+		 * iproto_stream::tx::in_connection.
+		 */
+		struct rlist streams;
 	} tx;
 	/** Authentication salt. */
 	char salt[IPROTO_SALT_SIZE];
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
-
 /**
  * Return true if we have not enough spare messages
- * in the message pool.
+ * in the message pool of a network thread.
  */
 static inline bool
-iproto_check_msg_max()
+iproto_check_msg_max(struct iproto_thread *iproto_thread)
 {
-	size_t request_count = mempool_count(&iproto_msg_pool);
+	size_t request_count = mempool_count(&iproto_thread->iproto_msg_pool);
 	return request_count > (size_t) iproto_msg_max;
 }
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc(&iproto_msg_pool);
+	struct mempool *pool = &con->iproto_thread->iproto_msg_pool;
+	struct iproto_msg *msg = (struct iproto_msg *) mempool_alloc(pool);
 	ERROR_INJECT(ERRINJ_TESTING, {
-		mempool_free(&iproto_msg_pool, msg);
+		mempool_free(pool, msg);
 		msg = NULL;
 	});
 	if (msg == NULL) {
@@ -485,9 +653,114 @@ iproto_msg_new(struct iproto_connection *con)
 		return NULL;
 	}
 	msg->connection = con;
+	msg->stream = NULL;
+	msg->is_zero_copy = false;
+	msg->stat_type = IPROTO_OK;
+	msg->start_time = ev_monotonic_now(con->loop);
 	return msg;
 }
 
+static inline void
+iproto_msg_delete(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	iproto_resume(iproto_thread);
+}
+
+/**
+ * Find a stream of a connection by id, create the stream if
+ * it doesn't exist.
+ */
+static struct iproto_stream *
+iproto_connection_stream(struct iproto_connection *con, uint64_t stream_id)
+{
+	struct mh_i64ptr_t *h = con->streams;
+	mh_int_t k = mh_i64ptr_find(h, stream_id, NULL);
+	if (k != mh_end(h))
+		return (struct iproto_stream *) mh_i64ptr_node(h, k)->val;
+
+	struct mempool *pool = &con->iproto_thread->iproto_stream_pool;
+	struct iproto_stream *stream =
+		(struct iproto_stream *) mempool_alloc(pool);
+	if (stream == NULL) {
+		diag_set(OutOfMemory, sizeof(*stream), "mempool_alloc",
+			 "stream");
+		return NULL;
+	}
+	stream->id = stream_id;
+	stream->connection = con;
+	stailq_create(&stream->pending_requests);
+	stream->is_busy = false;
+	stream->tx.fiber = NULL;
+	stream->tx.msg = NULL;
+	stream->tx.is_closed = false;
+	rlist_create(&stream->tx.in_connection);
+
+	struct mh_i64ptr_node_t node = { stream_id, stream };
+	if (mh_i64ptr_put(h, &node, NULL, NULL) == mh_end(h)) {
+		mempool_free(pool, stream);
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "mh_i64ptr_node_t");
+		return NULL;
+	}
+	return stream;
+}
+
+static void
+iproto_stream_delete(struct iproto_stream *stream)
+{
+	struct iproto_connection *con = stream->connection;
+	struct mh_i64ptr_t *h = con->streams;
+	mh_int_t k = mh_i64ptr_find(h, stream->id, NULL);
+	assert(k != mh_end(h));
+	mh_i64ptr_del(h, k, NULL);
+	mempool_free(&con->iproto_thread->iproto_stream_pool, stream);
+}
+
+/**
+ * Send a request to the tx thread. A request of a stream,
+ * which already has a request in progress, is queued until
+ * all previous requests of the stream are processed.
+ */
+static inline void
+iproto_msg_push(struct iproto_msg *msg)
+{
+	struct iproto_stream *stream = msg->stream;
+	if (stream != NULL) {
+		if (stream->is_busy) {
+			stailq_add_tail_entry(&stream->pending_requests,
+					      msg, in_stream);
+			return;
+		}
+		stream->is_busy = true;
+	}
+	cpipe_push_input(&msg->connection->iproto_thread->tx_pipe, &msg->base);
+}
+
+/**
+ * Called when a request of a stream has been processed:
+ * send the next pending request of the stream to tx, or
+ * delete the stream if it is not needed any more.
+ */
+static void
+iproto_stream_next(struct iproto_stream *stream)
+{
+	assert(stream->is_busy);
+	if (!stailq_empty(&stream->pending_requests)) {
+		struct iproto_msg *msg =
+			stailq_shift_entry(&stream->pending_requests,
+					   struct iproto_msg, in_stream);
+		/* Output may have been flushed since it was parsed. */
+		msg->wpos = stream->connection->wpos;
+		cpipe_push(&stream->connection->iproto_thread->tx_pipe,
+			   &msg->base);
+		return;
+	}
+	stream->is_busy = false;
+	if (stream->tx.fiber == NULL)
+		iproto_stream_delete(stream);
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -507,6 +780,7 @@ static inline bool
 iproto_connection_is_idle(struct iproto_connection *con)
 {
 	return con->long_poll_count == 0 &&
+	       con->zero_copy_count == 0 &&
 	       ibuf_used(&con->ibuf[0]) == 0 &&
 	       ibuf_used(&con->ibuf[1]) == 0;
 }
@@ -537,7 +811,20 @@ iproto_connection_stop_msg_max_limit(struct iproto_connection *con)
 	 * Important to add to tail and fetch from head to ensure
 	 * strict lifo order (fairness) for stopped connections.
 	 */
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
+}
+
+/**
+ * Send a zero-copy response back to the tx thread to release
+ * its tuples.
+ */
+static inline void
+iproto_zero_copy_release(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	cmsg_init(&msg->base, iproto_thread->zero_copy_route);
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
 }
 
 /**
@@ -565,6 +852,13 @@ iproto_connection_close(struct iproto_connection *con)
 		 */
 		con->p_ibuf->wpos -= con->parse_size;
 	}
+	/* Tuples of pending zero-copy responses won't be sent. */
+	while (!stailq_empty(&con->zero_copy_queue)) {
+		struct iproto_msg *msg =
+			stailq_shift_entry(&con->zero_copy_queue,
+					   struct iproto_msg, in_zero_copy);
+		iproto_zero_copy_release(msg);
+	}
 	/*
 	 * If the connection has no outstanding requests in the
 	 * input buffer, then no one (e.g. tx thread) is referring
@@ -580,7 +874,7 @@ iproto_connection_close(struct iproto_connection *con)
 	if (iproto_connection_is_idle(con)) {
 		assert(con->is_disconnected == false);
 		con->is_disconnected = true;
-		cpipe_push(&tx_pipe, &con->disconnect);
+		cpipe_push(&con->iproto_thread->tx_pipe, &con->disconnect);
 	}
 	rlist_del(&con->in_stop_list);
 }
@@ -689,13 +983,14 @@ static inline int
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	assert(rlist_empty(&con->in_stop_list));
+	struct iproto_thread *iproto_thread = con->iproto_thread;
 	int n_requests = 0;
 	bool stop_input = false;
 	const char *errmsg;
 	while (con->parse_size != 0 && !stop_input) {
-		if (iproto_check_msg_max()) {
+		if (iproto_check_msg_max(iproto_thread)) {
 			iproto_connection_stop_msg_max_limit(con);
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(&iproto_thread->tx_pipe);
 			return 0;
 		}
 		const char *reqstart = in->wpos - con->parse_size;
@@ -704,7 +999,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		if (mp_typeof(*pos) != MP_UINT) {
 			errmsg = "packet length";
 err_msgpack:
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(&iproto_thread->tx_pipe);
 			diag_set(ClientError, ER_INVALID_MSGPACK,
 				 errmsg);
 			return -1;
@@ -740,7 +1035,7 @@ err_msgpack:
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		iproto_msg_push(msg);
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
@@ -778,7 +1073,7 @@ err_msgpack:
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(&iproto_thread->tx_pipe);
 	return 0;
 }
 
@@ -790,7 +1085,7 @@ err_msgpack:
 static void
 iproto_connection_resume(struct iproto_connection *con)
 {
-	assert(! iproto_check_msg_max());
+	assert(! iproto_check_msg_max(con->iproto_thread));
 	rlist_del(&con->in_stop_list);
 	/*
 	 * Enqueue_batch() stops the connection again, if the
@@ -814,15 +1109,16 @@ iproto_connection_resume(struct iproto_connection *con)
  * necessary to use up the limit.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
-	while (!iproto_check_msg_max() && !rlist_empty(&stopped_connections)) {
+	struct rlist *stopped = &iproto_thread->stopped_connections;
+	while (!iproto_check_msg_max(iproto_thread) && !rlist_empty(stopped)) {
 		/*
 		 * Shift from list head to ensure strict FIFO
 		 * (fairness) for resumed connections.
 		 */
 		struct iproto_connection *con =
-			rlist_first_entry(&stopped_connections,
+			rlist_first_entry(stopped,
 					  struct iproto_connection,
 					  in_stop_list);
 		iproto_connection_resume(con);
@@ -844,7 +1140,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * otherwise we might deplete the fiber pool in tx
 	 * thread and deadlock.
 	 */
-	if (iproto_check_msg_max()) {
+	if (iproto_check_msg_max(con->iproto_thread)) {
 		iproto_connection_stop_msg_max_limit(con);
 		return;
 	}
@@ -867,7 +1163,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -883,6 +1179,46 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
+/**
+ * Write tuples of a zero-copy response to the socket.
+ * Return values are the same as of iproto_flush().
+ */
+static int
+iproto_flush_zero_copy(struct iproto_connection *con, struct iproto_msg *msg)
+{
+	struct iovec iov[SMALL_OBUF_IOV_MAX + 1];
+	int iovcnt = 0;
+	size_t offset = msg->zero_copy_offset;
+	for (struct port_tuple_entry *e = msg->zero_copy_next;
+	     e != NULL && iovcnt < (int) lengthof(iov); e = e->next) {
+		iov[iovcnt].iov_base = (char *) tuple_data(e->tuple) + offset;
+		iov[iovcnt].iov_len = e->tuple->bsize - offset;
+		offset = 0;
+		iovcnt++;
+	}
+	ssize_t nwr = sio_writev(con->output.fd, iov, iovcnt);
+	if (nwr <= 0)
+		return -1;
+	/* Count statistics */
+	rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
+	/* Advance the send position. */
+	size_t written = nwr;
+	struct port_tuple_entry *e = msg->zero_copy_next;
+	offset = msg->zero_copy_offset;
+	while (e != NULL && written >= e->tuple->bsize - offset) {
+		written -= e->tuple->bsize - offset;
+		e = e->next;
+		offset = 0;
+	}
+	msg->zero_copy_next = e;
+	msg->zero_copy_offset = offset + written;
+	if (e != NULL)
+		return -1;
+	stailq_shift(&con->zero_copy_queue);
+	iproto_zero_copy_release(msg);
+	return 0;
+}
+
 /** writev() to the socket and handle the result. */
 
 static int
@@ -893,6 +1229,20 @@ iproto_flush(struct iproto_connection *con)
 	struct obuf_svp obuf_end = obuf_create_svp(obuf);
 	struct obuf_svp *begin = &con->wpos.svp;
 	struct obuf_svp *end = &con->wend.svp;
+	/*
+	 * Tuples of a zero-copy response are written right
+	 * after its header, which is the last thing the response
+	 * stores in the output buffer.
+	 */
+	struct iproto_msg *zero_copy = NULL;
+	if (!stailq_empty(&con->zero_copy_queue)) {
+		zero_copy = stailq_first_entry(&con->zero_copy_queue,
+					       struct iproto_msg,
+					       in_zero_copy);
+		if (zero_copy->wpos.obuf == obuf &&
+		    zero_copy->wpos.svp.used == begin->used)
+			return iproto_flush_zero_copy(con, zero_copy);
+	}
 	if (con->wend.obuf != obuf) {
 		/*
 		 * Flush the current buffer before
@@ -905,6 +1255,11 @@ iproto_flush(struct iproto_connection *con)
 			end = &obuf_end;
 		}
 	}
+	if (zero_copy != NULL && zero_copy->wpos.obuf == obuf &&
+	    zero_copy->wpos.svp.used < end->used) {
+		/* Stop at the header end. */
+		end = &zero_copy->wpos.svp;
+	}
 	if (begin->used == end->used) {
 		/* Nothing to do. */
 		return 1;
@@ -925,7 +1280,7 @@ iproto_flush(struct iproto_connection *con)
 	ssize_t nwr = sio_writev(fd, iov, iovcnt);
 
 	/* Count statistics */
-	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
 	if (nwr > 0) {
 		if (begin->used + nwr == end->used) {
 			*begin = *end;
@@ -969,22 +1324,32 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 }
 
 static struct iproto_connection *
-iproto_connection_new(int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread, int fd)
 {
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc(&iproto_connection_pool);
+		mempool_alloc(&iproto_thread->iproto_connection_pool);
 	if (con == NULL) {
 		diag_set(OutOfMemory, sizeof(*con), "mempool_alloc", "con");
 		return NULL;
 	}
+	con->streams = mh_i64ptr_new();
+	if (con->streams == NULL) {
+		diag_set(OutOfMemory, sizeof(*con->streams), "mh_i64ptr_new",
+			 "streams");
+		mempool_free(&iproto_thread->iproto_connection_pool, con);
+		return NULL;
+	}
 	con->input.data = con->output.data = con;
 	con->loop = loop();
+	con->iproto_thread = iproto_thread;
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
 	ibuf_create(&con->ibuf[0], cord_slab_cache(), iproto_readahead);
 	ibuf_create(&con->ibuf[1], cord_slab_cache(), iproto_readahead);
-	obuf_create(&con->obuf[0], &net_slabc, iproto_readahead);
-	obuf_create(&con->obuf[1], &net_slabc, iproto_readahead);
+	obuf_create(&con->obuf[0], &iproto_thread->net_slabc,
+		    iproto_readahead);
+	obuf_create(&con->obuf[1], &iproto_thread->net_slabc,
+		    iproto_readahead);
 	con->p_ibuf = &con->ibuf[0];
 	con->tx.p_obuf = &con->obuf[0];
 	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
@@ -993,11 +1358,14 @@ iproto_connection_new(int fd)
 	con->long_poll_count = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
+	stailq_create(&con->zero_copy_queue);
+	con->zero_copy_count = 0;
 	/* It may be very awkward to allocate at close. */
-	cmsg_init(&con->disconnect, disconnect_route);
+	cmsg_init(&con->disconnect, iproto_thread->disconnect_route);
 	con->is_disconnected = false;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
+	rlist_create(&con->tx.streams);
 	return con;
 }
 
@@ -1009,6 +1377,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	assert(!evio_has_fd(&con->output));
 	assert(!evio_has_fd(&con->input));
 	assert(con->session == NULL);
+	struct iproto_thread *iproto_thread = con->iproto_thread;
 	/*
 	 * The output buffers must have been deleted
 	 * in tx thread.
@@ -1019,7 +1388,21 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
-	mempool_free(&iproto_connection_pool, con);
+	assert(stailq_empty(&con->zero_copy_queue));
+	/*
+	 * Streams with an open transaction outlive their
+	 * requests. The transactions have been rolled back
+	 * by tx_process_disconnect().
+	 */
+	mh_int_t i;
+	mh_foreach(con->streams, i) {
+		struct iproto_stream *stream = (struct iproto_stream *)
+			mh_i64ptr_node(con->streams, i)->val;
+		assert(!stream->is_busy && stream->tx.fiber == NULL);
+		mempool_free(&iproto_thread->iproto_stream_pool, stream);
+	}
+	mh_i64ptr_delete(con->streams);
+	mempool_free(&iproto_thread->iproto_connection_pool, con);
 }
 
 /* }}} iproto_connection */
@@ -1041,6 +1424,9 @@ tx_process_select(struct cmsg *msg);
 static void
 tx_process_sql(struct cmsg *msg);
 
+static void
+tx_process_stream(struct cmsg *msg);
+
 static void
 tx_reply_error(struct iproto_msg *msg);
 
@@ -1062,67 +1448,92 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+tx_end_zero_copy(struct cmsg *msg);
 
-static const struct cmsg_hop call_route[] = {
-	{ tx_process_call, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+net_end_zero_copy(struct cmsg *msg);
 
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+tx_process_connect(struct cmsg *m);
 
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+net_send_greeting(struct cmsg *m);
 
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
+/**
+ * A request of a stream may be executed by a fiber other
+ * than the one it was delivered to, see tx_process_stream(),
+ * so it is forwarded to net explicitly.
+ */
+static const struct cmsg_hop stream_route[] = {
+	{ tx_process_stream, NULL },
 	{ net_send_msg, NULL },
 };
 
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	call_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	call_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	call_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-	NULL,                                   /* IPROTO_NOP */
-};
-
-static const struct cmsg_hop join_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join, NULL },
-};
-
-static const struct cmsg_hop subscribe_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_subscribe, NULL },
-};
+static inline void
+iproto_route_init(struct cmsg_hop *route, cmsg_f tx_f, cmsg_f net_f,
+		  struct cpipe *pipe)
+{
+	route[0].f = tx_f;
+	route[0].pipe = pipe;
+	route[1].f = net_f;
+	route[1].pipe = NULL;
+}
 
-static const struct cmsg_hop error_route[] = {
-	{ tx_reply_iproto_error, &net_pipe },
-	{ net_send_error, NULL },
-};
+/** Initialize message routes of a network thread. */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	struct cpipe *net_pipe = &iproto_thread->net_pipe;
+	struct cpipe *tx_pipe = &iproto_thread->tx_pipe;
+	iproto_route_init(iproto_thread->disconnect_route,
+			  tx_process_disconnect, net_finish_disconnect,
+			  net_pipe);
+	iproto_route_init(iproto_thread->push_route,
+			  iproto_process_push, tx_end_push, tx_pipe);
+	iproto_route_init(iproto_thread->connect_route,
+			  tx_process_connect, net_send_greeting, net_pipe);
+	iproto_route_init(iproto_thread->misc_route,
+			  tx_process_misc, net_send_msg, net_pipe);
+	iproto_route_init(iproto_thread->call_route,
+			  tx_process_call, net_send_msg, net_pipe);
+	iproto_route_init(iproto_thread->select_route,
+			  tx_process_select, net_send_msg, net_pipe);
+	iproto_route_init(iproto_thread->process1_route,
+			  tx_process1, net_send_msg, net_pipe);
+	iproto_route_init(iproto_thread->sql_route,
+			  tx_process_sql, net_send_msg, net_pipe);
+	iproto_route_init(iproto_thread->join_route,
+			  tx_process_join_subscribe, net_end_join, net_pipe);
+	iproto_route_init(iproto_thread->subscribe_route,
+			  tx_process_join_subscribe, net_end_subscribe,
+			  net_pipe);
+	iproto_route_init(iproto_thread->error_route,
+			  tx_reply_iproto_error, net_send_error, net_pipe);
+	iproto_route_init(iproto_thread->zero_copy_route,
+			  tx_end_zero_copy, net_end_zero_copy, net_pipe);
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	memset(dml_route, 0, sizeof(iproto_thread->dml_route));
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->call_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->call_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->call_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+}
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
 {
 	uint8_t type;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 
 	if (xrow_header_decode(&msg->header, pos, reqend))
 		goto error;
@@ -1145,53 +1556,73 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(&msg->base, dml_route[type]);
+		assert(type < lengthof(iproto_thread->dml_route));
+		cmsg_init(&msg->base, iproto_thread->dml_route[type]);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
-		cmsg_init(&msg->base, call_route);
+		cmsg_init(&msg->base, iproto_thread->call_route);
 		break;
 	case IPROTO_EXECUTE:
 		if (xrow_decode_sql(&msg->header, &msg->sql, &fiber()->gc))
 			goto error;
-		cmsg_init(&msg->base, sql_route);
+		cmsg_init(&msg->base, iproto_thread->sql_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
-		cmsg_init(&msg->base, join_route);
+		cmsg_init(&msg->base, iproto_thread->join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+		cmsg_init(&msg->base, iproto_thread->subscribe_route);
 		*stop_input = true;
 		break;
 	case IPROTO_VOTE_DEPRECATED:
 	case IPROTO_VOTE:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_AUTH:
 		if (xrow_decode_auth(&msg->header, &msg->auth))
 			goto error;
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
+		break;
+	case IPROTO_BEGIN:
+	case IPROTO_COMMIT:
+	case IPROTO_ROLLBACK:
+		if (msg->header.stream_id == 0) {
+			diag_set(ClientError, ER_UNABLE_PROCESS_OUT_OF_STREAM,
+				 iproto_type_name(type));
+			goto error;
+		}
 		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
 			 (uint32_t) type);
 		goto error;
 	}
+	if (msg->header.stream_id != 0 && !*stop_input) {
+		msg->stream = iproto_connection_stream(msg->connection,
+						       msg->header.stream_id);
+		if (msg->stream == NULL)
+			goto error;
+		cmsg_init(&msg->base, stream_route);
+	}
+	if (type == IPROTO_CALL_16)
+		type = IPROTO_CALL;
+	if (type < IPROTO_TYPE_STAT_MAX && iproto_type_strs[type] != NULL)
+		msg->stat_type = type;
 	return;
 error:
 	/** Log and send the error. */
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
-	cmsg_init(&msg->base, error_route);
+	cmsg_init(&msg->base, iproto_thread->error_route);
 }
 
 static void
@@ -1223,6 +1654,19 @@ tx_process_disconnect(struct cmsg *m)
 {
 	struct iproto_connection *con =
 		container_of(m, struct iproto_connection, disconnect);
+	/* Roll back transactions left open by the client. */
+	while (!rlist_empty(&con->tx.streams)) {
+		struct iproto_stream *stream =
+			rlist_first_entry(&con->tx.streams,
+					  struct iproto_stream,
+					  tx.in_connection);
+		struct fiber *f = stream->tx.fiber;
+		assert(f != NULL && stream->tx.msg == NULL);
+		stream->tx.is_closed = true;
+		fiber_set_joinable(f, true);
+		fiber_wakeup(f);
+		fiber_join(f);
+	}
 	if (con->session) {
 		tx_fiber_init(con->session, 0);
 		if (! rlist_empty(&session_on_disconnect))
@@ -1284,7 +1728,8 @@ tx_discard_input(struct iproto_msg *msg)
 		{ net_discard_input, NULL },
 	};
 	cmsg_init(&msg->discard_input, discard_input_route);
-	cpipe_push(&net_pipe, &msg->discard_input);
+	cpipe_push(&msg->connection->iproto_thread->net_pipe,
+		   &msg->discard_input);
 }
 
 /**
@@ -1330,6 +1775,7 @@ static inline struct iproto_msg *
 tx_accept_msg(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
+	msg->tx_time = ev_monotonic_time();
 	tx_accept_wpos(msg->connection, &msg->wpos);
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 	return msg;
@@ -1398,13 +1844,39 @@ error:
 	tx_reply_error(msg);
 }
 
+/**
+ * Check if a SELECT result set should be sent to the client
+ * right from the tuple memory, bypassing the output buffer.
+ * It's worth it only if the result set is big, so that the copy
+ * matters, and tuples aren't too small, so that writev() isn't
+ * called for too little data.
+ *
+ * @param port Result set.
+ * @param[out] size Size of the tuple data.
+ */
+static bool
+tx_select_is_zero_copy(struct port *port, size_t *size)
+{
+	struct port_tuple *result = port_tuple(port);
+	if (result->size == 0)
+		return false;
+	*size = 0;
+	for (struct port_tuple_entry *e = result->first; e != NULL;
+	     e = e->next)
+		*size += e->tuple->bsize;
+	return *size >= IPROTO_ZERO_COPY_MIN_SIZE &&
+	       *size >= (size_t) result->size *
+			IPROTO_ZERO_COPY_MIN_TUPLE_SIZE;
+}
+
 static void
 tx_process_select(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
 	struct obuf *out;
 	struct obuf_svp svp;
-	struct port port;
+	struct port *port = &msg->port;
+	size_t size;
 	int count;
 	int rc;
 	struct request *req = &msg->dml;
@@ -1414,20 +1886,36 @@ tx_process_select(struct cmsg *m)
 	tx_inject_delay();
 	rc = box_select(req->space_id, req->index_id,
 			req->iterator, req->offset, req->limit,
-			req->key, req->key_end, &port);
+			req->key, req->key_end, port);
 	if (rc < 0)
 		goto error;
 
 	out = msg->connection->tx.p_obuf;
 	if (iproto_prepare_select(out, &svp) != 0) {
-		port_destroy(&port);
+		port_destroy(port);
 		goto error;
 	}
+	if (tx_select_is_zero_copy(port, &size)) {
+		/*
+		 * Only the header goes to the output buffer.
+		 * The iproto thread writes the tuples right
+		 * after it and sends the message back to release
+		 * them, see iproto_flush().
+		 */
+		iproto_reply_select_ext(out, &svp, msg->header.sync,
+					::schema_version,
+					port_tuple(port)->size, size);
+		iproto_wpos_create(&msg->wpos, out);
+		msg->is_zero_copy = true;
+		msg->zero_copy_next = port_tuple(port)->first;
+		msg->zero_copy_offset = 0;
+		return;
+	}
 	/*
 	 * SELECT output format has not changed since Tarantool 1.6
 	 */
-	count = port_dump_msgpack_16(&port, out);
-	port_destroy(&port);
+	count = port_dump_msgpack_16(port, out);
+	port_destroy(port);
 	if (count < 0) {
 		/* Discard the prepared select. */
 		obuf_rollback_to_svp(out, &svp);
@@ -1601,6 +2089,183 @@ error:
 	tx_reply_error(msg);
 }
 
+/** Process IPROTO_BEGIN, IPROTO_COMMIT or IPROTO_ROLLBACK. */
+static void
+tx_process_txn(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct obuf *out;
+	int rc;
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+	switch (msg->header.type) {
+	case IPROTO_BEGIN:
+		rc = box_txn_begin();
+		break;
+	case IPROTO_COMMIT:
+		rc = box_txn_commit();
+		break;
+	case IPROTO_ROLLBACK:
+		rc = box_txn_rollback();
+		break;
+	default:
+		unreachable();
+	}
+	if (rc != 0)
+		goto error;
+	out = msg->connection->tx.p_obuf;
+	if (iproto_reply_ok(out, msg->header.sync, ::schema_version) != 0)
+		goto error;
+	iproto_wpos_create(&msg->wpos, out);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
+/** Execute a request of a stream in the current fiber. */
+static void
+tx_process_stream_msg(struct iproto_msg *msg)
+{
+	switch (msg->header.type) {
+	case IPROTO_SELECT:
+		tx_process_select(&msg->base);
+		break;
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE:
+	case IPROTO_UPSERT:
+		tx_process1(&msg->base);
+		break;
+	case IPROTO_CALL_16:
+	case IPROTO_CALL:
+	case IPROTO_EVAL:
+		tx_process_call(&msg->base);
+		break;
+	case IPROTO_EXECUTE:
+		tx_process_sql(&msg->base);
+		break;
+	case IPROTO_BEGIN:
+	case IPROTO_COMMIT:
+	case IPROTO_ROLLBACK:
+		tx_process_txn(&msg->base);
+		break;
+	default:
+		tx_process_misc(&msg->base);
+		break;
+	}
+}
+
+/**
+ * A DML request which is a part of a transaction spanning
+ * multiple requests must outlive the input buffer, because
+ * the request header is used as the redo log row. Copy the
+ * request to the fiber region, which is freed at the end of
+ * the transaction.
+ */
+static int
+tx_stream_copy_dml(struct iproto_msg *msg)
+{
+	struct region *region = &fiber()->gc;
+	struct xrow_header *row = region_alloc_object(region,
+						      struct xrow_header);
+	if (row == NULL) {
+		diag_set(OutOfMemory, sizeof(*row), "region", "xrow_header");
+		return -1;
+	}
+	*row = msg->header;
+	if (row->bodycnt > 0) {
+		assert(row->bodycnt == 1);
+		size_t size = row->body[0].iov_len;
+		char *body = (char *) region_alloc(region, size);
+		if (body == NULL) {
+			diag_set(OutOfMemory, size, "region", "request body");
+			return -1;
+		}
+		memcpy(body, row->body[0].iov_base, size);
+		row->body[0].iov_base = body;
+	}
+	return xrow_decode_dml(row, &msg->dml, dml_request_key_map(row->type));
+}
+
+/**
+ * The fiber of a stream with an open transaction. Executes
+ * requests of the stream until the transaction is over or
+ * the connection is closed.
+ */
+static int
+tx_stream_f(va_list ap)
+{
+	struct iproto_stream *stream = va_arg(ap, struct iproto_stream *);
+	assert(stream->tx.fiber == fiber());
+	while (true) {
+		while (stream->tx.msg == NULL && !stream->tx.is_closed)
+			fiber_yield();
+		struct iproto_msg *msg = stream->tx.msg;
+		if (msg == NULL)
+			break;
+		stream->tx.msg = NULL;
+		uint32_t type = msg->header.type;
+		if (in_txn() != NULL && type != IPROTO_SELECT &&
+		    iproto_type_is_dml(type) && tx_stream_copy_dml(msg) != 0) {
+			tx_accept_msg(&msg->base);
+			tx_reply_error(msg);
+		} else {
+			tx_process_stream_msg(msg);
+		}
+		bool is_done = in_txn() == NULL;
+		if (is_done) {
+			stream->tx.fiber = NULL;
+			rlist_del(&stream->tx.in_connection);
+		}
+		cmsg_dispatch(&msg->connection->iproto_thread->net_pipe,
+			      &msg->base);
+		if (is_done)
+			return 0;
+	}
+	/* The connection is closed. */
+	txn_rollback();
+	stream->tx.fiber = NULL;
+	rlist_del(&stream->tx.in_connection);
+	return 0;
+}
+
+/**
+ * Process a request of a stream. If the stream has an open
+ * transaction, the request is handed over to the stream fiber,
+ * which owns the transaction. IPROTO_BEGIN starts such a fiber.
+ * Other requests are executed right away.
+ */
+static void
+tx_process_stream(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_stream *stream = msg->stream;
+	if (stream->tx.fiber != NULL) {
+		assert(stream->tx.msg == NULL);
+		stream->tx.msg = msg;
+		fiber_wakeup(stream->tx.fiber);
+		return;
+	}
+	if (msg->header.type == IPROTO_BEGIN) {
+		struct fiber *f = fiber_new("iproto.stream", tx_stream_f);
+		if (f != NULL) {
+			stream->tx.fiber = f;
+			stream->tx.msg = msg;
+			stream->tx.is_closed = false;
+			rlist_add_tail_entry(&msg->connection->tx.streams,
+					     stream, tx.in_connection);
+			fiber_start(f, stream);
+			return;
+		}
+		tx_accept_msg(m);
+		tx_reply_error(msg);
+	} else {
+		tx_process_stream_msg(msg);
+	}
+	cmsg_dispatch(&msg->connection->iproto_thread->net_pipe, m);
+}
+
 static void
 tx_process_join_subscribe(struct cmsg *m)
 {
@@ -1642,6 +2307,18 @@ net_send_msg(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 
+	if (msg->stream != NULL)
+		iproto_stream_next(msg->stream);
+
+	if (msg->stat_type != IPROTO_OK) {
+		struct iproto_thread *iproto_thread = con->iproto_thread;
+		double now = ev_monotonic_time();
+		latency_collect(&iproto_thread->latency[msg->stat_type],
+				now - msg->start_time);
+		latency_collect(&iproto_thread->tx_latency,
+				now - msg->tx_time);
+	}
+
 	if (msg->len != 0) {
 		/* Discard request (see iproto_enqueue_batch()). */
 		msg->p_ibuf->rpos += msg->len;
@@ -1652,13 +2329,49 @@ net_send_msg(struct cmsg *m)
 	}
 	con->wend = msg->wpos;
 
+	/* The message may be gone once sent to tx. */
+	bool is_zero_copy = msg->is_zero_copy;
+	if (is_zero_copy) {
+		con->zero_copy_count++;
+		if (evio_has_fd(&con->output)) {
+			stailq_add_tail_entry(&con->zero_copy_queue,
+					      msg, in_zero_copy);
+		} else {
+			iproto_zero_copy_release(msg);
+		}
+	}
 	if (evio_has_fd(&con->output)) {
 		if (! ev_is_active(&con->output))
 			ev_feed_event(con->loop, &con->output, EV_WRITE);
 	} else if (iproto_connection_is_idle(con)) {
 		iproto_connection_close(con);
 	}
+	if (!is_zero_copy)
+		iproto_msg_delete(msg);
+}
+
+/** Release tuples of a zero-copy response. */
+static void
+tx_end_zero_copy(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	port_destroy(&msg->port);
+}
+
+/**
+ * Recycle a zero-copy response message once its tuples are
+ * released. Close the connection if it was waiting for that.
+ */
+static void
+net_end_zero_copy(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	assert(con->zero_copy_count > 0);
+	con->zero_copy_count--;
 	iproto_msg_delete(msg);
+	if (!evio_has_fd(&con->output) && iproto_connection_is_idle(con))
+		iproto_connection_close(con);
 }
 
 /**
@@ -1757,7 +2470,8 @@ net_send_greeting(struct cmsg *m)
 						 obuf_iovcnt(out));
 
 			/* Count statistics */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean,
+				      IPROTO_SENT, nwr);
 		} catch (Exception *e) {
 			e->log();
 		}
@@ -1778,24 +2492,18 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
- * Create a connection and start input.
+ * Create a connection served by the given network thread and
+ * start input. Never throws, closes the socket on error.
  */
 static void
-iproto_on_accept(struct evio_service * /* service */, int fd,
-		 struct sockaddr *addr, socklen_t addrlen)
+iproto_thread_accept(struct iproto_thread *iproto_thread, int fd)
 {
-	(void) addr;
-	(void) addrlen;
 	struct iproto_msg *msg;
-	struct iproto_connection *con = iproto_connection_new(fd);
+	struct iproto_connection *con =
+		iproto_connection_new(iproto_thread, fd);
 	if (con == NULL)
 		goto error_conn;
 	/*
@@ -1806,64 +2514,163 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	msg = iproto_msg_new(con);
 	if (msg == NULL)
 		goto error_msg;
-	cmsg_init(&msg->base, connect_route);
+	cmsg_init(&msg->base, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->wpos = con->wpos;
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, &msg->base);
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
+	rmean_collect(iproto_thread->rmean, IPROTO_CONNECTIONS, 1);
 	return;
 error_msg:
-	mempool_free(&iproto_connection_pool, con);
+	mh_i64ptr_delete(con->streams);
+	mempool_free(&iproto_thread->iproto_connection_pool, con);
 error_conn:
 	close(fd);
 	return;
 }
 
-static struct evio_service binary; /* iproto binary listener */
+/**
+ * A socket accepted by the first network thread and handed
+ * over to another one.
+ */
+struct iproto_accept_msg {
+	struct cmsg base;
+	/** Network thread to serve the connection. */
+	struct iproto_thread *iproto_thread;
+	/** The accepted socket. */
+	int fd;
+};
+
+static void
+net_accept(struct cmsg *m)
+{
+	struct iproto_accept_msg *msg = (struct iproto_accept_msg *) m;
+	iproto_thread_accept(msg->iproto_thread, msg->fd);
+	free(msg);
+}
+
+static const struct cmsg_hop accept_route[] = {
+	{ net_accept, NULL },
+};
+
+/**
+ * Accept a connection in the first network thread and pass it
+ * to the next thread in turn, so that all threads get an equal
+ * share of connections. Letting every thread poll the listening
+ * socket would wake all of them up on each connection, and the
+ * connections would go to whichever thread is the least busy
+ * at the moment rather than spread evenly.
+ */
+static void
+iproto_on_accept(struct evio_service *service, int fd,
+		 struct sockaddr *addr, socklen_t addrlen)
+{
+	(void) addr;
+	(void) addrlen;
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
+	assert(iproto_thread->id == 0);
+	struct iproto_thread *target = &iproto_threads[
+		iproto_thread->accept_count++ % iproto_threads_count];
+	if (target == iproto_thread) {
+		iproto_thread_accept(iproto_thread, fd);
+		return;
+	}
+	struct iproto_accept_msg *msg = (struct iproto_accept_msg *)
+		malloc(sizeof(*msg));
+	if (msg == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*msg), "malloc",
+			  "struct iproto_accept_msg");
+	}
+	cmsg_init(&msg->base, accept_route);
+	msg->iproto_thread = target;
+	msg->fd = fd;
+	cpipe_push(&target->accept_pipe, &msg->base);
+}
+
+/** Name of the cbus endpoint of a network thread. */
+static const char *
+iproto_thread_endpoint_name(struct iproto_thread *iproto_thread)
+{
+	if (iproto_thread->id == 0)
+		return "net";
+	return tt_sprintf("net%d", iproto_thread->id);
+}
+
+/** Stop accepting connections in the first network thread. */
+static void
+iproto_thread_stop_listen(struct iproto_thread *iproto_thread)
+{
+	struct evio_service *binary = &iproto_thread->binary;
+	if (evio_service_is_active(binary))
+		evio_service_stop(binary);
+}
 
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	struct iproto_thread *iproto_thread =
+		va_arg(ap, struct iproto_thread *);
+
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
-		       sizeof(struct iproto_connection));
+	mempool_create(&iproto_thread->iproto_connection_pool,
+		       &cord()->slabc, sizeof(struct iproto_connection));
+	mempool_create(&iproto_thread->iproto_stream_pool, &cord()->slabc,
+		       sizeof(struct iproto_stream));
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint,
+			     iproto_thread_endpoint_name(iproto_thread),
+			     fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, iproto_msg_max / 2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe, iproto_msg_max / 2);
+	/*
+	 * Create pipes to the other network threads to hand
+	 * accepted connections over. Waits for the threads
+	 * to start.
+	 */
+	if (iproto_thread->id == 0) {
+		for (int i = 1; i < iproto_threads_count; i++) {
+			cpipe_create(&iproto_threads[i].accept_pipe,
+				     iproto_thread_endpoint_name(
+						&iproto_threads[i]));
+		}
+	}
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	if (iproto_thread->id == 0) {
+		for (int i = 1; i < iproto_threads_count; i++)
+			cpipe_destroy(&iproto_threads[i].accept_pipe);
+	}
+	cpipe_destroy(&iproto_thread->tx_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	iproto_thread_stop_listen(iproto_thread);
 
-	rmean_delete(rmean_net);
+	rmean_delete(iproto_thread->rmean);
 	return 0;
 }
 
@@ -1905,11 +2712,12 @@ static void
 tx_begin_push(struct iproto_connection *con)
 {
 	assert(! con->tx.is_push_sent);
-	cmsg_init(&con->kharon.base, push_route);
+	cmsg_init(&con->kharon.base, con->iproto_thread->push_route);
 	iproto_wpos_create(&con->kharon.wpos, con->tx.p_obuf);
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = true;
-	cpipe_push(&net_pipe, (struct cmsg *) &con->kharon);
+	cpipe_push(&con->iproto_thread->net_pipe,
+		   (struct cmsg *) &con->kharon);
 }
 
 static void
@@ -1957,18 +2765,44 @@ iproto_session_push(struct session *session, uint64_t sync, struct port *port)
 
 /** }}} */
 
-/** Initialize the iproto subsystem and start network io thread */
+/** Initialize the iproto subsystem and start network io threads */
 void
-iproto_init()
-{
-	slab_cache_create(&net_slabc, &runtime);
-
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
-
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, iproto_msg_max / 2);
+iproto_init(int threads_count)
+{
+	assert(threads_count >= 1 && threads_count <= IPROTO_THREADS_MAX);
+	iproto_threads = (struct iproto_thread *)
+		calloc(threads_count, sizeof(*iproto_threads));
+	if (iproto_threads == NULL) {
+		tnt_raise(OutOfMemory, threads_count * sizeof(*iproto_threads),
+			  "calloc", "iproto_threads");
+	}
+	/* The first thread needs it to connect to the others. */
+	iproto_threads_count = threads_count;
+	for (int i = 0; i < threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+			if (latency_create(&iproto_thread->latency[type]) != 0)
+				panic("failed to allocate iproto statistics");
+		}
+		if (latency_create(&iproto_thread->tx_latency) != 0)
+			panic("failed to allocate iproto statistics");
+		rlist_create(&iproto_thread->stopped_connections);
+		iproto_thread_init_routes(iproto_thread);
+		slab_cache_create(&iproto_thread->net_slabc, &runtime);
+
+		const char *name = i == 0 ? "iproto" :
+				   tt_sprintf("iproto%d", i);
+		if (cord_costart(&iproto_thread->net_cord, name,
+				 net_cord_f, iproto_thread))
+			panic("failed to initialize iproto thread");
+
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe,
+			     iproto_thread_endpoint_name(iproto_thread));
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    iproto_msg_max / 2);
+	}
 	struct session_vtab iproto_session_vtab = {
 		/* .push = */ iproto_session_push,
 		/* .fd = */ iproto_session_fd,
@@ -2000,6 +2834,8 @@ struct iproto_cfg_msg: public cbus_call_msg
 		/** New iproto max message count. */
 		int iproto_msg_max;
 	};
+	/** Network thread to execute the operation in. */
+	struct iproto_thread *iproto_thread;
 };
 
 static inline void
@@ -2013,24 +2849,22 @@ static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
 	struct iproto_cfg_msg *cfg_msg = (struct iproto_cfg_msg *) m;
-	int old;
+	struct iproto_thread *iproto_thread = cfg_msg->iproto_thread;
+	struct evio_service *binary = &iproto_thread->binary;
 	try {
 		switch (cfg_msg->op) {
 		case IPROTO_CFG_MSG_MAX:
-			cpipe_set_max_input(&tx_pipe,
+			cpipe_set_max_input(&iproto_thread->tx_pipe,
 					    cfg_msg->iproto_msg_max / 2);
-			old = iproto_msg_max;
-			iproto_msg_max = cfg_msg->iproto_msg_max;
-			if (old < iproto_msg_max)
-				iproto_resume();
+			/* The limit may have been raised. */
+			iproto_resume(iproto_thread);
 			break;
 		case IPROTO_CFG_LISTEN:
-			if (evio_service_is_active(&binary))
-				evio_service_stop(&binary);
-			if (cfg_msg->uri != NULL) {
-				evio_service_bind(&binary, cfg_msg->uri);
-				evio_service_listen(&binary);
-			}
+			iproto_thread_stop_listen(iproto_thread);
+			if (cfg_msg->uri == NULL)
+				break;
+			evio_service_bind(binary, cfg_msg->uri);
+			evio_service_listen(binary);
 			break;
 		default:
 			unreachable();
@@ -2042,10 +2876,11 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 }
 
 static inline void
-iproto_do_cfg(struct iproto_cfg_msg *msg)
+iproto_do_cfg(struct iproto_thread *iproto_thread, struct iproto_cfg_msg *msg)
 {
-	if (cbus_call(&net_pipe, &tx_pipe, msg, iproto_do_cfg_f,
-		      NULL, TIMEOUT_INFINITY) != 0)
+	msg->iproto_thread = iproto_thread;
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, msg,
+		      iproto_do_cfg_f, NULL, TIMEOUT_INFINITY) != 0)
 		diag_raise();
 }
 
@@ -2055,19 +2890,99 @@ iproto_listen(const char *uri)
 	struct iproto_cfg_msg cfg_msg;
 	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LISTEN);
 	cfg_msg.uri = uri;
-	iproto_do_cfg(&cfg_msg);
+	/* Connections are only accepted by the first thread. */
+	iproto_do_cfg(&iproto_threads[0], &cfg_msg);
 }
 
 size_t
 iproto_mem_used(void)
 {
-	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
+	size_t mem = 0;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		mem += slab_cache_used(&iproto_thread->net_cord.slabc);
+		mem += slab_cache_used(&iproto_thread->net_slabc);
+	}
+	return mem;
 }
 
 void
 iproto_reset_stat(void)
 {
-	rmean_cleanup(rmean_net);
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		rmean_cleanup(iproto_thread->rmean);
+		for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++)
+			latency_reset(&iproto_thread->latency[type]);
+		latency_reset(&iproto_thread->tx_latency);
+	}
+}
+
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx)
+{
+	for (size_t name = 0; name < IPROTO_LAST; name++) {
+		int64_t rps = 0;
+		int64_t total = 0;
+		for (int i = 0; i < iproto_threads_count; i++) {
+			struct rmean *rmean = iproto_threads[i].rmean;
+			rps += rmean_mean(rmean, name);
+			total += rmean_total(rmean, name);
+		}
+		int rc = cb(rmean_net_strings[name], rps, total, cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+int
+iproto_thread_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx)
+{
+	assert(thread_id >= 0 && thread_id < iproto_threads_count);
+	struct rmean *rmean = iproto_threads[thread_id].rmean;
+	for (size_t name = 0; name < IPROTO_LAST; name++) {
+		int rc = cb(rmean_net_strings[name], rmean_mean(rmean, name),
+			    rmean_total(rmean, name), cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+static void
+iproto_info_append_latency(struct info_handler *h, const char *name,
+			   struct latency *latency)
+{
+	info_table_begin(h, name);
+	info_append_double(h, "p50", latency_get(latency, 50));
+	info_append_double(h, "p99", latency_get(latency, 99));
+	info_append_double(h, "p999", latency_get(latency, 99.9));
+	info_table_end(h);
+}
+
+void
+iproto_latency_stat(struct info_handler *h)
+{
+	struct latency sum;
+	info_begin(h);
+	if (latency_create(&sum) != 0)
+		goto out;
+	for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+		if (iproto_type_strs[type] == NULL)
+			continue;
+		latency_reset(&sum);
+		for (int i = 0; i < iproto_threads_count; i++)
+			latency_merge(&sum, &iproto_threads[i].latency[type]);
+		iproto_info_append_latency(h, iproto_type_strs[type], &sum);
+	}
+	latency_reset(&sum);
+	for (int i = 0; i < iproto_threads_count; i++)
+		latency_merge(&sum, &iproto_threads[i].tx_latency);
+	iproto_info_append_latency(h, "tx", &sum);
+	latency_destroy(&sum);
+out:
+	info_end(h);
 }
 
 void
@@ -2078,9 +2993,15 @@ iproto_set_msg_max(int new_iproto_msg_max)
 			  tt_sprintf("minimal value is %d",
 				     IPROTO_MSG_MAX_MIN));
 	}
-	struct iproto_cfg_msg cfg_msg;
-	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
-	cfg_msg.iproto_msg_max = new_iproto_msg_max;
-	iproto_do_cfg(&cfg_msg);
-	cpipe_set_max_input(&net_pipe, new_iproto_msg_max / 2);
+	/* The limit applies to each network thread. */
+	iproto_msg_max = new_iproto_msg_max;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
+		cfg_msg.iproto_msg_max = new_iproto_msg_max;
+		iproto_do_cfg(iproto_thread, &cfg_msg);
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    new_iproto_msg_max / 2);
+	}
 }
@@ -32,6 +32,7 @@
  */
 
 #include <stddef.h>
+#include "rmean.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -52,9 +53,13 @@ enum {
 	 * processing stops until some new fibers are freed up.
 	 */
 	IPROTO_FIBER_POOL_SIZE_FACTOR = 5,
+	/** The maximal value for iproto_threads. */
+	IPROTO_THREADS_MAX = 1000,
 };
 
 extern unsigned iproto_readahead;
+/** Number of network threads. */
+extern int iproto_threads_count;
 
 /**
  * Return size of memory used for storing network buffers.
@@ -68,11 +73,39 @@ iproto_mem_used(void);
 void
 iproto_reset_stat(void);
 
+/**
+ * Invoke a callback for each network statistics counter,
+ * summed over all network threads.
+ */
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx);
+
+/**
+ * Invoke a callback for each network statistics counter
+ * of the network thread with the given number.
+ */
+int
+iproto_thread_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx);
+
+struct info_handler;
+
+/**
+ * Report request latency percentiles by request type, from
+ * reading a request to queuing its reply, and the part of
+ * it spent in the tx thread.
+ */
+void
+iproto_latency_stat(struct info_handler *h);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
+/**
+ * Initialize the iproto subsystem and start @a threads_count
+ * network threads.
+ */
 void
-iproto_init();
+iproto_init(int threads_count);
 
 void
 iproto_listen(const char *uri);
@@ -49,6 +49,12 @@ enum {
 	XLOG_FIXHEADER_SIZE = 19
 };
 
+/** IPROTO_FLAGS bits. */
+enum {
+	/** Set for the last row of a multi-statement transaction. */
+	IPROTO_FLAG_COMMIT = 0x01,
+};
+
 enum iproto_key {
 	IPROTO_REQUEST_TYPE = 0x00,
 	IPROTO_SYNC = 0x01,
@@ -60,6 +66,10 @@ enum iproto_key {
 	IPROTO_SCHEMA_VERSION = 0x05,
 	IPROTO_SERVER_VERSION = 0x06,
 	IPROTO_GROUP_ID = 0x07,
+	IPROTO_TSN = 0x08,
+	IPROTO_FLAGS = 0x09,
+	/* Request keys (header) */
+	IPROTO_STREAM_ID = 0x0a,
 	/* Leave a gap for other keys in the header. */
 	IPROTO_SPACE_ID = 0x10,
 	IPROTO_INDEX_ID = 0x11,
@@ -196,6 +206,13 @@ enum iproto_type {
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
+	/** Begin a transaction in a stream. */
+	IPROTO_BEGIN = 14,
+	/** Commit the transaction of a stream. */
+	IPROTO_COMMIT = 15,
+	/** Roll back the transaction of a stream. */
+	IPROTO_ROLLBACK = 16,
+
 	/** PING request */
 	IPROTO_PING = 64,
 	/** Replication JOIN command */
@@ -244,6 +261,12 @@ iproto_type_name(uint32_t type)
 		return iproto_type_strs[type];
 
 	switch (type) {
+	case IPROTO_BEGIN:
+		return "BEGIN";
+	case IPROTO_COMMIT:
+		return "COMMIT";
+	case IPROTO_ROLLBACK:
+		return "ROLLBACK";
 	case VY_INDEX_RUN_INFO:
 		return "RUNINFO";
 	case VY_INDEX_PAGE_INFO:
@@ -35,6 +35,7 @@
 #include "column_mask.h"
 #include "schema_def.h"
 #include "coll_id_cache.h"
+#include "json/path.h"
 
 const char *sort_order_strs[] = { "asc", "desc", "undef" };
 
@@ -44,7 +45,9 @@ static const struct key_part_def key_part_def_default = {
 	COLL_NONE,
 	false,
 	ON_CONFLICT_ACTION_ABORT,
-	SORT_ORDER_ASC
+	SORT_ORDER_ASC,
+	NULL,
+	0
 };
 
 static int64_t
@@ -59,6 +62,7 @@ part_type_by_name_wrapper(const char *str, uint32_t len)
 #define PART_OPT_NULLABILITY	 "is_nullable"
 #define PART_OPT_NULLABLE_ACTION "nullable_action"
 #define PART_OPT_SORT_ORDER	 "sort_order"
+#define PART_OPT_PATH		 "path"
 
 const struct opt_def part_def_reg[] = {
 	OPT_DEF_ENUM(PART_OPT_TYPE, field_type, struct key_part_def, type,
@@ -103,16 +107,34 @@ const uint32_t key_mp_type[] = {
 	/* [FIELD_TYPE_MAP]      =  */ (1U << MP_MAP),
 };
 
+/** Total length of JSON paths of key parts. */
+static uint32_t
+key_def_path_pool_size(const struct key_def *def)
+{
+	uint32_t size = 0;
+	for (uint32_t i = 0; i < def->part_count; i++)
+		size += def->parts[i].path_len;
+	return size;
+}
+
 struct key_def *
 key_def_dup(const struct key_def *src)
 {
-	size_t sz = key_def_sizeof(src->part_count);
+	size_t sz = key_def_sizeof(src->part_count,
+				   key_def_path_pool_size(src));
 	struct key_def *res = (struct key_def *)malloc(sz);
 	if (res == NULL) {
 		diag_set(OutOfMemory, sz, "malloc", "res");
 		return NULL;
 	}
 	memcpy(res, src, sz);
+	/* Paths point to the source key_def memory, relocate. */
+	for (uint32_t i = 0; i < src->part_count; i++) {
+		if (src->parts[i].path == NULL)
+			continue;
+		size_t offset = src->parts[i].path - (char *)src;
+		res->parts[i].path = (char *)res + offset;
+	}
 	return res;
 }
 
@@ -120,6 +142,8 @@ void
 key_def_swap(struct key_def *old_def, struct key_def *new_def)
 {
 	assert(old_def->part_count == new_def->part_count);
+	/* Paths are stored in key_def memory and can't be swapped. */
+	assert(!old_def->has_json_paths && !new_def->has_json_paths);
 	for (uint32_t i = 0; i < new_def->part_count; i++)
 		SWAP(old_def->parts[i], new_def->parts[i]);
 	SWAP(*old_def, *new_def);
@@ -136,14 +160,19 @@ key_def_set_cmp(struct key_def *def)
 {
 	def->tuple_compare = tuple_compare_create(def);
 	def->tuple_compare_with_key = tuple_compare_with_key_create(def);
+	tuple_hint_func_set(def);
 	tuple_hash_func_set(def);
 	tuple_extract_key_set(def);
 }
 
-struct key_def *
-key_def_new(uint32_t part_count)
+/**
+ * Allocate a new key_def with room for @a path_pool_size
+ * bytes of JSON paths after the parts array.
+ */
+static struct key_def *
+key_def_new_with_path_pool(uint32_t part_count, uint32_t path_pool_size)
 {
-	size_t sz = key_def_sizeof(part_count);
+	size_t sz = key_def_sizeof(part_count, path_pool_size);
 	/** Use calloc() to zero comparator function pointers. */
 	struct key_def *key_def = (struct key_def *) calloc(1, sz);
 	if (key_def == NULL) {
@@ -155,12 +184,60 @@ key_def_new(uint32_t part_count)
 	return key_def;
 }
 
+struct key_def *
+key_def_new(uint32_t part_count)
+{
+	return key_def_new_with_path_pool(part_count, 0);
+}
+
+/**
+ * Copy a JSON path of a key part to the path pool of its
+ * key_def. Must be called before key_def_set_part() for the
+ * same part, because the latter may initialize comparators.
+ * @param def Key definition.
+ * @param part_no Part number.
+ * @param path Path or NULL.
+ * @param path_len Length of @a path.
+ * @param[in][out] path_pool Pointer to free space of the pool.
+ */
+static void
+key_def_set_part_path(struct key_def *def, uint32_t part_no,
+		      const char *path, uint32_t path_len, char **path_pool)
+{
+	assert(part_no < def->part_count);
+	struct key_part *part = &def->parts[part_no];
+	if (path == NULL) {
+		part->path = NULL;
+		part->path_len = 0;
+		part->path_hash = 0;
+		part->is_multikey = false;
+		return;
+	}
+	part->path = *path_pool;
+	part->path_len = path_len;
+	part->path_hash = json_path_hash(path, path_len);
+	memcpy(part->path, path, path_len);
+	*path_pool += path_len;
+	int multikey_offset = json_path_multikey_offset(path, path_len);
+	part->is_multikey = multikey_offset >= 0;
+	if (part->is_multikey && !def->is_multikey) {
+		def->is_multikey = true;
+		def->multikey_part = part_no;
+		def->multikey_path_len = multikey_offset;
+	}
+}
+
 struct key_def *
 key_def_new_with_parts(struct key_part_def *parts, uint32_t part_count)
 {
-	struct key_def *def = key_def_new(part_count);
+	uint32_t path_pool_size = 0;
+	for (uint32_t i = 0; i < part_count; i++)
+		path_pool_size += parts[i].path_len;
+	struct key_def *def = key_def_new_with_path_pool(part_count,
+							 path_pool_size);
 	if (def == NULL)
 		return NULL;
+	char *path_pool = (char *)def + key_def_sizeof(part_count, 0);
 
 	for (uint32_t i = 0; i < part_count; i++) {
 		struct key_part_def *part = &parts[i];
@@ -175,6 +252,8 @@ key_def_new_with_parts(struct key_part_def *parts, uint32_t part_count)
 			}
 			coll = coll_id->coll;
 		}
+		key_def_set_part_path(def, i, part->path, part->path_len,
+				      &path_pool);
 		key_def_set_part(def, i, part->fieldno, part->type,
 				 part->nullable_action, coll, part->coll_id,
 				 part->sort_order);
@@ -193,6 +272,8 @@ key_def_dump_parts(const struct key_def *def, struct key_part_def *parts)
 		part_def->is_nullable = key_part_is_nullable(part);
 		part_def->nullable_action = part->nullable_action;
 		part_def->coll_id = part->coll_id;
+		part_def->path = part->path;
+		part_def->path_len = part->path_len;
 	}
 }
 
@@ -245,6 +326,9 @@ key_part_cmp(const struct key_part *parts1, uint32_t part_count1,
 	for (; part1 != end; part1++, part2++) {
 		if (part1->fieldno != part2->fieldno)
 			return part1->fieldno < part2->fieldno ? -1 : 1;
+		int rc = key_part_path_cmp(part1, part2);
+		if (rc != 0)
+			return rc;
 		if ((int) part1->type != (int) part2->type)
 			return (int) part1->type < (int) part2->type ? -1 : 1;
 		if (part1->coll != part2->coll)
@@ -266,6 +350,15 @@ key_def_set_part(struct key_def *def, uint32_t part_no, uint32_t fieldno,
 	assert(part_no < def->part_count);
 	assert(type < field_type_MAX);
 	def->is_nullable |= (nullable_action == ON_CONFLICT_ACTION_NONE);
+	if (def->parts[part_no].path != NULL) {
+		def->has_json_paths = true;
+		/*
+		 * A nullable JSON path part can be absent even
+		 * if the root field is present.
+		 */
+		def->has_optional_parts |=
+			(nullable_action == ON_CONFLICT_ACTION_NONE);
+	}
 	def->parts[part_no].nullable_action = nullable_action;
 	def->parts[part_no].fieldno = fieldno;
 	def->parts[part_no].type = type;
@@ -296,7 +389,8 @@ key_def_update_optionality(struct key_def *def, uint32_t min_field_count)
 	for (uint32_t i = 0; i < def->part_count; ++i) {
 		struct key_part *part = &def->parts[i];
 		def->has_optional_parts |= key_part_is_nullable(part) &&
-					   min_field_count < part->fieldno + 1;
+					   (min_field_count < part->fieldno + 1 ||
+					    part->path != NULL);
 		/*
 		 * One optional part is enough to switch to new
 		 * comparators.
@@ -336,6 +430,8 @@ key_def_sizeof_parts(const struct key_part_def *parts, uint32_t part_count)
 			count++;
 		if (part->is_nullable)
 			count++;
+		if (part->path != NULL)
+			count++;
 		size += mp_sizeof_map(count);
 		size += mp_sizeof_str(strlen(PART_OPT_FIELD));
 		size += mp_sizeof_uint(part->fieldno);
@@ -350,6 +446,10 @@ key_def_sizeof_parts(const struct key_part_def *parts, uint32_t part_count)
 			size += mp_sizeof_str(strlen(PART_OPT_NULLABILITY));
 			size += mp_sizeof_bool(part->is_nullable);
 		}
+		if (part->path != NULL) {
+			size += mp_sizeof_str(strlen(PART_OPT_PATH));
+			size += mp_sizeof_str(part->path_len);
+		}
 	}
 	return size;
 }
@@ -365,6 +465,8 @@ key_def_encode_parts(char *data, const struct key_part_def *parts,
 			count++;
 		if (part->is_nullable)
 			count++;
+		if (part->path != NULL)
+			count++;
 		data = mp_encode_map(data, count);
 		data = mp_encode_str(data, PART_OPT_FIELD,
 				     strlen(PART_OPT_FIELD));
@@ -384,6 +486,12 @@ key_def_encode_parts(char *data, const struct key_part_def *parts,
 					     strlen(PART_OPT_NULLABILITY));
 			data = mp_encode_bool(data, part->is_nullable);
 		}
+		if (part->path != NULL) {
+			data = mp_encode_str(data, PART_OPT_PATH,
+					     strlen(PART_OPT_PATH));
+			data = mp_encode_str(data, part->path,
+					     part->path_len);
+		}
 	}
 	return data;
 }
@@ -449,6 +557,57 @@ key_def_decode_parts_166(struct key_part_def *parts, uint32_t part_count,
 	return 0;
 }
 
+/**
+ * Check [*] in the path of a decoded key part: a path may have
+ * only one, and all parts of a key must index items of the
+ * same array.
+ * @param parts Decoded parts.
+ * @param part_no Number of the part to check, its path is
+ *        valid.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+static int
+key_def_check_multikey_part(const struct key_part_def *parts,
+			    uint32_t part_no)
+{
+	const struct key_part_def *part = &parts[part_no];
+	int offset = json_path_multikey_offset(part->path, part->path_len);
+	if (offset < 0)
+		return 0;
+	/* Skip the [*] itself. */
+	const char *suffix = part->path + offset + 3;
+	int suffix_len = part->path_len - offset - 3;
+	if (json_path_multikey_offset(suffix, suffix_len) >= 0) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 part_no + TUPLE_INDEX_BASE,
+			 "no more than one array can be indexed by [*] "
+			 "in a path");
+		return -1;
+	}
+	for (uint32_t i = 0; i < part_no; i++) {
+		const struct key_part_def *other = &parts[i];
+		if (other->path == NULL)
+			continue;
+		int other_offset = json_path_multikey_offset(other->path,
+							     other->path_len);
+		if (other_offset < 0)
+			continue;
+		if (other->fieldno != part->fieldno ||
+		    json_path_cmp(other->path, other_offset,
+				  part->path, offset) != 0) {
+			diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+				 part_no + TUPLE_INDEX_BASE,
+				 "all parts with [*] must index items of "
+				 "the same array");
+			return -1;
+		}
+		break;
+	}
+	return 0;
+}
+
 int
 key_def_decode_parts(struct key_part_def *parts, uint32_t part_count,
 		     const char **data, const struct field_def *fields,
@@ -479,6 +638,24 @@ key_def_decode_parts(struct key_part_def *parts, uint32_t part_count,
 			}
 			uint32_t key_len;
 			const char *key = mp_decode_str(data, &key_len);
+			if (key_len == strlen(PART_OPT_PATH) &&
+			    memcmp(key, PART_OPT_PATH, key_len) == 0) {
+				/*
+				 * The path is not copied: the caller
+				 * keeps the data until a key_def is
+				 * created from the parts.
+				 */
+				if (mp_typeof(**data) != MP_STR) {
+					diag_set(ClientError,
+						 ER_WRONG_INDEX_OPTIONS,
+						 i + TUPLE_INDEX_BASE,
+						 "path must be a string");
+					return -1;
+				}
+				part->path = mp_decode_str(data,
+							   &part->path_len);
+				continue;
+			}
 			if (opts_parse_key(part, part_def_reg, key, key_len, data,
 					   ER_WRONG_INDEX_OPTIONS,
 					   i + TUPLE_INDEX_BASE, NULL,
@@ -527,6 +704,21 @@ key_def_decode_parts(struct key_part_def *parts, uint32_t part_count,
 				 "index part: unknown sort order");
 			return -1;
 		}
+		if (part->path != NULL) {
+			int rc = json_path_validate(part->path,
+						    part->path_len);
+			if (rc != 0) {
+				diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+					 i + TUPLE_INDEX_BASE,
+					 tt_sprintf("invalid JSON path '%.*s': "
+						    "error at position %d",
+						    (int) part->path_len, part->path,
+						    rc));
+				return -1;
+			}
+			if (key_def_check_multikey_part(parts, i) != 0)
+				return -1;
+		}
 	}
 	return 0;
 }
@@ -543,13 +735,37 @@ key_def_find(const struct key_def *key_def, uint32_t fieldno)
 	return NULL;
 }
 
+int
+key_part_path_cmp(const struct key_part *part1,
+		  const struct key_part *part2)
+{
+	if (part1->path == NULL || part2->path == NULL)
+		return (part1->path != NULL) - (part2->path != NULL);
+	return json_path_cmp(part1->path, part1->path_len,
+			     part2->path, part2->path_len);
+}
+
+const struct key_part *
+key_def_find_part(const struct key_def *key_def,
+		  const struct key_part *to_find)
+{
+	const struct key_part *part = key_def->parts;
+	const struct key_part *end = part + key_def->part_count;
+	for (; part != end; part++) {
+		if (part->fieldno == to_find->fieldno &&
+		    key_part_path_cmp(part, to_find) == 0)
+			return part;
+	}
+	return NULL;
+}
+
 bool
 key_def_contains(const struct key_def *first, const struct key_def *second)
 {
 	const struct key_part *part = second->parts;
 	const struct key_part *end = part + second->part_count;
 	for (; part != end; part++) {
-		if (key_def_find(first, part->fieldno) == NULL)
+		if (key_def_find_part(first, part) == NULL)
 			return false;
 	}
 	return true;
@@ -559,6 +775,7 @@ struct key_def *
 key_def_merge(const struct key_def *first, const struct key_def *second)
 {
 	uint32_t new_part_count = first->part_count + second->part_count;
+	uint32_t path_pool_size = key_def_path_pool_size(first);
 	/*
 	 * Find and remove part duplicates, i.e. parts counted
 	 * twice since they are present in both key defs.
@@ -566,19 +783,17 @@ key_def_merge(const struct key_def *first, const struct key_def *second)
 	const struct key_part *part = second->parts;
 	const struct key_part *end = part + second->part_count;
 	for (; part != end; part++) {
-		if (key_def_find(first, part->fieldno))
+		if (key_def_find_part(first, part))
 			--new_part_count;
+		else
+			path_pool_size += part->path_len;
 	}
 
 	struct key_def *new_def;
-	new_def =  (struct key_def *)calloc(1, key_def_sizeof(new_part_count));
-	if (new_def == NULL) {
-		diag_set(OutOfMemory, key_def_sizeof(new_part_count), "malloc",
-			 "new_def");
+	new_def = key_def_new_with_path_pool(new_part_count, path_pool_size);
+	if (new_def == NULL)
 		return NULL;
-	}
-	new_def->part_count = new_part_count;
-	new_def->unique_part_count = new_part_count;
+	char *path_pool = (char *)new_def + key_def_sizeof(new_part_count, 0);
 	new_def->is_nullable = first->is_nullable || second->is_nullable;
 	new_def->has_optional_parts = first->has_optional_parts ||
 				      second->has_optional_parts;
@@ -588,6 +803,8 @@ key_def_merge(const struct key_def *first, const struct key_def *second)
 	part = first->parts;
 	end = part + first->part_count;
 	for (; part != end; part++) {
+		key_def_set_part_path(new_def, pos, part->path, part->path_len,
+				      &path_pool);
 		key_def_set_part(new_def, pos++, part->fieldno, part->type,
 				 part->nullable_action, part->coll,
 				 part->coll_id, part->sort_order);
@@ -597,8 +814,10 @@ key_def_merge(const struct key_def *first, const struct key_def *second)
 	part = second->parts;
 	end = part + second->part_count;
 	for (; part != end; part++) {
-		if (key_def_find(first, part->fieldno))
+		if (key_def_find_part(first, part))
 			continue;
+		key_def_set_part_path(new_def, pos, part->path, part->path_len,
+				      &path_pool);
 		key_def_set_part(new_def, pos++, part->fieldno, part->type,
 				 part->nullable_action, part->coll,
 				 part->coll_id, part->sort_order);
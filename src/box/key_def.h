@@ -68,6 +68,14 @@ struct key_part_def {
 	enum on_conflict_action nullable_action;
 	/** Part sort order. */
 	enum sort_order sort_order;
+	/**
+	 * JSON path to the indexed data relative to the field
+	 * fieldno or NULL if the whole field is indexed. Not
+	 * 0-terminated.
+	 */
+	const char *path;
+	/** Length of @a path. */
+	uint32_t path_len;
 };
 
 /**
@@ -90,6 +98,19 @@ struct key_part {
 	enum on_conflict_action nullable_action;
 	/** Part sort order. */
 	enum sort_order sort_order;
+	/**
+	 * JSON path to the indexed data relative to the field
+	 * fieldno or NULL if the whole field is indexed. The
+	 * path is stored in the key_def memory after the parts
+	 * array and is not 0-terminated.
+	 */
+	char *path;
+	/** Length of @a path. */
+	uint32_t path_len;
+	/** Hash of @a path, @sa json_path_hash(). */
+	uint32_t path_hash;
+	/** True if @a path has [*], i.e. indexes array items. */
+	bool is_multikey;
 };
 
 struct key_def;
@@ -125,6 +146,27 @@ typedef char *(*tuple_extract_key_raw_t)(const char *data,
 					 const char *data_end,
 					 const struct key_def *key_def,
 					 uint32_t *key_size);
+/**
+ * Tuple comparison hint. A hint is computed from the first key
+ * part and preserves its order: if hint(a) < hint(b) then
+ * a < b, if hint(a) > hint(b) then a > b. Hints let an index
+ * store a cheap prefix of the key next to a tuple pointer and
+ * skip decoding the tuple in most comparisons.
+ */
+typedef uint64_t hint_t;
+
+/**
+ * The hint is unknown, the keys must be compared in full.
+ * Greater than any real hint.
+ */
+#define HINT_NONE ((hint_t)UINT64_MAX)
+
+/** @copydoc tuple_hint() */
+typedef hint_t (*tuple_hint_t)(const struct tuple *tuple,
+			       const struct key_def *key_def);
+/** @copydoc key_hint() */
+typedef hint_t (*key_hint_t)(const char *key, uint32_t part_count,
+			     const struct key_def *key_def);
 /** @copydoc tuple_hash() */
 typedef uint32_t (*tuple_hash_t)(const struct tuple *tuple,
 				 const struct key_def *key_def);
@@ -142,6 +184,10 @@ struct key_def {
 	tuple_extract_key_t tuple_extract_key;
 	/** @see tuple_extract_key_raw() */
 	tuple_extract_key_raw_t tuple_extract_key_raw;
+	/** @see tuple_hint() */
+	tuple_hint_t tuple_hint;
+	/** @see key_hint() */
+	key_hint_t key_hint;
 	/** @see tuple_hash() */
 	tuple_hash_t tuple_hash;
 	/** @see key_hash() */
@@ -161,6 +207,21 @@ struct key_def {
 	 * fields assumed to be MP_NIL.
 	 */
 	bool has_optional_parts;
+	/** True, if at least one part has a JSON path. */
+	bool has_json_paths;
+	/**
+	 * True, if some parts index items of an array, i.e. their
+	 * paths have [*]. A tuple has as many keys as the array
+	 * has items, @sa tuple_multikey_count().
+	 */
+	bool is_multikey;
+	/** Number of the first part with [*] in its path. */
+	uint32_t multikey_part;
+	/**
+	 * Length of the path of @a multikey_part up to [*], i.e.
+	 * of the path to the indexed array in its field.
+	 */
+	uint32_t multikey_path_len;
 	/** Key fields mask. @sa column_mask.h for details. */
 	uint64_t column_mask;
 	/** The size of the 'parts' array. */
@@ -248,14 +309,20 @@ box_tuple_compare_with_key(const box_tuple_t *tuple_a, const char *key_b,
 
 /** \endcond public */
 
+/**
+ * Size of a key_def with @a part_count parts and
+ * @a path_pool_size bytes of JSON paths.
+ */
 static inline size_t
-key_def_sizeof(uint32_t part_count)
+key_def_sizeof(uint32_t part_count, uint32_t path_pool_size)
 {
-	return sizeof(struct key_def) + sizeof(struct key_part) * part_count;
+	return sizeof(struct key_def) + sizeof(struct key_part) * part_count +
+	       path_pool_size;
 }
 
 /**
- * Allocate a new key_def with the given part count.
+ * Allocate a new key_def with the given part count. Parts
+ * of such key_def can not have JSON paths.
  */
 struct key_def *
 key_def_new(uint32_t part_count);
@@ -336,6 +403,22 @@ key_def_decode_parts(struct key_part_def *parts, uint32_t part_count,
 const struct key_part *
 key_def_find(const struct key_def *key_def, uint32_t fieldno);
 
+/**
+ * Returns the part in @a key_def->parts indexing the same
+ * field and JSON path as @a to_find or NULL.
+ */
+const struct key_part *
+key_def_find_part(const struct key_def *key_def,
+		  const struct key_part *to_find);
+
+/**
+ * Compare JSON paths of two key parts.
+ * @retval 0 if the parts index the same data of a field.
+ */
+int
+key_part_path_cmp(const struct key_part *part1,
+		  const struct key_part *part2);
+
 /**
  * Check if key definition @a first contains all parts of
  * key definition @a second.
@@ -373,7 +456,8 @@ key_validate_parts(const struct key_def *key_def, const char *key,
 /**
  * Return true if @a index_def defines a sequential key without
  * holes starting from the first field. In other words, for all
- * key parts index_def->parts[part_id].fieldno == part_id.
+ * key parts index_def->parts[part_id].fieldno == part_id and
+ * none of them has a JSON path.
  * @param index_def index_def
  * @retval true index_def is sequential
  * @retval false otherwise
@@ -381,6 +465,8 @@ key_validate_parts(const struct key_def *key_def, const char *key,
 static inline bool
 key_def_is_sequential(const struct key_def *key_def)
 {
+	if (key_def->has_json_paths)
+		return false;
 	for (uint32_t part_id = 0; part_id < key_def->part_count; part_id++) {
 		if (key_def->parts[part_id].fieldno != part_id)
 			return false;
@@ -535,6 +621,44 @@ tuple_compare_with_key(const struct tuple *tuple, const char *key,
 	return key_def->tuple_compare_with_key(tuple, key, part_count, key_def);
 }
 
+/**
+ * Compute the comparison hint of a tuple.
+ * @param tuple tuple
+ * @param key_def key definition
+ * @return hint of the first key part or HINT_NONE
+ */
+static inline hint_t
+tuple_hint(const struct tuple *tuple, const struct key_def *key_def)
+{
+	return key_def->tuple_hint(tuple, key_def);
+}
+
+/**
+ * Compute the comparison hint of a key.
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ * @return hint of the first key part or HINT_NONE
+ */
+static inline hint_t
+key_hint(const char *key, uint32_t part_count, const struct key_def *key_def)
+{
+	return key_def->key_hint(key, part_count, key_def);
+}
+
+/**
+ * Compare two hints.
+ * @retval <0 or >0 if the hints decide the comparison
+ * @retval 0 if the keys must be compared in full
+ */
+static inline int
+hint_cmp(hint_t hint_a, hint_t hint_b)
+{
+	if (hint_a == hint_b || hint_a == HINT_NONE || hint_b == HINT_NONE)
+		return 0;
+	return hint_a < hint_b ? -1 : 1;
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
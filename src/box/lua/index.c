@@ -36,6 +36,7 @@
 #include "box/lua/info.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
+#include "fiber.h"
 
 /** {{{ box.index Lua library: access to spaces and indexes
  */
@@ -169,6 +170,45 @@ lbox_index_get(lua_State *L)
 	return luaT_pushtupleornil(L, tuple);
 }
 
+static int
+lbox_index_get_multi(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2))
+		return luaL_error(L, "usage index.get_multi(space_id, index_id, "
+				  "keys)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t region_svp = region_used(&fiber()->gc);
+	size_t keys_len;
+	const char *keys = lbox_encode_tuple_on_gc(L, 3, &keys_len);
+	const char *pos = keys;
+	uint32_t key_count = mp_decode_array(&pos);
+
+	size_t size = key_count * sizeof(struct tuple *);
+	struct tuple **result = region_alloc(&fiber()->gc, size);
+	if (result == NULL) {
+		region_truncate(&fiber()->gc, region_svp);
+		diag_set(OutOfMemory, size, "region", "result");
+		return luaT_error(L);
+	}
+	if (box_index_get_multi(space_id, index_id, keys, keys + keys_len,
+				result) != 0) {
+		region_truncate(&fiber()->gc, region_svp);
+		return luaT_error(L);
+	}
+	lua_createtable(L, key_count, 0);
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (result[i] == NULL)
+			continue;
+		luaT_pushtuple(L, result[i]);
+		box_tuple_unref(result[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	region_truncate(&fiber()->gc, region_svp);
+	return 1;
+}
+
 static int
 lbox_index_min(lua_State *L)
 {
@@ -357,6 +397,7 @@ box_lua_index_init(struct lua_State *L)
 		{"delete",  lbox_index_delete},
 		{"random", lbox_index_random},
 		{"get",  lbox_index_get},
+		{"get_multi", lbox_index_get_multi},
 		{"min", lbox_index_min},
 		{"max", lbox_index_max},
 		{"count", lbox_index_count},
@@ -50,6 +50,7 @@
 #include "box/checkpoint.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/memtx_engine.h"
 #include "main.h"
 #include "version.h"
 #include "box/box.h"
@@ -523,6 +524,34 @@ lbox_info_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_info_memtx_call(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_stat(memtx, &h);
+	return 1;
+}
+
+static int
+lbox_info_memtx(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_newtable(L); /* metatable */
+
+	lua_pushstring(L, "__call");
+	lua_pushcfunction(L, lbox_info_memtx_call);
+	lua_settable(L, -3);
+
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
 static const struct luaL_Reg lbox_info_dynamic_meta[] = {
 	{"id", lbox_info_id},
 	{"uuid", lbox_info_uuid},
@@ -537,6 +566,7 @@ static const struct luaL_Reg lbox_info_dynamic_meta[] = {
 	{"cluster", lbox_info_cluster},
 	{"memory", lbox_info_memory},
 	{"gc", lbox_info_gc},
+	{"memtx", lbox_info_memtx},
 	{"vinyl", lbox_info_vinyl},
 	{NULL, NULL}
 };
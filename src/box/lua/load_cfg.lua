@@ -12,6 +12,8 @@ local default_cfg = {
     memtx_memory        = 256 * 1024 *1024,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_sort_threads  = 0, -- number of cores
+    memtx_use_mvcc_engine = false,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
@@ -20,9 +22,11 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 0,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 2,
+    vinyl_max_subcompactions = 1,
     vinyl_timeout       = 60,
     vinyl_run_count_per_level = 2,
     vinyl_run_size_ratio      = 3.5,
@@ -31,6 +35,7 @@ local default_cfg = {
     vinyl_bloom_fpr           = 0.05,
     log                 = nil,
     log_nonblock        = nil,
+    log_async           = false,
     log_level           = 5,
     log_format          = "plain",
     io_collect_interval = nil,
@@ -41,6 +46,9 @@ local default_cfg = {
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
     wal_dir_rescan_delay= 2,
+    wal_group_commit_delay = 0,
+    wal_group_commit_max_rows = 10000,
+    wal_group_commit_max_size = 1024 * 1024,
     force_recovery      = false,
     replication         = nil,
     instance_uuid       = nil,
@@ -64,6 +72,7 @@ local default_cfg = {
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    iproto_threads        = 1,
 }
 
 -- types of available options
@@ -73,6 +82,8 @@ local template_cfg = {
     memtx_memory        = 'number',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_sort_threads    = 'number',
+    memtx_use_mvcc_engine = 'boolean',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
@@ -80,9 +91,11 @@ local template_cfg = {
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
+    vinyl_max_subcompactions  = 'number',
     vinyl_timeout             = 'number',
     vinyl_run_count_per_level = 'number',
     vinyl_run_size_ratio      = 'number',
@@ -92,6 +105,7 @@ local template_cfg = {
 
     log              = 'string',
     log_nonblock     = 'boolean',
+    log_async        = 'boolean',
     log_level           = 'number',
     log_format          = 'string',
     io_collect_interval = 'number',
@@ -102,6 +116,9 @@ local template_cfg = {
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
     wal_dir_rescan_delay= 'number',
+    wal_group_commit_delay = 'number',
+    wal_group_commit_max_rows = 'number',
+    wal_group_commit_max_size = 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     instance_uuid       = 'string',
@@ -125,6 +142,7 @@ local template_cfg = {
     feedback_host         = 'string',
     feedback_interval     = 'number',
     net_msg_max           = 'number',
+    iproto_threads        = 'number',
 }
 
 local function normalize_uri(port)
@@ -193,9 +211,12 @@ local dynamic_cfg = {
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_sort_threads      = private.cfg_set_memtx_sort_threads,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
+    vinyl_max_subcompactions = private.cfg_set_vinyl_max_subcompactions,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.checkpoint_daemon.set_checkpoint_interval,
@@ -205,6 +226,9 @@ local dynamic_cfg = {
     feedback_interval       = private.feedback_daemon.set_feedback_params,
     -- do nothing, affects new replicas, which query this value on start
     wal_dir_rescan_delay    = function() end,
+    wal_group_commit_delay  = private.cfg_set_wal_group_commit,
+    wal_group_commit_max_rows = private.cfg_set_wal_group_commit,
+    wal_group_commit_max_size = private.cfg_set_wal_group_commit,
     custom_proc_title       = function()
         require('title').update(box.cfg.custom_proc_title)
     end,
@@ -98,8 +98,11 @@ local method_encoder = {
     min     = internal.encode_select,
     max     = internal.encode_select,
     count   = internal.encode_call,
+    begin   = internal.encode_begin,
+    commit  = internal.encode_commit,
+    rollback = internal.encode_rollback,
     -- inject raw data into connection, used by console and tests
-    inject = function(buf, id, bytes)
+    inject = function(buf, id, stream_id, bytes)
         local ptr = buf:reserve(#bytes)
         ffi.copy(ptr, bytes, #bytes)
         buf.wpos = ptr + #bytes
@@ -122,6 +125,9 @@ local method_decoder = {
     min     = decode_get,
     max     = decode_get,
     count   = decode_count,
+    begin   = decode_nil,
+    commit  = decode_nil,
+    rollback = decode_nil,
     inject  = decode_data,
     push    = decode_push,
 }
@@ -485,7 +491,7 @@ local function create_transport(host, port, user, password, callback,
     -- @retval not nil Future object.
     --
     local function perform_async_request(buffer, method, on_push, on_push_ctx,
-                                         ...)
+                                         stream_id, ...)
         if state ~= 'active' and state ~= 'fetch_schema' then
             return nil, box.error.new({code = last_errno or E_NO_CONNECTION,
                                        reason = last_error})
@@ -496,7 +502,7 @@ local function create_transport(host, port, user, password, callback,
             worker_fiber:wakeup()
         end
         local id = next_request_id
-        method_encoder[method](send_buf, id, ...)
+        method_encoder[method](send_buf, id, stream_id, ...)
         next_request_id = next_id(id)
         -- Request in most cases has maximum 8 members:
         -- method, buffer, id, cond, errno, response, on_push,
@@ -518,9 +524,10 @@ local function create_transport(host, port, user, password, callback,
     -- @retval not nil Response object.
     --
     local function perform_request(timeout, buffer, method, on_push,
-                                   on_push_ctx, ...)
+                                   on_push_ctx, stream_id, ...)
         local request, err =
-            perform_async_request(buffer, method, on_push, on_push_ctx, ...)
+            perform_async_request(buffer, method, on_push, on_push_ctx,
+                                  stream_id, ...)
         if not request then
             return nil, err
         end
@@ -661,7 +668,7 @@ local function create_transport(host, port, user, password, callback,
             log.warn("Netbox text protocol support is deprecated since 1.10, "..
                      "please use require('console').connect() instead")
             local setup_delimiter = 'require("console").delimiter("$EOF$")\n'
-            method_encoder.inject(send_buf, nil, setup_delimiter)
+            method_encoder.inject(send_buf, nil, nil, setup_delimiter)
             local err, response = send_and_recv_console()
             if err then
                 return error_sm(err, response)
@@ -703,7 +710,7 @@ local function create_transport(host, port, user, password, callback,
             set_state('fetch_schema')
             return iproto_schema_sm()
         end
-        encode_auth(send_buf, new_request_id(), user, password, salt)
+        encode_auth(send_buf, new_request_id(), nil, user, password, salt)
         local err, hdr, body_rpos, body_end = send_and_recv_iproto()
         if err then
             return error_sm(err, hdr)
@@ -726,9 +733,11 @@ local function create_transport(host, port, user, password, callback,
         local select2_id = new_request_id()
         local response = {}
         -- fetch everything from space _vspace, 2 = ITER_ALL
-        encode_select(send_buf, select1_id, VSPACE_ID, 0, 2, 0, 0xFFFFFFFF, nil)
+        encode_select(send_buf, select1_id, nil, VSPACE_ID, 0, 2, 0, 0xFFFFFFFF,
+                      nil)
         -- fetch everything from space _vindex, 2 = ITER_ALL
-        encode_select(send_buf, select2_id, VINDEX_ID, 0, 2, 0, 0xFFFFFFFF, nil)
+        encode_select(send_buf, select2_id, nil, VINDEX_ID, 0, 2, 0, 0xFFFFFFFF,
+                      nil)
         schema_version = nil -- any schema_version will do provided that
                              -- it is consistent across responses
         repeat
@@ -876,6 +885,11 @@ local remote_mt = {
     __metatable = false
 }
 
+local stream_methods = {}
+local stream_mt = {
+    __index = stream_methods, __metatable = false
+}
+
 local console_methods = {}
 local console_mt = {
     __index = console_methods, __serialize = remote_serialize,
@@ -945,6 +959,7 @@ local function new_sm(host, port, opts, connection, greeting)
 
         remote._space_mt = space_metatable(remote)
         remote._index_mt = index_metatable(remote)
+        remote._last_stream_id = 0
         if opts.call_16 then
             remote.call = remote.call_16
             remote.eval = remote.eval_16
@@ -1054,7 +1069,12 @@ function remote_methods:wait_connected(timeout)
     return self._transport.wait_state('active', timeout)
 end
 
-function remote_methods:_request(method, opts, ...)
+--
+-- Send a request on behalf of a connection, optionally bound to
+-- the stream @a stream_id, and wait for the result unless the
+-- request is async.
+--
+local function remote_request(self, method, opts, stream_id, ...)
     local transport = self._transport
     local on_push, on_push_ctx, buffer, deadline
     -- Extract options, set defaults, check if the request is
@@ -1066,7 +1086,7 @@ function remote_methods:_request(method, opts, ...)
                 error('To handle pushes in an async request use future:pairs()')
             end
             return transport.perform_async_request(buffer, method, table.insert,
-                                                   {}, ...)
+                                                   {}, stream_id, ...)
         end
         if opts.timeout then
             -- conn.space:request(, { timeout = timeout })
@@ -1089,7 +1109,8 @@ function remote_methods:_request(method, opts, ...)
         timeout = deadline and max(0, deadline - fiber_clock())
     end
     local res, err = transport.perform_request(timeout, buffer, method,
-                                               on_push, on_push_ctx, ...)
+                                               on_push, on_push_ctx, stream_id,
+                                               ...)
     if err then
         box.error(err)
     end
@@ -1103,6 +1124,10 @@ function remote_methods:_request(method, opts, ...)
     return res
 end
 
+function remote_methods:_request(method, opts, ...)
+    return remote_request(self, method, opts, nil, ...)
+end
+
 function remote_methods:ping(opts)
     check_remote_arg(self, 'ping')
     return (pcall(self._request, self, 'ping', opts))
@@ -1156,6 +1181,88 @@ function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
                          sql_opts or {})
 end
 
+--
+-- Create a stream: a sequence of requests executed by the
+-- server one by one, in the order they were sent. A stream
+-- may hold an interactive transaction started by begin().
+--
+function remote_methods:new_stream()
+    check_remote_arg(self, 'new_stream')
+    self._last_stream_id = self._last_stream_id + 1
+    local stream = setmetatable({
+        stream_id = self._last_stream_id,
+        _conn = self,
+        _spaces = setmetatable({}, {__mode = 'k'}),
+    }, stream_mt)
+    stream._space_mt = space_metatable(stream)
+    stream._index_mt = index_metatable(stream)
+    stream.space = setmetatable({}, {
+        __index = function(_, key)
+            return stream:_get_space(key)
+        end
+    })
+    return stream
+end
+
+function stream_methods:_request(method, opts, ...)
+    return remote_request(self._conn, method, opts, self.stream_id, ...)
+end
+
+--
+-- Wrap a space of the connection so that its requests are
+-- sent via the stream. Wrappers are rebuilt on schema reload.
+--
+function stream_methods:_get_space(key)
+    local space = self._conn.space[key]
+    if space == nil then
+        return nil
+    end
+    local s = self._spaces[space]
+    if s ~= nil then
+        return s
+    end
+    s = setmetatable({}, self._space_mt)
+    for k, v in pairs(space) do
+        s[k] = v
+    end
+    s.connection = self
+    s.index = {}
+    local wrapped = {}
+    for k, index in pairs(space.index) do
+        local idx = wrapped[index]
+        if idx == nil then
+            idx = setmetatable({}, self._index_mt)
+            for ik, iv in pairs(index) do
+                idx[ik] = iv
+            end
+            idx.space = s
+            wrapped[index] = idx
+        end
+        s.index[k] = idx
+    end
+    self._spaces[space] = s
+    return s
+end
+
+function stream_methods:begin(opts)
+    check_remote_arg(self, 'begin')
+    return self:_request('begin', opts)
+end
+
+function stream_methods:commit(opts)
+    check_remote_arg(self, 'commit')
+    return self:_request('commit', opts)
+end
+
+function stream_methods:rollback(opts)
+    check_remote_arg(self, 'rollback')
+    return self:_request('rollback', opts)
+end
+
+stream_methods.call = remote_methods.call
+stream_methods.eval = remote_methods.eval
+stream_methods.execute = remote_methods.execute
+
 function remote_methods:wait_state(state, timeout)
     check_remote_arg(self, 'wait_state')
     if timeout == nil then
@@ -1292,10 +1399,11 @@ function console_methods:eval(line, timeout)
     end
     if self.protocol == 'Binary' then
         local loader = 'return require("console").eval(...)'
-        res, err = pr(timeout, nil, 'eval', nil, nil, loader, {line})
+        res, err = pr(timeout, nil, 'eval', nil, nil, nil, loader, {line})
     else
         assert(self.protocol == 'Lua console')
-        res, err = pr(timeout, nil, 'inject', nil, nil, line..'$EOF$\n')
+        res, err = pr(timeout, nil, 'inject', nil, nil, nil,
+                      line..'$EOF$\n')
     end
     if err then
         box.error(err)
@@ -427,6 +427,7 @@ box.schema.space.create = function(name, options)
         format = 'table',
         is_local = 'boolean',
         temporary = 'boolean',
+        defer_deletes = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -471,6 +472,7 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
+        defer_deletes = options.defer_deletes and true or nil,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -632,7 +634,13 @@ local function update_index_parts(format, parts)
             box.error(box.error.ILLEGAL_PARAMS,
                       "options.parts[" .. i .. "]: field (number) must be one-based")
         end
-        local fmt = format[part.field]
+        if part.path ~= nil and type(part.path) ~= 'string' then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "options.parts[" .. i .. "]: path (string) is expected")
+        end
+        -- Space format describes the root field, not the indexed
+        -- nested one, so don't inherit its type and nullability.
+        local fmt = part.path == nil and format[part.field] or nil
         if part.type == nil then
             if fmt and fmt.type then
                 part.type = fmt.type
@@ -1295,6 +1303,17 @@ base_index_mt.get_luac = function(index, key)
     key = keify(key)
     return internal.get(index.space_id, index.id, key)
 end
+base_index_mt.get_multi = function(index, keys)
+    check_index_arg(index, 'get_multi')
+    if type(keys) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS, "keys must be a table")
+    end
+    local tuple_keys = {}
+    for i, key in ipairs(keys) do
+        tuple_keys[i] = keify(key)
+    end
+    return internal.get_multi(index.space_id, index.id, tuple_keys)
+end
 
 local function check_select_opts(opts, key_is_nil)
     local offset = 0
@@ -1415,6 +1434,10 @@ space_mt.get = function(space, key)
     check_space_arg(space, 'get')
     return check_primary_index(space):get(key)
 end
+space_mt.get_multi = function(space, keys)
+    check_space_arg(space, 'get_multi')
+    return check_primary_index(space):get_multi(keys)
+end
 space_mt.select = function(space, key, opts)
     check_space_arg(space, 'select')
     return check_primary_index(space):select(key, opts)
@@ -221,6 +221,17 @@ lbox_xlog_parser_iterate(struct lua_State *L)
 		lua_pushnumber(L, row.tm);
 		lua_settable(L, -3); /* timestamp */
 	}
+	if (row.tsn != row.lsn || !row.is_commit) {
+		/* A row of a multi-statement transaction. */
+		lbox_xlog_pushkey(L, iproto_key_name(IPROTO_TSN));
+		lua_pushinteger(L, row.tsn);
+		lua_settable(L, -3); /* tsn */
+		if (row.is_commit) {
+			lbox_xlog_pushkey(L, "commit");
+			lua_pushboolean(L, true);
+			lua_settable(L, -3); /* commit */
+		}
+	}
 
 	lua_settable(L, -3); /* HEADER */
 
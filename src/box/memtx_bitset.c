@@ -39,6 +39,8 @@
 #include "fiber.h"
 #include "tuple.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
+#include "txn.h"
 
 #ifndef OLD_GOOD_BITSET
 #include "small/matras.h"
@@ -183,18 +185,22 @@ bitset_index_iterator_next(struct iterator *iterator, struct tuple **ret)
 {
 	assert(iterator->free == bitset_index_iterator_free);
 	struct bitset_index_iterator *it = bitset_index_iterator(iterator);
-
-	size_t value = tt_bitset_iterator_next(&it->bitset_it);
-	if (value == SIZE_MAX) {
-		*ret = NULL;
-		return 0;
-	}
-
+	struct txn *txn = in_txn();
+	do {
+		size_t value = tt_bitset_iterator_next(&it->bitset_it);
+		if (value == SIZE_MAX) {
+			*ret = NULL;
+			return 0;
+		}
 #ifndef OLD_GOOD_BITSET
-	*ret = memtx_bitset_index_value_to_tuple(it->bitset_index, value);
+		*ret = memtx_bitset_index_value_to_tuple(it->bitset_index,
+							 value);
 #else /* #ifndef OLD_GOOD_BITSET */
-	*ret = value_to_tuple(value);
+		*ret = value_to_tuple(value);
 #endif /* #ifndef OLD_GOOD_BITSET */
+		/* Skip tuples invisible to the current transaction. */
+		*ret = memtx_tx_tuple_clarify(txn, iterator->index, *ret);
+	} while (*ret == NULL);
 	return 0;
 }
 
@@ -398,6 +404,13 @@ memtx_bitset_index_count(struct index *base, enum iterator_type type,
 {
 	struct memtx_bitset_index *index = (struct memtx_bitset_index *)base;
 
+	/*
+	 * The bitset doesn't know which of the tuples stored
+	 * in it are visible to the current transaction.
+	 */
+	if (memtx_tx_manager_has_dirty())
+		return generic_index_count(base, type, key, part_count);
+
 	if (type == ITER_ALL)
 		return tt_bitset_index_size(&index->index);
 
@@ -473,8 +486,11 @@ static const struct index_vtab memtx_bitset_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ memtx_bitset_index_count,
 	/* .get = */ generic_index_get,
+	/* .get_multi = */ generic_index_get_multi,
 	/* .replace = */ memtx_bitset_index_replace,
 	/* .create_iterator = */ memtx_bitset_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
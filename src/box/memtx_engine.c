@@ -34,13 +34,18 @@
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
+#include <pmatomic.h>
+#include <unistd.h>
 
 #include "fiber.h"
+#include "fiber_cond.h"
+#include "cbus.h"
 #include "errinj.h"
 #include "coio_file.h"
 #include "tuple.h"
 #include "txn.h"
 #include "memtx_tree.h"
+#include "memtx_tx.h"
 #include "iproto_constants.h"
 #include "xrow.h"
 #include "xstream.h"
@@ -48,6 +53,9 @@
 #include "replication.h"
 #include "schema.h"
 #include "gc.h"
+#include "info.h"
+
+#include <third_party/qsort_arg.h>
 
 /*
  * Memtx yield-in-transaction trigger: roll back the effects
@@ -93,9 +101,13 @@ memtx_init_txn(struct txn *txn)
 	/*
 	 * Memtx doesn't allow yields between statements of
 	 * a transaction. Set a trigger which would roll
-	 * back the transaction if there is a yield.
+	 * back the transaction if there is a yield. With
+	 * the transaction manager, the trigger is only set
+	 * once the transaction changes a space in place,
+	 * see memtx_engine_begin_statement().
 	 */
-	trigger_add(&fiber->on_yield, &txn->fiber_on_yield);
+	if (!memtx_tx_manager_use_mvcc_engine)
+		trigger_add(&fiber->on_yield, &txn->fiber_on_yield);
 	trigger_add(&fiber->on_stop, &txn->fiber_on_stop);
 	/*
 	 * This serves as a marker that the triggers are
@@ -104,18 +116,6 @@ memtx_init_txn(struct txn *txn)
 	txn->engine_tx = txn;
 }
 
-struct memtx_tuple {
-	/*
-	 * sic: the header of the tuple is used
-	 * to store a free list pointer in smfree_delayed.
-	 * Please don't change it without understanding
-	 * how smfree_delayed and snapshotting COW works.
-	 */
-	/** Snapshot generation version. */
-	uint32_t version;
-	struct tuple base;
-};
-
 enum {
 	OBJSIZE_MIN = 16,
 	SLAB_SIZE = 16 * 1024 * 1024,
@@ -130,11 +130,148 @@ memtx_end_build_primary_key(struct space *space, void *param)
 	    memtx_space->replace == memtx_space_replace_all_keys)
 		return 0;
 
-	index_end_build(space->index[0]);
+	if (index_end_build(space->index[0]) != 0)
+		return -1;
 	memtx_space->replace = memtx_space_replace_primary_key;
 	return 0;
 }
 
+/* {{{ Parallel primary key sort */
+
+enum {
+	/**
+	 * Build arrays this large are sorted by qsort_arg() in
+	 * box.cfg.memtx_sort_threads threads on their own, so
+	 * they are left to end_build().
+	 */
+	MEMTX_PK_SORT_MT_THRESHOLD = 128 * 1024,
+};
+
+/**
+ * Primary keys of different spaces filled during the initial
+ * recovery are sorted concurrently by a pool of threads, each
+ * taking the next unsorted primary key until none are left.
+ * The trees are then filled from the sorted arrays on tx,
+ * because index extents come from a single-threaded allocator.
+ */
+struct memtx_pk_sort {
+	/** Memtx engine, to filter out spaces of other engines. */
+	struct engine *engine;
+	/** Primary keys to sort, largest first. */
+	struct memtx_tree_index **indexes;
+	/** Number of primary keys to sort. */
+	int index_count;
+	/** Number of allocated entries in @indexes. */
+	int index_capacity;
+	/** Position of the next primary key to sort. */
+	int next;
+};
+
+static int
+memtx_pk_sort_add(struct space *space, void *param)
+{
+	struct memtx_pk_sort *sort = (struct memtx_pk_sort *)param;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct index *pk = space_index(space, 0);
+	if (space->engine != sort->engine || pk == NULL ||
+	    pk->def->type != TREE ||
+	    memtx_space->replace == memtx_space_replace_all_keys)
+		return 0;
+
+	struct memtx_tree_index *index = (struct memtx_tree_index *)pk;
+	if (index->build_array_size == 0 ||
+	    index->build_array_size >= MEMTX_PK_SORT_MT_THRESHOLD)
+		return 0;
+	if (sort->index_count == sort->index_capacity) {
+		int capacity = MAX(sort->index_capacity * 2, 16);
+		struct memtx_tree_index **indexes =
+			realloc(sort->indexes, capacity * sizeof(*indexes));
+		if (indexes == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*indexes),
+				 "realloc", "primary keys to sort");
+			return -1;
+		}
+		sort->indexes = indexes;
+		sort->index_capacity = capacity;
+	}
+	sort->indexes[sort->index_count++] = index;
+	return 0;
+}
+
+/** Order primary keys by the number of tuples, descending. */
+static int
+memtx_pk_sort_cmp(const void *a, const void *b)
+{
+	size_t size_a = (*(struct memtx_tree_index **)a)->build_array_size;
+	size_t size_b = (*(struct memtx_tree_index **)b)->build_array_size;
+	return size_a < size_b ? 1 : size_a > size_b ? -1 : 0;
+}
+
+static void *
+memtx_pk_sort_f(void *arg)
+{
+	struct memtx_pk_sort *sort = (struct memtx_pk_sort *)arg;
+	int i;
+	while ((i = pm_atomic_fetch_add(&sort->next, 1)) < sort->index_count)
+		memtx_tree_index_sort_build_array(sort->indexes[i]);
+	return NULL;
+}
+
+/**
+ * Sort primary keys of different spaces in parallel before
+ * they are built, see struct memtx_pk_sort. Tx sorts along
+ * with the worker threads. Not being able to start a thread
+ * is not an error: whatever is left unsorted is sorted by
+ * end_build().
+ */
+static void
+memtx_engine_sort_primary_keys(struct memtx_engine *memtx)
+{
+	struct memtx_pk_sort sort;
+	memset(&sort, 0, sizeof(sort));
+	sort.engine = (struct engine *)memtx;
+	if (space_foreach(memtx_pk_sort_add, &sort) != 0) {
+		diag_log();
+		goto out;
+	}
+	int thread_count = memtx->sort_threads;
+	if (thread_count <= 0)
+		thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+	thread_count = MIN(thread_count, sort.index_count);
+	if (thread_count <= 1)
+		goto out;
+
+	qsort(sort.indexes, sort.index_count, sizeof(*sort.indexes),
+	      memtx_pk_sort_cmp);
+	struct cord *workers = calloc(thread_count - 1, sizeof(*workers));
+	int worker_count = 0;
+	if (workers == NULL) {
+		say_warn("failed to allocate primary key sort threads");
+		thread_count = 1;
+	}
+	for (; worker_count < thread_count - 1; worker_count++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "memtx.sort.%d", worker_count);
+		if (cord_start(&workers[worker_count], name,
+			       memtx_pk_sort_f, &sort) != 0) {
+			diag_log();
+			break;
+		}
+	}
+	say_info("sorting primary keys of %d spaces in %d threads",
+		 sort.index_count, worker_count + 1);
+	memtx_pk_sort_f(&sort);
+	for (int i = 0; i < worker_count; i++) {
+		if (cord_join(&workers[i]) != 0)
+			diag_log();
+	}
+	free(workers);
+out:
+	free(sort.indexes);
+}
+
+/* }}} */
+
 /**
  * Secondary indexes are built in bulk after all data is
  * recovered. This function enables secondary keys on a space.
@@ -184,6 +321,7 @@ memtx_engine_shutdown(struct engine *engine)
 		mempool_destroy(&memtx->hash_iterator_pool);
 	if (mempool_is_initialized(&memtx->bitset_iterator_pool))
 		mempool_destroy(&memtx->bitset_iterator_pool);
+	memtx_tx_manager_free();
 	mempool_destroy(&memtx->index_extent_pool);
 	slab_cache_destroy(&memtx->index_slab_cache);
 	small_alloc_destroy(&memtx->alloc);
@@ -197,6 +335,317 @@ static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
 
+static int
+memtx_engine_recover_snapshot_request(struct memtx_engine *memtx,
+				      struct request *request);
+
+/* {{{ Snapshot read-ahead */
+
+enum {
+	/** Max size of row bodies accumulated in one batch. */
+	SNAP_BATCH_SIZE = 4 * 1024 * 1024,
+	/** How many batches the reader may be ahead of tx. */
+	SNAP_BATCH_COUNT = 4,
+};
+
+struct snap_reader;
+
+/**
+ * A batch of snapshot rows read, decompressed and decoded
+ * in the reader thread. The batch shuttles between tx and
+ * the reader: tx submits it to the reader to be filled and
+ * processes it once it is back.
+ */
+struct snap_batch {
+	/** Cbus message, must be first. */
+	struct cmsg base;
+	/** The reader this batch belongs to. */
+	struct snap_reader *reader;
+	/** Decoded rows, bodies point to @data. */
+	struct xrow_header *rows;
+	/** Decoded requests, headers point to @rows. */
+	struct request *requests;
+	/** Number of rows read into the batch. */
+	int row_count;
+	/** Number of successfully decoded requests. */
+	int request_count;
+	/** Number of allocated rows and requests. */
+	int row_capacity;
+	/** Buffer with row bodies. */
+	char *data;
+	/** Number of used bytes in @data. */
+	size_t data_size;
+	/** Allocated size of @data. */
+	size_t data_capacity;
+	/** Set when the batch is back in tx. */
+	bool is_ready;
+	/** Set if there are no more rows in the snapshot. */
+	bool is_eof;
+	/** 0 on success, -1 on error, the error is in @diag. */
+	int rc;
+	struct diag diag;
+};
+
+/**
+ * Snapshot reader. Offloads reading, decompression and
+ * decoding of snapshot rows to a separate thread so that
+ * tx is busy only with building tuples and filling the
+ * primary keys. Rows are delivered to tx in the order they
+ * are stored in the snapshot file.
+ */
+struct snap_reader {
+	/** Thread reading the snapshot. */
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/** Route of a batch: reader -> tx. */
+	struct cmsg_hop route[2];
+	/** Name of the snapshot file. */
+	char filename[PATH_MAX];
+	/** Snapshot cursor, accessed only by the reader thread. */
+	struct xlog_cursor cursor;
+	/** Set when the reader hit EOF or error. Reader-only. */
+	bool is_done;
+	/** Skip invalid rows. */
+	bool force_recovery;
+	/** Signalled every time a batch is returned to tx. */
+	struct fiber_cond cond;
+	/** Batches in flight. */
+	struct snap_batch batches[SNAP_BATCH_COUNT];
+};
+
+/** Append a row to a batch, copying its body. */
+static int
+snap_batch_add_row(struct snap_batch *batch, struct xrow_header *row)
+{
+	if (batch->row_count == batch->row_capacity) {
+		int capacity = MAX(batch->row_capacity * 2, 1024);
+		struct xrow_header *rows = realloc(batch->rows,
+						   capacity * sizeof(*rows));
+		if (rows == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*rows),
+				 "realloc", "snapshot rows");
+			return -1;
+		}
+		batch->rows = rows;
+		struct request *requests = realloc(batch->requests,
+					capacity * sizeof(*requests));
+		if (requests == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*requests),
+				 "realloc", "snapshot requests");
+			return -1;
+		}
+		batch->requests = requests;
+		batch->row_capacity = capacity;
+	}
+	assert(row->bodycnt <= 1);
+	size_t size = row->bodycnt > 0 ? row->body[0].iov_len : 0;
+	if (batch->data_size + size > batch->data_capacity) {
+		size_t capacity = MAX(batch->data_size + size,
+				      (size_t)SNAP_BATCH_SIZE);
+		char *data = realloc(batch->data, capacity);
+		if (data == NULL) {
+			diag_set(OutOfMemory, capacity,
+				 "realloc", "snapshot batch");
+			return -1;
+		}
+		batch->data = data;
+		batch->data_capacity = capacity;
+	}
+	struct xrow_header *copy = &batch->rows[batch->row_count++];
+	*copy = *row;
+	if (size > 0) {
+		memcpy(batch->data + batch->data_size,
+		       row->body[0].iov_base, size);
+		/*
+		 * The data buffer may be reallocated, so store
+		 * the offset for now and fix it up once the batch
+		 * is complete, @sa snap_batch_decode().
+		 */
+		copy->body[0].iov_base = (void *)batch->data_size;
+		batch->data_size += size;
+	}
+	return 0;
+}
+
+/**
+ * Point row bodies to the batch buffer and decode requests.
+ * Invalid rows are skipped in force_recovery mode.
+ */
+static int
+snap_batch_decode(struct snap_batch *batch, bool force_recovery)
+{
+	for (int i = 0; i < batch->row_count; i++) {
+		struct xrow_header *row = &batch->rows[i];
+		if (row->bodycnt > 0) {
+			row->body[0].iov_base = batch->data +
+				(size_t)row->body[0].iov_base;
+		}
+	}
+	for (int i = 0; i < batch->row_count; i++) {
+		struct xrow_header *row = &batch->rows[i];
+		struct request *request =
+			&batch->requests[batch->request_count];
+		if (row->type != IPROTO_INSERT) {
+			diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+				 (uint32_t) row->type);
+		} else if (xrow_decode_dml(row, request,
+				dml_request_key_map(row->type)) == 0) {
+			batch->request_count++;
+			continue;
+		}
+		if (!force_recovery)
+			return -1;
+		say_error("can't apply row: ");
+		diag_log();
+	}
+	return 0;
+}
+
+/** Fill a batch with rows. Called in the reader thread. */
+static void
+snap_batch_read(struct cmsg *base)
+{
+	struct snap_batch *batch = (struct snap_batch *)base;
+	struct snap_reader *reader = batch->reader;
+	if (reader->is_done)
+		goto eof;
+	if (!xlog_cursor_is_open(&reader->cursor) &&
+	    xlog_cursor_open(&reader->cursor, reader->filename) != 0)
+		goto fail;
+
+	struct xrow_header row;
+	while (batch->data_size < SNAP_BATCH_SIZE) {
+		int rc = xlog_cursor_next(&reader->cursor, &row,
+					  reader->force_recovery);
+		if (rc < 0)
+			goto fail;
+		if (rc > 0) {
+			reader->is_done = true;
+			batch->is_eof = true;
+			break;
+		}
+		if (snap_batch_add_row(batch, &row) != 0)
+			goto fail;
+	}
+	if (snap_batch_decode(batch, reader->force_recovery) != 0)
+		goto fail;
+	return;
+fail:
+	batch->rc = -1;
+	diag_move(diag_get(), &batch->diag);
+eof:
+	reader->is_done = true;
+	batch->is_eof = true;
+}
+
+/** Hand a processed batch back to tx. */
+static void
+snap_batch_done(struct cmsg *base)
+{
+	struct snap_batch *batch = (struct snap_batch *)base;
+	batch->is_ready = true;
+	fiber_cond_broadcast(&batch->reader->cond);
+}
+
+/** Send a batch to the reader thread to be filled. */
+static void
+snap_batch_submit(struct snap_batch *batch)
+{
+	struct snap_reader *reader = batch->reader;
+	batch->row_count = 0;
+	batch->request_count = 0;
+	batch->data_size = 0;
+	batch->is_ready = false;
+	batch->is_eof = false;
+	batch->rc = 0;
+	cmsg_init(&batch->base, reader->route);
+	cpipe_push(&reader->reader_pipe, &batch->base);
+}
+
+/** Wait until a batch is back in tx. */
+static void
+snap_batch_wait(struct snap_batch *batch)
+{
+	while (!batch->is_ready)
+		fiber_cond_wait(&batch->reader->cond);
+}
+
+static int
+snap_reader_f(va_list ap)
+{
+	struct snap_reader *reader = va_arg(ap, struct snap_reader *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+	if (xlog_cursor_is_open(&reader->cursor))
+		xlog_cursor_close(&reader->cursor, false);
+	return 0;
+}
+
+/**
+ * Start the reader thread and submit all batches to it
+ * so that it starts reading ahead.
+ */
+static int
+snap_reader_start(struct snap_reader *reader, const char *filename,
+		  bool force_recovery)
+{
+	memset(reader, 0, sizeof(*reader));
+	snprintf(reader->filename, sizeof(reader->filename), "%s", filename);
+	reader->force_recovery = force_recovery;
+	fiber_cond_create(&reader->cond);
+	reader->route[0].f = snap_batch_read;
+	reader->route[0].pipe = &reader->tx_pipe;
+	reader->route[1].f = snap_batch_done;
+	reader->route[1].pipe = NULL;
+	if (cord_costart(&reader->cord, "snap_reader",
+			 snap_reader_f, reader) != 0) {
+		fiber_cond_destroy(&reader->cond);
+		return -1;
+	}
+	cpipe_create(&reader->reader_pipe, "snap_reader");
+	for (int i = 0; i < SNAP_BATCH_COUNT; i++) {
+		struct snap_batch *batch = &reader->batches[i];
+		batch->reader = reader;
+		diag_create(&batch->diag);
+		snap_batch_submit(batch);
+	}
+	return 0;
+}
+
+/**
+ * Wait for batches in flight, stop the reader thread and
+ * free all batches.
+ */
+static void
+snap_reader_stop(struct snap_reader *reader)
+{
+	for (int i = 0; i < SNAP_BATCH_COUNT; i++)
+		snap_batch_wait(&reader->batches[i]);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_cojoin(&reader->cord) != 0)
+		diag_log();
+	for (int i = 0; i < SNAP_BATCH_COUNT; i++) {
+		struct snap_batch *batch = &reader->batches[i];
+		diag_destroy(&batch->diag);
+		free(batch->rows);
+		free(batch->requests);
+		free(batch->data);
+	}
+	fiber_cond_destroy(&reader->cond);
+}
+
+/* }}} */
+
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock)
@@ -208,31 +657,44 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	struct snap_reader reader;
+	if (snap_reader_start(&reader, filename, memtx->force_recovery) != 0)
 		return -1;
 
-	int rc;
-	struct xrow_header row;
+	int rc = 0;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
-		row.lsn = signature;
-		rc = memtx_engine_recover_snapshot_row(memtx, &row);
-		if (rc < 0) {
-			if (!memtx->force_recovery)
-				break;
-			say_error("can't apply row: ");
-			diag_log();
+	for (int i = 0; ; i = (i + 1) % SNAP_BATCH_COUNT) {
+		struct snap_batch *batch = &reader.batches[i];
+		snap_batch_wait(batch);
+		if (batch->rc != 0) {
+			diag_move(&batch->diag, diag_get());
+			rc = -1;
+			break;
 		}
-		++row_count;
-		if (row_count % 100000 == 0) {
-			say_info("%.1fM rows processed",
-				 row_count / 1000000.);
-			fiber_yield_timeout(0);
+		for (int j = 0; j < batch->request_count; j++) {
+			struct request *request = &batch->requests[j];
+			request->header->lsn = signature;
+			rc = memtx_engine_recover_snapshot_request(memtx,
+								   request);
+			if (rc < 0) {
+				if (!memtx->force_recovery)
+					break;
+				say_error("can't apply row: ");
+				diag_log();
+				rc = 0;
+			}
+			++row_count;
+			if (row_count % 100000 == 0) {
+				say_info("%.1fM rows processed",
+					 row_count / 1000000.);
+				fiber_yield_timeout(0);
+			}
 		}
+		if (rc < 0 || batch->is_eof)
+			break;
+		snap_batch_submit(batch);
 	}
-	xlog_cursor_close(&cursor, false);
+	snap_reader_stop(&reader);
 	if (rc < 0)
 		return -1;
 
@@ -241,8 +703,8 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
-		panic("snapshot `%s' has no EOF marker", filename);
+	if (!xlog_cursor_is_eof(&reader.cursor))
+		panic("snapshot `%s' has no EOF marker", reader.filename);
 
 	return 0;
 }
@@ -261,7 +723,14 @@ memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 	struct request request;
 	if (xrow_decode_dml(row, &request, dml_request_key_map(row->type)) != 0)
 		return -1;
-	struct space *space = space_cache_find(request.space_id);
+	return memtx_engine_recover_snapshot_request(memtx, &request);
+}
+
+static int
+memtx_engine_recover_snapshot_request(struct memtx_engine *memtx,
+				      struct request *request)
+{
+	struct space *space = space_cache_find(request->space_id);
 	if (space == NULL)
 		return -1;
 	/* memtx snapshot must contain only memtx spaces */
@@ -270,7 +739,7 @@ memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 		return -1;
 	}
 	/* no access checks here - applier always works with admin privs */
-	if (space_apply_initial_join_row(space, &request) != 0)
+	if (space_apply_initial_join_row(space, request) != 0)
 		return -1;
 	/*
 	 * Don't let gc pool grow too much. Yet to
@@ -312,7 +781,9 @@ memtx_engine_begin_final_recovery(struct engine *engine)
 
 	assert(memtx->state == MEMTX_INITIAL_RECOVERY);
 	/* End of the fast path: loaded the primary key. */
-	space_foreach(memtx_end_build_primary_key, memtx);
+	memtx_engine_sort_primary_keys(memtx);
+	if (space_foreach(memtx_end_build_primary_key, memtx) != 0)
+		return -1;
 
 	if (!memtx->force_recovery) {
 		/*
@@ -368,20 +839,38 @@ static int
 memtx_engine_prepare(struct engine *engine, struct txn *txn)
 {
 	(void)engine;
-	if (txn->engine_tx == 0)
-		return 0;
-	/*
-	 * These triggers are only used for memtx and only
-	 * when autocommit == false, so we are saving
-	 * on calls to trigger_create/trigger_clear.
-	 */
-	trigger_clear(&txn->fiber_on_yield);
-	trigger_clear(&txn->fiber_on_stop);
-	if (txn->is_aborted) {
+	if (txn->engine_tx != NULL) {
+		/*
+		 * These triggers are only used for memtx and only
+		 * when autocommit == false, so we are saving
+		 * on calls to trigger_create/trigger_clear.
+		 */
+		trigger_clear(&txn->fiber_on_yield);
+		trigger_clear(&txn->fiber_on_stop);
+	}
+	if (txn->is_conflicted) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		diag_log();
+		return -1;
+	}
+	if (txn->engine_tx != NULL && txn->is_aborted) {
 		diag_set(ClientError, ER_TRANSACTION_YIELD);
 		diag_log();
 		return -1;
 	}
+	if (memtx_tx_manager_use_mvcc_engine) {
+		/*
+		 * Make the changes visible to everyone. Note,
+		 * the transaction is considered committed from
+		 * now on, although it hasn't been written yet.
+		 */
+		struct txn_stmt *stmt;
+		stailq_foreach_entry(stmt, &txn->stmts, next) {
+			if (stmt->space != NULL &&
+			    memtx_tx_stmt_is_dirty(stmt))
+				memtx_tx_history_prepare_stmt(stmt);
+		}
+	}
 	return 0;
 }
 
@@ -405,10 +894,9 @@ static int
 memtx_engine_begin_statement(struct engine *engine, struct txn *txn)
 {
 	(void)engine;
-	(void)txn;
+	struct space *space = txn_last_stmt(txn)->space;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
 	if (txn->engine_tx == NULL) {
-		struct space *space = txn_last_stmt(txn)->space;
-
 		if (space->def->id > BOX_SYSTEM_ID_MAX &&
 		    ! rlist_empty(&space->on_replace)) {
 			/**
@@ -419,6 +907,17 @@ memtx_engine_begin_statement(struct engine *engine, struct txn *txn)
 			memtx_init_txn(txn);
 		}
 	}
+	if (txn->engine_tx != NULL && memtx_tx_manager_use_mvcc_engine &&
+	    rlist_empty(&txn->fiber_on_yield.link) &&
+	    (!memtx_tx_space_id_is_managed(space->def->id) ||
+	     memtx_space->build != NULL)) {
+		/*
+		 * The statement is going to change the space
+		 * in place, see memtx_space_replace_all_keys(),
+		 * so the transaction can't survive a yield.
+		 */
+		trigger_add(&fiber()->on_yield, &txn->fiber_on_yield);
+	}
 	return 0;
 }
 
@@ -438,6 +937,11 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 	if (stmt->engine_savepoint == NULL)
 		return;
 
+	if (memtx_tx_stmt_is_dirty(stmt)) {
+		memtx_tx_history_rollback_stmt(stmt);
+		goto done;
+	}
+
 	if (memtx_space->replace == memtx_space_replace_all_keys)
 		index_count = space->index_count;
 	else if (memtx_space->replace == memtx_space_replace_primary_key)
@@ -445,6 +949,13 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 	else
 		panic("transaction rolled back during snapshot recovery");
 
+	/*
+	 * The statement is prepared, and transactions which
+	 * are still in progress may have changed the tuples
+	 * it has inserted. Abort them before undoing it.
+	 */
+	memtx_tx_abort_writers(space, txn);
+
 	for (int i = 0; i < index_count; i++) {
 		struct tuple *unused;
 		struct index *index = space->index[i];
@@ -456,7 +967,16 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 			panic("failed to rollback change");
 		}
 	}
-
+	if (memtx_space->build != NULL &&
+	    memtx_build_state_replace(memtx_space->build, stmt->new_tuple,
+				      stmt->old_tuple) != 0) {
+		diag_log();
+		unreachable();
+		panic("failed to rollback change");
+	}
+	if (stmt->new_tuple != NULL)
+		memtx_tx_invalidate_tuple(stmt->new_tuple);
+done:
 	memtx_space_update_bsize(space, stmt->new_tuple, stmt->old_tuple);
 	if (stmt->old_tuple != NULL)
 		tuple_ref(stmt->old_tuple);
@@ -475,6 +995,14 @@ memtx_engine_rollback(struct engine *engine, struct txn *txn)
 	stailq_reverse(&txn->stmts);
 	stailq_foreach_entry(stmt, &txn->stmts, next)
 		memtx_engine_rollback_statement(engine, txn, stmt);
+	memtx_tx_clean_txn(txn);
+}
+
+static void
+memtx_engine_commit(struct engine *engine, struct txn *txn)
+{
+	(void)engine;
+	memtx_tx_clean_txn(txn);
 }
 
 static int
@@ -959,7 +1487,7 @@ static const struct engine_vtab memtx_engine_vtab = {
 	/* .begin = */ memtx_engine_begin,
 	/* .begin_statement = */ memtx_engine_begin_statement,
 	/* .prepare = */ memtx_engine_prepare,
-	/* .commit = */ generic_engine_commit,
+	/* .commit = */ memtx_engine_commit,
 	/* .rollback_statement = */ memtx_engine_rollback_statement,
 	/* .rollback = */ memtx_engine_rollback,
 	/* .bootstrap = */ memtx_engine_bootstrap,
@@ -1080,6 +1608,8 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	memtx->num_reserved_extents = 0;
 	memtx->reserved_extents = NULL;
 
+	memtx_tx_manager_init();
+
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
 	memtx->force_recovery = force_recovery;
@@ -1127,6 +1657,29 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_sort_threads(struct memtx_engine *memtx, int threads)
+{
+	memtx->sort_threads = threads;
+	qsort_arg_set_thread_count(threads);
+}
+
+void
+memtx_engine_stat(struct memtx_engine *memtx, struct info_handler *h)
+{
+	info_begin(h);
+	info_table_begin(h, "build");
+	struct memtx_build_state *build = memtx->build;
+	if (build != NULL) {
+		info_append_str(h, "space", space_name(build->space));
+		info_append_str(h, "index", build->index->def->name);
+		info_append_int(h, "total", build->total);
+		info_append_int(h, "processed", build->processed);
+	}
+	info_table_end(h);
+	info_end(h);
+}
+
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 {
@@ -1160,6 +1713,7 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	struct tuple *tuple = &memtx_tuple->base;
 	tuple->refs = 0;
 	memtx_tuple->version = memtx->snapshot_version;
+	memtx_tuple->is_dirty = 0;
 	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
 	tuple->bsize = tuple_len;
 	tuple->format_id = tuple_format_id(format);
@@ -1318,6 +1872,8 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		const struct key_part *new_part = &new_cmp_def->parts[i];
 		if (old_part->fieldno != new_part->fieldno)
 			return true;
+		if (key_part_path_cmp(old_part, new_part) != 0)
+			return true;
 		if (old_part->coll != new_part->coll)
 			return true;
 	}
@@ -38,6 +38,7 @@
 #include <small/mempool.h>
 
 #include "engine.h"
+#include "tuple.h"
 #include "xlog.h"
 #include "salad/stailq.h"
 
@@ -49,6 +50,8 @@ struct index;
 struct fiber;
 struct tuple;
 struct tuple_format;
+struct info_handler;
+struct memtx_build_state;
 
 /**
  * The state of memtx recovery process.
@@ -127,6 +130,8 @@ struct memtx_engine {
 	void *reserved_extents;
 	/** Maximal allowed tuple size, box.cfg.memtx_max_tuple_size. */
 	size_t max_tuple_size;
+	/** Number of threads for sorting tuples, box.cfg.memtx_sort_threads. */
+	int sort_threads;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
 	/** Memory pool for tree index iterator. */
@@ -147,6 +152,8 @@ struct memtx_engine {
 	 * memtx_gc_task::link.
 	 */
 	struct stailq gc_queue;
+	/** Secondary index build in progress, NULL if none. */
+	struct memtx_build_state *build;
 };
 
 struct memtx_gc_task;
@@ -196,6 +203,44 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+/**
+ * Set the number of threads used for sorting tuples when
+ * building tree indexes, box.cfg.memtx_sort_threads.
+ * 0 means use all available CPU cores.
+ */
+void
+memtx_engine_set_sort_threads(struct memtx_engine *memtx, int threads);
+
+/**
+ * Memtx engine statistics (box.info.memtx()).
+ */
+void
+memtx_engine_stat(struct memtx_engine *memtx, struct info_handler *handler);
+
+struct memtx_tuple {
+	/*
+	 * sic: the header of the tuple is used
+	 * to store a free list pointer in smfree_delayed.
+	 * Please don't change it without understanding
+	 * how smfree_delayed and snapshotting COW works.
+	 */
+	/** Snapshot generation version. */
+	uint32_t version : 31;
+	/**
+	 * Set if the tuple has a story in the memtx transaction
+	 * manager, i.e. it is changed by a transaction which is
+	 * still in progress or is read by one. @sa memtx_tx.h.
+	 */
+	uint32_t is_dirty : 1;
+	struct tuple base;
+};
+
+static inline struct memtx_tuple *
+memtx_tuple(struct tuple *tuple)
+{
+	return container_of(tuple, struct memtx_tuple, base);
+}
+
 /** Allocate a memtx tuple. @sa tuple_new(). */
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
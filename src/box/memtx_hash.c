@@ -34,6 +34,8 @@
 #include "tuple.h"
 #include "tuple_hash.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
+#include "txn.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
@@ -58,8 +60,31 @@ hash_iterator_free(struct iterator *iterator)
 	mempool_free(it->pool, it);
 }
 
+/**
+ * Define an iterator method which calls name##_base() and skips
+ * tuples invisible to the current transaction. If the base
+ * method has switched the iterator to another method, the
+ * latter is used for skipping.
+ */
+#define WRAP_ITERATOR_METHOD(name)					\
+static int								\
+name(struct iterator *iterator, struct tuple **ret)			\
+{									\
+	struct txn *txn = in_txn();					\
+	do {								\
+		int rc = name##_base(iterator, ret);			\
+		if (rc != 0 || *ret == NULL)				\
+			return rc;					\
+		*ret = memtx_tx_tuple_clarify(txn, iterator->index,	\
+					      *ret);			\
+		if (*ret == NULL && iterator->next != name)		\
+			return iterator->next(iterator, ret);		\
+	} while (*ret == NULL);						\
+	return 0;							\
+}
+
 static int
-hash_iterator_ge(struct iterator *ptr, struct tuple **ret)
+hash_iterator_ge_base(struct iterator *ptr, struct tuple **ret)
 {
 	assert(ptr->free == hash_iterator_free);
 	struct hash_iterator *it = (struct hash_iterator *) ptr;
@@ -69,8 +94,10 @@ hash_iterator_ge(struct iterator *ptr, struct tuple **ret)
 	return 0;
 }
 
+WRAP_ITERATOR_METHOD(hash_iterator_ge)
+
 static int
-hash_iterator_gt(struct iterator *ptr, struct tuple **ret)
+hash_iterator_gt_base(struct iterator *ptr, struct tuple **ret)
 {
 	assert(ptr->free == hash_iterator_free);
 	ptr->next = hash_iterator_ge;
@@ -84,6 +111,8 @@ hash_iterator_gt(struct iterator *ptr, struct tuple **ret)
 	return 0;
 }
 
+WRAP_ITERATOR_METHOD(hash_iterator_gt)
+
 static int
 hash_iterator_eq_next(MAYBE_UNUSED struct iterator *it, struct tuple **ret)
 {
@@ -92,12 +121,16 @@ hash_iterator_eq_next(MAYBE_UNUSED struct iterator *it, struct tuple **ret)
 }
 
 static int
-hash_iterator_eq(struct iterator *it, struct tuple **ret)
+hash_iterator_eq_base(struct iterator *it, struct tuple **ret)
 {
 	it->next = hash_iterator_eq_next;
-	return hash_iterator_ge(it, ret);
+	return hash_iterator_ge_base(it, ret);
 }
 
+WRAP_ITERATOR_METHOD(hash_iterator_eq)
+
+#undef WRAP_ITERATOR_METHOD
+
 /* }}} */
 
 /* {{{ MemtxHash -- implementation of all hashes. **********************/
@@ -212,7 +245,8 @@ memtx_hash_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 		rnd++;
 		rnd %= (hash_table->table_size);
 	}
-	*result = light_index_get(hash_table, rnd);
+	*result = memtx_tx_tuple_clarify(in_txn(), base,
+					 light_index_get(hash_table, rnd));
 	return 0;
 }
 
@@ -220,7 +254,7 @@ static ssize_t
 memtx_hash_index_count(struct index *base, enum iterator_type type,
 		       const char *key, uint32_t part_count)
 {
-	if (type == ITER_ALL)
+	if (type == ITER_ALL && !memtx_tx_manager_has_dirty())
 		return memtx_hash_index_size(base); /* optimization */
 	return generic_index_count(base, type, key, part_count);
 }
@@ -238,8 +272,10 @@ memtx_hash_index_get(struct index *base, const char *key,
 	*result = NULL;
 	uint32_t h = key_hash(key, base->def->key_def);
 	uint32_t k = light_index_find_key(&index->hash_table, h, key);
-	if (k != light_index_end)
-		*result = light_index_get(&index->hash_table, k);
+	if (k != light_index_end) {
+		struct tuple *tuple = light_index_get(&index->hash_table, k);
+		*result = memtx_tx_tuple_clarify(in_txn(), base, tuple);
+	}
 	return 0;
 }
 
@@ -358,6 +394,8 @@ struct hash_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct light_index_core *hash_table;
 	struct light_index_iterator iterator;
+	/** Hides tuples which aren't committed yet. */
+	struct memtx_tx_snapshot_cleaner cleaner;
 };
 
 /**
@@ -372,6 +410,7 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
 	light_index_iterator_destroy(it->hash_table, &it->iterator);
+	memtx_tx_snapshot_cleaner_destroy(&it->cleaner);
 	free(iterator);
 }
 
@@ -386,11 +425,16 @@ hash_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 	assert(iterator->free == hash_snapshot_iterator_free);
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
-	struct tuple **res = light_index_iterator_get_and_next(it->hash_table,
-							       &it->iterator);
-	if (res == NULL)
-		return NULL;
-	return tuple_data_range(*res, size);
+	while (true) {
+		struct tuple **res = light_index_iterator_get_and_next(
+			it->hash_table, &it->iterator);
+		if (res == NULL)
+			return NULL;
+		struct tuple *tuple = memtx_tx_snapshot_clarify(&it->cleaner,
+								*res);
+		if (tuple != NULL)
+			return tuple_data_range(tuple, size);
+	}
 }
 
 /**
@@ -409,6 +453,11 @@ memtx_hash_index_create_snapshot_iterator(struct index *base)
 			 "memtx_hash_index", "iterator");
 		return NULL;
 	}
+	if (memtx_tx_snapshot_cleaner_create(&it->cleaner,
+					     base->def->space_id) != 0) {
+		free(it);
+		return NULL;
+	}
 
 	it->base.next = hash_snapshot_iterator_next;
 	it->base.free = hash_snapshot_iterator_free;
@@ -435,8 +484,11 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .random = */ memtx_hash_index_random,
 	/* .count = */ memtx_hash_index_count,
 	/* .get = */ memtx_hash_index_get,
+	/* .get_multi = */ generic_index_get_multi,
 	/* .replace = */ memtx_hash_index_replace,
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		memtx_hash_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
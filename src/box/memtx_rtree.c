@@ -40,6 +40,8 @@
 #include "tuple.h"
 #include "space.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
+#include "txn.h"
 
 /* {{{ Utilities. *************************************************/
 
@@ -138,7 +140,16 @@ static int
 index_rtree_iterator_next(struct iterator *i, struct tuple **ret)
 {
 	struct index_rtree_iterator *itr = (struct index_rtree_iterator *)i;
-	*ret = (struct tuple *)rtree_iterator_next(&itr->impl);
+	struct txn *txn = in_txn();
+	struct tuple *tuple;
+	do {
+		tuple = (struct tuple *)rtree_iterator_next(&itr->impl);
+		if (tuple == NULL)
+			break;
+		/* Skip tuples invisible to the current transaction. */
+		tuple = memtx_tx_tuple_clarify(txn, i->index, tuple);
+	} while (tuple == NULL);
+	*ret = tuple;
 	return 0;
 }
 
@@ -185,7 +196,7 @@ static ssize_t
 memtx_rtree_index_count(struct index *base, enum iterator_type type,
 			const char *key, uint32_t part_count)
 {
-	if (type == ITER_ALL)
+	if (type == ITER_ALL && !memtx_tx_manager_has_dirty())
 		return memtx_rtree_index_size(base); /* optimization */
 	return generic_index_count(base, type, key, part_count);
 }
@@ -203,8 +214,13 @@ memtx_rtree_index_get(struct index *base, const char *key,
 		unreachable();
 
 	*result = NULL;
-	if (rtree_search(&index->tree, &rect, SOP_OVERLAPS, &iterator))
-		*result = (struct tuple *)rtree_iterator_next(&iterator);
+	if (rtree_search(&index->tree, &rect, SOP_OVERLAPS, &iterator)) {
+		struct txn *txn = in_txn();
+		struct tuple *tuple;
+		while (*result == NULL &&
+		       (tuple = rtree_iterator_next(&iterator)) != NULL)
+			*result = memtx_tx_tuple_clarify(txn, base, tuple);
+	}
 	rtree_iterator_destroy(&iterator);
 	return 0;
 }
@@ -315,8 +331,11 @@ static const struct index_vtab memtx_rtree_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ memtx_rtree_index_count,
 	/* .get = */ memtx_rtree_index_get,
+	/* .get_multi = */ generic_index_get_multi,
 	/* .replace = */ memtx_rtree_index_replace,
 	/* .create_iterator = */ memtx_rtree_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
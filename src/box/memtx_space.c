@@ -40,8 +40,10 @@
 #include "memtx_rtree.h"
 #include "memtx_bitset.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
 #include "column_mask.h"
 #include "sequence.h"
+#include "fiber.h"
 
 static void
 memtx_space_destroy(struct space *space)
@@ -242,6 +244,7 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 			     struct tuple **result)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
 	/*
 	 * Ensure we have enough slack memory to guarantee
 	 * successful statement-level rollback.
@@ -251,6 +254,20 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 				       RESERVE_EXTENTS_BEFORE_DELETE) != 0)
 		return -1;
 
+	struct txn *txn = in_txn();
+	if (txn != NULL && memtx_space->build == NULL &&
+	    memtx_tx_space_id_is_managed(space_id(space))) {
+		/*
+		 * Changes of a space which is being altered are
+		 * applied in place, because the index being
+		 * built doesn't know about versions.
+		 */
+		if (memtx_tx_history_add_stmt(txn, space, old_tuple, new_tuple,
+					      mode, &old_tuple) != 0)
+			return -1;
+		goto done;
+	}
+
 	uint32_t i = 0;
 
 	/* Update the primary key */
@@ -275,6 +292,16 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 			goto rollback;
 	}
 
+	/* Update the index being built, if any. */
+	if (memtx_space->build != NULL &&
+	    memtx_build_state_replace(memtx_space->build,
+				      old_tuple, new_tuple) != 0)
+		goto rollback;
+
+	/* Readers of the replaced tuple have read stale data. */
+	if (old_tuple != NULL)
+		memtx_tx_invalidate_tuple(old_tuple);
+done:
 	memtx_space_update_bsize(space, old_tuple, new_tuple);
 	if (new_tuple != NULL)
 		tuple_ref(new_tuple);
@@ -621,6 +648,37 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	if (index_def->key_def->has_json_paths &&
+	    index_def->type != TREE && index_def->type != HASH) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 index_type_strs[index_def->type], "JSON path indexes");
+		return -1;
+	}
+	if (index_def->key_def->is_multikey) {
+		/*
+		 * A multikey index has several entries per tuple,
+		 * so it can't identify a tuple, and the
+		 * transaction manager tracks one entry per tuple
+		 * in each index.
+		 */
+		if (index_def->iid == 0) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "primary key can not be multikey");
+			return -1;
+		}
+		if (index_def->type != TREE) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 index_type_strs[index_def->type],
+				 "multikey indexes");
+			return -1;
+		}
+		if (memtx_tx_manager_use_mvcc_engine) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 "Memtx MVCC engine", "multikey indexes");
+			return -1;
+		}
+	}
 	switch (index_def->type) {
 	case HASH:
 		if (! index_def->opts.is_unique) {
@@ -843,6 +901,104 @@ memtx_init_ephemeral_space(struct space *space)
 	memtx_space_add_primary_key(space);
 }
 
+enum {
+	/**
+	 * Number of tuples inserted into a new index between
+	 * two yields during the index build.
+	 */
+#ifndef NDEBUG
+	/* Smaller value for debug mode to make tests faster. */
+	MEMTX_BUILD_YIELD_LOOPS = 10,
+#else
+	MEMTX_BUILD_YIELD_LOOPS = 1000,
+#endif
+};
+
+int
+memtx_build_state_replace(struct memtx_build_state *state,
+			  struct tuple *old_tuple, struct tuple *new_tuple)
+{
+	struct tuple *tuple = new_tuple != NULL ? new_tuple : old_tuple;
+	assert(tuple != NULL);
+	/*
+	 * Tuples which haven't been scanned yet will be
+	 * inserted by the build itself.
+	 */
+	if (state->cursor == NULL ||
+	    tuple_compare(tuple, state->cursor, state->cmp_def) > 0)
+		return 0;
+	if (new_tuple != NULL && tuple_validate(state->format, new_tuple) != 0)
+		return -1;
+	struct tuple *unused;
+	return index_replace(state->index, old_tuple, new_tuple,
+			     DUP_INSERT, &unused);
+}
+
+/**
+ * Build a secondary index of a space which is in use.
+ * Unlike bulk build, this function yields periodically to let
+ * other fibers make progress. Changes made to the space while
+ * the build is in progress are propagated to the new index by
+ * memtx_build_state_replace(). Requires the primary key to be
+ * a tree, because a tree iterator survives concurrent updates.
+ */
+static int
+memtx_space_build_index_online(struct space *space, struct index *pk,
+			       struct index *new_index,
+			       struct tuple_format *new_format)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
+	assert(memtx_space->build == NULL);
+	assert(pk->def->type == TREE);
+
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+
+	struct memtx_build_state state;
+	state.space = space;
+	state.index = new_index;
+	state.format = new_format;
+	state.cmp_def = pk->def->cmp_def;
+	state.cursor = NULL;
+	state.processed = 0;
+	state.total = index_size(pk);
+	memtx_space->build = &state;
+	memtx->build = &state;
+
+	int rc;
+	struct tuple *tuple;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		rc = tuple_validate(new_format, tuple);
+		if (rc != 0)
+			break;
+		struct tuple *old_tuple;
+		rc = index_replace(new_index, NULL, tuple,
+				   DUP_INSERT, &old_tuple);
+		if (rc != 0)
+			break;
+		assert(old_tuple == NULL); /* Guaranteed by DUP_INSERT. */
+		(void) old_tuple;
+		/*
+		 * From now on all changes of tuples up to this
+		 * one must be propagated to the new index.
+		 */
+		if (state.cursor != NULL)
+			tuple_unref(state.cursor);
+		state.cursor = tuple;
+		tuple_ref(state.cursor);
+		if (++state.processed % MEMTX_BUILD_YIELD_LOOPS == 0)
+			fiber_sleep(0);
+	}
+	iterator_delete(it);
+	if (state.cursor != NULL)
+		tuple_unref(state.cursor);
+	memtx_space->build = NULL;
+	memtx->build = NULL;
+	return rc;
+}
+
 static int
 memtx_space_build_index(struct space *src_space, struct index *new_index,
 			struct tuple_format *new_format)
@@ -867,14 +1023,44 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 		return -1;
 	}
 
+	/*
+	 * Don't block the tx thread while building a secondary
+	 * key of a space in use, unless the space is so small
+	 * that the build wouldn't yield anyway.
+	 */
+	struct memtx_engine *memtx = (struct memtx_engine *)src_space->engine;
+	if (new_index->def->iid != 0 && memtx->state == MEMTX_OK &&
+	    pk->def->type == TREE &&
+	    index_size(pk) > MEMTX_BUILD_YIELD_LOOPS) {
+		return memtx_space_build_index_online(src_space, pk,
+						      new_index, new_format);
+	}
+
 	/* Now deal with any kind of add index during normal operation. */
 	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
 	if (it == NULL)
 		return -1;
 
 	/*
-	 * The index has to be built tuple by tuple, since
-	 * there is no guarantee that all tuples satisfy
+	 * A secondary key is built in bulk: tuples are
+	 * collected, sorted (possibly in multiple threads,
+	 * see box.cfg.memtx_sort_threads) and checked for
+	 * duplicates at once. This is much faster than
+	 * inserting them one by one.
+	 */
+	bool is_bulk = new_index->def->iid != 0;
+	if (is_bulk) {
+		ssize_t n_tuples = index_size(pk);
+		index_begin_build(new_index);
+		if (n_tuples < 0 || (n_tuples > 0 &&
+		    index_reserve(new_index, n_tuples) != 0)) {
+			iterator_delete(it);
+			return -1;
+		}
+	}
+
+	/*
+	 * There is no guarantee that all tuples satisfy
 	 * new index' constraints. If any tuple can not be
 	 * added to the index (insufficient number of fields,
 	 * etc., the build is aborted.
@@ -890,6 +1076,12 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 		rc = tuple_validate(new_format, tuple);
 		if (rc != 0)
 			break;
+		if (is_bulk) {
+			rc = index_build_next(new_index, tuple);
+			if (rc != 0)
+				break;
+			continue;
+		}
 		/*
 		 * @todo: better message if there is a duplicate.
 		 */
@@ -908,6 +1100,8 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 			tuple_ref(tuple);
 	}
 	iterator_delete(it);
+	if (rc == 0 && is_bulk)
+		rc = index_end_build(new_index);
 	return rc;
 }
 
@@ -923,6 +1117,8 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 			 "can not switch temporary flag on a non-empty space");
 		return -1;
 	}
+	if (memtx_tx_on_space_alter(old_space) != 0)
+		return -1;
 
 	new_memtx_space->replace = old_memtx_space->replace;
 	new_memtx_space->bsize = old_memtx_space->bsize;
@@ -1003,5 +1199,6 @@ memtx_space_new(struct memtx_engine *memtx,
 
 	memtx_space->bsize = 0;
 	memtx_space->replace = memtx_space_replace_no_keys;
+	memtx_space->build = NULL;
 	return (struct space *)memtx_space;
 }
@@ -38,6 +38,32 @@ extern "C" {
 
 struct memtx_engine;
 
+/**
+ * State of a secondary index build which yields. While the
+ * build is in progress, changes made to the already scanned
+ * part of the space are propagated to the new index.
+ */
+struct memtx_build_state {
+	/** The space being altered. */
+	struct space *space;
+	/** The index being built. */
+	struct index *index;
+	/** Format to check new tuples against. */
+	struct tuple_format *format;
+	/** Primary key definition used to compare with @cursor. */
+	struct key_def *cmp_def;
+	/**
+	 * The last tuple inserted into the new index by the
+	 * build, referenced. Tuples with greater primary keys
+	 * haven't been scanned yet.
+	 */
+	struct tuple *cursor;
+	/** Number of tuples scanned so far. */
+	int64_t processed;
+	/** Number of tuples in the space when the build started. */
+	int64_t total;
+};
+
 struct memtx_space {
 	struct space base;
 	/* Number of bytes used in memory by tuples in the space. */
@@ -48,8 +74,23 @@ struct memtx_space {
 	 */
 	int (*replace)(struct space *, struct tuple *, struct tuple *,
 		       enum dup_replace_mode, struct tuple **);
+	/** Index build in progress, NULL if none. */
+	struct memtx_build_state *build;
 };
 
+/**
+ * Propagate replacement of @old_tuple with @new_tuple made in
+ * a space to the index being built, if the tuple has already
+ * been scanned by the build. Used both on replace and on
+ * statement rollback.
+ *
+ * @retval  0 success
+ * @retval -1 the new tuple doesn't fit the new index
+ */
+int
+memtx_build_state_replace(struct memtx_build_state *state,
+			  struct tuple *old_tuple, struct tuple *new_tuple);
+
 /**
  * Change binary size of a space subtracting old tuple's size and
  * adding new tuple's size. Used also for rollback by swaping old
@@ -30,12 +30,14 @@
  */
 #include "memtx_tree.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
 #include "memory.h"
 #include "fiber.h"
 #include "tuple.h"
+#include "txn.h"
 #include <third_party/qsort_arg.h>
 #include <small/mempool.h>
 
@@ -44,8 +46,9 @@
 static int
 memtx_tree_qcompare(const void* a, const void *b, void *c)
 {
-	return tuple_compare(*(struct tuple **)a,
-		*(struct tuple **)b, (struct key_def *)c);
+	return memtx_tree_compare((const struct memtx_tree_data *)a,
+				  (const struct memtx_tree_data *)b,
+				  (struct key_def *)c);
 }
 
 /* {{{ MemtxTree Iterators ****************************************/
@@ -56,7 +59,10 @@ struct tree_iterator {
 	struct memtx_tree_iterator tree_iterator;
 	enum iterator_type type;
 	struct memtx_tree_key_data key_data;
-	struct tuple *current_tuple;
+	/** The last returned tuple along with its hint. */
+	struct memtx_tree_data current;
+	/** Number of tuples to skip before the first one. */
+	uint32_t offset;
 	/** Memory pool the iterator was allocated from. */
 	struct mempool *pool;
 };
@@ -75,8 +81,8 @@ static void
 tree_iterator_free(struct iterator *iterator)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	if (it->current_tuple != NULL)
-		tuple_unref(it->current_tuple);
+	if (it->current.tuple != NULL)
+		tuple_unref(it->current.tuple);
 	mempool_free(it->pool, it);
 }
 
@@ -89,116 +95,150 @@ tree_iterator_dummie(struct iterator *iterator, struct tuple **ret)
 }
 
 static int
-tree_iterator_next(struct iterator *iterator, struct tuple **ret)
+tree_iterator_next_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct tuple **res;
+	struct memtx_tree_data *res;
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (check == NULL ||
+	    !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_upper_bound_elem(it->tree, it->current,
 						    NULL);
 	else
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
 	res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (res == NULL) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		it->current = *res;
+		*ret = res->tuple;
+		tuple_ref(*ret);
 	}
 	return 0;
 }
 
 static int
-tree_iterator_prev(struct iterator *iterator, struct tuple **ret)
+tree_iterator_prev_base(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (check == NULL ||
+	    !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_lower_bound_elem(it->tree, it->current,
 						    NULL);
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
+	struct memtx_tree_data *res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		it->current = *res;
+		*ret = res->tuple;
+		tuple_ref(*ret);
 	}
 	return 0;
 }
 
 static int
-tree_iterator_next_equal(struct iterator *iterator, struct tuple **ret)
+tree_iterator_next_equal_base(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check = memtx_tree_iterator_get_elem(it->tree,
 						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	if (check == NULL ||
+	    !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_upper_bound_elem(it->tree, it->current,
 						    NULL);
 	else
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
+	struct memtx_tree_data *res = memtx_tree_iterator_get_elem(it->tree,
 						&it->tree_iterator);
 	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
+	if (!res || memtx_tree_compare_key(res, &it->key_data,
 					   it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		it->current = *res;
+		*ret = res->tuple;
+		tuple_ref(*ret);
 	}
 	return 0;
 }
 
 static int
-tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
+tree_iterator_prev_equal_base(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check = memtx_tree_iterator_get_elem(it->tree,
 						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	if (check == NULL ||
+	    !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_lower_bound_elem(it->tree, it->current,
 						    NULL);
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
+	struct memtx_tree_data *res = memtx_tree_iterator_get_elem(it->tree,
 						&it->tree_iterator);
 	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
+	if (!res || memtx_tree_compare_key(res, &it->key_data,
 					   it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		it->current = *res;
+		*ret = res->tuple;
+		tuple_ref(*ret);
 	}
 	return 0;
 }
 
+/**
+ * Define an iterator method which calls name##_base() and skips
+ * tuples invisible to the current transaction.
+ */
+#define WRAP_ITERATOR_METHOD(name)					\
+static int								\
+name(struct iterator *iterator, struct tuple **ret)			\
+{									\
+	struct txn *txn = in_txn();					\
+	do {								\
+		int rc = name##_base(iterator, ret);			\
+		if (rc != 0 || *ret == NULL)				\
+			return rc;					\
+		*ret = memtx_tx_tuple_clarify(txn, iterator->index,	\
+					      *ret);			\
+	} while (*ret == NULL);						\
+	return 0;							\
+}
+
+WRAP_ITERATOR_METHOD(tree_iterator_next)
+WRAP_ITERATOR_METHOD(tree_iterator_prev)
+WRAP_ITERATOR_METHOD(tree_iterator_next_equal)
+WRAP_ITERATOR_METHOD(tree_iterator_prev_equal)
+
+#undef WRAP_ITERATOR_METHOD
+
 static void
 tree_iterator_set_next_method(struct tree_iterator *it)
 {
-	assert(it->current_tuple != NULL);
+	assert(it->current.tuple != NULL);
 	switch (it->type) {
 	case ITER_EQ:
 		it->base.next = tree_iterator_next_equal;
@@ -223,6 +263,61 @@ tree_iterator_set_next_method(struct tree_iterator *it)
 	}
 }
 
+/**
+ * Position the iterator at the tuple which is it->offset tuples
+ * away from the first tuple matching the search criteria in the
+ * iteration direction. Thanks to subtree sizes stored in the
+ * tree, it takes logarithmic time regardless of the offset.
+ * Return false if there's no such tuple.
+ */
+static bool
+tree_iterator_seek_offset(struct tree_iterator *it)
+{
+	const struct memtx_tree *tree = it->tree;
+	enum iterator_type type = it->type;
+	size_t offset = it->offset;
+	size_t pos;
+	if (it->key_data.key == NULL) {
+		size_t size = memtx_tree_size(tree);
+		if (offset >= size)
+			return false;
+		pos = iterator_type_is_reverse(type) ?
+		      size - 1 - offset : offset;
+	} else if (type == ITER_ALL || type == ITER_EQ ||
+		   type == ITER_GE || type == ITER_LT) {
+		memtx_tree_lower_bound_get_offset(tree, &it->key_data,
+						  NULL, &pos);
+		if (type == ITER_LT) {
+			if (pos <= offset)
+				return false;
+			pos -= offset + 1;
+		} else {
+			pos += offset;
+		}
+	} else { // ITER_GT, ITER_REQ, ITER_LE
+		memtx_tree_upper_bound_get_offset(tree, &it->key_data,
+						  NULL, &pos);
+		if (type == ITER_GT) {
+			pos += offset;
+		} else {
+			if (pos <= offset)
+				return false;
+			pos -= offset + 1;
+		}
+	}
+	it->tree_iterator = memtx_tree_iterator_at(tree, pos);
+	struct memtx_tree_data *res = memtx_tree_iterator_get_elem(tree,
+						&it->tree_iterator);
+	if (res == NULL)
+		return false;
+	/* Check that we haven't skipped past the equal range. */
+	if ((type == ITER_EQ || type == ITER_REQ) &&
+	    memtx_tree_compare_key(res, &it->key_data,
+				   it->index_def->key_def) != 0)
+		return false;
+	return true;
+}
+
 static int
 tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 {
@@ -232,8 +327,11 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 	const struct memtx_tree *tree = it->tree;
 	enum iterator_type type = it->type;
 	bool exact = false;
-	assert(it->current_tuple == NULL);
-	if (it->key_data.key == 0) {
+	assert(it->current.tuple == NULL);
+	if (it->offset != 0) {
+		if (!tree_iterator_seek_offset(it))
+			return 0;
+	} else if (it->key_data.key == 0) {
 		if (iterator_type_is_reverse(it->type))
 			it->tree_iterator = memtx_tree_iterator_last(tree);
 		else
@@ -269,13 +367,17 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 		}
 	}
 
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
+	struct memtx_tree_data *res = memtx_tree_iterator_get_elem(it->tree,
 						&it->tree_iterator);
 	if (!res)
 		return 0;
-	*ret = it->current_tuple = *res;
-	tuple_ref(it->current_tuple);
+	it->current = *res;
+	*ret = res->tuple;
+	tuple_ref(*ret);
 	tree_iterator_set_next_method(it);
+	*ret = memtx_tx_tuple_clarify(in_txn(), iterator->index, *ret);
+	if (*ret == NULL)
+		return iterator->next(iterator, ret);
 	return 0;
 }
 
@@ -328,7 +430,7 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 
 	unsigned int loops = 0;
 	while (!memtx_tree_iterator_is_invalid(itr)) {
-		struct tuple *tuple = *memtx_tree_iterator_get_elem(tree, itr);
+		struct tuple *tuple = memtx_tree_iterator_get_elem(tree, itr)->tuple;
 		memtx_tree_iterator_next(tree, itr);
 		tuple_unref(tuple);
 		if (++loops >= YIELD_LOOPS) {
@@ -390,6 +492,23 @@ memtx_tree_index_depends_on_pk(struct index *base)
 	return !def->opts.is_unique || def->key_def->is_nullable;
 }
 
+static bool
+memtx_tree_index_def_change_requires_rebuild(struct index *base,
+					     const struct index_def *new_def)
+{
+	if (memtx_index_def_change_requires_rebuild(base, new_def))
+		return true;
+	/*
+	 * Hints stored in the tree are calculated according to
+	 * the type of the first key part, so they have to be
+	 * recalculated if the type changes, e.g. from 'unsigned'
+	 * to 'integer' or 'scalar'.
+	 */
+	struct index_def *old_def = base->def;
+	return old_def->key_def->parts[0].type !=
+	       new_def->key_def->parts[0].type;
+}
+
 static ssize_t
 memtx_tree_index_size(struct index *base)
 {
@@ -408,8 +527,9 @@ static int
 memtx_tree_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	struct tuple **res = memtx_tree_random(&index->tree, rnd);
-	*result = res != NULL ? *res : NULL;
+	struct memtx_tree_data *res = memtx_tree_random(&index->tree, rnd);
+	*result = res != NULL ?
+		  memtx_tx_tuple_clarify(in_txn(), base, res->tuple) : NULL;
 	return 0;
 }
 
@@ -417,9 +537,53 @@ static ssize_t
 memtx_tree_index_count(struct index *base, enum iterator_type type,
 		       const char *key, uint32_t part_count)
 {
-	if (type == ITER_ALL)
+	/*
+	 * Dirty tuples may be invisible to the current transaction
+	 * so we have to check every tuple in the range.
+	 */
+	if (memtx_tx_manager_has_dirty())
+		return generic_index_count(base, type, key, part_count);
+	if (type == ITER_ALL || part_count == 0)
 		return memtx_tree_index_size(base); /* optimization */
-	return generic_index_count(base, type, key, part_count);
+	/*
+	 * Count the tuples in logarithmic time as the difference
+	 * between positions of the range bounds in the tree.
+	 */
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_tree_key_data key_data;
+	key_data.key = key;
+	key_data.part_count = part_count;
+	key_data.hint = key_hint(key, part_count,
+				 memtx_tree_index_cmp_def(index));
+	size_t size = memtx_tree_size(&index->tree);
+	size_t lower, upper;
+	switch (type) {
+	case ITER_EQ:
+	case ITER_REQ:
+		memtx_tree_lower_bound_get_offset(&index->tree, &key_data,
+						  NULL, &lower);
+		memtx_tree_upper_bound_get_offset(&index->tree, &key_data,
+						  NULL, &upper);
+		return upper - lower;
+	case ITER_GE:
+		memtx_tree_lower_bound_get_offset(&index->tree, &key_data,
+						  NULL, &lower);
+		return size - lower;
+	case ITER_LT:
+		memtx_tree_lower_bound_get_offset(&index->tree, &key_data,
+						  NULL, &lower);
+		return lower;
+	case ITER_GT:
+		memtx_tree_upper_bound_get_offset(&index->tree, &key_data,
+						  NULL, &upper);
+		return size - upper;
+	case ITER_LE:
+		memtx_tree_upper_bound_get_offset(&index->tree, &key_data,
+						  NULL, &upper);
+		return upper;
+	default:
+		return generic_index_count(base, type, key, part_count);
+	}
 }
 
 static int
@@ -432,8 +596,104 @@ memtx_tree_index_get(struct index *base, const char *key,
 	struct memtx_tree_key_data key_data;
 	key_data.key = key;
 	key_data.part_count = part_count;
-	struct tuple **res = memtx_tree_find(&index->tree, &key_data);
-	*result = res != NULL ? *res : NULL;
+	key_data.hint = key_hint(key, part_count,
+				 memtx_tree_index_cmp_def(index));
+	struct memtx_tree_data *res = memtx_tree_find(&index->tree, &key_data);
+	*result = res != NULL ?
+		  memtx_tx_tuple_clarify(in_txn(), base, res->tuple) : NULL;
+	return 0;
+}
+
+/**
+ * Delete entries of the first @a count array items of a tuple
+ * from a multikey index. Items with equal keys share an entry,
+ * deleting the others is a no-op.
+ */
+static void
+memtx_tree_index_delete_multikey(struct memtx_tree_index *index,
+				 struct tuple *tuple, uint32_t count)
+{
+	struct memtx_tree_data data;
+	data.tuple = tuple;
+	for (uint32_t i = 0; i < count; i++) {
+		data.hint = i;
+		memtx_tree_delete(&index->tree, data);
+	}
+}
+
+/**
+ * Insert an entry per array item of a tuple into a multikey
+ * index. Items with equal keys share an entry. On error the
+ * index is left intact.
+ */
+static int
+memtx_tree_index_insert_multikey(struct memtx_tree_index *index,
+				 struct tuple *tuple)
+{
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	uint32_t count = tuple_multikey_count(tuple, cmp_def);
+	struct memtx_tree_data data, dup_data;
+	data.tuple = tuple;
+	for (uint32_t i = 0; i < count; i++) {
+		data.hint = i;
+		dup_data.tuple = NULL;
+		if (memtx_tree_insert(&index->tree, data, &dup_data) != 0) {
+			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+				 "memtx_tree_index", "replace");
+			memtx_tree_index_delete_multikey(index, tuple, i);
+			return -1;
+		}
+		if (dup_data.tuple == NULL || dup_data.tuple == tuple)
+			continue;
+		/*
+		 * Entries of the old tuple are deleted before the
+		 * new one is inserted, so the duplicate belongs to
+		 * another tuple, which a secondary key can't
+		 * replace.
+		 */
+		memtx_tree_delete(&index->tree, data);
+		memtx_tree_insert(&index->tree, dup_data, NULL);
+		memtx_tree_index_delete_multikey(index, tuple, i);
+		struct space *sp = space_cache_find(index->base.def->space_id);
+		if (sp != NULL)
+			diag_set(ClientError, ER_TUPLE_FOUND,
+				 index->base.def->name, space_name(sp));
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Replace a tuple in a multikey index, which stores an entry
+ * per item of the indexed array of a tuple. A multikey index
+ * is never primary, so it is always updated with DUP_INSERT.
+ */
+static int
+memtx_tree_index_replace_multikey(struct memtx_tree_index *index,
+				  struct tuple *old_tuple,
+				  struct tuple *new_tuple,
+				  enum dup_replace_mode mode,
+				  struct tuple **result)
+{
+	assert(mode == DUP_INSERT);
+	(void) mode;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	uint32_t old_count = 0;
+	if (old_tuple != NULL) {
+		old_count = tuple_multikey_count(old_tuple, cmp_def);
+		memtx_tree_index_delete_multikey(index, old_tuple, old_count);
+	}
+	if (new_tuple != NULL &&
+	    memtx_tree_index_insert_multikey(index, new_tuple) != 0) {
+		struct memtx_tree_data old_data;
+		old_data.tuple = old_tuple;
+		for (uint32_t i = 0; i < old_count; i++) {
+			old_data.hint = i;
+			memtx_tree_insert(&index->tree, old_data, NULL);
+		}
+		return -1;
+	}
+	*result = old_tuple;
 	return 0;
 }
 
@@ -443,12 +703,22 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple **result)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	if (cmp_def->is_multikey) {
+		return memtx_tree_index_replace_multikey(index, old_tuple,
+							 new_tuple, mode,
+							 result);
+	}
 	if (new_tuple) {
-		struct tuple *dup_tuple = NULL;
+		struct memtx_tree_data new_data;
+		new_data.tuple = new_tuple;
+		new_data.hint = tuple_hint(new_tuple, cmp_def);
+		struct memtx_tree_data dup_data;
+		dup_data.tuple = NULL;
 
 		/* Try to optimistically replace the new_tuple. */
 		int tree_res = memtx_tree_insert(&index->tree,
-						 new_tuple, &dup_tuple);
+						 new_data, &dup_data);
 		if (tree_res) {
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "memtx_tree_index", "replace");
@@ -456,24 +726,27 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 		}
 
 		uint32_t errcode = replace_check_dup(old_tuple,
-						     dup_tuple, mode);
+						     dup_data.tuple, mode);
 		if (errcode) {
-			memtx_tree_delete(&index->tree, new_tuple);
-			if (dup_tuple)
-				memtx_tree_insert(&index->tree, dup_tuple, 0);
+			memtx_tree_delete(&index->tree, new_data);
+			if (dup_data.tuple != NULL)
+				memtx_tree_insert(&index->tree, dup_data, NULL);
 			struct space *sp = space_cache_find(base->def->space_id);
 			if (sp != NULL)
 				diag_set(ClientError, errcode, base->def->name,
 					 space_name(sp));
 			return -1;
 		}
-		if (dup_tuple) {
-			*result = dup_tuple;
+		if (dup_data.tuple != NULL) {
+			*result = dup_data.tuple;
 			return 0;
 		}
 	}
 	if (old_tuple) {
-		memtx_tree_delete(&index->tree, old_tuple);
+		struct memtx_tree_data old_data;
+		old_data.tuple = old_tuple;
+		old_data.hint = tuple_hint(old_tuple, cmp_def);
+		memtx_tree_delete(&index->tree, old_data);
 	}
 	*result = old_tuple;
 	return 0;
@@ -515,13 +788,40 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 	it->type = type;
 	it->key_data.key = key;
 	it->key_data.part_count = part_count;
+	it->key_data.hint = key_hint(key, part_count,
+				     memtx_tree_index_cmp_def(index));
 	it->index_def = base->def;
 	it->tree = &index->tree;
 	it->tree_iterator = memtx_tree_invalid_iterator();
-	it->current_tuple = NULL;
+	it->current.tuple = NULL;
+	it->current.hint = HINT_NONE;
+	it->offset = 0;
 	return (struct iterator *)it;
 }
 
+static struct iterator *
+memtx_tree_index_create_iterator_with_offset(struct index *base,
+					     enum iterator_type type,
+					     const char *key,
+					     uint32_t part_count,
+					     uint32_t offset)
+{
+	/*
+	 * Positional access doesn't know which tuples are
+	 * visible to the current transaction, so fall back on
+	 * skipping tuples one by one if there are dirty ones.
+	 */
+	if (offset == 0 || memtx_tx_manager_has_dirty())
+		return generic_index_create_iterator_with_offset(base, type,
+						key, part_count, offset);
+	struct iterator *it = memtx_tree_index_create_iterator(base, type,
+							key, part_count);
+	if (it == NULL)
+		return NULL;
+	tree_iterator(it)->offset = offset;
+	return it;
+}
+
 static void
 memtx_tree_index_begin_build(struct index *base)
 {
@@ -536,8 +836,9 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	if (size_hint < index->build_array_alloc_size)
 		return 0;
-	struct tuple **tmp = (struct tuple **)realloc(index->build_array,
-						      size_hint * sizeof(*tmp));
+	struct memtx_tree_data *tmp =
+		(struct memtx_tree_data *)realloc(index->build_array,
+						  size_hint * sizeof(*tmp));
 	if (tmp == NULL) {
 		diag_set(OutOfMemory, size_hint * sizeof(*tmp),
 			 "memtx_tree_index", "reserve");
@@ -548,25 +849,27 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 	return 0;
 }
 
+/** Append an element to the build array of an index. */
 static int
-memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
+memtx_tree_index_build_array_append(struct memtx_tree_index *index,
+				    struct tuple *tuple, hint_t hint)
 {
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	if (index->build_array == NULL) {
-		index->build_array = (struct tuple **)malloc(MEMTX_EXTENT_SIZE);
+		index->build_array =
+			(struct memtx_tree_data *)malloc(MEMTX_EXTENT_SIZE);
 		if (index->build_array == NULL) {
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "memtx_tree_index", "build_next");
 			return -1;
 		}
 		index->build_array_alloc_size =
-			MEMTX_EXTENT_SIZE / sizeof(struct tuple*);
+			MEMTX_EXTENT_SIZE / sizeof(struct memtx_tree_data);
 	}
 	assert(index->build_array_size <= index->build_array_alloc_size);
 	if (index->build_array_size == index->build_array_alloc_size) {
 		index->build_array_alloc_size = index->build_array_alloc_size +
 					index->build_array_alloc_size / 2;
-		struct tuple **tmp = (struct tuple **)
+		struct memtx_tree_data *tmp = (struct memtx_tree_data *)
 			realloc(index->build_array,
 				index->build_array_alloc_size * sizeof(*tmp));
 		if (tmp == NULL) {
@@ -576,31 +879,121 @@ memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 		}
 		index->build_array = tmp;
 	}
-	index->build_array[index->build_array_size++] = tuple;
+	struct memtx_tree_data *elem =
+		&index->build_array[index->build_array_size++];
+	elem->tuple = tuple;
+	elem->hint = hint;
 	return 0;
 }
 
-static void
-memtx_tree_index_end_build(struct index *base)
+static int
+memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	if (!cmp_def->is_multikey) {
+		return memtx_tree_index_build_array_append(index, tuple,
+						tuple_hint(tuple, cmp_def));
+	}
+	uint32_t count = tuple_multikey_count(tuple, cmp_def);
+	for (uint32_t i = 0; i < count; i++) {
+		if (memtx_tree_index_build_array_append(index, tuple, i) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Leave one entry of each group of equal entries of the same
+ * tuple in the sorted build array of a multikey index. Such
+ * entries come from array items with equal keys.
+ */
+static void
+memtx_tree_index_build_array_dedup(struct memtx_tree_index *index,
+				   struct key_def *cmp_def)
+{
+	if (index->build_array_size == 0)
+		return;
+	size_t w = 1;
+	for (size_t r = 1; r < index->build_array_size; r++) {
+		struct memtx_tree_data *prev = &index->build_array[w - 1];
+		struct memtx_tree_data *cur = &index->build_array[r];
+		if (prev->tuple == cur->tuple &&
+		    memtx_tree_compare(prev, cur, cmp_def) == 0)
+			continue;
+		index->build_array[w++] = *cur;
+	}
+	index->build_array_size = w;
+}
+
+/**
+ * Check that the sorted build array of a unique index doesn't
+ * contain duplicates. Tuples equal in terms of the index cmp def
+ * are adjacent after sorting.
+ */
+static int
+memtx_tree_index_check_build_dup(struct memtx_tree_index *index,
+				 struct key_def *cmp_def)
+{
+	for (size_t i = 1; i < index->build_array_size; i++) {
+		if (memtx_tree_compare(&index->build_array[i - 1],
+				       &index->build_array[i], cmp_def) != 0)
+			continue;
+		uint32_t space_id = index->base.def->space_id;
+		struct space *sp = space_by_id(space_id);
+		diag_set(ClientError, ER_TUPLE_FOUND, index->base.def->name,
+			 sp != NULL ? space_name(sp) : int2str(space_id));
+		return -1;
+	}
+	return 0;
+}
+
+void
+memtx_tree_index_sort_build_array(struct memtx_tree_index *index)
+{
+	/*
+	 * Sorting is the most expensive part of the build,
+	 * it is done in box.cfg.memtx_sort_threads threads.
+	 * The tree itself is then filled in one linear pass.
+	 */
 	qsort_arg(index->build_array, index->build_array_size,
-		  sizeof(struct tuple *),
-		  memtx_tree_qcompare, cmp_def);
-	memtx_tree_build(&index->tree, index->build_array,
-			 index->build_array_size);
+		  sizeof(struct memtx_tree_data),
+		  memtx_tree_qcompare, memtx_tree_index_cmp_def(index));
+	index->build_array_is_sorted = true;
+}
 
+static int
+memtx_tree_index_end_build(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	if (!index->build_array_is_sorted)
+		memtx_tree_index_sort_build_array(index);
+	if (cmp_def->is_multikey)
+		memtx_tree_index_build_array_dedup(index, cmp_def);
+	int rc = 0;
+	if (base->def->opts.is_unique)
+		rc = memtx_tree_index_check_build_dup(index, cmp_def);
+	if (rc == 0 && memtx_tree_build(&index->tree, index->build_array,
+					index->build_array_size) != 0) {
+		diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+			 "memtx_tree_index", "build");
+		rc = -1;
+	}
 	free(index->build_array);
 	index->build_array = NULL;
 	index->build_array_size = 0;
 	index->build_array_alloc_size = 0;
+	index->build_array_is_sorted = false;
+	return rc;
 }
 
 struct tree_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct memtx_tree *tree;
 	struct memtx_tree_iterator tree_iterator;
+	/** Hides tuples which aren't committed yet. */
+	struct memtx_tx_snapshot_cleaner cleaner;
 };
 
 static void
@@ -611,6 +1004,7 @@ tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 		(struct tree_snapshot_iterator *)iterator;
 	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
 	memtx_tree_iterator_destroy(tree, &it->tree_iterator);
+	memtx_tx_snapshot_cleaner_destroy(&it->cleaner);
 	free(iterator);
 }
 
@@ -620,12 +1014,17 @@ tree_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 	assert(iterator->free == tree_snapshot_iterator_free);
 	struct tree_snapshot_iterator *it =
 		(struct tree_snapshot_iterator *)iterator;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (res == NULL)
-		return NULL;
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return tuple_data_range(*res, size);
+	while (true) {
+		struct memtx_tree_data *res = memtx_tree_iterator_get_elem(it->tree,
+							&it->tree_iterator);
+		if (res == NULL)
+			return NULL;
+		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
+		struct tuple *tuple = memtx_tx_snapshot_clarify(&it->cleaner,
+								res->tuple);
+		if (tuple != NULL)
+			return tuple_data_range(tuple, size);
+	}
 }
 
 /**
@@ -644,6 +1043,11 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
 			 "memtx_tree_index", "create_snapshot_iterator");
 		return NULL;
 	}
+	if (memtx_tx_snapshot_cleaner_create(&it->cleaner,
+					     base->def->space_id) != 0) {
+		free(it);
+		return NULL;
+	}
 
 	it->base.free = tree_snapshot_iterator_free;
 	it->base.next = tree_snapshot_iterator_next;
@@ -662,7 +1066,7 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .update_def = */ memtx_tree_index_update_def,
 	/* .depends_on_pk = */ memtx_tree_index_depends_on_pk,
 	/* .def_change_requires_rebuild = */
-		memtx_index_def_change_requires_rebuild,
+		memtx_tree_index_def_change_requires_rebuild,
 	/* .size = */ memtx_tree_index_size,
 	/* .bsize = */ memtx_tree_index_bsize,
 	/* .min = */ generic_index_min,
@@ -670,8 +1074,11 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_multi = */ generic_index_get_multi,
 	/* .replace = */ memtx_tree_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		memtx_tree_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
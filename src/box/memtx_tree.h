@@ -32,9 +32,11 @@
  */
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "index.h"
 #include "memtx_engine.h"
+#include "tuple_compare.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -51,12 +53,69 @@ struct memtx_tree_key_data
 	const char *key;
 	/** Number of msgpacked search fields */
 	uint32_t part_count;
+	/** Comparison hint, see key_hint(). */
+	hint_t hint;
 };
 
+/**
+ * Struct that is used as an element in BPS tree definition.
+ * The hint is stored next to the tuple pointer so that most
+ * comparisons don't need to access tuple data.
+ */
+struct memtx_tree_data {
+	/** Tuple that this node represents. */
+	struct tuple *tuple;
+	/**
+	 * Comparison hint, see tuple_hint(). In a multikey
+	 * index it is the number of the array item the key
+	 * is taken from instead.
+	 */
+	hint_t hint;
+};
+
+/**
+ * Test whether BPS tree elements are identical i.e. represent
+ * the same tuple at the same position in the tree.
+ * @param a - First BPS tree element to compare.
+ * @param b - Second BPS tree element to compare.
+ * @retval true - When elements a and b are identical.
+ * @retval false - Otherwise.
+ */
+static inline bool
+memtx_tree_data_identical(const struct memtx_tree_data *a,
+			  const struct memtx_tree_data *b)
+{
+	return a->tuple == b->tuple && a->hint == b->hint;
+}
+
+/**
+ * BPS tree element comparator.
+ * Defined in header in order to allow compiler to inline it.
+ * @param a - first element to compare.
+ * @param b - second element to compare.
+ * @param def - key definition.
+ * @retval 0  if a == b in terms of def.
+ * @retval <0 if a < b in terms of def.
+ * @retval >0 if a > b in terms of def.
+ */
+static inline int
+memtx_tree_compare(const struct memtx_tree_data *a,
+		   const struct memtx_tree_data *b, struct key_def *def)
+{
+	if (def->is_multikey) {
+		return tuple_compare_multikey(a->tuple, a->hint,
+					      b->tuple, b->hint, def);
+	}
+	int rc = hint_cmp(a->hint, b->hint);
+	if (rc != 0)
+		return rc;
+	return tuple_compare(a->tuple, b->tuple, def);
+}
+
 /**
  * BPS tree element vs key comparator.
  * Defined in header in order to allow compiler to inline it.
- * @param tuple - tuple to compare.
+ * @param element - tree element to compare.
  * @param key_data - key to compare with.
  * @param def - key definition.
  * @retval 0  if tuple == key in terms of def.
@@ -64,22 +123,34 @@ struct memtx_tree_key_data
  * @retval >0 if tuple > key in terms of def.
  */
 static inline int
-memtx_tree_compare_key(const struct tuple *tuple,
+memtx_tree_compare_key(const struct memtx_tree_data *element,
 		       const struct memtx_tree_key_data *key_data,
 		       struct key_def *def)
 {
-	return tuple_compare_with_key(tuple, key_data->key,
+	if (def->is_multikey) {
+		return tuple_compare_with_key_multikey(element->tuple,
+						       element->hint,
+						       key_data->key,
+						       key_data->part_count,
+						       def);
+	}
+	int rc = hint_cmp(element->hint, key_data->hint);
+	if (rc != 0)
+		return rc;
+	return tuple_compare_with_key(element->tuple, key_data->key,
 				      key_data->part_count, def);
 }
 
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg) tuple_compare(a, b, arg)
-#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(a, b, arg)
-#define bps_tree_elem_t struct tuple *
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_compare(&a, &b, arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(&a, b, arg)
+#define BPS_TREE_IDENTICAL(a, b) memtx_tree_data_identical(&a, &b)
+#define bps_tree_elem_t struct memtx_tree_data
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
+#define BPS_INNER_CARD
 
 #include "salad/bps_tree.h"
 
@@ -88,15 +159,19 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #undef BPS_TREE_EXTENT_SIZE
 #undef BPS_TREE_COMPARE
 #undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_IDENTICAL
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
+#undef BPS_INNER_CARD
 
 struct memtx_tree_index {
 	struct index base;
 	struct memtx_tree tree;
-	struct tuple **build_array;
+	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/** Set if build_array was sorted ahead of end_build(). */
+	bool build_array_is_sorted;
 	struct memtx_gc_task gc_task;
 	struct memtx_tree_iterator gc_iterator;
 };
@@ -104,6 +179,15 @@ struct memtx_tree_index {
 struct memtx_tree_index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Sort the tuples accumulated by build_next() so that
+ * end_build() only has to fill the tree. Neither allocates
+ * memory nor accesses the schema, so may be called from any
+ * thread while tx doesn't touch the index.
+ */
+void
+memtx_tree_index_sort_build_array(struct memtx_tree_index *index);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -0,0 +1,720 @@
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_tx.h"
+
+#include <small/mempool.h>
+
+#include "assoc.h"
+#include "diag.h"
+#include "error.h"
+#include "fiber.h"
+#include "say.h"
+#include "schema.h"
+#include "space.h"
+#include "tuple.h"
+#include "txn.h"
+
+bool memtx_tx_manager_use_mvcc_engine = false;
+
+/** Position of a tuple in an index. */
+struct memtx_story_link {
+	/**
+	 * The tuple stored in the same index slot before the
+	 * tuple of the story was inserted there, NULL if the
+	 * slot was empty. Set only while the insertion is not
+	 * prepared.
+	 */
+	struct tuple *older;
+	/** True if the tuple is physically stored in the index. */
+	bool in_index;
+};
+
+/**
+ * History of a tuple. A story exists while the tuple is
+ * inserted or deleted by a transaction which hasn't been
+ * prepared yet or while it is read by an in-progress
+ * transaction.
+ */
+struct memtx_story {
+	/** The tuple, referenced. */
+	struct tuple *tuple;
+	/** ID of the space the tuple belongs to. */
+	uint32_t space_id;
+	/** Transaction that has inserted the tuple, if not prepared. */
+	struct txn *add_txn;
+	/** Transaction that has deleted the tuple, if not prepared. */
+	struct txn *del_txn;
+	/** Transactions that have read the tuple. */
+	struct rlist reader_list;
+	/** Link in memtx_tx_manager::all_stories. */
+	struct rlist in_all_stories;
+	/** Number of elements in @link. */
+	uint32_t index_count;
+	/** Position of the tuple in each index of the space. */
+	struct memtx_story_link link[0];
+};
+
+/** A record of a transaction having read a tuple. */
+struct memtx_tx_read_tracker {
+	/** The transaction. */
+	struct txn *reader;
+	/** The story of the read tuple. */
+	struct memtx_story *story;
+	/** Link in txn::read_set. */
+	struct rlist in_read_set;
+	/** Link in memtx_story::reader_list. */
+	struct rlist in_reader_list;
+};
+
+struct memtx_tx_manager {
+	/** Tuple -> struct memtx_story. */
+	struct mh_i64ptr_t *history;
+	/** List of all stories. */
+	struct rlist all_stories;
+	/**
+	 * Memory pools for stories, indexed by the number of
+	 * indexes in the space. Created on demand.
+	 */
+	struct mempool story_pool[BOX_INDEX_MAX + 1];
+	/** Memory pool for read trackers. */
+	struct mempool read_tracker_pool;
+	/** Number of statements which haven't been prepared. */
+	int64_t dirty_stmt_count;
+};
+
+static struct memtx_tx_manager txm;
+
+void
+memtx_tx_manager_init(void)
+{
+	txm.history = mh_i64ptr_new();
+	if (txm.history == NULL)
+		panic("failed to allocate memtx transaction history");
+	rlist_create(&txm.all_stories);
+	mempool_create(&txm.read_tracker_pool, cord_slab_cache(),
+		       sizeof(struct memtx_tx_read_tracker));
+	txm.dirty_stmt_count = 0;
+}
+
+void
+memtx_tx_manager_free(void)
+{
+	for (uint32_t i = 0; i <= BOX_INDEX_MAX; i++) {
+		if (mempool_is_initialized(&txm.story_pool[i]))
+			mempool_destroy(&txm.story_pool[i]);
+	}
+	mempool_destroy(&txm.read_tracker_pool);
+	mh_i64ptr_delete(txm.history);
+}
+
+bool
+memtx_tx_manager_has_dirty(void)
+{
+	return txm.dirty_stmt_count > 0;
+}
+
+/* {{{ Stories */
+
+static struct memtx_story *
+memtx_tx_story_find(struct tuple *tuple)
+{
+	if (!memtx_tuple(tuple)->is_dirty)
+		return NULL;
+	mh_int_t k = mh_i64ptr_find(txm.history, (uintptr_t)tuple, NULL);
+	assert(k != mh_end(txm.history));
+	return mh_i64ptr_node(txm.history, k)->val;
+}
+
+static struct memtx_story *
+memtx_tx_story_new(struct tuple *tuple, uint32_t space_id,
+		   uint32_t index_count)
+{
+	assert(!memtx_tuple(tuple)->is_dirty);
+	assert(index_count > 0 && index_count <= BOX_INDEX_MAX);
+	size_t size = sizeof(struct memtx_story) +
+		      index_count * sizeof(struct memtx_story_link);
+	struct mempool *pool = &txm.story_pool[index_count];
+	if (!mempool_is_initialized(pool))
+		mempool_create(pool, cord_slab_cache(), size);
+	struct memtx_story *story = mempool_alloc(pool);
+	if (story == NULL) {
+		diag_set(OutOfMemory, size, "mempool", "struct memtx_story");
+		return NULL;
+	}
+	struct mh_i64ptr_node_t node = { (uintptr_t)tuple, story };
+	if (mh_i64ptr_put(txm.history, &node, NULL, NULL) ==
+	    mh_end(txm.history)) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "mh_i64ptr_node_t");
+		mempool_free(pool, story);
+		return NULL;
+	}
+	story->tuple = tuple;
+	tuple_ref(tuple);
+	memtx_tuple(tuple)->is_dirty = 1;
+	story->space_id = space_id;
+	story->add_txn = NULL;
+	story->del_txn = NULL;
+	rlist_create(&story->reader_list);
+	rlist_add_tail_entry(&txm.all_stories, story, in_all_stories);
+	story->index_count = index_count;
+	for (uint32_t i = 0; i < index_count; i++) {
+		story->link[i].older = NULL;
+		story->link[i].in_index = true;
+	}
+	return story;
+}
+
+static void
+memtx_tx_story_delete(struct memtx_story *story)
+{
+	assert(rlist_empty(&story->reader_list));
+	mh_int_t k = mh_i64ptr_find(txm.history,
+				    (uintptr_t)story->tuple, NULL);
+	assert(k != mh_end(txm.history));
+	mh_i64ptr_del(txm.history, k, NULL);
+	rlist_del_entry(story, in_all_stories);
+	memtx_tuple(story->tuple)->is_dirty = 0;
+	tuple_unref(story->tuple);
+	mempool_free(&txm.story_pool[story->index_count], story);
+}
+
+static void
+memtx_tx_read_tracker_delete(struct memtx_tx_read_tracker *tracker)
+{
+	rlist_del_entry(tracker, in_read_set);
+	rlist_del_entry(tracker, in_reader_list);
+	mempool_free(&txm.read_tracker_pool, tracker);
+}
+
+/**
+ * Mark all transactions that have read the tuple of a story,
+ * except @a txn, as conflicted and forget about the reads.
+ */
+static void
+memtx_tx_story_conflict_readers(struct memtx_story *story, struct txn *txn)
+{
+	struct memtx_tx_read_tracker *tracker, *tmp;
+	rlist_foreach_entry_safe(tracker, &story->reader_list,
+				 in_reader_list, tmp) {
+		if (tracker->reader != txn)
+			tracker->reader->is_conflicted = true;
+		memtx_tx_read_tracker_delete(tracker);
+	}
+}
+
+/** Delete a story if nobody needs it anymore. */
+static void
+memtx_tx_story_gc(struct memtx_story *story)
+{
+	if (story->add_txn == NULL && story->del_txn == NULL &&
+	    rlist_empty(&story->reader_list))
+		memtx_tx_story_delete(story);
+}
+
+/**
+ * Find or create the story of a committed tuple which is going
+ * to be changed.
+ */
+static struct memtx_story *
+memtx_tx_story_get(struct tuple *tuple, struct space *space)
+{
+	struct memtx_story *story = memtx_tx_story_find(tuple);
+	if (story != NULL && story->index_count < space->index_count) {
+		/*
+		 * The story was created by a reader while an
+		 * index was being built. It has no history, but
+		 * doesn't have a link for the new index.
+		 */
+		assert(story->add_txn == NULL && story->del_txn == NULL);
+		memtx_tx_story_conflict_readers(story, NULL);
+		memtx_tx_story_delete(story);
+		story = NULL;
+	}
+	if (story == NULL)
+		story = memtx_tx_story_new(tuple, space_id(space),
+					   space->index_count);
+	return story;
+}
+
+/* }}} */
+
+/* {{{ Reads */
+
+/** Remember that @a txn has read @a tuple found in @a index. */
+static void
+memtx_tx_track_read(struct txn *txn, struct index *index,
+		    struct tuple *tuple, struct memtx_story *story)
+{
+	/*
+	 * The read set is released on commit or rollback by the
+	 * engine, so make sure the transaction is bound to it.
+	 */
+	if (txn->engine == NULL &&
+	    txn_begin_in_engine(index->engine, txn) != 0)
+		goto fail;
+	if (txn->engine != index->engine)
+		return;
+	struct memtx_tx_read_tracker *tracker;
+	if (story == NULL) {
+		struct space *space = space_by_id(index->def->space_id);
+		if (space == NULL)
+			goto fail;
+		story = memtx_tx_story_new(tuple, space_id(space),
+					   space->index_count);
+		if (story == NULL)
+			goto fail;
+	} else {
+		rlist_foreach_entry(tracker, &story->reader_list,
+				    in_reader_list) {
+			if (tracker->reader == txn)
+				return;
+		}
+	}
+	tracker = mempool_alloc(&txm.read_tracker_pool);
+	if (tracker == NULL) {
+		diag_set(OutOfMemory, sizeof(*tracker), "mempool",
+			 "struct memtx_tx_read_tracker");
+		memtx_tx_story_gc(story);
+		goto fail;
+	}
+	tracker->reader = txn;
+	tracker->story = story;
+	rlist_add_tail_entry(&txn->read_set, tracker, in_read_set);
+	rlist_add_tail_entry(&story->reader_list, tracker, in_reader_list);
+	return;
+fail:
+	/*
+	 * The read can't be validated at commit, so be
+	 * pessimistic and abort the transaction.
+	 */
+	diag_log();
+	txn->is_conflicted = true;
+}
+
+struct tuple *
+memtx_tx_tuple_clarify_slow(struct txn *txn, struct index *index,
+			    struct tuple *tuple)
+{
+	uint32_t iid = index->def->iid;
+	struct memtx_story *story;
+	while ((story = memtx_tx_story_find(tuple)) != NULL) {
+		if (story->add_txn != NULL && story->add_txn != txn) {
+			/*
+			 * The tuple is inserted by another in-progress
+			 * transaction. Look at the tuple it replaced.
+			 */
+			tuple = iid < story->index_count ?
+				story->link[iid].older : NULL;
+			if (tuple == NULL)
+				return NULL;
+			continue;
+		}
+		if (story->del_txn != NULL && story->del_txn == txn)
+			return NULL;
+		break;
+	}
+	if (txn != NULL && !txn->is_autocommit &&
+	    (story == NULL || story->add_txn == NULL))
+		memtx_tx_track_read(txn, index, tuple, story);
+	return tuple;
+}
+
+void
+memtx_tx_clean_txn(struct txn *txn)
+{
+	struct memtx_tx_read_tracker *tracker, *tmp;
+	rlist_foreach_entry_safe(tracker, &txn->read_set, in_read_set, tmp) {
+		struct memtx_story *story = tracker->story;
+		memtx_tx_read_tracker_delete(tracker);
+		memtx_tx_story_gc(story);
+	}
+}
+
+/* }}} */
+
+/* {{{ Writes */
+
+/**
+ * Find the version of a tuple found in an index slot which is
+ * visible to a transaction going to overwrite the slot. Fails
+ * if the slot is being changed by another transaction.
+ */
+static int
+memtx_tx_check_dup(struct txn *txn, struct tuple *dup,
+		   struct tuple **visible)
+{
+	*visible = dup;
+	if (dup == NULL)
+		return 0;
+	struct memtx_story *story = memtx_tx_story_find(dup);
+	if (story == NULL)
+		return 0;
+	if ((story->add_txn != NULL && story->add_txn != txn) ||
+	    (story->del_txn != NULL && story->del_txn != txn)) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		return -1;
+	}
+	if (story->del_txn == txn)
+		*visible = NULL;
+	return 0;
+}
+
+/**
+ * Remove the tuple of a story from the first @a index_count
+ * indexes of a space, putting back the tuples it replaced.
+ */
+static void
+memtx_tx_story_remove_new(struct memtx_story *story, struct space *space,
+			  uint32_t index_count)
+{
+	for (uint32_t i = 0; i < index_count; i++) {
+		struct tuple *older = story->link[i].older;
+		struct tuple *unused;
+		/* Rollback must not fail. */
+		if (index_replace(space->index[i], story->tuple, older,
+				  DUP_INSERT, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to rollback change");
+		}
+		if (older == NULL)
+			continue;
+		struct memtx_story *older_story = memtx_tx_story_find(older);
+		if (older_story != NULL)
+			older_story->link[i].in_index = true;
+		story->link[i].older = NULL;
+	}
+}
+
+int
+memtx_tx_history_add_stmt(struct txn *txn, struct space *space,
+			  struct tuple *old_tuple, struct tuple *new_tuple,
+			  enum dup_replace_mode mode, struct tuple **result)
+{
+	assert(old_tuple != NULL || new_tuple != NULL);
+	struct memtx_story *add_story = NULL;
+	struct memtx_story *del_story = NULL;
+	if (old_tuple != NULL) {
+		/* The tuple was looked up by the transaction. */
+		struct tuple *visible;
+		if (memtx_tx_check_dup(txn, old_tuple, &visible) != 0)
+			return -1;
+		assert(visible == old_tuple);
+		del_story = memtx_tx_story_get(old_tuple, space);
+		if (del_story == NULL)
+			return -1;
+	}
+	uint32_t i = 0;
+	if (new_tuple == NULL)
+		goto done;
+	add_story = memtx_tx_story_new(new_tuple, space_id(space),
+				       space->index_count);
+	if (add_story == NULL)
+		goto fail;
+	for (i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		struct tuple *dup, *visible;
+		/*
+		 * Old versions stay in the index until the
+		 * statement is prepared, so insert the new tuple
+		 * without deleting anything. If it takes the slot
+		 * of another tuple, the latter is linked to the
+		 * new one so that others can still find it.
+		 */
+		if (index_replace(index, NULL, new_tuple,
+				  DUP_REPLACE_OR_INSERT, &dup) != 0)
+			goto rollback;
+		add_story->link[i].older = dup;
+		if (memtx_tx_check_dup(txn, dup, &visible) != 0)
+			goto rollback_index;
+		if (i == 0 && old_tuple == NULL && visible != NULL) {
+			/* REPLACE of a tuple visible to us. */
+			old_tuple = visible;
+			del_story = memtx_tx_story_get(old_tuple, space);
+			if (del_story == NULL)
+				goto rollback_index;
+		}
+		uint32_t errcode = replace_check_dup(old_tuple, visible,
+						     i == 0 ? mode : DUP_INSERT);
+		if (errcode != 0) {
+			diag_set(ClientError, errcode, index->def->name,
+				 space_name(space));
+			goto rollback_index;
+		}
+		if (dup != NULL) {
+			/*
+			 * It's either the replaced tuple or a tuple
+			 * deleted by this transaction before, so it
+			 * has a story.
+			 */
+			struct memtx_story *dup_story =
+				memtx_tx_story_find(dup);
+			assert(dup_story != NULL);
+			dup_story->link[i].in_index = false;
+		}
+	}
+done:
+	if (del_story != NULL)
+		del_story->del_txn = txn;
+	if (add_story != NULL)
+		add_story->add_txn = txn;
+	txm.dirty_stmt_count++;
+	*result = old_tuple;
+	return 0;
+rollback_index:
+	/* Undo the insertion into the current index as well. */
+	i++;
+rollback:
+	memtx_tx_story_remove_new(add_story, space, i);
+	memtx_tx_story_delete(add_story);
+fail:
+	if (del_story != NULL)
+		memtx_tx_story_gc(del_story);
+	return -1;
+}
+
+bool
+memtx_tx_stmt_is_dirty(struct txn_stmt *stmt)
+{
+	if (!memtx_tx_manager_use_mvcc_engine)
+		return false;
+	struct memtx_story *story;
+	if (stmt->new_tuple != NULL) {
+		story = memtx_tx_story_find(stmt->new_tuple);
+		return story != NULL && story->add_txn != NULL;
+	}
+	if (stmt->old_tuple == NULL)
+		return false;
+	story = memtx_tx_story_find(stmt->old_tuple);
+	return story != NULL && story->del_txn != NULL;
+}
+
+void
+memtx_tx_history_rollback_stmt(struct txn_stmt *stmt)
+{
+	struct space *space = stmt->space;
+	struct memtx_story *story;
+	if (stmt->new_tuple != NULL) {
+		story = memtx_tx_story_find(stmt->new_tuple);
+		assert(story != NULL && story->add_txn != NULL);
+		/* Later statements have been rolled back already. */
+		assert(story->del_txn == NULL);
+		memtx_tx_story_remove_new(story, space,
+					  MIN(story->index_count,
+					      space->index_count));
+		story->add_txn = NULL;
+		memtx_tx_story_conflict_readers(story, NULL);
+		memtx_tx_story_delete(story);
+	}
+	if (stmt->old_tuple != NULL) {
+		story = memtx_tx_story_find(stmt->old_tuple);
+		assert(story != NULL && story->del_txn != NULL);
+		story->del_txn = NULL;
+		memtx_tx_story_gc(story);
+	}
+	assert(txm.dirty_stmt_count > 0);
+	txm.dirty_stmt_count--;
+}
+
+void
+memtx_tx_history_prepare_stmt(struct txn_stmt *stmt)
+{
+	struct space *space = stmt->space;
+	struct memtx_story *story;
+	if (stmt->old_tuple != NULL) {
+		story = memtx_tx_story_find(stmt->old_tuple);
+		assert(story != NULL && story->del_txn != NULL);
+		uint32_t index_count = MIN(story->index_count,
+					   space->index_count);
+		for (uint32_t i = 0; i < index_count; i++) {
+			if (!story->link[i].in_index)
+				continue;
+			struct tuple *unused;
+			if (index_replace(space->index[i], stmt->old_tuple,
+					  NULL, DUP_INSERT, &unused) != 0) {
+				diag_log();
+				unreachable();
+				panic("failed to commit change");
+			}
+			story->link[i].in_index = false;
+		}
+		/* Whoever has read the tuple has read stale data. */
+		memtx_tx_story_conflict_readers(story, story->del_txn);
+		story->del_txn = NULL;
+		memtx_tx_story_delete(story);
+	}
+	if (stmt->new_tuple != NULL) {
+		story = memtx_tx_story_find(stmt->new_tuple);
+		assert(story != NULL && story->add_txn != NULL);
+		/*
+		 * Tuples replaced by this one are deleted by this
+		 * transaction, so they are removed from indexes
+		 * above or by another statement of it.
+		 */
+		story->add_txn = NULL;
+		for (uint32_t i = 0; i < story->index_count; i++)
+			story->link[i].older = NULL;
+		memtx_tx_story_gc(story);
+	}
+	assert(txm.dirty_stmt_count > 0);
+	txm.dirty_stmt_count--;
+}
+
+void
+memtx_tx_invalidate_tuple_slow(struct tuple *tuple)
+{
+	struct memtx_story *story = memtx_tx_story_find(tuple);
+	assert(story != NULL);
+	assert(story->add_txn == NULL && story->del_txn == NULL);
+	memtx_tx_story_conflict_readers(story, NULL);
+	memtx_tx_story_delete(story);
+}
+
+void
+memtx_tx_abort_writers(struct space *space, struct txn *txn)
+{
+	if (!memtx_tx_space_id_is_managed(space_id(space)) ||
+	    txm.dirty_stmt_count == 0)
+		return;
+	struct memtx_story *story;
+restart:
+	rlist_foreach_entry(story, &txm.all_stories, in_all_stories) {
+		if (story->space_id != space_id(space))
+			continue;
+		struct txn *writer = story->add_txn != NULL ?
+				     story->add_txn : story->del_txn;
+		if (writer == NULL || writer == txn)
+			continue;
+		/*
+		 * Rolling back the writer deletes all its stories,
+		 * so start over.
+		 */
+		txn_abort(writer);
+		writer->is_conflicted = true;
+		goto restart;
+	}
+}
+
+int
+memtx_tx_on_space_alter(struct space *space)
+{
+	if (!memtx_tx_space_id_is_managed(space_id(space)))
+		return 0;
+	struct memtx_story *story, *tmp;
+	rlist_foreach_entry(story, &txm.all_stories, in_all_stories) {
+		if (story->space_id == space_id(space) &&
+		    (story->add_txn != NULL || story->del_txn != NULL)) {
+			diag_set(ClientError, ER_ALTER_SPACE,
+				 space_name(space),
+				 "the space has uncommitted changes");
+			return -1;
+		}
+	}
+	rlist_foreach_entry_safe(story, &txm.all_stories,
+				 in_all_stories, tmp) {
+		if (story->space_id != space_id(space))
+			continue;
+		memtx_tx_story_conflict_readers(story, NULL);
+		memtx_tx_story_delete(story);
+	}
+	return 0;
+}
+
+/* }}} */
+
+/* {{{ Snapshot */
+
+int
+memtx_tx_snapshot_cleaner_create(struct memtx_tx_snapshot_cleaner *cleaner,
+				 uint32_t space_id)
+{
+	cleaner->ht = NULL;
+	if (!memtx_tx_space_id_is_managed(space_id) ||
+	    txm.dirty_stmt_count == 0)
+		return 0;
+	struct mh_i64ptr_t *ht = NULL;
+	struct memtx_story *story;
+	rlist_foreach_entry(story, &txm.all_stories, in_all_stories) {
+		/*
+		 * Only uncommitted tuples stored in the primary
+		 * key need to be replaced. Deleted tuples are
+		 * still there and are written as is.
+		 */
+		if (story->space_id != space_id || story->add_txn == NULL ||
+		    !story->link[0].in_index)
+			continue;
+		struct tuple *clean = story->link[0].older;
+		while (clean != NULL) {
+			struct memtx_story *older = memtx_tx_story_find(clean);
+			if (older == NULL || older->add_txn == NULL)
+				break;
+			clean = older->link[0].older;
+		}
+		if (ht == NULL) {
+			ht = mh_i64ptr_new();
+			if (ht == NULL) {
+				diag_set(OutOfMemory, sizeof(*ht),
+					 "mh_i64ptr_new", "snapshot cleaner");
+				return -1;
+			}
+		}
+		struct mh_i64ptr_node_t node = { (uintptr_t)story->tuple,
+						 clean };
+		if (mh_i64ptr_put(ht, &node, NULL, NULL) == mh_end(ht)) {
+			diag_set(OutOfMemory, 0, "mh_i64ptr_put",
+				 "mh_i64ptr_node_t");
+			mh_i64ptr_delete(ht);
+			return -1;
+		}
+	}
+	cleaner->ht = ht;
+	return 0;
+}
+
+struct tuple *
+memtx_tx_snapshot_clarify_slow(struct memtx_tx_snapshot_cleaner *cleaner,
+			       struct tuple *tuple)
+{
+	mh_int_t k = mh_i64ptr_find(cleaner->ht, (uintptr_t)tuple, NULL);
+	if (k == mh_end(cleaner->ht))
+		return tuple;
+	return mh_i64ptr_node(cleaner->ht, k)->val;
+}
+
+void
+memtx_tx_snapshot_cleaner_destroy(struct memtx_tx_snapshot_cleaner *cleaner)
+{
+	if (cleaner->ht != NULL)
+		mh_i64ptr_delete(cleaner->ht);
+	cleaner->ht = NULL;
+}
+
+/* }}} */
@@ -0,0 +1,250 @@
+#ifndef TARANTOOL_BOX_MEMTX_TX_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_TX_H_INCLUDED
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "memtx_engine.h"
+#include "schema_def.h"
+#include "index.h"
+#include "txn.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct space;
+struct tuple;
+struct txn;
+struct txn_stmt;
+struct mh_i64ptr_t;
+
+/**
+ * Memtx transaction manager.
+ *
+ * Without the manager a memtx transaction changes indexes in
+ * place, so its changes are visible to everyone right away, and
+ * it has to be aborted if it yields before commit.
+ *
+ * With the manager (box.cfg.memtx_use_mvcc_engine) a change
+ * made by a transaction which hasn't been prepared yet is
+ * versioned. Indexes still store the newest version of a tuple
+ * while all the versions which are still needed are linked into
+ * a chain of tuple stories, one chain per index slot. Index
+ * lookups and iterators ask the manager for the version of
+ * a found tuple which is visible to the current transaction:
+ * own changes are visible, changes of other in-progress
+ * transactions are not.
+ *
+ * Conflicts are resolved as follows:
+ * - an attempt to change a tuple which is being changed by
+ *   another in-progress transaction fails immediately with
+ *   ER_TRANSACTION_CONFLICT (first writer wins);
+ * - a transaction which has read a tuple that has since been
+ *   overwritten by another transaction fails at commit with
+ *   the same error.
+ *
+ * A transaction is considered committed as soon as it is
+ * prepared, i.e. before it is written to WAL, as in classic
+ * memtx. Gap reads (phantoms) aren't tracked.
+ *
+ * The manager only versions user spaces. Changes of system
+ * spaces are applied in place, and a transaction which has
+ * made them is aborted on yield as before.
+ */
+
+/** box.cfg.memtx_use_mvcc_engine. */
+extern bool memtx_tx_manager_use_mvcc_engine;
+
+/** Initialize the memtx transaction manager. */
+void
+memtx_tx_manager_init(void);
+
+/** Free the memtx transaction manager. */
+void
+memtx_tx_manager_free(void);
+
+/**
+ * Return true if there are statements which haven't been
+ * prepared yet in the transaction manager. Such statements
+ * leave invisible tuples in indexes so index size can't be
+ * used as the number of visible tuples.
+ */
+bool
+memtx_tx_manager_has_dirty(void);
+
+/**
+ * Return true if changes of a space with the given id are
+ * versioned by the transaction manager.
+ */
+static inline bool
+memtx_tx_space_id_is_managed(uint32_t space_id)
+{
+	/* Ephemeral spaces have zero id. */
+	return memtx_tx_manager_use_mvcc_engine &&
+	       space_id > BOX_SYSTEM_ID_MAX;
+}
+
+/**
+ * Replace @a old_tuple with @a new_tuple in all indexes of
+ * @a space on behalf of @a txn, keeping the versions that are
+ * visible to other transactions. Arguments and return value
+ * are the same as of memtx_space_replace_all_keys().
+ */
+int
+memtx_tx_history_add_stmt(struct txn *txn, struct space *space,
+			  struct tuple *old_tuple, struct tuple *new_tuple,
+			  enum dup_replace_mode mode, struct tuple **result);
+
+/**
+ * Return true if a statement has made versioned changes that
+ * haven't been prepared yet.
+ */
+bool
+memtx_tx_stmt_is_dirty(struct txn_stmt *stmt);
+
+/**
+ * Undo a dirty statement. Statements must be rolled back in
+ * the reverse order.
+ */
+void
+memtx_tx_history_rollback_stmt(struct txn_stmt *stmt);
+
+/**
+ * Make changes of a dirty statement visible to everyone and
+ * remove the versions the statement has overwritten from
+ * indexes. Transactions that have read them are marked as
+ * conflicted. Must not fail.
+ */
+void
+memtx_tx_history_prepare_stmt(struct txn_stmt *stmt);
+
+/**
+ * Forget @a tuple, which has been deleted from its space
+ * bypassing the transaction manager. Transactions that have
+ * read it are marked as conflicted.
+ */
+void
+memtx_tx_invalidate_tuple_slow(struct tuple *tuple);
+
+static inline void
+memtx_tx_invalidate_tuple(struct tuple *tuple)
+{
+	if (memtx_tuple(tuple)->is_dirty)
+		memtx_tx_invalidate_tuple_slow(tuple);
+}
+
+/**
+ * Abort all in-progress transactions that have versioned
+ * changes in @a space, except @a txn. Called before changes of
+ * a prepared transaction are rolled back on WAL error, because
+ * in-progress changes may be based on them.
+ */
+void
+memtx_tx_abort_writers(struct space *space, struct txn *txn);
+
+/** Release tuples read by a transaction. */
+void
+memtx_tx_clean_txn(struct txn *txn);
+
+/**
+ * Check if a space may be altered. DDL is not allowed if the
+ * space has uncommitted versioned changes. Transactions that
+ * have read the space are marked as conflicted, because their
+ * reads are no longer tracked after alter.
+ */
+int
+memtx_tx_on_space_alter(struct space *space);
+
+struct tuple *
+memtx_tx_tuple_clarify_slow(struct txn *txn, struct index *index,
+			    struct tuple *tuple);
+
+/**
+ * Return the version of @a tuple, found in @a index, which is
+ * visible to @a txn or NULL if there's no such version. If
+ * @a txn is an interactive transaction, the read is tracked.
+ */
+static inline struct tuple *
+memtx_tx_tuple_clarify(struct txn *txn, struct index *index,
+		       struct tuple *tuple)
+{
+	if (!memtx_tx_space_id_is_managed(index->def->space_id))
+		return tuple;
+	if (!memtx_tuple(tuple)->is_dirty &&
+	    (txn == NULL || txn->is_autocommit))
+		return tuple;
+	return memtx_tx_tuple_clarify_slow(txn, index, tuple);
+}
+
+/**
+ * Helper to write a consistent snapshot of a space while some
+ * transactions have uncommitted changes in it. Maps tuples
+ * which are not committed to their last committed versions.
+ * Created in the tx thread and then used read-only by the
+ * checkpoint thread.
+ */
+struct memtx_tx_snapshot_cleaner {
+	/** Dirty tuple -> committed version, may be NULL. */
+	struct mh_i64ptr_t *ht;
+};
+
+/** Create a snapshot cleaner for the primary key of a space. */
+int
+memtx_tx_snapshot_cleaner_create(struct memtx_tx_snapshot_cleaner *cleaner,
+				 uint32_t space_id);
+
+struct tuple *
+memtx_tx_snapshot_clarify_slow(struct memtx_tx_snapshot_cleaner *cleaner,
+			       struct tuple *tuple);
+
+/**
+ * Return the committed version of a tuple found in a primary
+ * key read view or NULL if the tuple must be skipped.
+ */
+static inline struct tuple *
+memtx_tx_snapshot_clarify(struct memtx_tx_snapshot_cleaner *cleaner,
+			  struct tuple *tuple)
+{
+	if (cleaner->ht == NULL)
+		return tuple;
+	return memtx_tx_snapshot_clarify_slow(cleaner, tuple);
+}
+
+void
+memtx_tx_snapshot_cleaner_destroy(struct memtx_tx_snapshot_cleaner *cleaner);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_MEMTX_TX_H_INCLUDED */
@@ -366,6 +366,9 @@ recovery_finalize(struct recovery *r)
  * Any change to the WAL dir itself or a change in the XLOG
  * file triggers a wakeup. The WAL dir path is set in the
  * constructor. XLOG file path is set with set_log_path().
+ * Rows written over the zeros of a preallocated XLOG file do
+ * not change its size, the wakeup comes from the modification
+ * time change then.
  */
 class WalSubscription {
 public:
@@ -52,6 +52,15 @@
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
+#include "wal_mem.h"
+
+enum {
+	/**
+	 * Approximate size of rows copied from the WAL memory
+	 * buffer at once.
+	 */
+	RELAY_MEM_BATCH_SIZE = 128 * 1024,
+};
 
 /**
  * Cbus message to send status updates from relay to tx thread.
@@ -92,6 +101,18 @@ struct relay {
 	uint64_t sync;
 	/** Recovery instance to read xlog from the disk */
 	struct recovery *r;
+	/**
+	 * Position in the buffer of rows recently written to
+	 * WAL, valid if is_mem_used is set.
+	 */
+	struct wal_mem_cursor mem_cursor;
+	/**
+	 * Set if the relay sends rows from the WAL memory
+	 * buffer rather than reads them from xlog files.
+	 */
+	bool is_mem_used;
+	/** Region to copy rows from the WAL memory buffer to. */
+	struct region mem_region;
 	/** Xstream argument to recovery */
 	struct xstream stream;
 	/** Vclock to stop playing xlogs */
@@ -329,13 +350,16 @@ tx_gc_advance(struct cmsg *msg)
 	free(m);
 }
 
+/**
+ * Queue a request to advance the garbage collector of
+ * the replica to @a vclock.
+ */
 static void
-relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+relay_add_pending_gc(struct relay *relay, const struct vclock *vclock)
 {
 	static const struct cmsg_hop route[] = {
 		{tx_gc_advance, NULL}
 	};
-	struct relay *relay = (struct relay *)trigger->data;
 	struct relay_gc_msg *m = (struct relay_gc_msg *)malloc(sizeof(*m));
 	if (m == NULL) {
 		say_warn("failed to allocate relay gc message");
@@ -343,7 +367,7 @@ relay_on_close_log_f(struct trigger *trigger, void * /* event */)
 	}
 	cmsg_init(&m->msg, route);
 	m->relay = relay;
-	vclock_copy(&m->vclock, &relay->r->vclock);
+	vclock_copy(&m->vclock, vclock);
 	/*
 	 * Do not invoke garbage collection until the replica
 	 * confirms that it has received data stored in the
@@ -352,6 +376,81 @@ relay_on_close_log_f(struct trigger *trigger, void * /* event */)
 	stailq_add_tail_entry(&relay->pending_gc, m, in_pending);
 }
 
+static void
+relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+{
+	struct relay *relay = (struct relay *)trigger->data;
+	relay_add_pending_gc(relay, &relay->r->vclock);
+}
+
+/**
+ * A relay which sends rows from the WAL memory buffer doesn't
+ * close xlog files, so on WAL rotation it collects the files
+ * preceding the one containing the relay position instead.
+ */
+static void
+relay_gc_on_rotate(struct relay *relay)
+{
+	struct recovery *r = relay->r;
+	xdir_scan_xc(&r->wal_dir);
+	struct vclock *clock = vclockset_match(&r->wal_dir.index,
+					       &r->vclock);
+	if (clock != NULL)
+		relay_add_pending_gc(relay, clock);
+}
+
+/**
+ * Send rows the replica doesn't have from the WAL memory
+ * buffer.
+ *
+ * @retval  0 All rows available in the buffer have been sent.
+ * @retval -1 The buffer doesn't have some rows the replica
+ *            needs, they must be read from xlog files.
+ */
+static int
+relay_send_from_mem(struct relay *relay)
+{
+	struct wal_mem *mem = wal_get_mem();
+	struct recovery *r = relay->r;
+	if (!relay->is_mem_used) {
+		if (wal_mem_cursor_create(mem, &relay->mem_cursor,
+					  &r->vclock) != 0)
+			return -1;
+		relay->is_mem_used = true;
+		say_info("sending rows from memory at lsn %lld",
+			 (long long)vclock_sum(&r->vclock));
+	}
+	while (true) {
+		struct xrow_header *rows;
+		int count;
+		if (wal_mem_cursor_next(mem, &relay->mem_cursor,
+					&relay->mem_region,
+					RELAY_MEM_BATCH_SIZE,
+					&rows, &count) != 0) {
+			/* The replica is too far behind. */
+			say_info("rows following lsn %lld are not in memory "
+				 "any more, reading xlog files",
+				 (long long)vclock_sum(&r->vclock));
+			diag_clear(diag_get());
+			relay->is_mem_used = false;
+			region_truncate(&relay->mem_region, 0);
+			return -1;
+		}
+		if (count == 0)
+			break;
+		for (int i = 0; i < count; i++) {
+			struct xrow_header *row = &rows[i];
+			/* Skip rows the replica has, see recover_xlog(). */
+			if (row->lsn <= vclock_get(&r->vclock, row->replica_id))
+				continue;
+			vclock_follow(&r->vclock, row->replica_id, row->lsn);
+			xstream_write_xc(&relay->stream, row);
+		}
+		region_truncate(&relay->mem_region, 0);
+	}
+	return 0;
+}
+
 /**
  * Invoke pending garbage collection requests.
  *
@@ -387,8 +486,22 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
-		recover_remaining_wals(relay->r, &relay->stream, NULL,
-				       (events & WAL_EVENT_ROTATE) != 0);
+		/*
+		 * Read xlog files only if the replica needs rows
+		 * which aren't in memory any more.
+		 */
+		if (relay_send_from_mem(relay) == 0) {
+			if ((events & WAL_EVENT_ROTATE) != 0)
+				relay_gc_on_rotate(relay);
+		} else {
+			/*
+			 * The directory index is kept up to date
+			 * by relay_gc_on_rotate() while the buffer
+			 * is used.
+			 */
+			recover_remaining_wals(relay->r, &relay->stream, NULL,
+					(events & WAL_EVENT_ROTATE) != 0);
+		}
 	} catch (Exception *e) {
 		e->log();
 		diag_move(diag_get(), &relay->diag);
@@ -464,6 +577,8 @@ relay_subscribe_f(va_list ap)
 	struct recovery *r = relay->r;
 
 	coio_enable();
+	relay->is_mem_used = false;
+	region_create(&relay->mem_region, &cord()->slabc);
 	cbus_endpoint_create(&relay->endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
 	cbus_pair("tx", cord_name(cord()), &relay->tx_pipe, &relay->relay_pipe,
@@ -545,6 +660,7 @@ relay_subscribe_f(va_list ap)
 	cbus_unpair(&relay->tx_pipe, &relay->relay_pipe,
 		    NULL, NULL, cbus_process);
 	cbus_endpoint_destroy(&relay->endpoint, cbus_process);
+	region_destroy(&relay->mem_region);
 	if (!diag_is_empty(&relay->diag)) {
 		/* An error has occurred while reading ACKs of xlog. */
 		diag_move(&relay->diag, diag_get());
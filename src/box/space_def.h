@@ -64,6 +64,15 @@ struct space_opts {
 	 * this flag can't be changed after space creation.
 	 */
 	bool is_view;
+	/**
+	 * If set, a REPLACE or DELETE in a vinyl space does not
+	 * look up the old tuple in the primary index in order to
+	 * delete it from secondary indexes. Instead, DELETE
+	 * statements for secondary indexes are generated when
+	 * the primary index is dumped or compacted. The flag
+	 * can't be changed after space creation.
+	 */
+	bool defer_deletes;
 	/** SQL statement that produced this space. */
 	char *sql;
 	/** SQL Checks expressions list. */
@@ -141,6 +141,7 @@ tuple_validate_raw(struct tuple_format *format, const char *tuple)
 	if (format->field_count == 0)
 		return 0; /* Nothing to check */
 
+	const char *data = tuple;
 	/* Check to see if the tuple has a sufficient number of fields. */
 	uint32_t field_count = mp_decode_array(&tuple);
 	if (format->exact_field_count > 0 &&
@@ -168,7 +169,8 @@ tuple_validate_raw(struct tuple_format *format, const char *tuple)
 			return -1;
 		mp_next(&tuple);
 	}
-	return 0;
+	/* Check data indexed by JSON paths. */
+	return tuple_format_validate_paths(format, data);
 }
 
 /** Initialize big references container. */
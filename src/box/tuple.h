@@ -530,6 +530,48 @@ tuple_field(const struct tuple *tuple, uint32_t fieldno)
 			       tuple_field_map(tuple), fieldno);
 }
 
+/**
+ * Get data indexed by a key part.
+ * @param tuple Tuple to get data from.
+ * @param part Key part.
+ * @retval pointer to MessagePack data
+ * @retval NULL when the data is absent
+ * @sa tuple_field_by_part_raw()
+ */
+static inline const char *
+tuple_field_by_part(const struct tuple *tuple, const struct key_part *part)
+{
+	return tuple_field_by_part_raw(tuple_format(tuple), tuple_data(tuple),
+				       tuple_field_map(tuple), part);
+}
+
+/**
+ * Get data indexed by a key part for an item of the array
+ * indexed by a multikey key_def.
+ * @sa tuple_field_by_part_multikey_raw()
+ */
+static inline const char *
+tuple_field_by_part_multikey(const struct tuple *tuple,
+			     const struct key_part *part,
+			     uint32_t multikey_idx)
+{
+	return tuple_field_by_part_multikey_raw(tuple_format(tuple),
+						tuple_data(tuple),
+						tuple_field_map(tuple), part,
+						multikey_idx);
+}
+
+/**
+ * Get the number of keys a tuple has in a multikey index.
+ * @sa tuple_multikey_count_raw()
+ */
+static inline uint32_t
+tuple_multikey_count(const struct tuple *tuple, const struct key_def *key_def)
+{
+	return tuple_multikey_count_raw(tuple_format(tuple), tuple_data(tuple),
+					tuple_field_map(tuple), key_def);
+}
+
 /**
  * Get tuple field by its JSON path.
  * @param tuple Tuple to get field from.
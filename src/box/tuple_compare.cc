@@ -433,8 +433,8 @@ tuple_common_key_parts(const struct tuple *tuple_a,
 	uint32_t i;
 	for (i = 0; i < key_def->part_count; i++) {
 		const struct key_part *part = &key_def->parts[i];
-		const char *field_a = tuple_field(tuple_a, part->fieldno);
-		const char *field_b = tuple_field(tuple_b, part->fieldno);
+		const char *field_a = tuple_field_by_part(tuple_a, part);
+		const char *field_b = tuple_field_by_part(tuple_b, part);
 		enum mp_type a_type = field_a != NULL ?
 				      mp_typeof(*field_a) : MP_NIL;
 		enum mp_type b_type = field_b != NULL ?
@@ -460,7 +460,8 @@ tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
 	const struct key_part *part = key_def->parts;
 	const char *tuple_a_raw = tuple_data(tuple_a);
 	const char *tuple_b_raw = tuple_data(tuple_b);
-	if (key_def->part_count == 1 && part->fieldno == 0) {
+	if (key_def->part_count == 1 && part->fieldno == 0 &&
+	    part->path == NULL) {
 		/*
 		 * First field can not be optional - empty tuples
 		 * can not exist.
@@ -498,10 +499,10 @@ tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
 		end = part + key_def->part_count;
 
 	for (; part < end; part++) {
-		field_a = tuple_field_raw(format_a, tuple_a_raw, field_map_a,
-					  part->fieldno);
-		field_b = tuple_field_raw(format_b, tuple_b_raw, field_map_b,
-					  part->fieldno);
+		field_a = tuple_field_by_part_raw(format_a, tuple_a_raw,
+						  field_map_a, part);
+		field_b = tuple_field_by_part_raw(format_b, tuple_b_raw,
+						  field_map_b, part);
 		assert(has_optional_parts ||
 		       (field_a != NULL && field_b != NULL));
 		if (! is_nullable) {
@@ -548,10 +549,10 @@ tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
 	 */
 	end = key_def->parts + key_def->part_count;
 	for (; part < end; ++part) {
-		field_a = tuple_field_raw(format_a, tuple_a_raw, field_map_a,
-					  part->fieldno);
-		field_b = tuple_field_raw(format_b, tuple_b_raw, field_map_b,
-					  part->fieldno);
+		field_a = tuple_field_by_part_raw(format_a, tuple_a_raw,
+						  field_map_a, part);
+		field_b = tuple_field_by_part_raw(format_b, tuple_b_raw,
+						  field_map_b, part);
 		/*
 		 * Extended parts are primary, and they can not
 		 * be absent or be NULLs.
@@ -583,8 +584,8 @@ tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
 	enum mp_type a_type, b_type;
 	if (likely(part_count == 1)) {
 		const char *field;
-		field = tuple_field_raw(format, tuple_raw, field_map,
-					part->fieldno);
+		field = tuple_field_by_part_raw(format, tuple_raw, field_map,
+						part);
 		if (! is_nullable) {
 			return tuple_compare_field(field, key, part->type,
 						   part->coll);
@@ -609,8 +610,8 @@ tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
 	int rc;
 	for (; part < end; ++part, mp_next(&key)) {
 		const char *field;
-		field = tuple_field_raw(format, tuple_raw, field_map,
-					part->fieldno);
+		field = tuple_field_by_part_raw(format, tuple_raw, field_map,
+						part);
 		if (! is_nullable) {
 			rc = tuple_compare_field(field, key, part->type,
 						 part->coll);
@@ -640,6 +641,93 @@ tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
 	return 0;
 }
 
+/**
+ * Compare a key part of two multikey keys. An absent field is
+ * the same as NULL.
+ * @param[out] was_null_met Set if both parts are NULLs.
+ */
+static inline int
+tuple_compare_part_multikey(const char *field_a, const char *field_b,
+			    const struct key_part *part, bool *was_null_met)
+{
+	enum mp_type a_type = field_a != NULL ? mp_typeof(*field_a) : MP_NIL;
+	enum mp_type b_type = field_b != NULL ? mp_typeof(*field_b) : MP_NIL;
+	if (a_type == MP_NIL) {
+		if (b_type != MP_NIL)
+			return -1;
+		*was_null_met = true;
+		return 0;
+	} else if (b_type == MP_NIL) {
+		return 1;
+	}
+	return tuple_compare_field_with_hint(field_a, a_type, field_b, b_type,
+					     part->type, part->coll);
+}
+
+int
+tuple_compare_multikey(const struct tuple *tuple_a, uint32_t multikey_idx_a,
+		       const struct tuple *tuple_b, uint32_t multikey_idx_b,
+		       const struct key_def *key_def)
+{
+	assert(key_def->is_multikey);
+	bool was_null_met = false;
+	const struct key_part *part = key_def->parts;
+	const struct key_part *end = part + (key_def->is_nullable ?
+					     key_def->unique_part_count :
+					     key_def->part_count);
+	int rc;
+	for (; part < end; part++) {
+		const char *field_a =
+			tuple_field_by_part_multikey(tuple_a, part,
+						     multikey_idx_a);
+		const char *field_b =
+			tuple_field_by_part_multikey(tuple_b, part,
+						     multikey_idx_b);
+		rc = tuple_compare_part_multikey(field_a, field_b, part,
+						 &was_null_met);
+		if (rc != 0)
+			return rc;
+	}
+	/* NULL != NULL unless it is the same tuple, see slowpath. */
+	if (!was_null_met)
+		return 0;
+	end = key_def->parts + key_def->part_count;
+	for (; part < end; part++) {
+		/* Extended parts are primary, never multikey. */
+		rc = tuple_compare_part_multikey(tuple_field_by_part(tuple_a,
+								     part),
+						 tuple_field_by_part(tuple_b,
+								     part),
+						 part, &was_null_met);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+int
+tuple_compare_with_key_multikey(const struct tuple *tuple,
+				uint32_t multikey_idx, const char *key,
+				uint32_t part_count,
+				const struct key_def *key_def)
+{
+	assert(key_def->is_multikey);
+	assert(key != NULL || part_count == 0);
+	assert(part_count <= key_def->part_count);
+	bool was_null_met = false;
+	const struct key_part *part = key_def->parts;
+	const struct key_part *end = part + part_count;
+	for (; part < end; part++, mp_next(&key)) {
+		const char *field = tuple_field_by_part_multikey(tuple, part,
+								 multikey_idx);
+		int rc = tuple_compare_part_multikey(field, key, part,
+						     &was_null_met);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
 template<bool is_nullable>
 static inline int
 key_compare_parts(const char *key_a, const char *key_b, uint32_t part_count,
@@ -838,6 +926,28 @@ field_compare<FIELD_TYPE_UNSIGNED>(const char **field_a, const char **field_b)
 	return mp_compare_uint(*field_a, *field_b);
 }
 
+template <>
+inline int
+field_compare<FIELD_TYPE_INTEGER>(const char **field_a, const char **field_b)
+{
+	return mp_compare_integer_with_hint(*field_a, mp_typeof(**field_a),
+					    *field_b, mp_typeof(**field_b));
+}
+
+template <>
+inline int
+field_compare<FIELD_TYPE_NUMBER>(const char **field_a, const char **field_b)
+{
+	return mp_compare_number(*field_a, *field_b);
+}
+
+template <>
+inline int
+field_compare<FIELD_TYPE_SCALAR>(const char **field_a, const char **field_b)
+{
+	return mp_compare_scalar(*field_a, *field_b);
+}
+
 template <>
 inline int
 field_compare<FIELD_TYPE_STRING>(const char **field_a, const char **field_b)
@@ -851,16 +961,16 @@ field_compare<FIELD_TYPE_STRING>(const char **field_a, const char **field_b)
 	return r;
 }
 
+/**
+ * Compare two fields and advance both pointers past them.
+ * field_compare<TYPE>() doesn't move the pointers for any
+ * type but string, so this is good for everything else.
+ */
 template <int TYPE>
 static inline int
-field_compare_and_next(const char **field_a, const char **field_b);
-
-template <>
-inline int
-field_compare_and_next<FIELD_TYPE_UNSIGNED>(const char **field_a,
-					    const char **field_b)
+field_compare_and_next(const char **field_a, const char **field_b)
 {
-	int r = mp_compare_uint(*field_a, *field_b);
+	int r = field_compare<TYPE>(field_a, field_b);
 	mp_next(field_a);
 	mp_next(field_b);
 	return r;
@@ -986,14 +1096,32 @@ struct comparator_signature {
 
 /**
  * field1 no, field1 type, field2 no, field2 type, ...
+ *
+ * Besides primary keys, the table covers the most common
+ * secondary key layout: one indexed field followed by an
+ * unsigned primary key in field 0, which is what a non-unique
+ * secondary index compares by.
  */
 static const comparator_signature cmp_arr[] = {
 	COMPARATOR(0, FIELD_TYPE_UNSIGNED)
 	COMPARATOR(0, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_INTEGER)
+	COMPARATOR(0, FIELD_TYPE_NUMBER)
+	COMPARATOR(0, FIELD_TYPE_SCALAR)
 	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED)
 	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED)
 	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING)
 	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_INTEGER)
+	COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_INTEGER)
+	COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_INTEGER)
+	COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(1, FIELD_TYPE_INTEGER , 0, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(1, FIELD_TYPE_NUMBER  , 0, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(1, FIELD_TYPE_SCALAR  , 0, FIELD_TYPE_UNSIGNED)
 	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED)
 	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED)
 	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED)
@@ -1006,9 +1134,208 @@ static const comparator_signature cmp_arr[] = {
 
 #undef COMPARATOR
 
+/*
+ * Precompiled comparators for keys with a nullable or collated
+ * first part. The key is either this part alone or the part
+ * followed by an unsigned primary key in field 0, which is
+ * what a nullable or collated secondary index compares by.
+ * The primary key part is never nullable.
+ */
+
+template <int TYPE>
+static inline int
+field_compare_coll(const char *field_a, const char *field_b,
+		   struct coll *coll)
+{
+	/* Only strings and scalars can have a collation. */
+	(void) coll;
+	return field_compare<TYPE>(&field_a, &field_b);
+}
+
+template <>
+inline int
+field_compare_coll<FIELD_TYPE_STRING>(const char *field_a,
+				      const char *field_b, struct coll *coll)
+{
+	return mp_compare_str_coll(field_a, field_b, coll);
+}
+
+template <>
+inline int
+field_compare_coll<FIELD_TYPE_SCALAR>(const char *field_a,
+				      const char *field_b, struct coll *coll)
+{
+	return mp_compare_scalar_coll(field_a, field_b, coll);
+}
+
+/**
+ * Compare the first key part of two tuples or of a tuple and
+ * a key. NULL is less than any value.
+ * @param[out] was_null_met Set if both parts are NULLs.
+ */
+template <int TYPE, bool IS_NULLABLE, bool HAS_COLL>
+static inline int
+first_part_compare(const char *field_a, const char *field_b,
+		   const struct key_def *key_def, bool *was_null_met)
+{
+	if (IS_NULLABLE) {
+		enum mp_type a_type = mp_typeof(*field_a);
+		enum mp_type b_type = mp_typeof(*field_b);
+		if (a_type == MP_NIL) {
+			if (b_type != MP_NIL)
+				return -1;
+			*was_null_met = true;
+			return 0;
+		} else if (b_type == MP_NIL) {
+			return 1;
+		}
+	}
+	if (HAS_COLL) {
+		return field_compare_coll<TYPE>(field_a, field_b,
+						key_def->parts[0].coll);
+	}
+	return field_compare<TYPE>(&field_a, &field_b);
+}
+
+namespace /* local symbols */ {
+
+template <int IDX, int TYPE, bool IS_NULLABLE, bool HAS_COLL>
+struct FirstPartCompare
+{
+	static int compare(const struct tuple *tuple_a,
+			   const struct tuple *tuple_b,
+			   const struct key_def *key_def)
+	{
+		struct tuple_format *format_a = tuple_format(tuple_a);
+		struct tuple_format *format_b = tuple_format(tuple_b);
+		const char *field_a, *field_b;
+		field_a = tuple_field_raw(format_a, tuple_data(tuple_a),
+					  tuple_field_map(tuple_a), IDX);
+		field_b = tuple_field_raw(format_b, tuple_data(tuple_b),
+					  tuple_field_map(tuple_b), IDX);
+		bool was_null_met = false;
+		int r = first_part_compare<TYPE, IS_NULLABLE, HAS_COLL>(
+				field_a, field_b, key_def, &was_null_met);
+		if (r != 0 || key_def->part_count == 1)
+			return r;
+		/*
+		 * Same as in tuple_compare_slowpath(): a unique
+		 * nullable key is extended with the primary key
+		 * only if it contains NULLs.
+		 */
+		if (IS_NULLABLE && !was_null_met &&
+		    key_def->unique_part_count == 1)
+			return 0;
+		field_a = tuple_field_raw(format_a, tuple_data(tuple_a),
+					  tuple_field_map(tuple_a), 0);
+		field_b = tuple_field_raw(format_b, tuple_data(tuple_b),
+					  tuple_field_map(tuple_b), 0);
+		return mp_compare_uint(field_a, field_b);
+	}
+};
+
+template <int IDX, int TYPE, bool IS_NULLABLE, bool HAS_COLL>
+struct FirstPartCompareWithKey
+{
+	static int compare(const struct tuple *tuple, const char *key,
+			   uint32_t part_count,
+			   const struct key_def *key_def)
+	{
+		/* Part count can be 0 in wildcard searches. */
+		if (part_count == 0)
+			return 0;
+		struct tuple_format *format = tuple_format(tuple);
+		const char *field = tuple_field_raw(format, tuple_data(tuple),
+						    tuple_field_map(tuple),
+						    IDX);
+		bool was_null_met = false;
+		int r = first_part_compare<TYPE, IS_NULLABLE, HAS_COLL>(
+				field, key, key_def, &was_null_met);
+		if (r != 0 || part_count == 1)
+			return r;
+		mp_next(&key);
+		field = tuple_field_raw(format, tuple_data(tuple),
+					tuple_field_map(tuple), 0);
+		return mp_compare_uint(field, key);
+	}
+};
+
+} /* end of anonymous namespace */
+
+struct first_part_comparator_signature {
+	tuple_compare_t f;
+	tuple_compare_with_key_t f_with_key;
+	uint32_t fieldno;
+	enum field_type type;
+	bool is_nullable;
+	bool has_coll;
+};
+
+#define FIRST_PART_COMPARATOR(...) \
+	{ FirstPartCompare<__VA_ARGS__>::compare, \
+	  FirstPartCompareWithKey<__VA_ARGS__>::compare, __VA_ARGS__ },
+
+/**
+ * field no, field type, is nullable, has collation
+ *
+ * Keys which are neither nullable nor collated are covered
+ * by cmp_arr and cmp_wk_arr.
+ */
+static const first_part_comparator_signature cmp_first_part_arr[] = {
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_UNSIGNED, true, false)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_STRING  , true, false)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_INTEGER , true, false)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_NUMBER  , true, false)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_SCALAR  , true, false)
+	FIRST_PART_COMPARATOR(0, FIELD_TYPE_STRING  , false, true)
+	FIRST_PART_COMPARATOR(0, FIELD_TYPE_SCALAR  , false, true)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_STRING  , false, true)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_SCALAR  , false, true)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_STRING  , true, true)
+	FIRST_PART_COMPARATOR(1, FIELD_TYPE_SCALAR  , true, true)
+};
+
+#undef FIRST_PART_COMPARATOR
+
+/**
+ * Find a precompiled comparator for a key with a nullable or
+ * collated first part, see cmp_first_part_arr.
+ */
+static const struct first_part_comparator_signature *
+first_part_comparator_lookup(const struct key_def *def)
+{
+	if (def->has_optional_parts || def->has_json_paths)
+		return NULL;
+	const struct key_part *part = &def->parts[0];
+	if (def->part_count == 2) {
+		const struct key_part *pk_part = &def->parts[1];
+		if (pk_part->fieldno != 0 ||
+		    pk_part->type != FIELD_TYPE_UNSIGNED ||
+		    pk_part->coll != NULL ||
+		    key_part_is_nullable(pk_part))
+			return NULL;
+	} else if (def->part_count != 1) {
+		return NULL;
+	}
+	for (uint32_t k = 0; k < lengthof(cmp_first_part_arr); k++) {
+		const struct first_part_comparator_signature *sig =
+			&cmp_first_part_arr[k];
+		if (part->fieldno == sig->fieldno &&
+		    part->type == sig->type &&
+		    key_part_is_nullable(part) == sig->is_nullable &&
+		    (part->coll != NULL) == sig->has_coll)
+			return sig;
+	}
+	return NULL;
+}
+
 tuple_compare_t
 tuple_compare_create(const struct key_def *def)
 {
+	const struct first_part_comparator_signature *sig =
+		first_part_comparator_lookup(def);
+	if (sig != NULL)
+		return sig->f;
 	if (def->is_nullable) {
 		if (key_def_is_sequential(def)) {
 			if (def->has_optional_parts)
@@ -1022,8 +1349,11 @@ tuple_compare_create(const struct key_def *def)
 		}
 	}
 	assert(! def->has_optional_parts);
-	if (!key_def_has_collation(def)) {
-		/* Precalculated comparators don't use collation */
+	if (!key_def_has_collation(def) && !def->has_json_paths) {
+		/*
+		 * Precalculated comparators don't use collation
+		 * and access only top-level fields.
+		 */
 		for (uint32_t k = 0;
 		     k < sizeof(cmp_arr) / sizeof(cmp_arr[0]); k++) {
 			uint32_t i = 0;
@@ -1049,13 +1379,9 @@ tuple_compare_create(const struct key_def *def)
 /* {{{ tuple_compare_with_key */
 
 template <int TYPE>
-static inline int field_compare_with_key(const char **field, const char **key);
-
-template <>
-inline int
-field_compare_with_key<FIELD_TYPE_UNSIGNED>(const char **field, const char **key)
+static inline int field_compare_with_key(const char **field, const char **key)
 {
-	return mp_compare_uint(*field, *key);
+	return field_compare<TYPE>(field, key);
 }
 
 template <>
@@ -1073,17 +1399,9 @@ field_compare_with_key<FIELD_TYPE_STRING>(const char **field, const char **key)
 
 template <int TYPE>
 static inline int
-field_compare_with_key_and_next(const char **field_a, const char **field_b);
-
-template <>
-inline int
-field_compare_with_key_and_next<FIELD_TYPE_UNSIGNED>(const char **field_a,
-						     const char **field_b)
+field_compare_with_key_and_next(const char **field_a, const char **field_b)
 {
-	int r = mp_compare_uint(*field_a, *field_b);
-	mp_next(field_a);
-	mp_next(field_b);
-	return r;
+	return field_compare_and_next<TYPE>(field_a, field_b);
 }
 
 template <>
@@ -1215,10 +1533,24 @@ static const comparator_with_key_signature cmp_wk_arr[] = {
 	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING)
 	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING)
 
+	KEY_COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_INTEGER)
+	KEY_COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_INTEGER)
+	KEY_COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_INTEGER)
+	KEY_COMPARATOR(0, FIELD_TYPE_NUMBER)
+	KEY_COMPARATOR(0, FIELD_TYPE_SCALAR)
+
 	KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED)
 	KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED)
 	KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING)
 	KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING)
+
+	KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(1, FIELD_TYPE_INTEGER , 0, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(1, FIELD_TYPE_NUMBER  , 0, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(1, FIELD_TYPE_SCALAR  , 0, FIELD_TYPE_UNSIGNED)
 };
 
 #undef KEY_COMPARATOR
@@ -1226,6 +1558,10 @@ static const comparator_with_key_signature cmp_wk_arr[] = {
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *def)
 {
+	const struct first_part_comparator_signature *sig =
+		first_part_comparator_lookup(def);
+	if (sig != NULL)
+		return sig->f_with_key;
 	if (def->is_nullable) {
 		if (key_def_is_sequential(def)) {
 			if (def->has_optional_parts) {
@@ -1242,8 +1578,11 @@ tuple_compare_with_key_create(const struct key_def *def)
 		}
 	}
 	assert(! def->has_optional_parts);
-	if (!key_def_has_collation(def)) {
-		/* Precalculated comparators don't use collation */
+	if (!key_def_has_collation(def) && !def->has_json_paths) {
+		/*
+		 * Precalculated comparators don't use collation
+		 * and access only top-level fields.
+		 */
 		for (uint32_t k = 0;
 		     k < sizeof(cmp_wk_arr) / sizeof(cmp_wk_arr[0]);
 		     k++) {
@@ -1268,3 +1607,232 @@ tuple_compare_with_key_create(const struct key_def *def)
 }
 
 /* }}} tuple_compare_with_key */
+
+/* {{{ tuple_hint */
+
+/**
+ * A comparison hint is computed from the first key part as
+ * follows. The field value is mapped to a 64-bit integer
+ * (ordinal) so that the order of ordinals matches the order
+ * of values, then the ordinal is shifted right by one bit
+ * to make room for NULL, which is less than anything else,
+ * and HINT_NONE, which is greater than any hint. Values which
+ * can't be mapped (strings with collation, NaNs) get HINT_NONE,
+ * so they are always compared in full.
+ *
+ * Since the mapping doesn't depend on nullability, a hint stays
+ * valid when a key part becomes nullable or vice versa.
+ */
+enum { HINT_NIL = 0 };
+
+static inline hint_t
+hint_by_ordinal(uint64_t ord)
+{
+	return 1 + (ord >> 1);
+}
+
+static inline uint64_t
+hint_ordinal_int(const char *field, enum mp_type type)
+{
+	if (type == MP_UINT) {
+		uint64_t val = mp_decode_uint(&field);
+		return val > INT64_MAX ? UINT64_MAX : val + (1ULL << 63);
+	}
+	assert(type == MP_INT);
+	int64_t val = mp_decode_int(&field);
+	return (uint64_t)val ^ (1ULL << 63);
+}
+
+/**
+ * Map a number to the ordinal of the closest double. Rounding
+ * is monotonic, so the order is preserved, although different
+ * big integers may get the same ordinal.
+ */
+static inline bool
+hint_ordinal_number(const char *field, enum mp_type type, uint64_t *ord)
+{
+	double val;
+	switch (type) {
+	case MP_UINT:
+		val = mp_decode_uint(&field);
+		break;
+	case MP_INT:
+		val = mp_decode_int(&field);
+		break;
+	case MP_FLOAT:
+		val = mp_decode_float(&field);
+		break;
+	case MP_DOUBLE:
+		val = mp_decode_double(&field);
+		break;
+	default:
+		return false;
+	}
+	if (isnan(val))
+		return false;
+	/* -0.0 is equal to 0.0. */
+	if (val == 0)
+		val = 0;
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	*ord = (bits & (1ULL << 63)) != 0 ? ~bits : bits | (1ULL << 63);
+	return true;
+}
+
+/**
+ * Map a string or a binary to its first 8 bytes, big-endian,
+ * padded with zeros.
+ */
+static inline uint64_t
+hint_ordinal_bytes(const char *data, uint32_t len)
+{
+	uint64_t ord = 0;
+	uint32_t n = MIN(len, (uint32_t)sizeof(ord));
+	for (uint32_t i = 0; i < n; i++)
+		ord |= (uint64_t)(uint8_t)data[i] << (56 - 8 * i);
+	return ord;
+}
+
+template <enum field_type type, bool is_nullable>
+static inline hint_t
+field_hint(const char *field, struct coll *coll)
+{
+	if (is_nullable && (field == NULL || mp_typeof(*field) == MP_NIL))
+		return HINT_NIL;
+	enum mp_type mp_type = mp_typeof(*field);
+	uint64_t ord;
+	uint32_t len;
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+		if (mp_type != MP_UINT)
+			return HINT_NONE;
+		return hint_by_ordinal(mp_decode_uint(&field));
+	case FIELD_TYPE_INTEGER:
+		if (mp_type != MP_UINT && mp_type != MP_INT)
+			return HINT_NONE;
+		return hint_by_ordinal(hint_ordinal_int(field, mp_type));
+	case FIELD_TYPE_NUMBER:
+		if (!hint_ordinal_number(field, mp_type, &ord))
+			return HINT_NONE;
+		return hint_by_ordinal(ord);
+	case FIELD_TYPE_STRING:
+		if (mp_type != MP_STR || coll != NULL)
+			return HINT_NONE;
+		field = mp_decode_str(&field, &len);
+		return hint_by_ordinal(hint_ordinal_bytes(field, len));
+	case FIELD_TYPE_SCALAR:
+		/*
+		 * Scalars are ordered by class first. The class
+		 * takes the two most significant bits.
+		 */
+		switch (mp_classof(mp_type)) {
+		case MP_CLASS_BOOL:
+			ord = mp_decode_bool(&field) ? 1ULL << 61 : 0;
+			break;
+		case MP_CLASS_NUMBER:
+			if (!hint_ordinal_number(field, mp_type, &ord))
+				return HINT_NONE;
+			ord = (1ULL << 62) | (ord >> 2);
+			break;
+		case MP_CLASS_STR:
+			if (coll != NULL)
+				return HINT_NONE;
+			field = mp_decode_str(&field, &len);
+			ord = (2ULL << 62) |
+			      (hint_ordinal_bytes(field, len) >> 2);
+			break;
+		case MP_CLASS_BIN:
+			field = mp_decode_bin(&field, &len);
+			ord = (3ULL << 62) |
+			      (hint_ordinal_bytes(field, len) >> 2);
+			break;
+		default:
+			return HINT_NONE;
+		}
+		return hint_by_ordinal(ord);
+	default:
+		unreachable();
+		return HINT_NONE;
+	}
+}
+
+template <enum field_type type, bool is_nullable>
+static hint_t
+tuple_hint_impl(const struct tuple *tuple, const struct key_def *key_def)
+{
+	const struct key_part *part = &key_def->parts[0];
+	const char *field = tuple_field_by_part(tuple, part);
+	return field_hint<type, is_nullable>(field, part->coll);
+}
+
+template <enum field_type type, bool is_nullable>
+static hint_t
+key_hint_impl(const char *key, uint32_t part_count,
+	      const struct key_def *key_def)
+{
+	if (part_count == 0)
+		return HINT_NONE;
+	return field_hint<type, is_nullable>(key, key_def->parts[0].coll);
+}
+
+static hint_t
+tuple_hint_none(const struct tuple *tuple, const struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+static hint_t
+key_hint_none(const char *key, uint32_t part_count,
+	      const struct key_def *key_def)
+{
+	(void)key;
+	(void)part_count;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+template <enum field_type type>
+static void
+key_def_set_hint_func_for_type(struct key_def *def)
+{
+	if (key_part_is_nullable(&def->parts[0])) {
+		def->tuple_hint = tuple_hint_impl<type, true>;
+		def->key_hint = key_hint_impl<type, true>;
+	} else {
+		def->tuple_hint = tuple_hint_impl<type, false>;
+		def->key_hint = key_hint_impl<type, false>;
+	}
+}
+
+void
+tuple_hint_func_set(struct key_def *def)
+{
+	def->tuple_hint = tuple_hint_none;
+	def->key_hint = key_hint_none;
+	if (def->part_count == 0)
+		return;
+	switch (def->parts[0].type) {
+	case FIELD_TYPE_UNSIGNED:
+		key_def_set_hint_func_for_type<FIELD_TYPE_UNSIGNED>(def);
+		break;
+	case FIELD_TYPE_INTEGER:
+		key_def_set_hint_func_for_type<FIELD_TYPE_INTEGER>(def);
+		break;
+	case FIELD_TYPE_NUMBER:
+		key_def_set_hint_func_for_type<FIELD_TYPE_NUMBER>(def);
+		break;
+	case FIELD_TYPE_STRING:
+		if (def->parts[0].coll == NULL)
+			key_def_set_hint_func_for_type<FIELD_TYPE_STRING>(def);
+		break;
+	case FIELD_TYPE_SCALAR:
+		key_def_set_hint_func_for_type<FIELD_TYPE_SCALAR>(def);
+		break;
+	default:
+		break;
+	}
+}
+
+/* }}} tuple_hint */
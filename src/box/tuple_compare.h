@@ -68,6 +68,50 @@ tuple_compare_create(const struct key_def *key_def);
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *key_def);
 
+/**
+ * Compare keys of two tuples in a multikey index.
+ * @param tuple_a First tuple.
+ * @param multikey_idx_a Array item the key of @a tuple_a is
+ *        taken from.
+ * @param tuple_b Second tuple.
+ * @param multikey_idx_b Array item the key of @a tuple_b is
+ *        taken from.
+ * @param key_def Multikey key definition.
+ * @retval 0  if key_a == key_b
+ * @retval <0 if key_a < key_b
+ * @retval >0 if key_a > key_b
+ */
+int
+tuple_compare_multikey(const struct tuple *tuple_a, uint32_t multikey_idx_a,
+		       const struct tuple *tuple_b, uint32_t multikey_idx_b,
+		       const struct key_def *key_def);
+
+/**
+ * Compare a key of a tuple in a multikey index with a key.
+ * @param tuple Tuple.
+ * @param multikey_idx Array item the key of @a tuple is taken
+ *        from.
+ * @param key MessagePack array of key parts.
+ * @param part_count Number of parts in @a key.
+ * @param key_def Multikey key definition.
+ * @retval 0  if key_a == key
+ * @retval <0 if key_a < key
+ * @retval >0 if key_a > key
+ */
+int
+tuple_compare_with_key_multikey(const struct tuple *tuple,
+				uint32_t multikey_idx, const char *key,
+				uint32_t part_count,
+				const struct key_def *key_def);
+
+/**
+ * Initialize tuple_hint() and key_hint() functions for the
+ * key_def.
+ * @param key_def key definition to set up.
+ */
+void
+tuple_hint_func_set(struct key_def *key_def);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -4,12 +4,26 @@
 
 enum { MSGPACK_NULL = 0xc0 };
 
+/**
+ * True, if the key part @a part_no and the next one index
+ * two adjacent fields as a whole, so the key data of both is
+ * a contiguous piece of a tuple.
+ */
+static inline bool
+key_def_parts_are_sequential(const struct key_def *def, uint32_t part_no)
+{
+	const struct key_part *part = &def->parts[part_no];
+	const struct key_part *next = part + 1;
+	return part->fieldno + 1 == next->fieldno &&
+	       part->path == NULL && next->path == NULL;
+}
+
 /** True, if a key con contain two or more parts in sequence. */
 static bool
 key_def_contains_sequential_parts(const struct key_def *def)
 {
 	for (uint32_t i = 0; i < def->part_count - 1; ++i) {
-		if (def->parts[i].fieldno + 1 == def->parts[i + 1].fieldno)
+		if (key_def_parts_are_sequential(def, i))
 			return true;
 	}
 	return false;
@@ -111,8 +125,8 @@ tuple_extract_key_slowpath(const struct tuple *tuple,
 	/* Calculate the key size. */
 	for (uint32_t i = 0; i < part_count; ++i) {
 		const char *field =
-			tuple_field_raw(format, data, field_map,
-					key_def->parts[i].fieldno);
+			tuple_field_by_part_raw(format, data, field_map,
+						&key_def->parts[i]);
 		if (has_optional_parts && field == NULL) {
 			bsize += mp_sizeof_nil();
 			continue;
@@ -125,8 +139,7 @@ tuple_extract_key_slowpath(const struct tuple *tuple,
 			 * minimize tuple_field_raw() calls.
 			 */
 			for (; i < part_count - 1; i++) {
-				if (key_def->parts[i].fieldno + 1 !=
-				    key_def->parts[i + 1].fieldno) {
+				if (!key_def_parts_are_sequential(key_def, i)) {
 					/*
 					 * End of sequential part.
 					 */
@@ -153,8 +166,8 @@ tuple_extract_key_slowpath(const struct tuple *tuple,
 	char *key_buf = mp_encode_array(key, part_count);
 	for (uint32_t i = 0; i < part_count; ++i) {
 		const char *field =
-			tuple_field_raw(format, data, field_map,
-					key_def->parts[i].fieldno);
+			tuple_field_by_part_raw(format, data, field_map,
+						&key_def->parts[i]);
 		if (has_optional_parts && field == NULL) {
 			key_buf = mp_encode_nil(key_buf);
 			continue;
@@ -167,8 +180,7 @@ tuple_extract_key_slowpath(const struct tuple *tuple,
 			 * minimize tuple_field_raw() calls.
 			 */
 			for (; i < part_count - 1; i++) {
-				if (key_def->parts[i].fieldno + 1 !=
-				    key_def->parts[i + 1].fieldno) {
+				if (!key_def_parts_are_sequential(key_def, i)) {
 					/*
 					 * End of sequential part.
 					 */
@@ -210,10 +222,17 @@ tuple_extract_key_slowpath_raw(const char *data, const char *data_end,
 	assert(!has_optional_parts || key_def->is_nullable);
 	assert(has_optional_parts == key_def->has_optional_parts);
 	assert(mp_sizeof_nil() == 1);
-	/* allocate buffer with maximal possible size */
-	char *key = (char *) region_alloc(&fiber()->gc, data_end - data);
+	/*
+	 * Allocate buffer with maximal possible size. Data at a
+	 * JSON path can be absent in a present field, which
+	 * takes a NULL per such part.
+	 */
+	size_t size = data_end - data;
+	if (key_def->has_json_paths)
+		size += key_def->part_count * mp_sizeof_nil();
+	char *key = (char *) region_alloc(&fiber()->gc, size);
 	if (key == NULL) {
-		diag_set(OutOfMemory, data_end - data, "region",
+		diag_set(OutOfMemory, size, "region",
 			 "tuple_extract_key_raw");
 		return NULL;
 	}
@@ -234,8 +253,7 @@ tuple_extract_key_slowpath_raw(const char *data, const char *data_end,
 		uint32_t fieldno = key_def->parts[i].fieldno;
 		uint32_t null_count = 0;
 		for (; i < key_def->part_count - 1; i++) {
-			if (key_def->parts[i].fieldno + 1 !=
-			    key_def->parts[i + 1].fieldno)
+			if (!key_def_parts_are_sequential(key_def, i))
 				break;
 		}
 		uint32_t end_fieldno = key_def->parts[i].fieldno;
@@ -267,6 +285,23 @@ tuple_extract_key_slowpath_raw(const char *data, const char *data_end,
 			current_fieldno++;
 		}
 
+		const struct key_part *part = &key_def->parts[i];
+		if (part->path != NULL) {
+			/* A path part is never a part of a range. */
+			assert(fieldno == end_fieldno);
+			const char *value = field;
+			if (tuple_field_go_to_path(&value, part->path,
+						   part->path_len) != 0) {
+				key_buf = mp_encode_nil(key_buf);
+				continue;
+			}
+			const char *value_end = value;
+			mp_next(&value_end);
+			memcpy(key_buf, value, value_end - value);
+			key_buf += value_end - value;
+			continue;
+		}
+
 		/*
 		 * If the last fieldno is out of tuple size, then
 		 * fill rest of columns with NULLs.
@@ -286,7 +321,7 @@ tuple_extract_key_slowpath_raw(const char *data, const char *data_end,
 			memset(key_buf, MSGPACK_NULL, null_count);
 			key_buf += null_count * mp_sizeof_nil();
 		} else {
-			assert(key_buf - key <= data_end - data);
+			assert(key_buf - key <= (ptrdiff_t) size);
 		}
 	}
 	if (key_size != NULL)
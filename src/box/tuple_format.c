@@ -43,6 +43,123 @@ static const struct tuple_field tuple_field_default = {
 	ON_CONFLICT_ACTION_DEFAULT, NULL, COLL_NONE,
 };
 
+/** Printable name of a field indexed by a JSON path. */
+static const char *
+tuple_path_field_name(uint32_t fieldno, const char *path, uint32_t path_len)
+{
+	const char *sep = path[0] == '[' || path[0] == '.' ? "" : ".";
+	return tt_sprintf("'[%u]%s%.*s'", fieldno + TUPLE_INDEX_BASE, sep,
+			  (int) path_len, path);
+}
+
+/**
+ * Find a field indexed by a JSON path in a format. Paths are
+ * matched by hash first, so that the lookup is cheap enough for
+ * comparators. Usually the path is spelled the same way in all
+ * indexes, so it is compared byte by byte before it is parsed.
+ */
+static struct tuple_path_field *
+tuple_format_path_field(const struct tuple_format *format, uint32_t fieldno,
+			const char *path, uint32_t path_len, uint32_t path_hash)
+{
+	struct tuple_path_field *field = format->path_fields;
+	struct tuple_path_field *end = field + format->path_field_count;
+	for (; field < end; field++) {
+		if (field->fieldno != fieldno || field->path_hash != path_hash)
+			continue;
+		if (field->path_len == path_len &&
+		    memcmp(field->path, path, path_len) == 0)
+			return field;
+		if (json_path_cmp(field->path, field->path_len,
+				  path, path_len) == 0)
+			return field;
+	}
+	return NULL;
+}
+
+/** True if some data of a field is indexed by a JSON path. */
+static bool
+tuple_format_has_path_in(const struct tuple_format *format, uint32_t fieldno)
+{
+	for (uint32_t i = 0; i < format->path_field_count; i++) {
+		if (format->path_fields[i].fieldno == fieldno)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Add a key part with a JSON path to a format. The root
+ * field gets an offset slot to make the path lookup on tuple
+ * creation cheap, the path itself gets another one.
+ * @param format Format to update.
+ * @param part Key part with a path.
+ * @param[in][out] path_pool Free space for path strings.
+ * @param[in][out] current_slot The last used offset slot.
+ *
+ * @retval  0 Success.
+ * @retval -1 The part conflicts with other parts.
+ */
+static int
+tuple_format_add_path_field(struct tuple_format *format,
+			    const struct key_part *part, char **path_pool,
+			    int *current_slot)
+{
+	assert(part->path != NULL);
+	struct tuple_field *root = &format->fields[part->fieldno];
+	if (root->is_key_part || (root->type != FIELD_TYPE_ANY &&
+				  root->type != FIELD_TYPE_MAP &&
+				  root->type != FIELD_TYPE_ARRAY)) {
+		diag_set(ClientError, ER_INDEX_PATH_ROOT_TYPE,
+			 tt_sprintf("%u", part->fieldno + TUPLE_INDEX_BASE),
+			 field_type_strs[root->type]);
+		return -1;
+	}
+	if (root->offset_slot == TUPLE_OFFSET_SLOT_NIL && part->fieldno > 0)
+		root->offset_slot = --*current_slot;
+
+	struct tuple_path_field *field =
+		tuple_format_path_field(format, part->fieldno, part->path,
+					part->path_len, part->path_hash);
+	if (field == NULL) {
+		field = &format->path_fields[format->path_field_count++];
+		field->fieldno = part->fieldno;
+		memcpy(*path_pool, part->path, part->path_len);
+		field->path = *path_pool;
+		field->path_len = part->path_len;
+		field->path_hash = part->path_hash;
+		*path_pool += part->path_len;
+		field->type = part->type;
+		field->nullable_action = part->nullable_action;
+		field->is_multikey = part->is_multikey;
+		field->multikey_path_len = 0;
+		field->offset_slot = TUPLE_OFFSET_SLOT_NIL;
+		if (part->is_multikey) {
+			field->multikey_path_len =
+				json_path_multikey_offset(part->path,
+							  part->path_len);
+		} else {
+			field->offset_slot = --*current_slot;
+		}
+		return 0;
+	}
+	/* The same path is indexed by another part. */
+	if (field_type1_contains_type2(field->type, part->type)) {
+		field->type = part->type;
+	} else if (! field_type1_contains_type2(part->type, field->type)) {
+		diag_set(ClientError, ER_INDEX_PART_TYPE_MISMATCH,
+			 tuple_path_field_name(part->fieldno, part->path,
+					       part->path_len),
+			 field_type_strs[field->type],
+			 field_type_strs[part->type]);
+		return -1;
+	}
+	/* The data must be present if any index requires it. */
+	if (! key_part_is_nullable(part))
+		field->nullable_action = part->nullable_action;
+	return 0;
+}
+
 /**
  * Extract all available type info from keys and field
  * definitions.
@@ -84,6 +201,9 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 		format->fields[i] = tuple_field_default;
 
 	int current_slot = 0;
+	char *path_pool = (char *) (format->path_fields +
+				    format->path_field_count);
+	format->path_field_count = 0;
 
 	/* extract field type info */
 	for (uint16_t key_no = 0; key_no < key_count; ++key_no) {
@@ -94,8 +214,21 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 
 		for (; part < parts_end; part++) {
 			assert(part->fieldno < format->field_count);
+			if (part->path != NULL) {
+				if (tuple_format_add_path_field(format, part,
+						&path_pool, &current_slot) != 0)
+					return -1;
+				continue;
+			}
 			struct tuple_field *field =
 				&format->fields[part->fieldno];
+			if (tuple_format_has_path_in(format, part->fieldno)) {
+				diag_set(ClientError, ER_INDEX_PATH_ROOT_TYPE,
+					 tt_sprintf("%u", part->fieldno +
+						    TUPLE_INDEX_BASE),
+					 field_type_strs[part->type]);
+				return -1;
+			}
 			if (part->fieldno >= field_count) {
 				field->nullable_action = part->nullable_action;
 			} else {
@@ -242,6 +375,8 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 		   uint32_t space_field_count, struct tuple_dictionary *dict)
 {
 	uint32_t index_field_count = 0;
+	uint32_t path_field_count = 0;
+	uint32_t path_pool_size = 0;
 	/* find max max field no */
 	for (uint16_t key_no = 0; key_no < key_count; ++key_no) {
 		const struct key_def *key_def = keys[key_no];
@@ -250,6 +385,10 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 		for (; part < pend; part++) {
 			index_field_count = MAX(index_field_count,
 						part->fieldno + 1);
+			if (part->path != NULL) {
+				path_field_count++;
+				path_pool_size += part->path_len;
+			}
 		}
 	}
 	uint32_t field_count = MAX(space_field_count, index_field_count);
@@ -262,10 +401,28 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 			 "tuple format");
 		return NULL;
 	}
+	/*
+	 * Path fields are allocated for the worst case of all
+	 * paths being different. tuple_format_create() puts the
+	 * path strings after the array and sets the actual count.
+	 */
+	format->path_fields = NULL;
+	format->path_field_count = path_field_count;
+	if (path_field_count > 0) {
+		size_t size = path_field_count *
+			      sizeof(struct tuple_path_field) + path_pool_size;
+		format->path_fields = (struct tuple_path_field *) malloc(size);
+		if (format->path_fields == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "path fields");
+			free(format);
+			return NULL;
+		}
+	}
 	if (dict == NULL) {
 		assert(space_field_count == 0);
 		format->dict = tuple_dictionary_new(NULL, 0);
 		if (format->dict == NULL) {
+			free(format->path_fields);
 			free(format);
 			return NULL;
 		}
@@ -286,6 +443,7 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 static inline void
 tuple_format_destroy(struct tuple_format *format)
 {
+	free(format->path_fields);
 	tuple_dictionary_unref(format->dict);
 }
 
@@ -363,6 +521,23 @@ tuple_format1_can_store_format2_tuples(const struct tuple_format *format1,
 		    !tuple_field_is_nullable(field1))
 			return false;
 	}
+	for (uint32_t i = 0; i < format1->path_field_count; ++i) {
+		const struct tuple_path_field *field1 =
+			&format1->path_fields[i];
+		const struct tuple_path_field *field2 =
+			tuple_format_path_field(format2, field1->fieldno,
+						field1->path,
+						field1->path_len,
+						field1->path_hash);
+		/* The path is not indexed in format2, check data. */
+		if (field2 == NULL)
+			return false;
+		if (! field_type1_contains_type2(field1->type, field2->type))
+			return false;
+		if (field2->nullable_action == ON_CONFLICT_ACTION_NONE &&
+		    field1->nullable_action != ON_CONFLICT_ACTION_NONE)
+			return false;
+	}
 	return true;
 }
 
@@ -377,6 +552,29 @@ tuple_format_dup(struct tuple_format *src)
 		return NULL;
 	}
 	memcpy(format, src, total);
+	format->path_fields = NULL;
+	if (src->path_field_count > 0) {
+		size_t size = src->path_field_count *
+			      sizeof(struct tuple_path_field);
+		for (uint32_t i = 0; i < src->path_field_count; i++)
+			size += src->path_fields[i].path_len;
+		format->path_fields = (struct tuple_path_field *) malloc(size);
+		if (format->path_fields == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "path fields");
+			free(format);
+			return NULL;
+		}
+		char *path_pool = (char *) (format->path_fields +
+					    src->path_field_count);
+		for (uint32_t i = 0; i < src->path_field_count; i++) {
+			struct tuple_path_field *field =
+				&format->path_fields[i];
+			*field = src->path_fields[i];
+			memcpy(path_pool, field->path, field->path_len);
+			field->path = path_pool;
+			path_pool += field->path_len;
+		}
+	}
 	tuple_dictionary_ref(format->dict);
 	format->id = FORMAT_ID_NIL;
 	format->refs = 0;
@@ -388,6 +586,111 @@ tuple_format_dup(struct tuple_format *src)
 	return format;
 }
 
+/**
+ * Check type and presence of data indexed by a JSON path.
+ * @param field Path field of the format.
+ * @param data The indexed data or NULL if it is absent.
+ *
+ * @retval  0 Success.
+ * @retval -1 The data is missing or has a wrong type.
+ */
+static int
+tuple_path_field_check(const struct tuple_path_field *field, const char *data)
+{
+	bool is_nullable = field->nullable_action == ON_CONFLICT_ACTION_NONE;
+	if (data == NULL) {
+		if (is_nullable)
+			return 0;
+		diag_set(ClientError, ER_FIELD_PATH_MISSING,
+			 tuple_path_field_name(field->fieldno, field->path,
+					       field->path_len));
+		return -1;
+	}
+	uint32_t mask = key_mp_type[field->type] |
+			(is_nullable * (1U << MP_NIL));
+	if ((mask & (1U << mp_typeof(*data))) == 0) {
+		diag_set(ClientError, ER_FIELD_PATH_TYPE,
+			 tuple_path_field_name(field->fieldno, field->path,
+					       field->path_len),
+			 field_type_strs[field->type]);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Check data indexed by a multikey JSON path: the path up to
+ * [*] must lead to an array, and the rest of the path is
+ * checked in every item of it. A missing array is fine if the
+ * data is nullable, the tuple has no keys in the index then.
+ * @param field Multikey path field of the format.
+ * @param root Top-level field the path starts from or NULL if
+ *        the tuple doesn't have it.
+ *
+ * @retval  0 Success.
+ * @retval -1 The data is missing or has a wrong type.
+ */
+static int
+tuple_path_field_check_multikey(const struct tuple_path_field *field,
+				const char *root)
+{
+	assert(field->is_multikey);
+	const char *array = root;
+	if (array != NULL &&
+	    tuple_field_go_to_path(&array, field->path,
+				   field->multikey_path_len) != 0)
+		array = NULL;
+	if (array == NULL || mp_typeof(*array) == MP_NIL)
+		return tuple_path_field_check(field, NULL);
+	if (mp_typeof(*array) != MP_ARRAY) {
+		diag_set(ClientError, ER_FIELD_PATH_TYPE,
+			 tuple_path_field_name(field->fieldno, field->path,
+					       field->multikey_path_len),
+			 field_type_strs[FIELD_TYPE_ARRAY]);
+		return -1;
+	}
+	uint32_t count = mp_decode_array(&array);
+	/* Skip the [*] itself. */
+	const char *suffix = field->path + field->multikey_path_len + 3;
+	uint32_t suffix_len = field->path_len - field->multikey_path_len - 3;
+	for (uint32_t i = 0; i < count; i++) {
+		const char *data = array;
+		if (tuple_field_go_to_path(&data, suffix, suffix_len) != 0)
+			data = NULL;
+		if (tuple_path_field_check(field, data) != 0)
+			return -1;
+		mp_next(&array);
+	}
+	return 0;
+}
+
+/**
+ * Find data indexed by a JSON path of a format and check its
+ * type and presence. Multikey data is checked in every array
+ * item, but has no single location.
+ * @param field Path field of the format.
+ * @param root Top-level field the path starts from or NULL if
+ *        the tuple doesn't have it.
+ * @param[out] data The indexed data or NULL if it is absent
+ *        or multikey.
+ *
+ * @retval  0 Success.
+ * @retval -1 The data is missing or has a wrong type.
+ */
+static int
+tuple_path_field_find(const struct tuple_path_field *field, const char *root,
+		      const char **data)
+{
+	*data = NULL;
+	if (field->is_multikey)
+		return tuple_path_field_check_multikey(field, root);
+	*data = root;
+	if (root != NULL &&
+	    tuple_field_go_to_path(data, field->path, field->path_len) != 0)
+		*data = NULL;
+	return tuple_path_field_check(field, *data);
+}
+
 /** @sa declaration for details. */
 int
 tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
@@ -445,6 +748,47 @@ tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
 		}
 		mp_next(&pos);
 	}
+	/*
+	 * Roots of JSON paths have offset slots, so it is cheap
+	 * to find them now that top-level offsets are known.
+	 */
+	const struct tuple_path_field *path_field = format->path_fields;
+	const struct tuple_path_field *path_end =
+		path_field + format->path_field_count;
+	for (; path_field < path_end; path_field++) {
+		const char *root = tuple_field_raw(format, tuple, field_map,
+						   path_field->fieldno);
+		const char *data;
+		if (tuple_path_field_find(path_field, root, &data) != 0)
+			return -1;
+		if (path_field->offset_slot == TUPLE_OFFSET_SLOT_NIL)
+			continue;
+		field_map[path_field->offset_slot] =
+			data != NULL ? (uint32_t) (data - tuple) : 0;
+	}
+	return 0;
+}
+
+int
+tuple_format_validate_paths(const struct tuple_format *format,
+			    const char *tuple)
+{
+	const struct tuple_path_field *path_field = format->path_fields;
+	const struct tuple_path_field *path_end =
+		path_field + format->path_field_count;
+	for (; path_field < path_end; path_field++) {
+		const char *root = tuple;
+		uint32_t field_count = mp_decode_array(&root);
+		if (path_field->fieldno < field_count) {
+			for (uint32_t i = 0; i < path_field->fieldno; i++)
+				mp_next(&root);
+		} else {
+			root = NULL;
+		}
+		const char *data;
+		if (tuple_path_field_find(path_field, root, &data) != 0)
+			return -1;
+	}
 	return 0;
 }
 
@@ -642,7 +986,9 @@ tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
 		break;
 	}
 	default:
-		assert(node.type == JSON_PATH_END);
+		/* [*] doesn't lead to a single field. */
+		assert(node.type == JSON_PATH_END ||
+		       node.type == JSON_PATH_ANY);
 		*field = NULL;
 		return 0;
 	}
@@ -654,6 +1000,9 @@ tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
 		case JSON_PATH_STR:
 			rc = tuple_field_go_to_key(field, node.str, node.len);
 			break;
+		case JSON_PATH_ANY:
+			rc = -1;
+			break;
 		default:
 			assert(node.type == JSON_PATH_END);
 			return 0;
@@ -669,3 +1018,86 @@ error:
 		 tt_sprintf("error in path on position %d", rc));
 	return -1;
 }
+
+int
+tuple_field_go_to_path_multikey(const char **field, const char *path,
+				uint32_t path_len, uint32_t multikey_idx)
+{
+	struct json_path_parser parser;
+	struct json_path_node node;
+	json_path_parser_create(&parser, path, path_len);
+	int rc;
+	while ((rc = json_path_next(&parser, &node)) == 0) {
+		switch (node.type) {
+		case JSON_PATH_NUM:
+			rc = tuple_field_go_to_index(field, node.num);
+			break;
+		case JSON_PATH_STR:
+			rc = tuple_field_go_to_key(field, node.str, node.len);
+			break;
+		case JSON_PATH_ANY:
+			if (mp_typeof(**field) != MP_ARRAY)
+				return -1;
+			rc = tuple_field_go_to_index(field, multikey_idx +
+						     TUPLE_INDEX_BASE);
+			break;
+		default:
+			assert(node.type == JSON_PATH_END);
+			return 0;
+		}
+		if (rc != 0)
+			return -1;
+	}
+	/* Paths of key parts are validated on key_def creation. */
+	unreachable();
+	return -1;
+}
+
+const char *
+tuple_field_raw_by_part_path(const struct tuple_format *format,
+			     const char *tuple, const uint32_t *field_map,
+			     const struct key_part *part)
+{
+	assert(part->path != NULL);
+	/*
+	 * Key parts are shared by threads sorting tuples, so
+	 * the slot is looked up in the format, not cached in
+	 * the part.
+	 */
+	const struct tuple_path_field *path_field =
+		tuple_format_path_field(format, part->fieldno, part->path,
+					part->path_len, part->path_hash);
+	if (path_field != NULL &&
+	    path_field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
+		uint32_t offset = field_map[path_field->offset_slot];
+		return offset != 0 ? tuple + offset : NULL;
+	}
+	/*
+	 * The format doesn't index the path, e.g. the tuple was
+	 * created before the index, or the path is multikey.
+	 * Decode it.
+	 */
+	const char *field = tuple_field_raw(format, tuple, field_map,
+					    part->fieldno);
+	if (field == NULL ||
+	    tuple_field_go_to_path(&field, part->path, part->path_len) != 0)
+		return NULL;
+	return field;
+}
+
+uint32_t
+tuple_multikey_count_raw(const struct tuple_format *format, const char *tuple,
+			 const uint32_t *field_map,
+			 const struct key_def *key_def)
+{
+	assert(key_def->is_multikey);
+	const struct key_part *part = &key_def->parts[key_def->multikey_part];
+	const char *array = tuple_field_raw(format, tuple, field_map,
+					    part->fieldno);
+	if (array == NULL ||
+	    tuple_field_go_to_path(&array, part->path,
+				   key_def->multikey_path_len) != 0 ||
+	    mp_typeof(*array) != MP_ARRAY)
+		return 0;
+	return mp_decode_array(&array);
+}
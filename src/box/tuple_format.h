@@ -115,6 +115,38 @@ struct tuple_field {
 	uint32_t coll_id;
 };
 
+/**
+ * Meta information of data indexed by a JSON path, i.e.
+ * nested in a top-level field of a tuple.
+ */
+struct tuple_path_field {
+	/** Number of the top-level field the path starts from. */
+	uint32_t fieldno;
+	/** JSON path relative to the field, not 0-terminated. */
+	const char *path;
+	/** Length of @a path. */
+	uint32_t path_len;
+	/** Hash of @a path, @sa json_path_hash(). */
+	uint32_t path_hash;
+	/** Type of the indexed data. */
+	enum field_type type;
+	/** Action to perform if NULL constraint failed. */
+	enum on_conflict_action nullable_action;
+	/**
+	 * True if the path has [*], i.e. the data is an item of
+	 * an array, one per array item.
+	 */
+	bool is_multikey;
+	/** Length of the path up to [*] if @a is_multikey. */
+	uint32_t multikey_path_len;
+	/**
+	 * Offset slot in field map of tuple. Unlike top-level
+	 * fields, a path field always has one, unless it is
+	 * multikey: there is no single offset of the data then.
+	 */
+	int32_t offset_slot;
+};
+
 /**
  * Get is_nullable property of tuple_field.
  * @param tuple_field for which attribute is being fetched
@@ -174,6 +206,10 @@ struct tuple_format {
 	uint32_t min_field_count;
 	/* Length of 'fields' array. */
 	uint32_t field_count;
+	/** Length of 'path_fields' array. */
+	uint32_t path_field_count;
+	/** Fields indexed by JSON paths. */
+	struct tuple_path_field *path_fields;
 	/**
 	 * Shared names storage used by all formats of a space.
 	 */
@@ -340,6 +376,20 @@ int
 tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
 		     const char *tuple);
 
+/**
+ * Check data indexed by JSON paths of a format. Used to
+ * validate tuples that have a field map of another format,
+ * e.g. when an index is built over existing data.
+ * @param format Tuple format.
+ * @param tuple  MessagePack array.
+ *
+ * @retval  0 Success.
+ * @retval -1 Indexed data is missing or has a wrong type.
+ */
+int
+tuple_format_validate_paths(const struct tuple_format *format,
+			    const char *tuple);
+
 /**
  * Get a field at the specific position in this MessagePack array.
  * Returns a pointer to MessagePack data.
@@ -423,6 +473,111 @@ tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
                         uint32_t path_len, uint32_t path_hash,
                         const char **field);
 
+/**
+ * Propagate @a field to the data at a JSON path in it.
+ * @param[in][out] field Field to propagate.
+ * @param path Valid JSON path.
+ * @param path_len Length of @a path.
+ * @param multikey_idx 0-based number of the array item [*]
+ *        stands for.
+ *
+ * @retval  0 Success, the data was found.
+ * @retval -1 Not found.
+ */
+int
+tuple_field_go_to_path_multikey(const char **field, const char *path,
+				uint32_t path_len, uint32_t multikey_idx);
+
+/**
+ * Propagate @a field to the data at a JSON path in it. [*]
+ * stands for the first array item.
+ * @sa tuple_field_go_to_path_multikey().
+ */
+static inline int
+tuple_field_go_to_path(const char **field, const char *path,
+		       uint32_t path_len)
+{
+	return tuple_field_go_to_path_multikey(field, path, path_len, 0);
+}
+
+/**
+ * Get data indexed by a key part with a JSON path.
+ * @sa tuple_field_by_part_raw().
+ */
+const char *
+tuple_field_raw_by_part_path(const struct tuple_format *format,
+			     const char *tuple, const uint32_t *field_map,
+			     const struct key_part *part);
+
+/**
+ * Get data indexed by a key part: either a top-level field
+ * or data at the JSON path of the part. If the format indexes
+ * the path, its offset is taken from the field map, so the
+ * lookup costs the same as of a top-level field.
+ * @param format Tuple format.
+ * @param tuple MessagePack tuple's body.
+ * @param field_map Tuple field map.
+ * @param part Key part.
+ *
+ * @retval not NULL MessagePack field.
+ * @retval     NULL The data is absent.
+ */
+static inline const char *
+tuple_field_by_part_raw(const struct tuple_format *format, const char *tuple,
+			const uint32_t *field_map,
+			const struct key_part *part)
+{
+	if (likely(part->path == NULL))
+		return tuple_field_raw(format, tuple, field_map, part->fieldno);
+	return tuple_field_raw_by_part_path(format, tuple, field_map, part);
+}
+
+/**
+ * Get data indexed by a key part for the given item of the
+ * array indexed by a multikey key_def.
+ * @param format Tuple format.
+ * @param tuple MessagePack tuple's body.
+ * @param field_map Tuple field map.
+ * @param part Key part.
+ * @param multikey_idx 0-based number of the array item.
+ *
+ * @retval not NULL MessagePack field.
+ * @retval     NULL The data is absent.
+ */
+static inline const char *
+tuple_field_by_part_multikey_raw(const struct tuple_format *format,
+				 const char *tuple, const uint32_t *field_map,
+				 const struct key_part *part,
+				 uint32_t multikey_idx)
+{
+	if (likely(!part->is_multikey))
+		return tuple_field_by_part_raw(format, tuple, field_map, part);
+	const char *field = tuple_field_raw(format, tuple, field_map,
+					    part->fieldno);
+	if (field == NULL ||
+	    tuple_field_go_to_path_multikey(&field, part->path,
+					    part->path_len,
+					    multikey_idx) != 0)
+		return NULL;
+	return field;
+}
+
+/**
+ * Get the number of items of the array indexed by a multikey
+ * key_def, i.e. the number of keys the tuple has in the index.
+ * A tuple without the array has none.
+ * @param format Tuple format.
+ * @param tuple MessagePack tuple's body.
+ * @param field_map Tuple field map.
+ * @param key_def Multikey key definition.
+ *
+ * @retval Number of array items.
+ */
+uint32_t
+tuple_multikey_count_raw(const struct tuple_format *format, const char *tuple,
+			 const uint32_t *field_map,
+			 const struct key_def *key_def);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -65,6 +65,9 @@ txn_add_redo(struct txn_stmt *stmt, struct request *request)
 	row->lsn = 0;
 	row->sync = 0;
 	row->tm = 0;
+	row->tsn = 0;
+	row->is_commit = false;
+	row->stream_id = 0;
 	row->bodycnt = xrow_encode_dml(request, row->body);
 	if (row->bodycnt < 0)
 		return -1;
@@ -145,11 +148,13 @@ txn_begin(bool is_autocommit)
 	txn->is_autocommit = is_autocommit;
 	txn->has_triggers  = false;
 	txn->is_aborted = false;
+	txn->is_conflicted = false;
 	txn->in_sub_stmt = 0;
 	txn->id = ++txn_id;
 	txn->signature = -1;
 	txn->engine = NULL;
 	txn->engine_tx = NULL;
+	rlist_create(&txn->read_set);
 	txn->psql_txn = NULL;
 	/* fiber_on_yield/fiber_on_stop initialized by engine on demand */
 	fiber_set_txn(fiber(), txn);
@@ -140,6 +140,13 @@ struct txn {
 	 * rolled back at commit.
 	 */
 	bool is_aborted;
+	/**
+	 * True if the transaction has read a tuple which has
+	 * been overwritten by another transaction since then,
+	 * so it must fail at commit. Set by the memtx
+	 * transaction manager.
+	 */
+	bool is_conflicted;
 	/** True if on_commit and on_rollback lists are non-empty. */
 	bool has_triggers;
 	/** The number of active nested statement-level transactions. */
@@ -155,6 +162,11 @@ struct txn {
 	struct engine *engine;
 	/** Engine-specific transaction data */
 	void *engine_tx;
+	/**
+	 * Tuples read by the transaction, tracked by the memtx
+	 * transaction manager. Linked by memtx_tx_read_tracker.
+	 */
+	struct rlist read_set;
 	/**
 	 * Triggers on fiber yield to abort transaction for
 	 * for in-memory engine.
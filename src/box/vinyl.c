@@ -64,6 +64,7 @@
 #include "xlog.h"
 #include "engine.h"
 #include "space.h"
+#include "schema.h"
 #include "index.h"
 #include "xstream.h"
 #include "info.h"
@@ -302,6 +303,8 @@ vy_info_append_quota(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "watermark", q->watermark);
 	info_append_int(h, "use_rate", env->quota_use_rate);
 	info_append_int(h, "dump_bandwidth", vy_dump_bandwidth(env));
+	info_append_int(h, "throttle_count", q->throttle_count);
+	info_append_double(h, "throttle_time", q->throttle_time);
 	info_table_end(h);
 }
 
@@ -322,6 +325,22 @@ vy_info_append_cache(struct vy_env *env, struct info_handler *h)
 	info_table_end(h);
 }
 
+static void
+vy_info_append_page_cache(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_page_cache *c = &env->run_env.page_cache;
+
+	info_table_begin(h, "page_cache");
+
+	info_append_int(h, "used", c->mem_used);
+	info_append_int(h, "limit", c->mem_quota);
+	info_append_int(h, "pages", c->page_count);
+	info_append_int(h, "hit", c->hit);
+	info_append_int(h, "miss", c->miss);
+
+	info_table_end(h);
+}
+
 static void
 vy_info_append_tx(struct vy_env *env, struct info_handler *h)
 {
@@ -354,6 +373,7 @@ vinyl_engine_stat(struct vinyl_engine *vinyl, struct info_handler *h)
 	info_begin(h);
 	vy_info_append_quota(env, h);
 	vy_info_append_cache(env, h);
+	vy_info_append_page_cache(env, h);
 	vy_info_append_tx(env, h);
 	info_end(h);
 }
@@ -685,6 +705,16 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 		diag_set(ClientError, ER_NULLABLE_PRIMARY, space_name(space));
 		return -1;
 	}
+	/*
+	 * Statements are restored from keys and partial tuples
+	 * (surrogate deletes, upserts), which requires all key
+	 * parts to be top-level fields.
+	 */
+	if (index_def->key_def->has_json_paths) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "JSON path indexes");
+		return -1;
+	}
 	/* Check that there are no ANY, ARRAY, MAP parts */
 	for (uint32_t i = 0; i < index_def->key_def->part_count; i++) {
 		struct key_part *part = &index_def->key_def->parts[i];
@@ -725,6 +755,7 @@ vinyl_space_create_index(struct space *space, struct index_def *index_def)
 		free(index);
 		return NULL;
 	}
+	lsm->defer_deletes = space->def->opts.defer_deletes;
 	if (index_create(&index->base, (struct engine *)vinyl,
 			 &vinyl_index_vtab, index_def) != 0) {
 		vy_lsm_delete(lsm);
@@ -1291,6 +1322,78 @@ vy_lsm_get(struct vy_lsm *lsm, struct vy_tx *tx,
 	return rc;
 }
 
+/**
+ * Get the full tuple from the primary index for a statement
+ * read from a secondary index.
+ *
+ * If the space defers DELETEs (see vy_lsm::defer_deletes), the
+ * secondary index may store statements for tuples that have been
+ * overwritten or deleted in the primary index. For such a
+ * statement @result is set to NULL. Since overwriting a tuple
+ * doesn't update the secondary index in this case, the read is
+ * tracked in the primary index.
+ *
+ * @param lsm         Secondary index LSM tree.
+ * @param tx          Current transaction.
+ * @param rv          Read view.
+ * @param tuple       Statement read from the secondary index.
+ * @param[out] result The found tuple is stored here. Must be
+ *                    unreferenced after usage.
+ *
+ * @param  0 Success.
+ * @param -1 Memory error or read error.
+ */
+static int
+vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
+			  const struct vy_read_view **rv,
+			  struct tuple *tuple, struct tuple **result)
+{
+	assert(lsm->index_id > 0);
+	if (lsm->defer_deletes && tx != NULL &&
+	    vy_tx_track_point(tx, lsm->pk, tuple) != 0)
+		return -1;
+	if (vy_point_lookup(lsm->pk, tx, rv, tuple, result) != 0)
+		return -1;
+	if (*result != NULL && lsm->defer_deletes &&
+	    vy_tuple_compare(*result, tuple, lsm->cmp_def) != 0) {
+		/* The statement is stale, skip it. */
+		tuple_unref(*result);
+		*result = NULL;
+	}
+	return 0;
+}
+
+/**
+ * Get the full tuple by a key of a secondary index LSM tree of
+ * a space with deferred DELETEs. Unlike vy_lsm_get(), skips
+ * stale statements, see vy_get_by_secondary_tuple().
+ *
+ * @param  0 Success.
+ * @param -1 Memory error or read error.
+ */
+static int
+vy_lsm_get_deferred(struct vy_lsm *lsm, struct vy_tx *tx,
+		    const struct vy_read_view **rv,
+		    struct tuple *key, struct tuple **result)
+{
+	assert(lsm->index_id > 0 && lsm->defer_deletes);
+	assert(tx == NULL || tx->state == VINYL_TX_READY);
+
+	int rc;
+	struct tuple *found;
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, lsm, tx, ITER_EQ, key, rv);
+	*result = NULL;
+	while ((rc = vy_read_iterator_next(&itr, &found)) == 0 &&
+	       found != NULL) {
+		rc = vy_get_by_secondary_tuple(lsm, tx, rv, found, result);
+		if (rc != 0 || *result != NULL)
+			break;
+	}
+	vy_read_iterator_close(&itr);
+	return rc;
+}
+
 /**
  * Check if the LSM tree contains the key. If true, then set
  * a duplicate key error in the diagnostics area.
@@ -1330,6 +1433,44 @@ vy_check_is_unique(struct vy_env *env, struct vy_tx *tx,
 	return 0;
 }
 
+/**
+ * Check if a secondary index of a space with deferred DELETEs
+ * contains a tuple other than @stmt with the given key. If true,
+ * then set a duplicate key error in the diagnostics area.
+ *
+ * The index may return a tuple with the same primary key as
+ * @stmt, because a REPLACE in such a space doesn't delete the
+ * overwritten tuple from secondary indexes. This isn't a
+ * conflict, as the tuple is going to be overwritten.
+ *
+ * @retval  0 Success, the key isn't found.
+ * @retval -1 Memory error or the key is found.
+ */
+static int
+vy_check_is_unique_deferred(struct vy_env *env, struct vy_tx *tx,
+			    const struct vy_read_view **rv,
+			    const char *space_name, const char *index_name,
+			    struct vy_lsm *lsm, struct tuple *key,
+			    const struct tuple *stmt)
+{
+	struct tuple *found;
+	if (env->status != VINYL_ONLINE)
+		return 0;
+	if (vy_lsm_get_deferred(lsm, tx, rv, key, &found) != 0)
+		return -1;
+	if (found == NULL)
+		return 0;
+	bool is_same = vy_tuple_compare(found, stmt,
+					lsm->pk->key_def) == 0;
+	tuple_unref(found);
+	if (!is_same) {
+		diag_set(ClientError, ER_TUPLE_FOUND,
+			 index_name, space_name);
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * Check if insertion of a new tuple violates unique constraint
  * of a secondary index.
@@ -1360,8 +1501,13 @@ vy_check_is_unique_secondary(struct vy_env *env, struct vy_tx *tx,
 							lsm->env->key_format);
 		if (key == NULL)
 			return -1;
-		int rc = vy_check_is_unique(env, tx, rv, space_name,
-					    index_name, lsm, key);
+		int rc;
+		if (lsm->defer_deletes)
+			rc = vy_check_is_unique_deferred(env, tx, rv,
+					space_name, index_name, lsm, key, stmt);
+		else
+			rc = vy_check_is_unique(env, tx, rv, space_name,
+						index_name, lsm, key);
 		tuple_unref(key);
 		return rc;
 	}
@@ -1487,6 +1633,33 @@ error_unref:
 	return -1;
 }
 
+/**
+ * Check if the old tuple doesn't need to be looked up on REPLACE
+ * or DELETE, because deleting it from secondary indexes can be
+ * deferred until the primary index is dumped or compacted, see
+ * vy_lsm::defer_deletes.
+ * @param tx    Current transaction.
+ * @param space Vinyl space.
+ * @param pk    Primary index LSM tree.
+ * @param key   Statement containing the primary key.
+ */
+static inline bool
+vy_can_defer_delete(struct vy_tx *tx, struct space *space,
+		    struct vy_lsm *pk, const struct tuple *key)
+{
+	/* The old tuple is passed to on_replace triggers. */
+	if (!pk->defer_deletes || !rlist_empty(&space->on_replace))
+		return false;
+	/*
+	 * If the key has been modified by this transaction, the
+	 * overwritten statement never reaches the primary index
+	 * and so the write iterator can't generate a DELETE for
+	 * it. Since the old tuple is found in the transaction
+	 * write set without disk access, look it up as usual.
+	 */
+	return write_set_search_key(&tx->write_set, pk, key) == NULL;
+}
+
 /**
  * Execute REPLACE in a space with multiple indexes and lookup for
  * an old tuple, that should has been set in \p stmt->old_tuple if
@@ -1524,12 +1697,17 @@ vy_replace_impl(struct vy_env *env, struct vy_tx *tx, struct space *space,
 	if (new_stmt == NULL)
 		return -1;
 
-	/* Get full tuple from the primary index. */
-	if (vy_lsm_get(pk, tx, vy_tx_read_view(tx),
-			 new_stmt, &old_stmt) != 0)
+	/*
+	 * Get full tuple from the primary index unless deletion
+	 * of the old tuple from secondary indexes is deferred.
+	 */
+	bool defer_delete = vy_can_defer_delete(tx, space, pk, new_stmt);
+	if (!defer_delete &&
+	    vy_lsm_get(pk, tx, vy_tx_read_view(tx),
+		       new_stmt, &old_stmt) != 0)
 		goto error;
 
-	if (old_stmt == NULL) {
+	if (old_stmt == NULL && !defer_delete) {
 		/*
 		 * We can turn REPLACE into INSERT if the new key
 		 * does not have history.
@@ -1651,6 +1829,11 @@ vy_lsm_full_by_key(struct vy_lsm *lsm, struct vy_tx *tx,
 					       key_raw, part_count);
 	if (key == NULL)
 		return -1;
+	if (lsm->index_id > 0 && lsm->defer_deletes) {
+		rc = vy_lsm_get_deferred(lsm, tx, rv, key, result);
+		tuple_unref(key);
+		return rc;
+	}
 	struct tuple *found;
 	rc = vy_lsm_get(lsm, tx, rv, key, &found);
 	tuple_unref(key);
@@ -1740,6 +1923,25 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	uint32_t part_count = mp_decode_array(&key);
 	if (vy_unique_key_validate(lsm, key, part_count))
 		return -1;
+	if (has_secondary && lsm->index_id == 0 && pk->defer_deletes) {
+		/*
+		 * Deletion from secondary indexes may be deferred
+		 * so that the full tuple isn't needed.
+		 */
+		struct tuple *delete =
+			vy_stmt_new_surrogate_delete_from_key(request->key,
+							      pk->key_def,
+							      pk->mem_format);
+		if (delete == NULL)
+			return -1;
+		int rc = 0;
+		bool deferred = vy_can_defer_delete(tx, space, pk, delete);
+		if (deferred)
+			rc = vy_tx_set(tx, pk, delete);
+		tuple_unref(delete);
+		if (deferred)
+			return rc;
+	}
 	/*
 	 * There are two cases when need to get the full tuple
 	 * before deletion.
@@ -2510,6 +2712,11 @@ vy_env_quota_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 			    (dump_bandwidth + e->quota_use_rate + 1));
 
 	vy_quota_set_watermark(&e->quota, watermark);
+	/*
+	 * Writers are throttled above the watermark so that
+	 * the limit isn't hit before the dump completes.
+	 */
+	e->quota.dump_bandwidth = dump_bandwidth;
 }
 
 static void
@@ -2568,6 +2775,97 @@ vy_env_dump_complete_cb(struct vy_scheduler *scheduler,
 				  mem_dumped / dump_duration);
 }
 
+/**
+ * Delete a tuple overwritten in the primary index from a secondary
+ * index LSM tree. The DELETE is assigned the LSN of the statement
+ * that overwrote the tuple.
+ *
+ * Readers of the LSM tree assume that newer in-memory trees and
+ * runs store newer statements and stop at the first DELETE found,
+ * so we must not insert the DELETE if the tuple was deleted or
+ * replaced with an LSN greater than @lsn. Since LSM trees of a
+ * space with deferred DELETEs may contain stale statements, which
+ * are filtered out on read, skipping the DELETE in this case is
+ * safe.
+ */
+static int
+vy_env_deferred_delete_one(struct vy_env *env, struct vy_lsm *lsm,
+			   struct tuple *old_stmt, struct tuple *new_stmt,
+			   int64_t lsn)
+{
+	assert(lsm->index_id > 0);
+	/* Nothing to do if the secondary key was not modified. */
+	if (new_stmt != NULL &&
+	    vy_tuple_compare(old_stmt, new_stmt, lsm->cmp_def) == 0)
+		return 0;
+	/*
+	 * Lookup may yield, so pin the active in-memory tree to
+	 * make sure that all statements inserted after the lookup
+	 * go to the same or newer in-memory tree.
+	 */
+	struct vy_mem *mem = lsm->mem;
+	struct tuple *found;
+	vy_mem_pin(mem);
+	int rc = vy_point_lookup(lsm, NULL, &env->xm->p_global_read_view,
+				 old_stmt, &found);
+	vy_mem_unpin(mem);
+	if (rc != 0)
+		return -1;
+	if (found == NULL)
+		return 0; /* already deleted */
+	int64_t found_lsn = vy_stmt_lsn(found);
+	tuple_unref(found);
+	if (found_lsn >= lsn || lsm->is_dropped)
+		return 0;
+
+	struct tuple *delete = vy_stmt_new_surrogate_delete(lsm->mem_format,
+							    old_stmt);
+	if (delete == NULL)
+		return -1;
+	vy_stmt_set_lsn(delete, lsn);
+
+	size_t mem_used_before = lsregion_used(&env->mem_env.allocator);
+	const struct tuple *region_stmt = NULL;
+	rc = vy_lsm_set(lsm, mem, delete, &region_stmt);
+	tuple_unref(delete);
+	size_t mem_used_after = lsregion_used(&env->mem_env.allocator);
+	assert(mem_used_after >= mem_used_before);
+	if (rc == 0) {
+		vy_lsm_commit_stmt(lsm, mem, region_stmt);
+		vy_quota_force_use(&env->quota,
+				   mem_used_after - mem_used_before);
+	}
+	return rc;
+}
+
+static void
+vy_env_deferred_delete_cb(struct vy_scheduler *scheduler, struct vy_lsm *pk,
+			  struct tuple *old_stmt, struct tuple *new_stmt,
+			  int64_t lsn)
+{
+	struct vy_env *env = container_of(scheduler, struct vy_env, scheduler);
+	/*
+	 * Deletion yields, during which the space can be altered
+	 * or dropped, so look it up anew for each index.
+	 */
+	for (uint32_t iid = 1; ; iid++) {
+		struct space *space = space_by_id(pk->space_id);
+		if (space == NULL || iid >= space->index_count ||
+		    vy_lsm(space->index[0]) != pk)
+			break;
+		struct vy_lsm *lsm = vy_lsm(space->index[iid]);
+		vy_lsm_ref(lsm);
+		if (vy_env_deferred_delete_one(env, lsm, old_stmt,
+					       new_stmt, lsn) != 0) {
+			diag_log();
+			say_error("%s: failed to process deferred delete "
+				  "of %s", vy_lsm_name(lsm),
+				  vy_stmt_str(old_stmt));
+		}
+		vy_lsm_unref(lsm);
+	}
+}
+
 static struct vy_squash_queue *
 vy_squash_queue_new(void);
 static void
@@ -2637,6 +2935,7 @@ vy_env_new(const char *path, size_t memory,
 	vy_mem_env_create(&e->mem_env, e->memory);
 	vy_scheduler_create(&e->scheduler, e->write_threads,
 			    vy_env_dump_complete_cb,
+			    vy_env_deferred_delete_cb,
 			    &e->run_env, &e->xm->read_views);
 
 	if (vy_lsm_env_create(&e->lsm_env, e->path,
@@ -2730,6 +3029,19 @@ vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota)
 	vy_cache_env_set_quota(&vinyl->env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_page_cache(&vinyl->env->run_env, quota);
+}
+
+void
+vinyl_engine_set_max_subcompactions(struct vinyl_engine *vinyl,
+				    int max_subcompactions)
+{
+	vinyl->env->scheduler.max_subcompactions = max_subcompactions;
+}
+
 int
 vinyl_engine_set_memory(struct vinyl_engine *vinyl, size_t size)
 {
@@ -3906,9 +4218,14 @@ next:
 	 * Note, there's no need in vy_tx_track() as the
 	 * tuple is already tracked in the secondary index.
 	 */
-	if (vy_point_lookup(it->lsm->pk, it->tx, vy_tx_read_view(it->tx),
-			    tuple, ret) != 0)
+	if (vy_get_by_secondary_tuple(it->lsm, it->tx,
+				      vy_tx_read_view(it->tx),
+				      tuple, ret) != 0)
 		goto fail;
+	if (*ret == NULL && it->lsm->defer_deletes) {
+		/* Stale statement, see vy_lsm::defer_deletes. */
+		goto next;
+	}
 	if (*ret == NULL) {
 		/*
 		 * All indexes of a space must be consistent, i.e.
@@ -4020,6 +4337,108 @@ vinyl_index_get(struct index *index, const char *key,
 	return 0;
 }
 
+static int
+vinyl_index_get_multi(struct index *index, const char **keys,
+		      uint32_t key_count, struct tuple **result)
+{
+	assert(index->def->opts.is_unique);
+
+	struct vy_lsm *lsm = vy_lsm(index);
+	struct vy_env *env = vy_env(index->engine);
+	struct vy_tx *tx = in_txn() ? in_txn()->engine_tx : NULL;
+	const struct vy_read_view **rv = (tx != NULL ? vy_tx_read_view(tx) :
+					  &env->xm->p_global_read_view);
+	uint32_t part_count = index->def->key_def->part_count;
+	uint32_t i;
+
+	for (i = 0; i < key_count; i++)
+		result[i] = NULL;
+	if (lsm->index_id > 0 && lsm->defer_deletes) {
+		/* Stale statements have to be skipped one by one. */
+		for (i = 0; i < key_count; i++) {
+			if (vy_lsm_full_by_key(lsm, tx, rv, keys[i],
+					       part_count, &result[i]) != 0)
+				goto fail;
+		}
+		return 0;
+	}
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = key_count * (4 * sizeof(struct tuple *) +
+				   sizeof(uint32_t));
+	struct tuple **keys_stmt = region_alloc(region, size);
+	if (keys_stmt == NULL) {
+		diag_set(OutOfMemory, size, "region", "get_multi");
+		return -1;
+	}
+	struct tuple **stmts = keys_stmt + key_count;
+	struct tuple **found = stmts + key_count;
+	struct tuple **full = found + key_count;
+	uint32_t *found_pos = (uint32_t *)(full + key_count);
+	memset(keys_stmt, 0, 2 * key_count * sizeof(*keys_stmt));
+	int rc = -1;
+
+	for (i = 0; i < key_count; i++) {
+		struct tuple *key = vy_stmt_new_select(lsm->env->key_format,
+						       keys[i], part_count);
+		if (key == NULL)
+			goto out;
+		keys_stmt[i] = key;
+		/*
+		 * Keys of a secondary index that lack primary key
+		 * parts are tracked by the read iterator.
+		 */
+		if (tx != NULL && part_count >= lsm->cmp_def->part_count &&
+		    vy_tx_track_point(tx, lsm, key) != 0)
+			goto out;
+	}
+	/*
+	 * Collect statements to look up in the primary index.
+	 * For a secondary index, these are the statements found
+	 * in it, which are looked up in a batch, too.
+	 */
+	if (lsm->index_id == 0) {
+		for (i = 0; i < key_count; i++) {
+			stmts[i] = keys_stmt[i];
+			tuple_ref(stmts[i]);
+		}
+	} else if (vy_point_lookup_multi(lsm, tx, rv, keys_stmt, key_count,
+					 stmts) != 0) {
+		goto out;
+	}
+	uint32_t count = 0;
+	for (i = 0; i < key_count; i++) {
+		if (stmts[i] != NULL) {
+			found[count] = stmts[i];
+			found_pos[count] = i;
+			count++;
+		}
+	}
+	struct vy_lsm *pk = lsm->index_id == 0 ? lsm : lsm->pk;
+	if (vy_point_lookup_multi(pk, tx, rv, found, count, full) != 0)
+		goto out;
+	for (i = 0; i < count; i++)
+		result[found_pos[i]] = full[i];
+	rc = 0;
+out:
+	for (i = 0; i < key_count; i++) {
+		if (keys_stmt[i] != NULL)
+			tuple_unref(keys_stmt[i]);
+		if (stmts[i] != NULL)
+			tuple_unref(stmts[i]);
+	}
+	region_truncate(region, region_svp);
+	return rc;
+fail:
+	for (i = 0; i < key_count; i++) {
+		if (result[i] != NULL)
+			tuple_unref(result[i]);
+		result[i] = NULL;
+	}
+	return -1;
+}
+
 /*** }}} Cursor */
 
 /* {{{ Index build */
@@ -4490,8 +4909,11 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ vinyl_index_get,
+	/* .get_multi = */ vinyl_index_get_multi,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ vinyl_index_stat,
@@ -57,6 +57,20 @@ vinyl_engine_stat(struct vinyl_engine *vinyl, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota);
 
+/**
+ * Update vinyl page cache size.
+ */
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota);
+
+/**
+ * Update the max number of parts a range compaction
+ * can be split into.
+ */
+void
+vinyl_engine_set_max_subcompactions(struct vinyl_engine *vinyl,
+				    int max_subcompactions);
+
 /**
  * Update vinyl memory size.
  */
@@ -174,6 +174,20 @@ struct vy_lsm {
 	 * of another unique index.
 	 */
 	bool check_is_unique;
+	/**
+	 * Set if the space this LSM tree belongs to was created
+	 * with the defer_deletes option. In this case REPLACE and
+	 * DELETE don't delete overwritten tuples from secondary
+	 * index LSM trees. Instead, the DELETEs are generated by
+	 * the write iterator when the primary index is dumped or
+	 * compacted, so a secondary index may return a statement
+	 * that doesn't match the tuple stored in the primary index
+	 * and such statements must be skipped on read. Deferred
+	 * DELETEs are not logged and may be lost on restart, so
+	 * major compaction of a secondary index also checks its
+	 * statements against the primary index.
+	 */
+	bool defer_deletes;
 	/**
 	 * Tuple format for tuples of this LSM tree created when
 	 * reading pages from disk.
@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <small/region.h>
 #include <small/rlist.h>
@@ -46,6 +47,31 @@
 #include "vy_run.h"
 #include "vy_cache.h"
 #include "vy_history.h"
+#include "vy_read_iterator.h"
+
+/**
+ * Pages read in advance by vy_point_lookup_multi(),
+ * sorted by run id and page number.
+ */
+struct vy_point_lookup_pages {
+	struct vy_page_read_req *reqs;
+	int count;
+};
+
+/**
+ * Return a page read in advance that may store the given key
+ * in a slice or NULL if there's no such page.
+ */
+static struct vy_page *
+vy_point_lookup_find_page(struct vy_lsm *lsm,
+			  struct vy_point_lookup_pages *pages,
+			  struct vy_slice *slice, struct tuple *key)
+{
+	if (pages == NULL)
+		return NULL;
+	return vy_slice_find_read_page(slice, key, lsm->cmp_def, lsm->key_def,
+				       pages->reqs, pages->count);
+}
 
 /**
  * Scan TX write set for given key.
@@ -134,6 +160,7 @@ vy_point_lookup_scan_mems(struct vy_lsm *lsm, const struct vy_read_view **rv,
 static int
 vy_point_lookup_scan_slice(struct vy_lsm *lsm, struct vy_slice *slice,
 			   const struct vy_read_view **rv, struct tuple *key,
+			   struct vy_point_lookup_pages *pages,
 			   struct vy_history *history)
 {
 	/*
@@ -145,6 +172,10 @@ vy_point_lookup_scan_slice(struct vy_lsm *lsm, struct vy_slice *slice,
 	vy_run_iterator_open(&run_itr, &lsm->stat.disk.iterator, slice,
 			     ITER_EQ, key, rv, lsm->cmp_def, lsm->key_def,
 			     lsm->disk_format, lsm->index_id == 0);
+	struct vy_page *page = vy_point_lookup_find_page(lsm, pages,
+							 slice, key);
+	if (page != NULL)
+		vy_run_iterator_add_page(&run_itr, page);
 	struct vy_history slice_history;
 	vy_history_create(&slice_history, &lsm->env->history_node_pool);
 	int rc = vy_run_iterator_next(&run_itr, &slice_history);
@@ -161,7 +192,8 @@ vy_point_lookup_scan_slice(struct vy_lsm *lsm, struct vy_slice *slice,
  */
 static int
 vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
-			    struct tuple *key, struct vy_history *history)
+			    struct tuple *key, struct vy_point_lookup_pages *pages,
+			    struct vy_history *history)
 {
 	struct vy_range *range = vy_range_tree_find_by_key(lsm->tree,
 							   ITER_EQ, key);
@@ -185,44 +217,65 @@ vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
 	for (i = 0; i < slice_count; i++) {
 		if (rc == 0 && !vy_history_is_terminal(history))
 			rc = vy_point_lookup_scan_slice(lsm, slices[i],
-							rv, key, history);
+							rv, key, pages,
+							history);
 		vy_slice_unpin(slices[i]);
 	}
 	return rc;
 }
 
-int
-vy_point_lookup(struct vy_lsm *lsm, struct vy_tx *tx,
-		const struct vy_read_view **rv,
-		struct tuple *key, struct tuple **ret)
+/**
+ * Compute the resultant statement from the key history and
+ * add it to the cache if it is the latest version of the key.
+ */
+static int
+vy_point_lookup_apply(struct vy_lsm *lsm, const struct vy_read_view **rv,
+		      struct tuple *key, struct vy_history *history,
+		      struct tuple **ret)
 {
-	assert(tuple_field_count(key) >= lsm->cmp_def->part_count);
+	int upserts_applied;
+	int rc = vy_history_apply(history, lsm->cmp_def, lsm->mem_format,
+				  false, &upserts_applied, ret);
+	lsm->stat.upsert.applied += upserts_applied;
+	if (rc != 0)
+		return -1;
 
-	*ret = NULL;
-	double start_time = ev_monotonic_now(loop());
-	int rc = 0;
+	if (*ret != NULL) {
+		vy_stmt_counter_acct_tuple(&lsm->stat.get, *ret);
+		if ((*rv)->vlsn == INT64_MAX)
+			vy_cache_add(&lsm->cache, *ret, NULL, key, ITER_EQ);
+	}
+	return 0;
+}
 
-	lsm->stat.lookup++;
-	/* History list */
-	struct vy_history history;
-	vy_history_create(&history, &lsm->env->history_node_pool);
+/**
+ * Look up a key, using pages read in advance if any.
+ * The history collected so far is passed in @history.
+ */
+static int
+vy_point_lookup_impl(struct vy_lsm *lsm, struct vy_tx *tx,
+		     const struct vy_read_view **rv, struct tuple *key,
+		     struct vy_point_lookup_pages *pages,
+		     struct vy_history *history, struct tuple **ret)
+{
+	int rc;
 restart:
-	rc = vy_point_lookup_scan_txw(lsm, tx, key, &history);
-	if (rc != 0 || vy_history_is_terminal(&history))
+	rc = vy_point_lookup_scan_txw(lsm, tx, key, history);
+	if (rc != 0 || vy_history_is_terminal(history))
 		goto done;
 
-	rc = vy_point_lookup_scan_cache(lsm, rv, key, &history);
-	if (rc != 0 || vy_history_is_terminal(&history))
+	rc = vy_point_lookup_scan_cache(lsm, rv, key, history);
+	if (rc != 0 || vy_history_is_terminal(history))
 		goto done;
 
-	rc = vy_point_lookup_scan_mems(lsm, rv, key, &history);
-	if (rc != 0 || vy_history_is_terminal(&history))
+	rc = vy_point_lookup_scan_mems(lsm, rv, key, history);
+	if (rc != 0 || vy_history_is_terminal(history))
 		goto done;
 
 	/* Save version before yield */
 	uint32_t mem_list_version = lsm->mem_list_version;
 
-	rc = vy_point_lookup_scan_slices(lsm, rv, key, &history);
+	rc = vy_point_lookup_scan_slices(lsm, rv, key, pages, history);
 	if (rc != 0)
 		goto done;
 
@@ -241,27 +294,33 @@ restart:
 		 * This in unnecessary in case of rotation but since we
 		 * cannot distinguish these two cases we always restart.
 		 */
-		vy_history_cleanup(&history);
+		vy_history_cleanup(history);
 		goto restart;
 	}
 
 done:
-	if (rc == 0) {
-		int upserts_applied;
-		rc = vy_history_apply(&history, lsm->cmp_def, lsm->mem_format,
-				      false, &upserts_applied, ret);
-		lsm->stat.upsert.applied += upserts_applied;
-	}
-	vy_history_cleanup(&history);
+	if (rc == 0)
+		rc = vy_point_lookup_apply(lsm, rv, key, history, ret);
+	vy_history_cleanup(history);
+	return rc;
+}
 
-	if (rc != 0)
-		return -1;
+int
+vy_point_lookup(struct vy_lsm *lsm, struct vy_tx *tx,
+		const struct vy_read_view **rv,
+		struct tuple *key, struct tuple **ret)
+{
+	assert(tuple_field_count(key) >= lsm->cmp_def->part_count);
 
-	if (*ret != NULL) {
-		vy_stmt_counter_acct_tuple(&lsm->stat.get, *ret);
-		if ((*rv)->vlsn == INT64_MAX)
-			vy_cache_add(&lsm->cache, *ret, NULL, key, ITER_EQ);
-	}
+	*ret = NULL;
+	double start_time = ev_monotonic_now(loop());
+
+	lsm->stat.lookup++;
+	/* History list */
+	struct vy_history history;
+	vy_history_create(&history, &lsm->env->history_node_pool);
+	if (vy_point_lookup_impl(lsm, tx, rv, key, NULL, &history, ret) != 0)
+		return -1;
 
 	double latency = ev_monotonic_now(loop()) - start_time;
 	latency_collect(&lsm->stat.latency, latency);
@@ -273,3 +332,198 @@ done:
 	}
 	return 0;
 }
+
+/**
+ * Look up a key of a unique index that lacks primary key parts.
+ * Statements of different full keys may match it, e.g. a DELETE
+ * of an old tuple and a REPLACE of a new one, so the history of
+ * a single key isn't enough and a read iterator is used instead.
+ * Unlike point lookups, it tracks the read in the transaction.
+ */
+static int
+vy_point_lookup_partial(struct vy_lsm *lsm, struct vy_tx *tx,
+			const struct vy_read_view **rv, struct tuple *key,
+			struct vy_point_lookup_pages *pages,
+			struct tuple **ret)
+{
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, lsm, tx, ITER_EQ, key, rv);
+	vy_read_iterator_add_pages(&itr, pages->reqs, pages->count);
+	int rc = vy_read_iterator_next(&itr, ret);
+	if (*ret != NULL)
+		tuple_ref(*ret);
+	vy_read_iterator_close(&itr);
+	return rc;
+}
+
+/**
+ * Collect pages that may store the given keys from all slices
+ * of the ranges the keys fall into. The result is sorted and
+ * has no duplicates.
+ */
+static int
+vy_point_lookup_collect_pages(struct vy_lsm *lsm, struct tuple **keys,
+			      bool *is_pending, int count,
+			      struct vy_point_lookup_pages *pages)
+{
+	int max_count = 0;
+	for (int i = 0; i < count; i++) {
+		if (!is_pending[i])
+			continue;
+		struct vy_range *range = vy_range_tree_find_by_key(lsm->tree,
+							ITER_EQ, keys[i]);
+		assert(range != NULL);
+		max_count += range->slice_count;
+	}
+	pages->reqs = NULL;
+	pages->count = 0;
+	if (max_count == 0)
+		return 0;
+	size_t size = max_count * sizeof(*pages->reqs);
+	pages->reqs = region_alloc(&fiber()->gc, size);
+	if (pages->reqs == NULL) {
+		diag_set(OutOfMemory, size, "region", "page read requests");
+		return -1;
+	}
+	int n = 0;
+	for (int i = 0; i < count; i++) {
+		if (!is_pending[i])
+			continue;
+		struct vy_range *range = vy_range_tree_find_by_key(lsm->tree,
+							ITER_EQ, keys[i]);
+		struct vy_slice *slice;
+		rlist_foreach_entry(slice, &range->slices, in_range) {
+			struct vy_page_read_req *req = &pages->reqs[n];
+			if (!vy_slice_find_page(slice, keys[i], lsm->cmp_def,
+						lsm->key_def, &req->page_no))
+				continue;
+			req->run = slice->run;
+			req->page = NULL;
+			n++;
+		}
+	}
+	if (n == 0)
+		return 0;
+	qsort(pages->reqs, n, sizeof(*pages->reqs), vy_page_read_req_cmp);
+	int unique = 1;
+	for (int i = 1; i < n; i++) {
+		if (vy_page_read_req_cmp(&pages->reqs[unique - 1],
+					 &pages->reqs[i]) != 0)
+			pages->reqs[unique++] = pages->reqs[i];
+	}
+	pages->count = unique;
+	return 0;
+}
+
+int
+vy_point_lookup_multi(struct vy_lsm *lsm, struct vy_tx *tx,
+		      const struct vy_read_view **rv,
+		      struct tuple **keys, int count, struct tuple **ret)
+{
+	if (count == 0)
+		return 0;
+
+	double start_time = ev_monotonic_now(loop());
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int rc = -1;
+	int i;
+
+	bool *is_pending = region_alloc(region, count * sizeof(*is_pending));
+	if (is_pending == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*is_pending),
+			 "region", "is_pending");
+		return -1;
+	}
+	for (i = 0; i < count; i++)
+		ret[i] = NULL;
+
+	/*
+	 * Look up all keys in memory first. This doesn't yield
+	 * so keys found here don't need to be looked up again.
+	 */
+	for (i = 0; i < count; i++) {
+		struct tuple *key = keys[i];
+		if (tuple_field_count(key) < lsm->cmp_def->part_count) {
+			/* Looked up by a read iterator, see below. */
+			assert(lsm->opts.is_unique);
+			is_pending[i] = true;
+			continue;
+		}
+		lsm->stat.lookup++;
+		struct vy_history history;
+		vy_history_create(&history, &lsm->env->history_node_pool);
+		int key_rc = vy_point_lookup_scan_txw(lsm, tx, key, &history);
+		if (key_rc == 0 && !vy_history_is_terminal(&history))
+			key_rc = vy_point_lookup_scan_cache(lsm, rv, key,
+							    &history);
+		if (key_rc == 0 && !vy_history_is_terminal(&history))
+			key_rc = vy_point_lookup_scan_mems(lsm, rv, key,
+							   &history);
+		is_pending[i] = !vy_history_is_terminal(&history);
+		if (key_rc == 0 && !is_pending[i])
+			key_rc = vy_point_lookup_apply(lsm, rv, key,
+						       &history, &ret[i]);
+		vy_history_cleanup(&history);
+		if (key_rc != 0)
+			goto out;
+	}
+
+	/*
+	 * Find pages that may store the remaining keys with the
+	 * aid of bloom filters and page indexes and read them all
+	 * at once so that reads are spread among reader threads.
+	 */
+	struct vy_point_lookup_pages pages;
+	if (vy_point_lookup_collect_pages(lsm, keys, is_pending,
+					  count, &pages) != 0)
+		goto out;
+	for (i = 0; i < pages.count; i++)
+		vy_run_ref(pages.reqs[i].run);
+	if (vy_run_read_pages(pages.reqs, pages.count,
+			      &lsm->stat.disk.iterator) != 0)
+		goto out_unref;
+
+	/*
+	 * Complete the lookups. Since the in-memory sources could
+	 * have changed while we were reading the disk, rescan them.
+	 */
+	for (i = 0; i < count; i++) {
+		if (!is_pending[i])
+			continue;
+		if (tuple_field_count(keys[i]) < lsm->cmp_def->part_count) {
+			if (vy_point_lookup_partial(lsm, tx, rv, keys[i],
+						    &pages, &ret[i]) != 0)
+				goto out_release;
+			continue;
+		}
+		struct vy_history history;
+		vy_history_create(&history, &lsm->env->history_node_pool);
+		if (vy_point_lookup_impl(lsm, tx, rv, keys[i], &pages,
+					 &history, &ret[i]) != 0)
+			goto out_release;
+	}
+	rc = 0;
+
+	double latency = ev_monotonic_now(loop()) - start_time;
+	latency_collect(&lsm->stat.latency, latency);
+	if (latency > lsm->env->too_long_threshold) {
+		say_warn("%s: get_multi(%d keys) took too long: %.3f sec",
+			 vy_lsm_name(lsm), count, latency);
+	}
+out_release:
+	vy_run_release_pages(pages.reqs, pages.count);
+out_unref:
+	for (i = 0; i < pages.count; i++)
+		vy_run_unref(pages.reqs[i].run);
+out:
+	region_truncate(region, region_svp);
+	if (rc != 0) {
+		for (i = 0; i < count; i++) {
+			if (ret[i] != NULL)
+				tuple_unref(ret[i]);
+			ret[i] = NULL;
+		}
+	}
+	return rc;
+}
@@ -74,6 +74,24 @@ vy_point_lookup(struct vy_lsm *lsm, struct vy_tx *tx,
 		const struct vy_read_view **rv,
 		struct tuple *key, struct tuple **ret);
 
+/**
+ * Look up several keys at once. Works like vy_point_lookup()
+ * called for each key, but disk pages that may store the keys
+ * are found with the aid of bloom filters up front and read in
+ * parallel by reader threads. The tuple found for @keys[i] is
+ * returned in @ret[i] with its reference counter elevated or
+ * NULL if there's no such key. On failure, nothing is returned.
+ *
+ * If the index is unique, a key may consist of the index parts
+ * only, without primary index parts. Such a key is looked up
+ * with a read iterator, which tracks the read in @tx itself,
+ * but still uses the pages read in advance.
+ */
+int
+vy_point_lookup_multi(struct vy_lsm *lsm, struct vy_tx *tx,
+		      const struct vy_read_view **rv,
+		      struct tuple **keys, int count, struct tuple **ret);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
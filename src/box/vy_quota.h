@@ -33,6 +33,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <tarantool_ev.h>
 
 #include "fiber.h"
@@ -59,13 +60,32 @@ struct vy_quota {
 	 */
 	size_t limit;
 	/**
-	 * Memory watermark. Exceeding it does not result in
-	 * throttling new transactions, but it does trigger
-	 * background memory reclaim.
+	 * Memory watermark. Exceeding it triggers background
+	 * memory reclaim and makes new transactions slow down,
+	 * see vy_quota_rate_limit().
 	 */
 	size_t watermark;
 	/** Current memory consumption. */
 	size_t used;
+	/**
+	 * Rate at which memory is reclaimed, in bytes per
+	 * second. Used for throttling consumers when memory
+	 * consumption is above the watermark.
+	 */
+	size_t dump_bandwidth;
+	/**
+	 * Time when the next throttled consumer may proceed.
+	 * Every throttled consumer moves it forward by the time
+	 * it takes to consume its memory at the current rate
+	 * limit so that consumers are served one by one. A
+	 * consumer that stops waiting before its turn gives
+	 * its time back.
+	 */
+	double throttle_next;
+	/** Number of times consumers were throttled. */
+	int64_t throttle_count;
+	/** Total time consumers spent throttled, in seconds. */
+	double throttle_time;
 	/**
 	 * If vy_quota_use() takes longer than the given
 	 * value, warn about it in the log.
@@ -89,6 +109,10 @@ vy_quota_create(struct vy_quota *q, vy_quota_exceeded_f quota_exceeded_cb)
 	q->limit = SIZE_MAX;
 	q->watermark = SIZE_MAX;
 	q->used = 0;
+	q->dump_bandwidth = SIZE_MAX;
+	q->throttle_next = 0;
+	q->throttle_count = 0;
+	q->throttle_time = 0;
 	q->too_long_threshold = TIMEOUT_INFINITY;
 	q->quota_exceeded_cb = quota_exceeded_cb;
 	fiber_cond_create(&q->cond);
@@ -124,6 +148,8 @@ vy_quota_set_watermark(struct vy_quota *q, size_t watermark)
 	q->watermark = watermark;
 	if (q->used >= watermark)
 		q->quota_exceeded_cb(q);
+	else
+		q->throttle_next = 0;
 }
 
 /**
@@ -146,19 +172,84 @@ vy_quota_release(struct vy_quota *q, size_t size)
 {
 	assert(q->used >= size);
 	q->used -= size;
+	if (q->used < q->watermark)
+		q->throttle_next = 0;
 	fiber_cond_broadcast(&q->cond);
 }
 
+/**
+ * Return the rate, in bytes per second, at which memory may be
+ * consumed so that memory reclaim completes before the limit is
+ * hit, or 0 if consumers should not be throttled.
+ *
+ * Memory is only reclaimed when a dump completes, so what is left
+ * to the limit must last until all memory is dumped, i.e.
+ *
+ *   limit - used        used
+ *   ------------ = --------------
+ *    rate_limit    dump_bandwidth
+ *
+ * When the watermark is set as described in the comment to
+ * vy_env_quota_timer_cb(), the rate limit is equal to the current
+ * quota use rate at the watermark and decreases smoothly down to
+ * zero as memory consumption approaches the limit.
+ */
+static inline double
+vy_quota_rate_limit(struct vy_quota *q)
+{
+	if (q->used < q->watermark || q->used >= q->limit ||
+	    q->dump_bandwidth == SIZE_MAX)
+		return 0;
+	return (double)(q->limit - q->used) * q->dump_bandwidth /
+	       (q->used + 1) + 1;
+}
+
+/**
+ * Throttle the caller that is going to consume @size bytes if
+ * memory consumption is above the watermark. Stop waiting if
+ * memory is reclaimed or @deadline is reached.
+ */
+static inline void
+vy_quota_throttle(struct vy_quota *q, size_t size, double deadline)
+{
+	double rate_limit = vy_quota_rate_limit(q);
+	if (rate_limit == 0)
+		return;
+	double now = ev_monotonic_now(loop());
+	double wakeup = MAX(now, q->throttle_next);
+	q->throttle_next = wakeup + size / rate_limit;
+	if (wakeup <= now)
+		return;
+	double start_time = now;
+	q->throttle_count++;
+	while (vy_quota_rate_limit(q) != 0 && now < wakeup &&
+	       now < deadline) {
+		fiber_cond_wait_deadline(&q->cond, MIN(wakeup, deadline));
+		now = ev_monotonic_now(loop());
+	}
+	q->throttle_time += now - start_time;
+	if (now < wakeup && q->throttle_next > 0) {
+		/*
+		 * The caller stopped waiting before its turn,
+		 * don't make writers coming after it wait for
+		 * the time slot it reserved.
+		 */
+		q->throttle_next = MAX(q->throttle_next - size / rate_limit,
+				       now);
+	}
+}
+
 /**
  * Try to consume @size bytes of memory, throttle the caller
- * if the limit is exceeded. @timeout specifies the maximal
- * time to wait. Return 0 on success, -1 on timeout.
+ * if the watermark or the limit is exceeded. @timeout specifies
+ * the maximal time to wait. Return 0 on success, -1 on timeout.
  */
 static inline int
 vy_quota_use(struct vy_quota *q, size_t size, double timeout)
 {
 	double start_time = ev_monotonic_now(loop());
 	double deadline = start_time + timeout;
+	vy_quota_throttle(q, size, deadline);
 	while (q->used + size > q->limit && timeout > 0) {
 		q->quota_exceeded_cb(q);
 		if (fiber_cond_wait_deadline(&q->cond, deadline) != 0)
@@ -624,6 +624,11 @@ vy_read_iterator_add_disk(struct vy_read_iterator *itr)
 				     itr->read_view, lsm->cmp_def,
 				     lsm->key_def, lsm->disk_format,
 				     lsm->index_id == 0);
+		struct vy_page *page = vy_slice_find_read_page(slice,
+					itr->key, lsm->cmp_def, lsm->key_def,
+					itr->pages, itr->page_count);
+		if (page != NULL)
+			vy_run_iterator_add_page(&sub_src->run_iterator, page);
 	}
 }
 
@@ -706,6 +711,16 @@ vy_read_iterator_open(struct vy_read_iterator *itr, struct vy_lsm *lsm,
 
 }
 
+void
+vy_read_iterator_add_pages(struct vy_read_iterator *itr,
+			   struct vy_page_read_req *pages, int page_count)
+{
+	assert(itr->iterator_type == ITER_EQ);
+	assert(itr->src_count == 0);
+	itr->pages = pages;
+	itr->page_count = page_count;
+}
+
 /**
  * Restart the read iterator from the position following
  * the last statement returned to the user. Called when
@@ -112,6 +112,13 @@ struct vy_read_iterator {
 	 * front_id from the previous iteration.
 	 */
 	uint32_t prev_front_id;
+	/**
+	 * Pages read in advance by vy_run_read_pages(), sorted
+	 * with vy_page_read_req_cmp(), see vy_read_iterator_add_pages().
+	 */
+	struct vy_page_read_req *pages;
+	/** Number of elements in the pages array. */
+	int page_count;
 };
 
 /**
@@ -129,6 +136,16 @@ vy_read_iterator_open(struct vy_read_iterator *itr, struct vy_lsm *lsm,
 		      struct vy_tx *tx, enum iterator_type iterator_type,
 		      struct tuple *key, const struct vy_read_view **rv);
 
+/**
+ * Make an EQ iterator use pages read in advance by
+ * vy_run_read_pages() instead of reading them from disk.
+ * The pages must stay referenced until the iterator is
+ * closed. Must be called right after opening the iterator.
+ */
+void
+vy_read_iterator_add_pages(struct vy_read_iterator *itr,
+			   struct vy_page_read_req *pages, int page_count);
+
 /**
  * Get the next statement with another key, or start the iterator,
  * if it wasn't started.
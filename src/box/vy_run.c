@@ -30,6 +30,7 @@
  */
 #include "vy_run.h"
 
+#include <stdlib.h>
 #include <zstd.h>
 
 #include "fiber.h"
@@ -95,8 +96,43 @@ struct vy_page_read_task {
 	struct vy_run *run;
 	/** [out] resulting vinyl page */
 	struct vy_page *page;
+	/** Page number, set for asynchronous reads. */
+	uint32_t page_no;
+	/**
+	 * Set if the page read asynchronously isn't needed
+	 * anymore. Such a task frees itself on completion.
+	 */
+	bool is_dropped;
 };
 
+struct vy_page_cache_key {
+	int64_t run_id;
+	uint32_t page_no;
+};
+
+static inline uint32_t
+vy_page_cache_hash(int64_t run_id, uint32_t page_no)
+{
+	uint64_t h = (uint64_t)run_id * 0x9E3779B97F4A7C15ULL ^ page_no;
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+#define mh_name _vy_page_cache
+#define mh_key_t const struct vy_page_cache_key *
+#define mh_node_t struct vy_page *
+#define mh_arg_t void *
+#define mh_hash(a, arg) vy_page_cache_hash((*(a))->run->id, (*(a))->page_no)
+#define mh_hash_key(a, arg) vy_page_cache_hash((a)->run_id, (a)->page_no)
+#define mh_cmp(a, b, arg) ((*(a))->run->id != (*(b))->run->id || \
+			   (*(a))->page_no != (*(b))->page_no)
+#define mh_cmp_key(a, b, arg) ((a)->run_id != (*(b))->run->id || \
+			       (a)->page_no != (*(b))->page_no)
+#define MH_SOURCE 1
+#include "salad/mhash.h"
+
+static void
+vy_page_cache_purge_run(struct vy_page_cache *cache, struct vy_run *run);
+
 /** Destructor for env->zdctx_key thread-local variable */
 static void
 vy_free_zdctx(void *arg)
@@ -172,6 +208,12 @@ vy_run_env_create(struct vy_run_env *env)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	struct vy_page_cache *cache = &env->page_cache;
+	cache->hash = mh_vy_page_cache_new();
+	if (cache->hash == NULL)
+		panic("failed to allocate vinyl page cache");
+	rlist_create(&cache->probation);
+	rlist_create(&cache->protected);
 }
 
 /**
@@ -182,6 +224,8 @@ vy_run_env_destroy(struct vy_run_env *env)
 {
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
+	vy_run_env_set_page_cache(env, 0);
+	mh_vy_page_cache_delete(env->page_cache.hash);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
 }
@@ -269,6 +313,8 @@ void
 vy_run_delete(struct vy_run *run)
 {
 	assert(run->refs == 0);
+	if (run->cached_page_count > 0)
+		vy_page_cache_purge_run(&run->env->page_cache, run);
 	if (run->fd >= 0 && close(run->fd) < 0)
 		say_syserror("close failed");
 	vy_run_clear(run);
@@ -650,6 +696,11 @@ vy_page_new(const struct vy_page_info *page_info)
 		free(page);
 		return NULL;
 	}
+	page->refs = 1;
+	page->run = NULL;
+	page->in_cache = false;
+	page->is_protected = false;
+	rlist_create(&page->in_lru);
 	return page;
 }
 
@@ -668,6 +719,189 @@ vy_page_delete(struct vy_page *page)
 	free(page);
 }
 
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/** Size of memory occupied by a page. */
+static inline size_t
+vy_page_mem_size(const struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(*page->row_index);
+}
+
+/* {{{ vy_page_cache */
+
+/** Remove a page from the page cache and unreference it. */
+static void
+vy_page_cache_remove(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(page->in_cache);
+	struct vy_page_cache_key key = { page->run->id, page->page_no };
+	mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+	assert(k != mh_end(cache->hash));
+	mh_vy_page_cache_del(cache->hash, k, NULL);
+	rlist_del_entry(page, in_lru);
+
+	size_t size = vy_page_mem_size(page);
+	assert(cache->mem_used >= size);
+	cache->mem_used -= size;
+	if (page->is_protected) {
+		assert(cache->protected_used >= size);
+		cache->protected_used -= size;
+		page->is_protected = false;
+	}
+	assert(cache->page_count > 0);
+	cache->page_count--;
+	assert(page->run->cached_page_count > 0);
+	page->run->cached_page_count--;
+	page->in_cache = false;
+	vy_page_unref(page);
+}
+
+/**
+ * Evict least recently used pages until the cache fits in
+ * the given amount of memory. Pages that have been accessed
+ * only once are evicted first.
+ */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, size_t limit)
+{
+	while (cache->mem_used > limit) {
+		struct rlist *lru = !rlist_empty(&cache->probation) ?
+				    &cache->probation : &cache->protected;
+		assert(!rlist_empty(lru));
+		struct vy_page *page = rlist_last_entry(lru, struct vy_page,
+							in_lru);
+		vy_page_cache_remove(cache, page);
+	}
+}
+
+/**
+ * Move a page that has just been accessed to the head of the
+ * protected segment. Pages that don't fit in the segment are
+ * demoted back to the probation segment.
+ */
+static void
+vy_page_cache_touch(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(page->in_cache);
+	rlist_del_entry(page, in_lru);
+	rlist_add_entry(&cache->protected, page, in_lru);
+	if (!page->is_protected) {
+		page->is_protected = true;
+		cache->protected_used += vy_page_mem_size(page);
+	}
+	/* The protected segment may take up to 3/4 of the cache. */
+	size_t protected_quota = cache->mem_quota / 4 * 3;
+	while (cache->protected_used > protected_quota) {
+		struct vy_page *victim = rlist_last_entry(&cache->protected,
+							  struct vy_page,
+							  in_lru);
+		rlist_del_entry(victim, in_lru);
+		rlist_add_entry(&cache->probation, victim, in_lru);
+		victim->is_protected = false;
+		cache->protected_used -= vy_page_mem_size(victim);
+	}
+}
+
+/** Check if a page is in the cache without touching it. */
+static bool
+vy_page_cache_has(struct vy_page_cache *cache, struct vy_run *run,
+		  uint32_t page_no)
+{
+	if (run->cached_page_count == 0)
+		return false;
+	struct vy_page_cache_key key = { run->id, page_no };
+	return mh_vy_page_cache_find(cache->hash, &key,
+				     NULL) != mh_end(cache->hash);
+}
+
+/**
+ * Look up a page in the cache.
+ * @retval not NULL The page. The caller must reference it.
+ * @retval     NULL The page isn't cached.
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, struct vy_run *run,
+		  uint32_t page_no)
+{
+	if (run->cached_page_count == 0)
+		return NULL;
+	struct vy_page_cache_key key = { run->id, page_no };
+	mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+	if (k == mh_end(cache->hash))
+		return NULL;
+	struct vy_page *page = *mh_vy_page_cache_node(cache->hash, k);
+	vy_page_cache_touch(cache, page);
+	return page;
+}
+
+/**
+ * Add a page read from disk to the probation segment of the
+ * cache. The page is silently left out if it doesn't fit in
+ * the cache or another fiber has already cached it.
+ */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(!page->in_cache && page->run != NULL);
+	size_t size = vy_page_mem_size(page);
+	if (size > cache->mem_quota)
+		return;
+	struct vy_page_cache_key key = { page->run->id, page->page_no };
+	if (mh_vy_page_cache_find(cache->hash, &key,
+				  NULL) != mh_end(cache->hash))
+		return;
+	vy_page_cache_evict(cache, cache->mem_quota - size);
+	if (mh_vy_page_cache_put(cache->hash, &page, NULL,
+				 NULL) == mh_end(cache->hash))
+		return; /* out of memory, not critical */
+	vy_page_ref(page);
+	page->in_cache = true;
+	rlist_add_entry(&cache->probation, page, in_lru);
+	cache->mem_used += size;
+	cache->page_count++;
+	page->run->cached_page_count++;
+}
+
+/** Remove all pages of a run from the cache. */
+static void
+vy_page_cache_purge_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	for (uint32_t page_no = 0; run->cached_page_count > 0 &&
+	     page_no < run->info.page_count; page_no++) {
+		struct vy_page_cache_key key = { run->id, page_no };
+		mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+		if (k != mh_end(cache->hash))
+			vy_page_cache_remove(cache,
+				*mh_vy_page_cache_node(cache->hash, k));
+	}
+	assert(run->cached_page_count == 0);
+}
+
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota)
+{
+	struct vy_page_cache *cache = &env->page_cache;
+	cache->mem_quota = quota;
+	vy_page_cache_evict(cache, quota);
+}
+
+/* }}} vy_page_cache */
+
 static int
 vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
 	     struct xrow_header *xrow)
@@ -704,6 +938,9 @@ vy_page_stmt(struct vy_page *page, uint32_t stmt_no,
 	return vy_stmt_decode(&xrow, cmp_def, format, is_primary);
 }
 
+static void
+vy_run_iterator_drop_read_ahead(struct vy_run_iterator *itr);
+
 /**
  * End iteration and free cached data.
  */
@@ -715,11 +952,12 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr_stmt = NULL;
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
+	vy_run_iterator_drop_read_ahead(itr);
 	itr->search_ended = true;
 }
 
@@ -882,39 +1120,274 @@ vy_page_read_cb_free(struct cbus_call_msg *base)
 	return 0;
 }
 
+/** Free an asynchronous read task along with the page it read. */
+static void
+vy_page_read_task_delete(struct vy_page_read_task *task)
+{
+	diag_destroy(&task->base.diag);
+	vy_page_read_cb_free(&task->base);
+}
+
+/**
+ * Asynchronous read hop executed in a reader thread.
+ */
+static void
+vy_page_read_async_perform(struct cmsg *m)
+{
+	struct cbus_call_msg *msg = (struct cbus_call_msg *)m;
+	msg->rc = vy_page_read_cb(msg);
+	if (msg->rc != 0)
+		diag_move(diag_get(), &msg->diag);
+}
+
 /**
- * Read a page from disk given its number.
- * The function caches two most recently read pages.
+ * Asynchronous read hop executed in tx on completion.
+ * Wakes up the fiber waiting for the page, if any.
+ */
+static void
+vy_page_read_async_done(struct cmsg *m)
+{
+	struct vy_page_read_task *task = (struct vy_page_read_task *)m;
+	if (task->is_dropped) {
+		vy_page_read_task_delete(task);
+		return;
+	}
+	task->base.complete = true;
+	if (task->base.caller != NULL)
+		fiber_wakeup(task->base.caller);
+}
+
+/**
+ * Account a page read from disk in iterator statistics
+ * and add it to the page cache.
+ */
+static void
+vy_page_read_complete(struct vy_page *page, struct vy_run *run,
+		      uint32_t page_no, struct vy_run_iterator_stat *stat)
+{
+	struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+	page->run = run;
+	page->page_no = page_no;
+
+	/* Update read statistics. */
+	stat->read.rows += page_info->row_count;
+	stat->read.bytes += page_info->unpacked_size;
+	stat->read.bytes_compressed += page_info->size;
+	stat->read.pages++;
+
+	vy_page_cache_put(&run->env->page_cache, page);
+}
+
+/**
+ * Find a pending read-ahead task for the given page
+ * and remove it from the iterator.
+ */
+static struct vy_page_read_task *
+vy_run_iterator_take_read_ahead(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	for (int i = 0; i < itr->read_ahead_count; i++) {
+		struct vy_page_read_task *task = itr->read_ahead[i];
+		if (task->page_no != page_no)
+			continue;
+		itr->read_ahead[i] = itr->read_ahead[--itr->read_ahead_count];
+		return task;
+	}
+	return NULL;
+}
+
+/**
+ * Drop all pending read-ahead tasks of an iterator.
+ * Tasks that haven't completed yet free themselves
+ * on completion.
+ */
+static void
+vy_run_iterator_drop_read_ahead(struct vy_run_iterator *itr)
+{
+	for (int i = 0; i < itr->read_ahead_count; i++) {
+		struct vy_page_read_task *task = itr->read_ahead[i];
+		if (task->base.complete)
+			vy_page_read_task_delete(task);
+		else
+			task->is_dropped = true;
+	}
+	itr->read_ahead_count = 0;
+}
+
+/**
+ * Post a read of the given page to a reader thread without
+ * waiting for it to complete. Use vy_page_read_task_wait()
+ * to get the page.
  *
- * @retval 0 success
- * @retval -1 critical error
+ * @retval not NULL the task
+ * @retval NULL out of memory
  */
-static NODISCARD int
-vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
-			  struct vy_page **result)
+static struct vy_page_read_task *
+vy_page_read_task_post(struct vy_run *run, uint32_t page_no)
+{
+	struct vy_run_env *env = run->env;
+	assert(env->reader_pool != NULL);
+
+	struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+	struct vy_page *page = vy_page_new(page_info);
+	if (page == NULL)
+		return NULL;
+	struct vy_page_read_task *task = mempool_alloc(&env->read_task_pool);
+	if (task == NULL) {
+		diag_set(OutOfMemory, sizeof(*task), "mempool",
+			 "vy_page_read_task");
+		vy_page_delete(page);
+		return NULL;
+	}
+
+	/* Pick a reader thread. */
+	struct vy_run_reader *reader;
+	reader = &env->reader_pool[env->next_reader++];
+	env->next_reader %= env->reader_pool_size;
+
+	task->run = run;
+	task->page_info = *page_info;
+	task->page = page;
+	task->page_no = page_no;
+	task->is_dropped = false;
+	vy_run_ref(run);
+
+	struct cbus_call_msg *msg = &task->base;
+	diag_create(&msg->diag);
+	msg->caller = NULL;
+	msg->complete = false;
+	msg->rc = 0;
+	msg->func = vy_page_read_cb;
+	msg->free_cb = vy_page_read_cb_free;
+	msg->route[0].f = vy_page_read_async_perform;
+	msg->route[0].pipe = &reader->tx_pipe;
+	msg->route[1].f = vy_page_read_async_done;
+	msg->route[1].pipe = NULL;
+	cmsg_init(cmsg(msg), msg->route);
+	cpipe_push(&reader->reader_pipe, cmsg(msg));
+	return task;
+}
+
+/**
+ * Post a read of the given page ahead of the iterator.
+ */
+static void
+vy_run_iterator_post_read_ahead(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	assert(itr->read_ahead_count < VY_RUN_ITERATOR_READ_AHEAD);
+	struct vy_page_read_task *task;
+	task = vy_page_read_task_post(itr->slice->run, page_no);
+	if (task == NULL)
+		return; /* not critical */
+	itr->read_ahead[itr->read_ahead_count++] = task;
+}
+
+/**
+ * Wait for an asynchronous read task to complete and return
+ * the page it read. The task is freed.
+ *
+ * @retval not NULL the page
+ * @retval NULL read error or the fiber was cancelled
+ */
+static struct vy_page *
+vy_page_read_task_wait(struct vy_page_read_task *task)
+{
+	struct cbus_call_msg *msg = &task->base;
+	if (!msg->complete) {
+		msg->caller = fiber();
+		while (!msg->complete && !fiber_is_cancelled())
+			fiber_yield();
+		msg->caller = NULL;
+	}
+	if (!msg->complete) {
+		/* The task will free itself on completion. */
+		task->is_dropped = true;
+		diag_set(FiberIsCancelled);
+		return NULL;
+	}
+	if (msg->rc != 0) {
+		diag_move(&msg->diag, diag_get());
+		vy_page_read_task_delete(task);
+		return NULL;
+	}
+	struct vy_page *page = task->page;
+	struct vy_run_env *env = task->run->env;
+	vy_run_unref(task->run);
+	mempool_free(&env->read_task_pool, task);
+	return page;
+}
+
+/**
+ * Issue read-ahead if the iterator has just loaded the page
+ * following the previously loaded one in the iteration
+ * direction. Reads of pages already cached or pending are
+ * not issued. Any other access pattern is considered random,
+ * in which case pending read-ahead tasks are dropped.
+ */
+static void
+vy_run_iterator_read_ahead(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	struct vy_slice *slice = itr->slice;
+	struct vy_run *run = slice->run;
+	uint32_t last_page_no = itr->last_page_no;
+	itr->last_page_no = page_no;
+
+	/* Blocking reads are used if there are no reader threads. */
+	if (run->env->reader_pool == NULL)
+		return;
+
+	int dir = iterator_direction(itr->iterator_type);
+	if (last_page_no == UINT32_MAX ||
+	    page_no != last_page_no + dir) {
+		vy_run_iterator_drop_read_ahead(itr);
+		return;
+	}
+	for (int i = 1; i <= VY_RUN_ITERATOR_READ_AHEAD &&
+	     itr->read_ahead_count < VY_RUN_ITERATOR_READ_AHEAD; i++) {
+		if (dir > 0 ? page_no + i > slice->last_page_no :
+			      page_no < slice->first_page_no + i)
+			break;
+		uint32_t next_page_no = page_no + dir * i;
+		bool is_pending = false;
+		for (int j = 0; j < itr->read_ahead_count; j++) {
+			if (itr->read_ahead[j]->page_no == next_page_no)
+				is_pending = true;
+		}
+		if (is_pending || vy_page_cache_has(&run->env->page_cache,
+						    run, next_page_no))
+			continue;
+		vy_run_iterator_post_read_ahead(itr, next_page_no);
+	}
+}
+
+/**
+ * Read a page from disk given its number and add it to
+ * the page cache. If the page is being read ahead, wait
+ * for the pending read instead of issuing a new one.
+ *
+ * @retval not NULL the page
+ * @retval NULL critical error
+ */
+static struct vy_page *
+vy_run_iterator_read_page(struct vy_run_iterator *itr, uint32_t page_no)
 {
 	struct vy_slice *slice = itr->slice;
 	struct vy_run_env *env = slice->run->env;
+	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
+	struct vy_page *page;
 
-	/* Check cache */
-	if (itr->curr_page != NULL) {
-		if (itr->curr_page->page_no == page_no) {
-			*result = itr->curr_page;
-			return 0;
-		}
-		if (itr->prev_page != NULL &&
-		    itr->prev_page->page_no == page_no) {
-			SWAP(itr->prev_page, itr->curr_page);
-			*result = itr->curr_page;
-			return 0;
-		}
+	struct vy_page_read_task *read_ahead;
+	read_ahead = vy_run_iterator_take_read_ahead(itr, page_no);
+	if (read_ahead != NULL) {
+		page = vy_page_read_task_wait(read_ahead);
+		if (page == NULL)
+			return NULL;
+		goto done;
 	}
 
 	/* Allocate buffers */
-	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	struct vy_page *page = vy_page_new(page_info);
+	page = vy_page_new(page_info);
 	if (page == NULL)
-		return -1;
+		return NULL;
 
 	/* Read page data from the disk */
 	int rc;
@@ -926,7 +1399,7 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 			diag_set(OutOfMemory, sizeof(*task), "mempool",
 				 "vy_page_read_task");
 			vy_page_delete(page);
-			return -1;
+			return NULL;
 		}
 
 		/* Pick a reader thread. */
@@ -944,7 +1417,7 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 			       &task->base, vy_page_read_cb,
 			       vy_page_read_cb_free, TIMEOUT_INFINITY);
 		if (!task->base.complete)
-			return -1; /* timed out or cancelled */
+			return NULL; /* timed out or cancelled */
 
 		vy_run_unref(task->run);
 		mempool_free(&env->read_task_pool, task);
@@ -952,7 +1425,7 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		if (rc != 0) {
 			/* posted, but failed */
 			vy_page_delete(page);
-			return -1;
+			return NULL;
 		}
 	} else {
 		/*
@@ -962,26 +1435,69 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		ZSTD_DStream *zdctx = vy_env_get_zdctx(env);
 		if (zdctx == NULL) {
 			vy_page_delete(page);
-			return -1;
+			return NULL;
 		}
 		if (vy_page_read(page, page_info, slice->run, zdctx) != 0) {
 			vy_page_delete(page);
-			return -1;
+			return NULL;
+		}
+	}
+done:
+	vy_page_read_complete(page, slice->run, page_no, itr->stat);
+	return page;
+}
+
+/**
+ * Load a page given its number. The page is looked up in the
+ * two most recently loaded pages, then in the page cache, and
+ * is read from disk only if neither has it.
+ *
+ * @retval 0 success
+ * @retval -1 critical error
+ */
+static NODISCARD int
+vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
+			  struct vy_page **result)
+{
+	struct vy_run *run = itr->slice->run;
+	struct vy_page_cache *cache = &run->env->page_cache;
+
+	/* Check cache */
+	if (itr->curr_page != NULL) {
+		if (itr->curr_page->page_no == page_no) {
+			*result = itr->curr_page;
+			return 0;
+		}
+		if (itr->prev_page != NULL &&
+		    itr->prev_page->page_no == page_no) {
+			SWAP(itr->prev_page, itr->curr_page);
+			*result = itr->curr_page;
+			return 0;
+		}
+	}
+
+	struct vy_page *page = NULL;
+	if (cache->mem_quota > 0) {
+		page = vy_page_cache_get(cache, run, page_no);
+		if (page != NULL) {
+			vy_page_ref(page);
+			cache->hit++;
+		} else {
+			cache->miss++;
 		}
 	}
+	if (page == NULL) {
+		page = vy_run_iterator_read_page(itr, page_no);
+		if (page == NULL)
+			return -1;
+	}
+	vy_run_iterator_read_ahead(itr, page_no);
 
 	/* Update cache */
 	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
+		vy_page_unref(itr->prev_page);
 	itr->prev_page = itr->curr_page;
 	itr->curr_page = page;
-	page->page_no = page_no;
-
-	/* Update read statistics. */
-	itr->stat->read.rows += page_info->row_count;
-	itr->stat->read.bytes += page_info->unpacked_size;
-	itr->stat->read.bytes_compressed += page_info->size;
-	itr->stat->read.pages++;
 
 	*result = page;
 	return 0;
@@ -1410,6 +1926,8 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 	itr->curr_pos.page_no = slice->run->info.page_count;
 	itr->curr_page = NULL;
 	itr->prev_page = NULL;
+	itr->last_page_no = UINT32_MAX;
+	itr->read_ahead_count = 0;
 
 	itr->search_started = false;
 	itr->search_ended = false;
@@ -1579,6 +2097,216 @@ vy_run_iterator_close(struct vy_run_iterator *itr)
 	TRASH(itr);
 }
 
+void
+vy_run_iterator_add_page(struct vy_run_iterator *itr, struct vy_page *page)
+{
+	assert(itr->curr_page == NULL);
+	assert(page->run == itr->slice->run);
+	vy_page_ref(page);
+	itr->curr_page = page;
+}
+
+bool
+vy_slice_find_page(struct vy_slice *slice, const struct tuple *key,
+		   const struct key_def *cmp_def,
+		   const struct key_def *key_def, uint32_t *page_no)
+{
+	struct vy_run *run = slice->run;
+	if (slice->begin != NULL &&
+	    vy_stmt_compare_with_key(key, slice->begin, cmp_def) < 0)
+		return false;
+	if (slice->end != NULL &&
+	    vy_stmt_compare_with_key(key, slice->end, cmp_def) >= 0)
+		return false;
+	struct tuple_bloom *bloom = run->info.bloom;
+	if (bloom != NULL) {
+		bool need_lookup;
+		if (vy_stmt_type(key) == IPROTO_SELECT) {
+			const char *data = tuple_data(key);
+			uint32_t part_count = mp_decode_array(&data);
+			need_lookup = tuple_bloom_maybe_has_key(bloom, data,
+							part_count, key_def);
+		} else {
+			need_lookup = tuple_bloom_maybe_has(bloom, key,
+							    key_def);
+		}
+		if (!need_lookup)
+			return false;
+	}
+	bool equal_key;
+	*page_no = vy_page_index_find_page(run, key, cmp_def, ITER_EQ,
+					   &equal_key);
+	return *page_no < run->info.page_count;
+}
+
+int
+vy_page_read_req_cmp(const void *a_raw, const void *b_raw)
+{
+	const struct vy_page_read_req *a = a_raw;
+	const struct vy_page_read_req *b = b_raw;
+	if (a->run->id != b->run->id)
+		return a->run->id < b->run->id ? -1 : 1;
+	if (a->page_no != b->page_no)
+		return a->page_no < b->page_no ? -1 : 1;
+	return 0;
+}
+
+struct vy_page *
+vy_slice_find_read_page(struct vy_slice *slice, const struct tuple *key,
+			const struct key_def *cmp_def,
+			const struct key_def *key_def,
+			struct vy_page_read_req *reqs, int count)
+{
+	struct vy_page_read_req req;
+	if (count == 0 ||
+	    !vy_slice_find_page(slice, key, cmp_def, key_def, &req.page_no))
+		return NULL;
+	req.run = slice->run;
+	struct vy_page_read_req *found = bsearch(&req, reqs, count,
+						 sizeof(req),
+						 vy_page_read_req_cmp);
+	return found != NULL ? found->page : NULL;
+}
+
+int
+vy_run_read_pages(struct vy_page_read_req *reqs, int count,
+		  struct vy_run_iterator_stat *stat)
+{
+	for (int i = 0; i < count; i++)
+		reqs[i].page = NULL;
+	if (count == 0 || reqs[0].run->env->reader_pool == NULL)
+		return 0;
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct vy_page_read_task **tasks = region_alloc(region,
+						count * sizeof(*tasks));
+	if (tasks == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*tasks),
+			 "region", "page read tasks");
+		return -1;
+	}
+	memset(tasks, 0, count * sizeof(*tasks));
+	/* Post all reads at once so that they run in parallel. */
+	for (int i = 0; i < count; i++) {
+		struct vy_run *run = reqs[i].run;
+		if (vy_page_cache_has(&run->env->page_cache, run,
+				      reqs[i].page_no))
+			continue;
+		tasks[i] = vy_page_read_task_post(run, reqs[i].page_no);
+		if (tasks[i] == NULL)
+			goto fail;
+	}
+	for (int i = 0; i < count; i++) {
+		if (tasks[i] == NULL)
+			continue;
+		struct vy_page *page = vy_page_read_task_wait(tasks[i]);
+		tasks[i] = NULL;
+		if (page == NULL)
+			goto fail;
+		vy_page_read_complete(page, reqs[i].run, reqs[i].page_no,
+				      stat);
+		reqs[i].page = page;
+	}
+	region_truncate(region, region_svp);
+	return 0;
+fail:
+	for (int i = 0; i < count; i++) {
+		struct vy_page_read_task *task = tasks[i];
+		if (task == NULL)
+			continue;
+		if (task->base.complete)
+			vy_page_read_task_delete(task);
+		else
+			task->is_dropped = true;
+	}
+	region_truncate(region, region_svp);
+	vy_run_release_pages(reqs, count);
+	return -1;
+}
+
+void
+vy_run_release_pages(struct vy_page_read_req *reqs, int count)
+{
+	for (int i = 0; i < count; i++) {
+		if (reqs[i].page != NULL)
+			vy_page_unref(reqs[i].page);
+		reqs[i].page = NULL;
+	}
+}
+
+int
+vy_run_find_stmt(struct vy_run *run, const struct tuple *key, int64_t vlsn,
+		 const struct key_def *cmp_def, const struct key_def *key_def,
+		 struct tuple_format *format, bool is_primary,
+		 struct tuple **ret)
+{
+	*ret = NULL;
+	if (run->info.page_count == 0)
+		return 0;
+	struct tuple_bloom *bloom = run->info.bloom;
+	if (bloom != NULL && !tuple_bloom_maybe_has(bloom, key, key_def))
+		return 0;
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(run->env);
+	if (zdctx == NULL)
+		return -1;
+	bool unused;
+	uint32_t page_no = vy_page_index_find_page(run, key, cmp_def,
+						   ITER_GE, &unused);
+	/*
+	 * Statements are sorted by key, then by LSN in descending
+	 * order. The history of the key may span several pages.
+	 */
+	struct vy_page *page;
+	for (; page_no < run->info.page_count; page_no++) {
+		struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+		page = vy_page_new(page_info);
+		if (page == NULL)
+			return -1;
+		if (vy_page_read(page, page_info, run, zdctx) != 0)
+			goto fail;
+		/* Find the first statement for the key in the page. */
+		uint32_t begin = 0, end = page->row_count;
+		while (begin != end) {
+			uint32_t mid = begin + (end - begin) / 2;
+			struct tuple *stmt = vy_page_stmt(page, mid, cmp_def,
+							  format, is_primary);
+			if (stmt == NULL)
+				goto fail;
+			int cmp = vy_stmt_compare(stmt, key, cmp_def);
+			tuple_unref(stmt);
+			if (cmp < 0)
+				begin = mid + 1;
+			else
+				end = mid;
+		}
+		/* Skip statements invisible from the read view. */
+		for (uint32_t pos = begin; pos < page->row_count; pos++) {
+			struct tuple *stmt = vy_page_stmt(page, pos, cmp_def,
+							  format, is_primary);
+			if (stmt == NULL)
+				goto fail;
+			if (vy_stmt_compare(stmt, key, cmp_def) != 0) {
+				/* No more statements for the key. */
+				tuple_unref(stmt);
+				vy_page_delete(page);
+				return 0;
+			}
+			if (vy_stmt_lsn(stmt) <= vlsn) {
+				*ret = stmt;
+				vy_page_delete(page);
+				return 0;
+			}
+			tuple_unref(stmt);
+		}
+		vy_page_delete(page);
+	}
+	return 0;
+fail:
+	vy_page_delete(page);
+	return -1;
+}
+
 /* }}} vy_run_iterator API implementation */
 
 /** Account a page to run statistics. */
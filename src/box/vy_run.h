@@ -51,6 +51,40 @@ extern "C" {
 
 struct vy_history;
 struct vy_run_reader;
+struct mh_vy_page_cache_t;
+
+/**
+ * Cache of decompressed run pages shared by all runs of
+ * a vinyl environment. Pages are looked up by run id and
+ * page number.
+ *
+ * Eviction follows the segmented LRU scheme: a page read
+ * from disk is put to the probation segment and gets to the
+ * protected segment only if it is accessed again, so a range
+ * scan can't wash hot pages out of the cache.
+ *
+ * The cache is accessed from the tx thread only.
+ */
+struct vy_page_cache {
+	/** Run id and page number => struct vy_page. */
+	struct mh_vy_page_cache_t *hash;
+	/** Pages accessed once, most recently used first. */
+	struct rlist probation;
+	/** Pages accessed more than once, MRU first. */
+	struct rlist protected;
+	/** Size of memory occupied by cached pages. */
+	size_t mem_used;
+	/** Size of memory occupied by protected pages. */
+	size_t protected_used;
+	/** Max size of memory that can be used by the cache. */
+	size_t mem_quota;
+	/** Number of pages in the cache. */
+	int64_t page_count;
+	/** Number of lookups that found a page in the cache. */
+	int64_t hit;
+	/** Number of lookups that had to read a page from disk. */
+	int64_t miss;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -69,6 +103,8 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Cache of decompressed pages. */
+	struct vy_page_cache page_cache;
 };
 
 /**
@@ -149,6 +185,8 @@ struct vy_run {
 	struct rlist in_unused;
 	/** Link in vy_lsm::runs list. */
 	struct rlist in_lsm;
+	/** Number of pages of this run in the page cache. */
+	uint32_t cached_page_count;
 };
 
 /**
@@ -195,6 +233,14 @@ struct vy_slice {
 	struct vy_disk_stmt_counter count;
 };
 
+/**
+ * Max number of pages a run iterator reads ahead once it
+ * detects sequential access, see vy_run_iterator::read_ahead.
+ */
+enum { VY_RUN_ITERATOR_READ_AHEAD = 4 };
+
+struct vy_page_read_task;
+
 /** Position of a particular stmt in vy_run. */
 struct vy_run_iterator_pos {
 	uint32_t page_no;
@@ -257,6 +303,21 @@ struct vy_run_iterator {
 	 */
 	struct vy_page *curr_page;
 	struct vy_page *prev_page;
+	/**
+	 * Number of the last page loaded by the iterator or
+	 * UINT32_MAX if none. Used for detecting sequential
+	 * access.
+	 */
+	uint32_t last_page_no;
+	/**
+	 * Reads of the pages following the last loaded one in
+	 * the iteration direction, posted to reader threads
+	 * without waiting for them to complete. Issued only
+	 * while the iterator reads pages one after another.
+	 */
+	struct vy_page_read_task *read_ahead[VY_RUN_ITERATOR_READ_AHEAD];
+	/** Number of pending read-ahead tasks. */
+	int read_ahead_count;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
 	/** Search is finished, you will not get more values from iterator */
@@ -267,6 +328,18 @@ struct vy_run_iterator {
  * Vinyl page stored in memory.
  */
 struct vy_page {
+	/**
+	 * Reference counter. A page is referenced by the page
+	 * cache and by each run iterator that keeps it loaded.
+	 */
+	int refs;
+	/**
+	 * Run this page was read from. Set for pages loaded by
+	 * run iterators, which are the only pages to be cached.
+	 * A cached page never outlives its run, because pages
+	 * are purged from the cache when the run is deleted.
+	 */
+	struct vy_run *run;
 	/** Page position in the run file. */
 	uint32_t page_no;
 	/** Size of page data in memory, i.e. unpacked. */
@@ -277,6 +350,12 @@ struct vy_page {
 	uint32_t *row_index;
 	/** Pointer to the page data. */
 	char *data;
+	/** Set if the page is in the page cache. */
+	bool in_cache;
+	/** Set if the page is in the protected LRU segment. */
+	bool is_protected;
+	/** Link in one of vy_page_cache LRU lists. */
+	struct rlist in_lru;
 };
 
 /**
@@ -303,6 +382,14 @@ vy_run_env_destroy(struct vy_run_env *env);
 void
 vy_run_env_enable_coio(struct vy_run_env *env, int threads);
 
+/**
+ * Set the max size of memory that can be used by the page
+ * cache of a vinyl run environment. Pages that don't fit
+ * are evicted immediately. Zero disables the cache.
+ */
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota);
+
 /**
  * Return the size of a run bloom filter.
  */
@@ -525,6 +612,91 @@ vy_run_iterator_skip(struct vy_run_iterator *itr,
 void
 vy_run_iterator_close(struct vy_run_iterator *itr);
 
+/**
+ * Make a run iterator use a page read in advance by
+ * vy_run_read_pages() instead of reading it from disk.
+ * Must be called right after opening the iterator.
+ */
+void
+vy_run_iterator_add_page(struct vy_run_iterator *itr, struct vy_page *page);
+
+/** A request to read a run page, see vy_run_read_pages(). */
+struct vy_page_read_req {
+	/** Run to read the page from. */
+	struct vy_run *run;
+	/** Number of the page to read. */
+	uint32_t page_no;
+	/** [out] The page or NULL if it wasn't read. */
+	struct vy_page *page;
+};
+
+/**
+ * Find the page of a slice that may store statements for
+ * the given full key without reading anything from disk.
+ * Returns false if the key is out of the slice boundaries
+ * or the bloom filter says it isn't in the run.
+ */
+bool
+vy_slice_find_page(struct vy_slice *slice, const struct tuple *key,
+		   const struct key_def *cmp_def,
+		   const struct key_def *key_def, uint32_t *page_no);
+
+/**
+ * Compare page read requests by run id and page number.
+ * Suitable for sorting an array of requests with qsort().
+ */
+int
+vy_page_read_req_cmp(const void *a, const void *b);
+
+/**
+ * Return a page that may store the given key in a slice among
+ * pages read by vy_run_read_pages() or NULL if there's no such
+ * page. @reqs must be sorted with vy_page_read_req_cmp().
+ */
+struct vy_page *
+vy_slice_find_read_page(struct vy_slice *slice, const struct tuple *key,
+			const struct key_def *cmp_def,
+			const struct key_def *key_def,
+			struct vy_page_read_req *reqs, int count);
+
+/**
+ * Read the requested pages from disk, posting all reads to
+ * reader threads at once so that they are executed in parallel.
+ * The pages are accounted in @stat and added to the page cache.
+ * Pages that are already cached are skipped, as is everything
+ * if there are no reader threads.
+ *
+ * Pages must be released with vy_run_release_pages().
+ *
+ * @retval 0 success
+ * @retval -1 read error or the fiber was cancelled
+ */
+int
+vy_run_read_pages(struct vy_page_read_req *reqs, int count,
+		  struct vy_run_iterator_stat *stat);
+
+/** Release pages read by vy_run_read_pages(). */
+void
+vy_run_release_pages(struct vy_page_read_req *reqs, int count);
+
+/**
+ * Find the newest statement for the given full key visible
+ * from a read view with LSN @vlsn in a run. Unlike the run
+ * iterator, reads pages directly, bypassing the page cache
+ * and reader threads, so can be called from a worker thread.
+ *
+ * The statement is returned in @ret (NULL if not found) and
+ * must be unreferenced after usage.
+ *
+ * @retval 0 success
+ * @retval -1 read error or out of memory
+ */
+int
+vy_run_find_stmt(struct vy_run *run, const struct tuple *key, int64_t vlsn,
+		 const struct key_def *cmp_def, const struct key_def *key_def,
+		 struct tuple_format *format, bool is_primary,
+		 struct tuple **ret);
+
 /**
  * Simple stream over a slice. @see vy_stmt_stream.
  */
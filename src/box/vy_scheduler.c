@@ -53,6 +53,7 @@
 #include "vy_mem.h"
 #include "vy_range.h"
 #include "vy_run.h"
+#include "vy_stmt.h"
 #include "vy_write_iterator.h"
 #include "trivia/util.h"
 #include "tt_pthread.h"
@@ -60,11 +61,14 @@
 /* Min and max values for vy_scheduler::timeout. */
 #define VY_SCHEDULER_TIMEOUT_MIN	1
 #define VY_SCHEDULER_TIMEOUT_MAX	60
+/* Max number of tasks a range compaction can be split into. */
+#define VY_SUBCOMPACTION_MAX_PARTS	16
 
 static void *vy_worker_f(void *);
 static int vy_scheduler_f(va_list);
 
 struct vy_task;
+struct vy_subcompaction;
 
 struct vy_task_ops {
 	/**
@@ -132,8 +136,239 @@ struct vy_task {
 	 */
 	double bloom_fpr;
 	int64_t page_size;
+	/**
+	 * Handler passed to the write iterator of a primary index
+	 * LSM tree with deferred DELETEs.
+	 */
+	struct vy_deferred_delete_handler deferred_delete_handler;
+	/**
+	 * Tuples overwritten in the primary index, collected by
+	 * the write iterator in a worker thread and processed in
+	 * the tx thread on task completion. Linked by
+	 * vy_deferred_delete::in_task.
+	 */
+	struct stailq deferred_deletes;
+	/**
+	 * Filter passed to the write iterator compacting
+	 * a secondary index LSM tree with deferred DELETEs.
+	 */
+	struct vy_stale_stmt_filter stale_stmt_filter;
+	/** Primary index runs used by the stale statement filter. */
+	struct vy_pk_snapshot *pk_snapshot;
+	/**
+	 * Set if the task compacts a part of a range that is
+	 * compacted by several tasks at once.
+	 */
+	struct vy_subcompaction *subcompaction;
+	/** Number of the range part compacted by this task. */
+	int part_no;
+	/**
+	 * Slices of compacted runs cut at the boundaries of
+	 * the range part, linked by vy_slice::in_range.
+	 */
+	struct rlist part_slices;
+	/** Next task to be queued along with this one. */
+	struct vy_task *next;
 };
 
+/**
+ * A range compacted by several worker threads at once.
+ *
+ * The range is split into parts at page min keys of its
+ * oldest run. Each part is compacted by a separate task into
+ * a separate run. When all the tasks are done, the range is
+ * replaced with new ranges, one per part, in one metadata log
+ * transaction.
+ */
+struct vy_subcompaction {
+	/** Range being compacted. */
+	struct vy_range *range;
+	/** First (newest) and last (oldest) compacted slices. */
+	struct vy_slice *first_slice, *last_slice;
+	/** Number of parts the range is split into. */
+	int part_count;
+	/** Number of tasks that haven't finished yet. */
+	int pending_count;
+	/** Set if any of the tasks failed. */
+	bool is_failed;
+	/**
+	 * Part boundaries: part i spans keys [keys[i], keys[i + 1]).
+	 * keys[0] and keys[part_count] are the range boundaries.
+	 */
+	struct tuple **keys;
+	/** Runs written by the tasks, indexed by part number. */
+	struct vy_run **new_runs;
+	/** Ranges replacing the compacted range on completion. */
+	struct vy_range **new_ranges;
+};
+
+/**
+ * A tuple overwritten in the primary index of a space with
+ * deferred DELETEs. The tuple data are copied to malloc'ed
+ * memory, because statements read by a worker thread can't be
+ * referenced from the tx thread.
+ */
+struct vy_deferred_delete {
+	/** Link in vy_task::deferred_deletes. */
+	struct stailq_entry in_task;
+	/** LSN of the statement that overwrote the tuple. */
+	int64_t lsn;
+	/** Size of the overwritten tuple data. */
+	uint32_t old_size;
+	/**
+	 * Size of the data of the tuple that overwrote the old
+	 * one or 0 if the old tuple was deleted.
+	 */
+	uint32_t new_size;
+	/** Old tuple data followed by new tuple data. */
+	char data[0];
+};
+
+/** A range of a primary index LSM tree, see vy_pk_snapshot. */
+struct vy_pk_snapshot_range {
+	/** Range boundaries, see vy_range::begin, end. */
+	struct tuple *begin;
+	struct tuple *end;
+	/** Runs of the range, newest first. */
+	struct vy_run **runs;
+	/** Number of entries in @runs. */
+	int run_count;
+};
+
+/**
+ * Runs of a primary index LSM tree taken when a task compacting
+ * a secondary index of a space with deferred DELETEs is created.
+ * Used by a worker thread to look up tuples in the primary index
+ * in order to drop stale statements, see vy_task_is_stale().
+ * Since the range tree may change while the task is in progress,
+ * the runs are referenced and the range boundaries are copied.
+ */
+struct vy_pk_snapshot {
+	/** Primary index LSM tree. */
+	struct vy_lsm *pk;
+	/** Copies of pk->cmp_def and pk->key_def. */
+	struct key_def *cmp_def;
+	struct key_def *key_def;
+	/** Value of pk->dump_lsn when the snapshot was taken. */
+	int64_t dump_lsn;
+	/** Number of entries in @ranges. */
+	int range_count;
+	/** Ranges of the primary index, ordered by key. */
+	struct vy_pk_snapshot_range ranges[0];
+};
+
+static void
+vy_pk_snapshot_delete(struct vy_pk_snapshot *snapshot)
+{
+	for (int i = 0; i < snapshot->range_count; i++) {
+		struct vy_pk_snapshot_range *range = &snapshot->ranges[i];
+		if (range->begin != NULL)
+			tuple_unref(range->begin);
+		if (range->end != NULL)
+			tuple_unref(range->end);
+		for (int j = 0; j < range->run_count; j++)
+			vy_run_unref(range->runs[j]);
+	}
+	if (snapshot->cmp_def != NULL)
+		key_def_delete(snapshot->cmp_def);
+	if (snapshot->key_def != NULL)
+		key_def_delete(snapshot->key_def);
+	vy_lsm_unref(snapshot->pk);
+	TRASH(snapshot);
+	free(snapshot);
+}
+
+/** Take a snapshot of the runs of a primary index LSM tree. */
+static struct vy_pk_snapshot *
+vy_pk_snapshot_new(struct vy_lsm *pk)
+{
+	assert(pk->index_id == 0);
+	int run_count = 0;
+	struct vy_range *range;
+	for (range = vy_range_tree_first(pk->tree); range != NULL;
+	     range = vy_range_tree_next(pk->tree, range))
+		run_count += range->slice_count;
+
+	size_t size = sizeof(struct vy_pk_snapshot) +
+		      pk->range_count * sizeof(struct vy_pk_snapshot_range) +
+		      run_count * sizeof(struct vy_run *);
+	struct vy_pk_snapshot *snapshot = calloc(1, size);
+	if (snapshot == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_pk_snapshot");
+		return NULL;
+	}
+	snapshot->pk = pk;
+	vy_lsm_ref(pk);
+	snapshot->dump_lsn = pk->dump_lsn;
+
+	struct vy_run **runs = (struct vy_run **)(snapshot->ranges +
+						  pk->range_count);
+	for (range = vy_range_tree_first(pk->tree); range != NULL;
+	     range = vy_range_tree_next(pk->tree, range)) {
+		struct vy_pk_snapshot_range *r;
+		r = &snapshot->ranges[snapshot->range_count++];
+		r->begin = range->begin;
+		if (r->begin != NULL)
+			tuple_ref(r->begin);
+		r->end = range->end;
+		if (r->end != NULL)
+			tuple_ref(r->end);
+		r->runs = runs;
+		struct vy_slice *slice;
+		rlist_foreach_entry(slice, &range->slices, in_range) {
+			vy_run_ref(slice->run);
+			r->runs[r->run_count++] = slice->run;
+		}
+		runs += r->run_count;
+	}
+	assert(snapshot->range_count == pk->range_count);
+
+	snapshot->cmp_def = key_def_dup(pk->cmp_def);
+	if (snapshot->cmp_def == NULL)
+		goto fail;
+	snapshot->key_def = key_def_dup(pk->key_def);
+	if (snapshot->key_def == NULL)
+		goto fail;
+	return snapshot;
+fail:
+	vy_pk_snapshot_delete(snapshot);
+	return NULL;
+}
+
+/**
+ * Look up the newest statement for the primary key of a tuple
+ * visible from a read view in a primary index snapshot.
+ */
+static int
+vy_pk_snapshot_get(struct vy_pk_snapshot *snapshot, struct tuple *tuple,
+		   int64_t vlsn, struct tuple **result)
+{
+	*result = NULL;
+	/* Find the range the key belongs to. */
+	int begin = 0, end = snapshot->range_count;
+	while (begin != end) {
+		int mid = begin + (end - begin) / 2;
+		struct tuple *range_end = snapshot->ranges[mid].end;
+		if (range_end != NULL &&
+		    vy_stmt_compare(tuple, range_end, snapshot->cmp_def) >= 0)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	if (begin == snapshot->range_count)
+		return 0;
+	struct vy_pk_snapshot_range *range = &snapshot->ranges[begin];
+	for (int i = 0; i < range->run_count && *result == NULL; i++) {
+		if (vy_run_find_stmt(range->runs[i], tuple, vlsn,
+				     snapshot->cmp_def, snapshot->key_def,
+				     snapshot->pk->disk_format, true,
+				     result) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 /**
  * Allocate a new task to be executed by a worker thread.
  * When preparing an asynchronous task, this function must
@@ -167,6 +402,8 @@ vy_task_new(struct mempool *pool, struct vy_lsm *lsm,
 	}
 	vy_lsm_ref(lsm);
 	diag_create(&task->diag);
+	stailq_create(&task->deferred_deletes);
+	rlist_create(&task->part_slices);
 	return task;
 }
 
@@ -174,6 +411,16 @@ vy_task_new(struct mempool *pool, struct vy_lsm *lsm,
 static void
 vy_task_delete(struct mempool *pool, struct vy_task *task)
 {
+	struct vy_deferred_delete *dd, *next_dd;
+	stailq_foreach_entry_safe(dd, next_dd, &task->deferred_deletes,
+				  in_task)
+		free(dd);
+	struct vy_slice *slice, *next_slice;
+	rlist_foreach_entry_safe(slice, &task->part_slices, in_range,
+				 next_slice)
+		vy_slice_delete(slice);
+	if (task->pk_snapshot != NULL)
+		vy_pk_snapshot_delete(task->pk_snapshot);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
 	vy_lsm_unref(task->lsm);
@@ -312,11 +559,13 @@ vy_scheduler_stop_workers(struct vy_scheduler *scheduler)
 void
 vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 		    vy_scheduler_dump_complete_f dump_complete_cb,
+		    vy_scheduler_deferred_delete_f deferred_delete_cb,
 		    struct vy_run_env *run_env, struct rlist *read_views)
 {
 	memset(scheduler, 0, sizeof(*scheduler));
 
 	scheduler->dump_complete_cb = dump_complete_cb;
+	scheduler->deferred_delete_cb = deferred_delete_cb;
 	scheduler->read_views = read_views;
 	scheduler->run_env = run_env;
 
@@ -330,6 +579,7 @@ vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 	ev_async_init(&scheduler->scheduler_async, vy_scheduler_async_cb);
 
 	scheduler->worker_pool_size = write_threads;
+	scheduler->max_subcompactions = 1;
 	mempool_create(&scheduler->task_pool, cord_slab_cache(),
 		       sizeof(struct vy_task));
 	stailq_create(&scheduler->input_queue);
@@ -659,6 +909,173 @@ vy_run_discard(struct vy_run *run)
 	vy_log_tx_try_commit();
 }
 
+/**
+ * Remember a tuple overwritten in the primary index so that it
+ * can be deleted from secondary indexes on task completion.
+ * Called by the write iterator from a worker thread.
+ */
+static int
+vy_task_deferred_delete_process(struct vy_deferred_delete_handler *handler,
+				struct tuple *old_stmt, struct tuple *new_stmt)
+{
+	struct vy_task *task = container_of(handler, struct vy_task,
+					    deferred_delete_handler);
+	uint32_t old_size, new_size = 0;
+	const char *old_data = tuple_data_range(old_stmt, &old_size);
+	const char *new_data = NULL;
+	if (vy_stmt_type(new_stmt) != IPROTO_DELETE)
+		new_data = tuple_data_range(new_stmt, &new_size);
+
+	size_t size = sizeof(struct vy_deferred_delete) + old_size + new_size;
+	struct vy_deferred_delete *dd = malloc(size);
+	if (dd == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_deferred_delete");
+		return -1;
+	}
+	dd->lsn = vy_stmt_lsn(new_stmt);
+	dd->old_size = old_size;
+	dd->new_size = new_size;
+	memcpy(dd->data, old_data, old_size);
+	if (new_data != NULL)
+		memcpy(dd->data + old_size, new_data, new_size);
+	stailq_add_tail_entry(&task->deferred_deletes, dd, in_task);
+	return 0;
+}
+
+static const struct vy_deferred_delete_handler_iface
+vy_task_deferred_delete_iface = {
+	.process = vy_task_deferred_delete_process,
+};
+
+/**
+ * Make the write iterator of a task pass tuples overwritten in
+ * the primary index to vy_task_deferred_delete_process() if the
+ * LSM tree the task is for defers DELETEs.
+ */
+static void
+vy_task_set_deferred_delete_handler(struct vy_task *task)
+{
+	struct vy_lsm *lsm = task->lsm;
+	if (lsm->index_id != 0 || !lsm->defer_deletes)
+		return;
+	task->deferred_delete_handler.iface = &vy_task_deferred_delete_iface;
+	vy_write_iterator_set_deferred_delete_handler(task->wi,
+					&task->deferred_delete_handler);
+}
+
+/**
+ * Check if a statement read from a secondary index of a space
+ * with deferred DELETEs is stale, i.e. the primary index stores
+ * a newer version of the tuple with a different secondary key
+ * or the tuple was deleted. Such statements are normally deleted
+ * by deferred DELETEs, but those may be lost on restart, because
+ * they are not written to WAL. Called by the write iterator from
+ * a worker thread.
+ */
+static int
+vy_task_is_stale(struct vy_stale_stmt_filter *filter,
+		 struct tuple *stmt, int64_t vlsn)
+{
+	struct vy_task *task = container_of(filter, struct vy_task,
+					    stale_stmt_filter);
+	struct vy_pk_snapshot *snapshot = task->pk_snapshot;
+	struct tuple *found;
+	if (vy_pk_snapshot_get(snapshot, stmt, vlsn, &found) != 0)
+		return -1;
+	if (found == NULL) {
+		/*
+		 * If the statement was dumped to the primary index,
+		 * but there's no statement for the key on disk now,
+		 * the tuple was deleted and the DELETE was purged by
+		 * compaction, which only happens if the DELETE is
+		 * visible from all read views. If there are read
+		 * views, we don't know if the key has newer statements
+		 * invisible from them, so we don't check it then.
+		 */
+		return vlsn == INT64_MAX &&
+		       vy_stmt_lsn(stmt) <= snapshot->dump_lsn;
+	}
+	int rc = 0;
+	enum iproto_type type = vy_stmt_type(found);
+	if (vy_stmt_lsn(found) > vy_stmt_lsn(stmt) &&
+	    (type == IPROTO_DELETE || (type != IPROTO_UPSERT &&
+	     vy_tuple_compare(found, stmt, task->cmp_def) != 0)))
+		rc = 1;
+	tuple_unref(found);
+	return rc;
+}
+
+static const struct vy_stale_stmt_filter_iface
+vy_task_stale_stmt_filter_iface = {
+	.is_stale = vy_task_is_stale,
+};
+
+/**
+ * Make the write iterator of a task compacting a secondary index
+ * LSM tree of a space with deferred DELETEs drop stale statements
+ * left in the index, see vy_task_is_stale(). Since this requires
+ * a lookup in the primary index for each key, it is only done on
+ * major compaction.
+ */
+static int
+vy_task_set_stale_stmt_filter(struct vy_task *task, bool is_last_level)
+{
+	struct vy_lsm *lsm = task->lsm;
+	if (lsm->index_id == 0 || !lsm->defer_deletes || !is_last_level)
+		return 0;
+	task->pk_snapshot = vy_pk_snapshot_new(lsm->pk);
+	if (task->pk_snapshot == NULL)
+		return -1;
+	task->stale_stmt_filter.iface = &vy_task_stale_stmt_filter_iface;
+	vy_write_iterator_set_stale_stmt_filter(task->wi,
+						&task->stale_stmt_filter);
+	return 0;
+}
+
+/**
+ * Pass tuples overwritten in the primary index and collected
+ * by a worker thread to vy_scheduler::deferred_delete_cb.
+ * Called on task completion. May yield.
+ */
+static int
+vy_task_flush_deferred_deletes(struct vy_scheduler *scheduler,
+			       struct vy_task *task)
+{
+	struct vy_lsm *lsm = task->lsm;
+	while (!stailq_empty(&task->deferred_deletes)) {
+		struct vy_deferred_delete *dd;
+		dd = stailq_shift_entry(&task->deferred_deletes,
+					struct vy_deferred_delete, in_task);
+		struct tuple *old_stmt = NULL, *new_stmt = NULL;
+		const char *old_data = dd->data;
+		const char *new_data = dd->data + dd->old_size;
+		old_stmt = vy_stmt_new_replace(lsm->mem_format, old_data,
+					       old_data + dd->old_size);
+		if (old_stmt == NULL)
+			goto fail;
+		if (dd->new_size > 0) {
+			new_stmt = vy_stmt_new_replace(lsm->mem_format,
+					new_data, new_data + dd->new_size);
+			if (new_stmt == NULL)
+				goto fail;
+		}
+		scheduler->deferred_delete_cb(scheduler, lsm, old_stmt,
+					      new_stmt, dd->lsn);
+		tuple_unref(old_stmt);
+		if (new_stmt != NULL)
+			tuple_unref(new_stmt);
+		free(dd);
+		continue;
+fail:
+		if (old_stmt != NULL)
+			tuple_unref(old_stmt);
+		free(dd);
+		return -1;
+	}
+	return 0;
+}
+
 static int
 vy_task_write_run(struct vy_scheduler *scheduler, struct vy_task *task)
 {
@@ -735,6 +1152,9 @@ vy_task_dump_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 
 	assert(lsm->is_dumping);
 
+	if (vy_task_flush_deferred_deletes(scheduler, task) != 0)
+		goto fail;
+
 	if (vy_run_is_empty(new_run)) {
 		/*
 		 * In case the run is empty, we can discard the run
@@ -1026,6 +1446,7 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
 	task->page_size = lsm->opts.page_size;
+	vy_task_set_deferred_delete_handler(task);
 
 	lsm->is_dumping = true;
 	vy_scheduler_update_lsm(scheduler, lsm);
@@ -1066,9 +1487,350 @@ vy_task_compact_execute(struct vy_scheduler *scheduler, struct vy_task *task)
 	return vy_task_write_run(scheduler, task);
 }
 
+/** Free a subcompaction descriptor. */
+static void
+vy_subcompaction_delete(struct vy_subcompaction *sc)
+{
+	for (int i = 0; i <= sc->part_count; i++) {
+		if (sc->keys[i] != NULL)
+			tuple_unref(sc->keys[i]);
+	}
+	for (int i = 0; i < sc->part_count; i++) {
+		assert(sc->new_runs[i] == NULL);
+		assert(sc->new_ranges[i] == NULL);
+	}
+	TRASH(sc);
+	free(sc);
+}
+
+/**
+ * Allocate a subcompaction descriptor for a range split
+ * into parts at the given keys.
+ */
+static struct vy_subcompaction *
+vy_subcompaction_new(struct vy_lsm *lsm, struct vy_range *range,
+		     const char **split_keys, int part_count)
+{
+	size_t size = sizeof(struct vy_subcompaction) +
+		      (part_count + 1) * sizeof(struct tuple *) +
+		      part_count * sizeof(struct vy_run *) +
+		      part_count * sizeof(struct vy_range *);
+	struct vy_subcompaction *sc = calloc(1, size);
+	if (sc == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_subcompaction");
+		return NULL;
+	}
+	sc->range = range;
+	sc->part_count = part_count;
+	sc->pending_count = part_count;
+	sc->keys = (struct tuple **)(sc + 1);
+	sc->new_runs = (struct vy_run **)(sc->keys + part_count + 1);
+	sc->new_ranges = (struct vy_range **)(sc->new_runs + part_count);
+
+	sc->keys[0] = range->begin;
+	if (range->begin != NULL)
+		tuple_ref(range->begin);
+	sc->keys[part_count] = range->end;
+	if (range->end != NULL)
+		tuple_ref(range->end);
+	for (int i = 1; i < part_count; i++) {
+		sc->keys[i] = vy_key_from_msgpack(lsm->env->key_format,
+						  split_keys[i - 1]);
+		if (sc->keys[i] == NULL) {
+			vy_subcompaction_delete(sc);
+			return NULL;
+		}
+	}
+	return sc;
+}
+
+/**
+ * Discard runs written by a failed subcompaction and put
+ * the range back to the compaction queue.
+ */
+static void
+vy_subcompaction_abort(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+		       struct vy_subcompaction *sc, bool in_shutdown)
+{
+	for (int i = 0; i < sc->part_count; i++) {
+		struct vy_run *run = sc->new_runs[i];
+		if (run == NULL)
+			continue;
+		/* The metadata log is unavailable on shutdown. */
+		if (!in_shutdown)
+			vy_run_discard(run);
+		else
+			vy_run_unref(run);
+		sc->new_runs[i] = NULL;
+	}
+	struct vy_range *range = sc->range;
+	assert(range->heap_node.pos == UINT32_MAX);
+	vy_range_heap_insert(&lsm->range_heap, &range->heap_node);
+	vy_scheduler_update_lsm(scheduler, lsm);
+	vy_subcompaction_delete(sc);
+}
+
+/**
+ * Replace a range compacted by several tasks with new ranges,
+ * one per part, each of which consists of the run written by
+ * the corresponding task and cuts of slices that were dumped
+ * to the range while compaction was in progress.
+ */
+static int
+vy_subcompaction_commit(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+			struct vy_subcompaction *sc)
+{
+	struct vy_range *range = sc->range;
+	struct vy_slice *first_slice = sc->first_slice;
+	struct vy_slice *last_slice = sc->last_slice;
+	struct vy_slice *slice, *new_slice;
+	struct vy_range *part;
+	struct vy_run *run;
+
+	/* Only full compaction is split, see vy_task_compact_new(). */
+	assert(last_slice == rlist_last_entry(&range->slices,
+					      struct vy_slice, in_range));
+
+	/*
+	 * Allocate new ranges. vy_range_add_slice() adds a slice
+	 * to the list head, so add the oldest slice first.
+	 */
+	for (int i = 0; i < sc->part_count; i++) {
+		part = vy_range_new(vy_log_next_id(), sc->keys[i],
+				    sc->keys[i + 1], lsm->cmp_def);
+		if (part == NULL)
+			goto fail;
+		sc->new_ranges[i] = part;
+		run = sc->new_runs[i];
+		if (!vy_run_is_empty(run)) {
+			new_slice = vy_slice_new(vy_log_next_id(), run,
+						 NULL, NULL, lsm->cmp_def);
+			if (new_slice == NULL)
+				goto fail;
+			vy_range_add_slice(part, new_slice);
+		}
+		for (slice = rlist_prev_entry_safe(first_slice,
+					&range->slices, in_range);
+		     slice != NULL;
+		     slice = rlist_prev_entry_safe(slice,
+					&range->slices, in_range)) {
+			if (vy_slice_cut(slice, vy_log_next_id(),
+					 part->begin, part->end,
+					 lsm->cmp_def, &new_slice) != 0)
+				goto fail;
+			if (new_slice != NULL)
+				vy_range_add_slice(part, new_slice);
+		}
+		part->n_compactions = range->n_compactions + 1;
+		vy_range_update_compact_priority(part, &lsm->opts);
+	}
+
+	/*
+	 * Build the list of runs that became unused
+	 * as a result of compaction.
+	 */
+	RLIST_HEAD(unused_runs);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		slice->run->compacted_slice_count++;
+		if (slice == last_slice)
+			break;
+	}
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		run = slice->run;
+		if (run->compacted_slice_count == run->slice_count)
+			rlist_add_entry(&unused_runs, run, in_unused);
+		slice->run->compacted_slice_count = 0;
+		if (slice == last_slice)
+			break;
+	}
+
+	/*
+	 * Log change in metadata.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_log_delete_slice(slice->id);
+	vy_log_delete_range(range->id);
+	int64_t gc_lsn = vy_log_signature();
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_log_drop_run(run->id, gc_lsn);
+	for (int i = 0; i < sc->part_count; i++) {
+		run = sc->new_runs[i];
+		if (!vy_run_is_empty(run))
+			vy_log_create_run(lsm->id, run->id, run->dump_lsn);
+	}
+	for (int i = 0; i < sc->part_count; i++) {
+		part = sc->new_ranges[i];
+		vy_log_insert_range(lsm->id, part->id,
+				    tuple_data_or_null(part->begin),
+				    tuple_data_or_null(part->end));
+		rlist_foreach_entry(slice, &part->slices, in_range)
+			vy_log_insert_slice(part->id, slice->run->id, slice->id,
+					    tuple_data_or_null(slice->begin),
+					    tuple_data_or_null(slice->end));
+	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	/*
+	 * Remove compacted run files that were created after
+	 * the last checkpoint (and hence are not referenced
+	 * by any checkpoint) immediately to save disk space.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(run, &unused_runs, in_unused) {
+		if (run->dump_lsn > gc_lsn &&
+		    vy_run_remove_files(lsm->env->path, lsm->space_id,
+					lsm->index_id, run->id) == 0) {
+			vy_log_forget_run(run->id);
+		}
+	}
+	vy_log_tx_try_commit();
+
+	/*
+	 * Account new runs if they are not empty,
+	 * otherwise discard them.
+	 */
+	for (int i = 0; i < sc->part_count; i++) {
+		run = sc->new_runs[i];
+		sc->new_runs[i] = NULL;
+		if (!vy_run_is_empty(run)) {
+			vy_lsm_add_run(lsm, run);
+			vy_stmt_counter_add_disk(&lsm->stat.disk.compact.out,
+						 &run->count);
+			/* Drop the reference held by the task. */
+			vy_run_unref(run);
+		} else
+			vy_run_discard(run);
+	}
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		vy_stmt_counter_add_disk(&lsm->stat.disk.compact.in,
+					 &slice->count);
+		if (slice == last_slice)
+			break;
+	}
+
+	/*
+	 * Replace the compacted range in the LSM tree.
+	 * The range was removed from the heap when the
+	 * compaction was scheduled, but vy_lsm_remove_range()
+	 * expects to find it there.
+	 */
+	vy_lsm_unacct_range(lsm, range);
+	vy_range_heap_insert(&lsm->range_heap, &range->heap_node);
+	vy_lsm_remove_range(lsm, range);
+	for (int i = 0; i < sc->part_count; i++) {
+		part = sc->new_ranges[i];
+		sc->new_ranges[i] = NULL;
+		vy_lsm_add_range(lsm, part);
+		vy_lsm_acct_range(lsm, part);
+	}
+	lsm->range_tree_version++;
+	lsm->stat.disk.compact.count++;
+
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_lsm_remove_run(lsm, run);
+
+	say_info("%s: completed compacting range %s in %d parts",
+		 vy_lsm_name(lsm), vy_range_str(range), sc->part_count);
+
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_slice_wait_pinned(slice);
+	vy_range_delete(range);
+	vy_scheduler_update_lsm(scheduler, lsm);
+	vy_subcompaction_delete(sc);
+	return 0;
+fail:
+	for (int i = 0; i < sc->part_count; i++) {
+		if (sc->new_ranges[i] != NULL)
+			vy_range_delete(sc->new_ranges[i]);
+		sc->new_ranges[i] = NULL;
+	}
+	return -1;
+}
+
+/**
+ * Complete a task compacting a part of a range. The last
+ * completed task commits the whole compaction.
+ */
+static int
+vy_task_subcompact_complete(struct vy_scheduler *scheduler,
+			    struct vy_task *task)
+{
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_subcompaction *sc = task->subcompaction;
+
+	if (vy_task_flush_deferred_deletes(scheduler, task) != 0)
+		return -1;
+
+	/* The iterator has been cleaned up in worker. */
+	task->wi->iface->close(task->wi);
+	task->wi = NULL;
+
+	sc->new_runs[task->part_no] = task->new_run;
+	task->new_run = NULL;
+	assert(sc->pending_count > 0);
+	if (sc->pending_count > 1) {
+		sc->pending_count--;
+		return 0;
+	}
+	/*
+	 * This task is the last one to complete. If it fails
+	 * to commit, vy_task_subcompact_abort() cleans up.
+	 */
+	if (sc->is_failed) {
+		/* The error has been logged by the failed task. */
+		sc->pending_count--;
+		vy_subcompaction_abort(scheduler, lsm, sc, false);
+		return 0;
+	}
+	return vy_subcompaction_commit(scheduler, lsm, sc);
+}
+
+static void
+vy_task_subcompact_abort(struct vy_scheduler *scheduler, struct vy_task *task,
+			 bool in_shutdown)
+{
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_subcompaction *sc = task->subcompaction;
+
+	/* The iterator has been cleaned up in worker. */
+	if (task->wi != NULL)
+		task->wi->iface->close(task->wi);
+
+	/*
+	 * It's no use alerting the user if the server is
+	 * shutting down or the LSM tree was dropped.
+	 */
+	if (!in_shutdown && !lsm->is_dropped) {
+		struct error *e = diag_last_error(&task->diag);
+		error_log(e);
+		say_error("%s: failed to compact part %d of range %s",
+			  vy_lsm_name(lsm), task->part_no,
+			  vy_range_str(task->range));
+	}
+
+	if (task->new_run != NULL) {
+		/* The metadata log is unavailable on shutdown. */
+		if (!in_shutdown)
+			vy_run_discard(task->new_run);
+		else
+			vy_run_unref(task->new_run);
+	}
+
+	sc->is_failed = true;
+	assert(sc->pending_count > 0);
+	if (--sc->pending_count == 0)
+		vy_subcompaction_abort(scheduler, lsm, sc, in_shutdown);
+}
+
 static int
 vy_task_compact_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 {
+	if (task->subcompaction != NULL)
+		return vy_task_subcompact_complete(scheduler, task);
+
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
 	struct vy_run *new_run = task->new_run;
@@ -1077,6 +1839,9 @@ vy_task_compact_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 	struct vy_slice *slice, *next_slice, *new_slice = NULL;
 	struct vy_run *run;
 
+	if (vy_task_flush_deferred_deletes(scheduler, task) != 0)
+		return -1;
+
 	/*
 	 * Allocate a slice of the new run.
 	 *
@@ -1216,6 +1981,11 @@ static void
 vy_task_compact_abort(struct vy_scheduler *scheduler, struct vy_task *task,
 		      bool in_shutdown)
 {
+	if (task->subcompaction != NULL) {
+		vy_task_subcompact_abort(scheduler, task, in_shutdown);
+		return;
+	}
+
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
 
@@ -1244,6 +2014,163 @@ vy_task_compact_abort(struct vy_scheduler *scheduler, struct vy_task *task,
 	vy_scheduler_update_lsm(scheduler, lsm);
 }
 
+/**
+ * Check if a range compaction should be split between several
+ * worker threads. Only a full compaction of a range that is
+ * going to produce a run much larger than range_size is split,
+ * so that the resulting ranges are neither split nor coalesced
+ * right away. Split keys are picked from page min keys of the
+ * oldest run of the range, which is usually the largest one.
+ *
+ * Returns the number of parts. Split keys are returned in @keys.
+ */
+static int
+vy_task_compact_split(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+		      struct vy_range *range, const char **keys)
+{
+	if (scheduler->max_subcompactions < 2 ||
+	    range->compact_priority != range->slice_count)
+		return 1;
+	/* One worker thread is reserved for dumps. */
+	int64_t part_count = MIN(scheduler->workers_available - 1,
+				 scheduler->max_subcompactions);
+	part_count = MIN(part_count, VY_SUBCOMPACTION_MAX_PARTS);
+	part_count = MIN(part_count, (int64_t)range->count.bytes_compressed /
+				     lsm->opts.range_size);
+	if (part_count < 2)
+		return 1;
+
+	struct vy_slice *slice = rlist_last_entry(&range->slices,
+						  struct vy_slice, in_range);
+	uint32_t page_count = slice->last_page_no - slice->first_page_no + 1;
+	const char *prev_key = NULL;
+	if (range->begin != NULL)
+		prev_key = tuple_data(range->begin);
+	if (slice->begin != NULL && (prev_key == NULL ||
+	    key_compare(tuple_data(slice->begin), prev_key,
+			lsm->cmp_def) > 0))
+		prev_key = tuple_data(slice->begin);
+	int n = 0;
+	for (int i = 1; i < part_count; i++) {
+		uint32_t page_no = slice->first_page_no +
+				   (uint64_t)page_count * i / part_count;
+		const char *key = vy_run_page_info(slice->run,
+						   page_no)->min_key;
+		/* Skip keys that would make a part empty. */
+		if (prev_key != NULL &&
+		    key_compare(key, prev_key, lsm->cmp_def) <= 0)
+			continue;
+		if (range->end != NULL &&
+		    key_compare(key, tuple_data(range->end),
+				lsm->cmp_def) >= 0)
+			break;
+		keys[n++] = key;
+		prev_key = key;
+	}
+	return n + 1;
+}
+
+/**
+ * Create tasks compacting a range split into parts at the
+ * given keys. The tasks are chained via vy_task::next.
+ */
+static int
+vy_task_subcompact_new(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+		       struct vy_range *range, const struct vy_task_ops *ops,
+		       const char **split_keys, int part_count,
+		       struct vy_task **p_task)
+{
+	struct vy_task *first_task = NULL, *task, *next;
+	struct vy_subcompaction *sc = vy_subcompaction_new(lsm, range,
+						split_keys, part_count);
+	if (sc == NULL)
+		goto err;
+	sc->first_slice = rlist_first_entry(&range->slices,
+					    struct vy_slice, in_range);
+	sc->last_slice = rlist_last_entry(&range->slices,
+					  struct vy_slice, in_range);
+
+	int64_t dump_lsn = -1;
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		dump_lsn = MAX(dump_lsn, slice->run->dump_lsn);
+	assert(dump_lsn >= 0);
+
+	/* Create tasks in reverse order to chain them easily. */
+	for (int i = part_count - 1; i >= 0; i--) {
+		task = vy_task_new(&scheduler->task_pool, lsm, ops);
+		if (task == NULL)
+			goto err;
+		task->next = first_task;
+		first_task = task;
+		task->subcompaction = sc;
+		task->part_no = i;
+		task->range = range;
+		task->first_slice = sc->first_slice;
+		task->last_slice = sc->last_slice;
+		task->bloom_fpr = lsm->opts.bloom_fpr;
+		task->page_size = lsm->opts.page_size;
+
+		task->new_run = vy_run_prepare(scheduler->run_env, lsm);
+		if (task->new_run == NULL)
+			goto err;
+		task->new_run->dump_lsn = dump_lsn;
+
+		task->wi = vy_write_iterator_new(task->cmp_def,
+						 lsm->disk_format,
+						 lsm->index_id == 0, true,
+						 scheduler->read_views);
+		if (task->wi == NULL)
+			goto err;
+		rlist_foreach_entry(slice, &range->slices, in_range) {
+			struct vy_slice *part_slice;
+			if (vy_slice_cut(slice, vy_log_next_id(),
+					 sc->keys[i], sc->keys[i + 1],
+					 lsm->cmp_def, &part_slice) != 0)
+				goto err;
+			if (part_slice == NULL)
+				continue;
+			rlist_add_tail_entry(&task->part_slices, part_slice,
+					     in_range);
+			if (vy_write_iterator_new_slice(task->wi,
+							part_slice) != 0)
+				goto err;
+		}
+		vy_task_set_deferred_delete_handler(task);
+		if (vy_task_set_stale_stmt_filter(task, true) != 0)
+			goto err;
+	}
+
+	/*
+	 * Remove the range we are going to compact from the heap
+	 * so that it doesn't get selected again.
+	 */
+	vy_range_heap_delete(&lsm->range_heap, &range->heap_node);
+	range->heap_node.pos = UINT32_MAX;
+	vy_scheduler_update_lsm(scheduler, lsm);
+
+	say_info("%s: started compacting range %s in %d parts, runs %d/%d",
+		 vy_lsm_name(lsm), vy_range_str(range), part_count,
+		 range->compact_priority, range->slice_count);
+	*p_task = first_task;
+	return 0;
+err:
+	for (task = first_task; task != NULL; task = next) {
+		next = task->next;
+		if (task->wi != NULL)
+			task->wi->iface->close(task->wi);
+		if (task->new_run != NULL)
+			vy_run_discard(task->new_run);
+		vy_task_delete(&scheduler->task_pool, task);
+	}
+	if (sc != NULL)
+		vy_subcompaction_delete(sc);
+	diag_log();
+	say_error("%s: could not start compacting range %s",
+		  vy_lsm_name(lsm), vy_range_str(range));
+	return -1;
+}
+
 static int
 vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
 		    struct vy_task **p_task)
@@ -1270,6 +2197,14 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
 		return 0;
 	}
 
+	const char *split_keys[VY_SUBCOMPACTION_MAX_PARTS - 1];
+	int part_count = vy_task_compact_split(scheduler, lsm, range,
+					       split_keys);
+	if (part_count > 1)
+		return vy_task_subcompact_new(scheduler, lsm, range,
+					      &compact_ops, split_keys,
+					      part_count, p_task);
+
 	struct vy_task *task = vy_task_new(&scheduler->task_pool,
 					   lsm, &compact_ops);
 	if (task == NULL)
@@ -1310,6 +2245,9 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
 	task->page_size = lsm->opts.page_size;
+	vy_task_set_deferred_delete_handler(task);
+	if (vy_task_set_stale_stmt_filter(task, is_last_level) != 0)
+		goto err_wi_sub;
 
 	/*
 	 * Remove the range we are going to compact from the heap
@@ -1575,15 +2513,25 @@ vy_scheduler_f(va_list va)
 		if (task == NULL)
 			goto wait;
 
-		/* Queue the task and notify workers if necessary. */
+		/*
+		 * Queue the task and notify workers if necessary.
+		 * A range compaction may consist of several tasks,
+		 * see vy_task_subcompact_new().
+		 */
 		tt_pthread_mutex_lock(&scheduler->mutex);
 		was_empty = stailq_empty(&scheduler->input_queue);
-		stailq_add_tail_entry(&scheduler->input_queue, task, link);
+		do {
+			next = task->next;
+			task->next = NULL;
+			stailq_add_tail_entry(&scheduler->input_queue,
+					      task, link);
+			scheduler->workers_available--;
+		} while ((task = next) != NULL);
 		if (was_empty)
-			tt_pthread_cond_signal(&scheduler->worker_cond);
+			tt_pthread_cond_broadcast(&scheduler->worker_cond);
 		tt_pthread_mutex_unlock(&scheduler->mutex);
 
-		scheduler->workers_available--;
+		assert(scheduler->workers_available >= 0);
 		fiber_reschedule();
 		continue;
 error:
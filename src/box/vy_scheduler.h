@@ -50,6 +50,7 @@ extern "C" {
 
 struct cord;
 struct fiber;
+struct tuple;
 struct vy_lsm;
 struct vy_run_env;
 struct vy_scheduler;
@@ -58,6 +59,18 @@ typedef void
 (*vy_scheduler_dump_complete_f)(struct vy_scheduler *scheduler,
 				int64_t dump_generation, double dump_duration);
 
+/**
+ * Callback invoked for each tuple overwritten in the primary
+ * index of a space with deferred DELETEs, see vy_lsm::defer_deletes.
+ * @old_stmt is the overwritten tuple, @new_stmt is the tuple that
+ * overwrote it or NULL if it was deleted, @lsn is the LSN of the
+ * overwriting statement.
+ */
+typedef void
+(*vy_scheduler_deferred_delete_f)(struct vy_scheduler *scheduler,
+				  struct vy_lsm *pk, struct tuple *old_stmt,
+				  struct tuple *new_stmt, int64_t lsn);
+
 struct vy_scheduler {
 	/** Scheduler fiber. */
 	struct fiber *scheduler_fiber;
@@ -78,6 +91,11 @@ struct vy_scheduler {
 	int worker_pool_size;
 	/** Number worker threads that are currently idle. */
 	int workers_available;
+	/**
+	 * Max number of parts a range compaction can be split
+	 * into and run in parallel (vinyl_max_subcompactions).
+	 */
+	int max_subcompactions;
 	/** Memory pool used for allocating vy_task objects. */
 	struct mempool task_pool;
 	/** Queue of pending tasks, linked by vy_task::link. */
@@ -163,6 +181,13 @@ struct vy_scheduler {
 	 * by the dump.
 	 */
 	vy_scheduler_dump_complete_f dump_complete_cb;
+	/**
+	 * Function called by the scheduler upon dump or
+	 * compaction of a primary index LSM tree with deferred
+	 * DELETEs. It is supposed to delete overwritten tuples
+	 * from secondary indexes.
+	 */
+	vy_scheduler_deferred_delete_f deferred_delete_cb;
 	/** List of read views, see tx_manager::read_views. */
 	struct rlist *read_views;
 	/** Context needed for writing runs. */
@@ -175,6 +200,7 @@ struct vy_scheduler {
 void
 vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 		    vy_scheduler_dump_complete_f dump_complete_cb,
+		    vy_scheduler_deferred_delete_f deferred_delete_cb,
 		    struct vy_run_env *run_env, struct rlist *read_views);
 
 /**
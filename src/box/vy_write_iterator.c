@@ -177,6 +177,16 @@ struct vy_write_iterator {
 	 * key and its tuple format is different.
 	 */
 	bool is_primary;
+	/**
+	 * Handler of tuples overwritten in the primary index
+	 * or NULL if DELETEs are not deferred.
+	 */
+	struct vy_deferred_delete_handler *deferred_delete_handler;
+	/**
+	 * Filter of stale statements of a secondary index
+	 * or NULL if the statements are not checked.
+	 */
+	struct vy_stale_stmt_filter *stale_stmt_filter;
 
 	/** Length of the @read_views. */
 	int rv_count;
@@ -367,6 +377,24 @@ vy_write_iterator_new(const struct key_def *cmp_def,
 	return &stream->base;
 }
 
+void
+vy_write_iterator_set_deferred_delete_handler(struct vy_stmt_stream *vstream,
+		struct vy_deferred_delete_handler *handler)
+{
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	assert(stream->is_primary);
+	stream->deferred_delete_handler = handler;
+}
+
+void
+vy_write_iterator_set_stale_stmt_filter(struct vy_stmt_stream *vstream,
+					struct vy_stale_stmt_filter *filter)
+{
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	assert(!stream->is_primary);
+	stream->stale_stmt_filter = filter;
+}
+
 /**
  * Start the search. Must be called after *new* methods and
  * before *next* method.
@@ -547,6 +575,98 @@ vy_write_iterator_pop_read_view_stmt(struct vy_write_iterator *stream)
 	return rv->tuple;
 }
 
+/**
+ * Remember the oldest REPLACE, INSERT or DELETE seen so far for
+ * the current key if the iterator has a deferred DELETE handler.
+ * The statement is referenced, because the source it was read
+ * from may free it when advanced.
+ *
+ * @param stream Write iterator.
+ * @param[in/out] last_terminal Last remembered statement.
+ * @param stmt REPLACE, INSERT or DELETE to remember.
+ */
+static inline void
+vy_write_iterator_set_last_terminal(struct vy_write_iterator *stream,
+				    struct tuple **last_terminal,
+				    struct tuple *stmt)
+{
+	if (stream->deferred_delete_handler == NULL)
+		return;
+	vy_stmt_ref_if_possible(stmt);
+	if (*last_terminal != NULL)
+		vy_stmt_unref_if_possible(*last_terminal);
+	*last_terminal = stmt;
+}
+
+/**
+ * Pass a statement skipped by the write iterator to the deferred
+ * DELETE handler if it is a REPLACE or INSERT overwritten by
+ * @a last_terminal, then make it the last terminal statement of
+ * the current key.
+ *
+ * @param stream Write iterator.
+ * @param stmt Skipped statement.
+ * @param[in/out] last_terminal Oldest REPLACE, INSERT or DELETE
+ * newer than @a stmt.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error returned by the handler.
+ */
+static inline int
+vy_write_iterator_defer_delete(struct vy_write_iterator *stream,
+			       struct tuple *stmt,
+			       struct tuple **last_terminal)
+{
+	struct vy_deferred_delete_handler *handler =
+		stream->deferred_delete_handler;
+	if (handler == NULL)
+		return 0;
+	enum iproto_type type = vy_stmt_type(stmt);
+	if (type == IPROTO_UPSERT)
+		return 0;
+	if ((type == IPROTO_REPLACE || type == IPROTO_INSERT) &&
+	    *last_terminal != NULL &&
+	    handler->iface->process(handler, stmt, *last_terminal) != 0)
+		return -1;
+	vy_write_iterator_set_last_terminal(stream, last_terminal, stmt);
+	return 0;
+}
+
+/**
+ * Pass the newest statement for the current key to the stale
+ * statement filter if the iterator has one. If the statement
+ * is stale, return a DELETE with the same LSN that should be
+ * used instead of it, otherwise set @a delete to NULL.
+ *
+ * @param stream Write iterator.
+ * @param stmt The newest statement for the current key.
+ * @param[out] delete DELETE replacing @a stmt or NULL.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or read error.
+ */
+static NODISCARD int
+vy_write_iterator_check_stale(struct vy_write_iterator *stream,
+			      struct tuple *stmt, struct tuple **delete)
+{
+	*delete = NULL;
+	struct vy_stale_stmt_filter *filter = stream->stale_stmt_filter;
+	if (filter == NULL)
+		return 0;
+	enum iproto_type type = vy_stmt_type(stmt);
+	if (type != IPROTO_REPLACE && type != IPROTO_INSERT)
+		return 0;
+	int64_t vlsn = stream->read_views[stream->rv_count - 1].vlsn;
+	int rc = filter->iface->is_stale(filter, stmt, vlsn);
+	if (rc <= 0)
+		return rc;
+	*delete = vy_stmt_new_surrogate_delete(stream->format, stmt);
+	if (*delete == NULL)
+		return -1;
+	vy_stmt_set_lsn(*delete, vy_stmt_lsn(stmt));
+	return 0;
+}
+
 /**
  * Build the history of the current key.
  * Apply optimizations 1, 2 and 3 (@sa vy_write_iterator.h).
@@ -607,6 +727,14 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 	int64_t current_rv_lsn = vy_write_iterator_get_vlsn(stream, 0);
 	int64_t merge_until_lsn = vy_write_iterator_get_vlsn(stream, 1);
 	uint64_t key_mask = stream->cmp_def->column_mask;
+	/*
+	 * The last REPLACE, INSERT or DELETE seen for the current
+	 * key. Passed to the deferred DELETE handler along with
+	 * the statement it overwrote.
+	 */
+	struct tuple *last_terminal = NULL;
+	/* Set while processing the newest statement for the key. */
+	bool is_newest = true;
 
 	while (true) {
 		*is_first_insert = vy_stmt_type(src->tuple) == IPROTO_INSERT;
@@ -630,6 +758,10 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 			 * view but older than the previous read view,
 			 * which is already fully built.
 			 */
+			rc = vy_write_iterator_defer_delete(stream,
+					src->tuple, &last_terminal);
+			if (rc != 0)
+				break;
 			goto next_lsn;
 		}
 		while (vy_stmt_lsn(src->tuple) <= merge_until_lsn) {
@@ -646,6 +778,39 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 							   current_rv_i + 1);
 		}
 
+		if (is_newest) {
+			/*
+			 * Turn a stale statement of a secondary
+			 * index into a DELETE, see the comment in
+			 * vy_write_iterator.h. The filter returns
+			 * true only if all read views see the newer
+			 * version, so this is the only read view.
+			 */
+			struct tuple *delete;
+			rc = vy_write_iterator_check_stale(stream, src->tuple,
+							   &delete);
+			if (rc != 0)
+				break;
+			if (delete != NULL) {
+				assert(merge_until_lsn == 0);
+				if (stream->is_last_level) {
+					/* Optimization 1. */
+					vy_stmt_unref_if_possible(delete);
+					current_rv_lsn = 0; /* Force skip */
+					goto next_lsn;
+				}
+				rc = vy_write_iterator_push_rv(stream, delete,
+							       current_rv_i);
+				vy_stmt_unref_if_possible(delete);
+				if (rc != 0)
+					break;
+				++*count;
+				current_rv_i++;
+				current_rv_lsn = merge_until_lsn;
+				goto next_lsn;
+			}
+		}
+
 		/*
 		 * Optimization 1: skip last level delete.
 		 * @sa vy_write_iterator for details about this
@@ -654,6 +819,8 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 		if (vy_stmt_type(src->tuple) == IPROTO_DELETE &&
 		    stream->is_last_level && merge_until_lsn == 0) {
 			current_rv_lsn = 0; /* Force skip */
+			vy_write_iterator_set_last_terminal(stream,
+					&last_terminal, src->tuple);
 			goto next_lsn;
 		}
 
@@ -678,6 +845,8 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 			if (rc != 0)
 				break;
 			++*count;
+			vy_write_iterator_set_last_terminal(stream,
+					&last_terminal, src->tuple);
 			current_rv_i++;
 			current_rv_lsn = merge_until_lsn;
 			merge_until_lsn =
@@ -693,6 +862,7 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 			break;
 		++*count;
 next_lsn:
+		is_newest = false;
 		rc = vy_write_iterator_merge_step(stream);
 		if (rc != 0)
 			break;
@@ -706,6 +876,8 @@ next_lsn:
 
 	vy_source_heap_delete(&stream->src_heap, &end_of_key_src.heap_node);
 	vy_stmt_unref_if_possible(end_of_key_src.tuple);
+	if (last_terminal != NULL)
+		vy_stmt_unref_if_possible(last_terminal);
 	return rc;
 }
 
@@ -210,6 +210,38 @@
  * also turn the first INSERT in the resulting key's history to a
  * REPLACE in case the oldest statement among all sources is not
  * an INSERT.
+ *
+ * ---------------------------------------------------------------
+ * Deferred DELETEs: if the iterator is for a primary index and
+ * a deferred DELETE handler is set, then each time a REPLACE or
+ * INSERT is skipped because it is overwritten by a newer REPLACE,
+ * INSERT or DELETE, the handler is passed the overwritten tuple
+ * and the statement that overwrote it. This is used by spaces
+ * that don't delete overwritten tuples from secondary indexes on
+ * REPLACE and DELETE, see space_opts::defer_deletes.
+ *
+ *                         --------
+ *                         SAME KEY
+ *                         --------
+ *
+ * 0                                          VLSN1    INT64_MAX
+ * |                                            |           |
+ * | REPLACE1  REPLACE2  DELETE3  ...  REPLACE4 | ...       |
+ * \_____________________________________^______/___________/
+ *   (1, 2)    (2, 3)    (3, 4)        keep
+ *
+ * Pairs passed to the handler are shown under skipped statements.
+ *
+ * ---------------------------------------------------------------
+ * Stale statements: if the iterator is for a secondary index of
+ * such a space and a stale statement filter is set, the newest
+ * REPLACE or INSERT for each key is passed to the filter. If the
+ * filter says the primary index stores a newer version of the
+ * tuple with a different secondary key, which is visible from
+ * all read views, the statement is turned into a DELETE with the
+ * same LSN. The DELETE is then discarded on the last level, see
+ * optimization #1. This drops statements left in secondary
+ * indexes in case deferred DELETEs were lost on restart.
  */
 
 struct vy_write_iterator;
@@ -218,6 +250,51 @@ struct tuple_format;
 struct tuple;
 struct vy_mem;
 struct vy_slice;
+struct vy_deferred_delete_handler;
+struct vy_stale_stmt_filter;
+
+struct vy_deferred_delete_handler_iface {
+	/**
+	 * Process a tuple overwritten in the primary index.
+	 * Called from a worker thread.
+	 *
+	 * @param handler   Deferred DELETE handler.
+	 * @param old_stmt  Overwritten REPLACE or INSERT.
+	 * @param new_stmt  REPLACE, INSERT or DELETE that
+	 *                  overwrote @old_stmt.
+	 * @return 0 on success, -1 on error (diag is set).
+	 */
+	int (*process)(struct vy_deferred_delete_handler *handler,
+		       struct tuple *old_stmt, struct tuple *new_stmt);
+};
+
+/** Callback invoked for each tuple overwritten in a primary index. */
+struct vy_deferred_delete_handler {
+	const struct vy_deferred_delete_handler_iface *iface;
+};
+
+struct vy_stale_stmt_filter_iface {
+	/**
+	 * Check if a statement of a secondary index is stale,
+	 * i.e. the primary index stores a newer version of the
+	 * tuple with a different secondary key or a DELETE, and
+	 * the newer version is visible from all read views.
+	 * Called from a worker thread.
+	 *
+	 * @param filter  Stale statement filter.
+	 * @param stmt    REPLACE or INSERT of a secondary index.
+	 * @param vlsn    LSN of the oldest read view.
+	 * @return 1 if the statement is stale, 0 if it isn't or
+	 *         it can't be checked, -1 on error (diag is set).
+	 */
+	int (*is_stale)(struct vy_stale_stmt_filter *filter,
+			struct tuple *stmt, int64_t vlsn);
+};
+
+/** Callback checking secondary index statements for staleness. */
+struct vy_stale_stmt_filter {
+	const struct vy_stale_stmt_filter_iface *iface;
+};
 
 /**
  * Open an empty write iterator. To add sources to the iterator
@@ -235,6 +312,24 @@ vy_write_iterator_new(const struct key_def *cmp_def,
 		      bool is_primary, bool is_last_level,
 		      struct rlist *read_views);
 
+/**
+ * Set a handler which is passed tuples overwritten in a primary
+ * index, see the comment to the deferred DELETEs above.
+ * Must be called before the iteration is started.
+ */
+void
+vy_write_iterator_set_deferred_delete_handler(struct vy_stmt_stream *stream,
+		struct vy_deferred_delete_handler *handler);
+
+/**
+ * Set a filter which is used to drop stale statements of
+ * a secondary index, see the comment above.
+ * Must be called before the iteration is started.
+ */
+void
+vy_write_iterator_set_stale_stmt_filter(struct vy_stmt_stream *stream,
+					struct vy_stale_stmt_filter *filter);
+
 /**
  * Add a mem as a source to the iterator.
  * @return 0 on success, -1 on error (diag is set).
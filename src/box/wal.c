@@ -39,14 +39,21 @@
 
 #include "xlog.h"
 #include "xrow.h"
+#include "wal_mem.h"
 #include "vy_log.h"
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "info.h"
 
 
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
 
+enum {
+	/** Max size of the buffer of recently written rows. */
+	WAL_MEM_SIZE_MAX = 16 * 1024 * 1024,
+};
+
 int wal_dir_lock = -1;
 
 static int64_t
@@ -84,6 +91,20 @@ struct wal_writer
 	 * the wal-tx bus and are rolled back "on arrival".
 	 */
 	struct stailq rollback;
+	/**
+	 * Group commit: how long a batch may linger in tx
+	 * waiting for more requests before it is sent to WAL,
+	 * 0 to send it at the end of the event loop iteration.
+	 */
+	double commit_delay;
+	/** Send the batch at once when it has that many rows. */
+	int64_t commit_max_rows;
+	/** Send the batch at once when it is that big. */
+	int64_t commit_max_size;
+	/** Sends the batch when commit_delay expires. */
+	struct ev_timer commit_timer;
+	/** WAL write statistics, box.stat.wal(). */
+	struct wal_stat stat;
 	/* ----------------- wal ------------------- */
 	/** A setting from instance configuration - rows_per_wal */
 	int64_t wal_max_rows;
@@ -119,6 +140,11 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/**
+	 * Rows recently written to the log, so that relays
+	 * don't have to read them back from files.
+	 */
+	struct wal_mem mem;
 };
 
 struct wal_msg {
@@ -130,6 +156,22 @@ struct wal_msg {
 	 * be rolled back.
 	 */
 	struct stailq rollback;
+	/** The number of rows in the batch. */
+	int64_t rows;
+	/** Approximate size of the batch rows, in bytes. */
+	int64_t approx_len;
+	/** Bytes written to the log for the batch, set in WAL. */
+	int64_t written;
+	/** Set in WAL if the written rows were synced to disk. */
+	bool is_synced;
+	/** Monotonic time the batch was created in tx. */
+	double create_time;
+	/** Time the batch waited for WAL, set in WAL. */
+	double queue_time;
+	/** Time writing the batch took, set in WAL. */
+	double write_time;
+	/** Time syncing the batch took, set in WAL. */
+	double sync_time;
 };
 
 /**
@@ -167,6 +209,14 @@ wal_msg_create(struct wal_msg *batch)
 	cmsg_init(&batch->base, wal_request_route);
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
+	batch->rows = 0;
+	batch->approx_len = 0;
+	batch->written = 0;
+	batch->is_synced = false;
+	batch->create_time = ev_monotonic_now(loop());
+	batch->queue_time = 0;
+	batch->write_time = 0;
+	batch->sync_time = 0;
 }
 
 static struct wal_msg *
@@ -226,13 +276,27 @@ static void
 tx_schedule_commit(struct cmsg *msg)
 {
 	struct wal_msg *batch = (struct wal_msg *) msg;
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (batch->written > 0) {
+		writer->stat.batches++;
+		writer->stat.rows += batch->rows;
+		writer->stat.bytes += batch->written;
+		latency_collect(&writer->stat.queue_latency,
+				batch->queue_time);
+		latency_collect(&writer->stat.write_latency,
+				batch->write_time);
+		if (batch->is_synced) {
+			writer->stat.syncs++;
+			latency_collect(&writer->stat.sync_latency,
+					batch->sync_time);
+		}
+	}
 	/*
 	 * Move the rollback list to the writer first, since
 	 * wal_msg memory disappears after the first
 	 * iteration of tx_schedule_queue loop.
 	 */
 	if (! stailq_empty(&batch->rollback)) {
-		struct wal_writer *writer = &wal_writer_singleton;
 		/* Closes the input valve. */
 		stailq_concat(&writer->rollback, &batch->rollback);
 	}
@@ -257,6 +321,16 @@ tx_schedule_rollback(struct cmsg *msg)
 	stailq_create(&writer->rollback);
 }
 
+/** Send the batch accumulated in tx to WAL. */
+static void
+wal_commit_timer_cb(ev_loop *loop, ev_timer *timer, int events)
+{
+	(void) loop;
+	(void) timer;
+	(void) events;
+	cpipe_flush_input(&wal_thread.wal_pipe);
+}
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -275,9 +349,25 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		       wal_write_in_wal_mode_none : wal_write, NULL);
 
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid);
+	/*
+	 * Zero-fill every new WAL file up to its maximal size
+	 * so that appending rows does not have to allocate
+	 * blocks, grow the file and update the extent tree on
+	 * every write, which makes syncing the file considerably
+	 * cheaper.
+	 */
+	writer->wal_dir.prealloc_size = wal_max_size;
 	xlog_clear(&writer->current_wal);
-	if (wal_mode == WAL_FSYNC)
-		writer->wal_dir.open_wflags |= O_SYNC;
+
+	writer->commit_delay = 0;
+	writer->commit_max_rows = INT64_MAX;
+	writer->commit_max_size = INT64_MAX;
+	ev_timer_init(&writer->commit_timer, wal_commit_timer_cb, 0, 0);
+	memset(&writer->stat, 0, sizeof(writer->stat));
+	if (latency_create(&writer->stat.queue_latency) != 0 ||
+	    latency_create(&writer->stat.write_latency) != 0 ||
+	    latency_create(&writer->stat.sync_latency) != 0)
+		panic("failed to allocate WAL statistics");
 
 	stailq_create(&writer->rollback);
 	cmsg_init(&writer->in_rollback, NULL);
@@ -287,6 +377,7 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	vclock_copy(&writer->vclock, vclock);
 
 	rlist_create(&writer->watchers);
+	wal_mem_create(&writer->mem, WAL_MEM_SIZE_MAX, vclock);
 }
 
 /** Destroy a WAL writer structure. */
@@ -294,6 +385,10 @@ static void
 wal_writer_destroy(struct wal_writer *writer)
 {
 	xdir_destroy(&writer->wal_dir);
+	wal_mem_destroy(&writer->mem);
+	latency_destroy(&writer->stat.queue_latency);
+	latency_destroy(&writer->stat.write_latency);
+	latency_destroy(&writer->stat.sync_latency);
 }
 
 /** WAL thread routine. */
@@ -320,7 +415,10 @@ wal_open_f(struct cbus_call_msg *msg)
 	const char *path = xdir_format_filename(&writer->wal_dir,
 				vclock_sum(&writer->vclock), NONE);
 	assert(!xlog_is_open(&writer->current_wal));
-	return xlog_open(&writer->current_wal, path);
+	if (xlog_open(&writer->current_wal, path) != 0)
+		return -1;
+	writer->current_wal.sync_on_flush = writer->wal_mode == WAL_FSYNC;
+	return 0;
 }
 
 /**
@@ -381,6 +479,41 @@ wal_open(struct wal_writer *writer)
 	return 0;
 }
 
+void
+wal_set_group_commit(double delay, int64_t max_rows, int64_t max_size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->commit_delay = delay;
+	writer->commit_max_rows = max_rows;
+	writer->commit_max_size = max_size;
+}
+
+static void
+wal_info_append_latency(struct info_handler *h, const char *name,
+			struct latency *latency)
+{
+	info_table_begin(h, name);
+	info_append_double(h, "p50", latency_get(latency, 50));
+	info_append_double(h, "p99", latency_get(latency, 99));
+	info_append_double(h, "p999", latency_get(latency, 99.9));
+	info_table_end(h);
+}
+
+void
+wal_stat(struct info_handler *h)
+{
+	struct wal_stat *stat = &wal_writer_singleton.stat;
+	info_begin(h);
+	info_append_int(h, "batches", stat->batches);
+	info_append_int(h, "rows", stat->rows);
+	info_append_int(h, "bytes", stat->bytes);
+	info_append_int(h, "syncs", stat->syncs);
+	wal_info_append_latency(h, "queue_latency", &stat->queue_latency);
+	wal_info_append_latency(h, "write_latency", &stat->write_latency);
+	wal_info_append_latency(h, "sync_latency", &stat->sync_latency);
+	info_end(h);
+}
+
 /**
  * Initialize WAL writer.
  *
@@ -594,6 +727,11 @@ wal_opt_rotate(struct wal_writer *writer)
 		free(vclock);
 		return -1;
 	}
+	/*
+	 * In fsync mode sync each batch once, after all its
+	 * rows are written, rather than each write.
+	 */
+	writer->current_wal.sync_on_flush = writer->wal_mode == WAL_FSYNC;
 	/*
 	 * Keep track of the new WAL vclock. Required for garbage
 	 * collection, see wal_collect_garbage().
@@ -656,16 +794,30 @@ static void
 wal_assign_lsn(struct wal_writer *writer, struct xrow_header **row,
 	       struct xrow_header **end)
 {
-	/** Assign LSN to all local rows. */
+	/*
+	 * Assign LSN to all local rows. The LSN of the first
+	 * local row identifies the transaction, the last local
+	 * row commits it. Rows received from other replicas keep
+	 * the transaction identifiers assigned by their origin.
+	 */
+	struct xrow_header **last = NULL;
+	int64_t tsn = 0;
 	for ( ; row < end; row++) {
 		if ((*row)->replica_id == 0) {
 			(*row)->lsn = vclock_inc(&writer->vclock, instance_id);
 			(*row)->replica_id = instance_id;
+			if (tsn == 0)
+				tsn = (*row)->lsn;
+			(*row)->tsn = tsn;
+			(*row)->is_commit = false;
+			last = row;
 		} else {
 			vclock_follow(&writer->vclock, (*row)->replica_id,
 				      (*row)->lsn);
 		}
 	}
+	if (last != NULL)
+		(*last)->is_commit = true;
 }
 
 static void
@@ -713,6 +865,9 @@ wal_write_to_disk(struct cmsg *msg)
 	 */
 
 	struct xlog *l = &writer->current_wal;
+	off_t start_offset = l->offset;
+	double write_start = ev_monotonic_time();
+	wal_msg->queue_time = write_start - wal_msg->create_time;
 
 	/*
 	 * Iterate over requests (transactions)
@@ -733,8 +888,13 @@ wal_write_to_disk(struct cmsg *msg)
 		goto done;
 
 	last_committed = stailq_last(&wal_msg->commit);
+	wal_msg->is_synced = l->sync_on_flush && l->offset > start_offset;
+	if (wal_msg->is_synced)
+		wal_msg->sync_time = l->sync_time;
+	wal_msg->write_time = ev_monotonic_time() - write_start;
 
 done:
+	wal_msg->written = l->offset - start_offset;
 	error = diag_last_error(diag_get());
 	if (error) {
 		/* Until we can pass the error to tx, log it and clear. */
@@ -759,6 +919,11 @@ done:
 		stailq_concat(&wal_msg->rollback, &rollback);
 		wal_writer_begin_rollback(writer);
 	}
+	/* Make the written rows available to relays. */
+	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+		wal_mem_write(&writer->mem, entry->rows,
+			      entry->rows + entry->n_rows);
+	}
 	fiber_gc();
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
@@ -812,6 +977,19 @@ wal_thread_f(va_list ap)
 	return 0;
 }
 
+/** Approximate size of journal entry rows, in bytes. */
+static int64_t
+wal_entry_approx_len(struct journal_entry *entry)
+{
+	int64_t len = 0;
+	for (int i = 0; i < entry->n_rows; i++) {
+		struct xrow_header *row = entry->rows[i];
+		for (int j = 0; j < row->bodycnt; j++)
+			len += row->body[j].iov_len;
+	}
+	return len;
+}
+
 /**
  * WAL writer main entry point: queue a single request
  * to be written to disk and wait until this task is completed.
@@ -858,10 +1036,27 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 		 * thread right away.
 		 */
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
-		cpipe_push(&wal_thread.wal_pipe, &batch->base);
+		if (writer->commit_delay > 0)
+			cpipe_push_input(&wal_thread.wal_pipe, &batch->base);
+		else
+			cpipe_push(&wal_thread.wal_pipe, &batch->base);
 	}
+	batch->rows += entry->n_rows;
+	batch->approx_len += wal_entry_approx_len(entry);
 	wal_thread.wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
-	cpipe_flush_input(&wal_thread.wal_pipe);
+	if (writer->commit_delay == 0 ||
+	    batch->rows >= writer->commit_max_rows ||
+	    batch->approx_len >= writer->commit_max_size) {
+		ev_timer_stop(loop(), &writer->commit_timer);
+		cpipe_flush_input(&wal_thread.wal_pipe);
+	} else if (!ev_is_active(&writer->commit_timer)) {
+		/*
+		 * Let the batch collect more requests, so that
+		 * they are all written and synced at once.
+		 */
+		ev_timer_set(&writer->commit_timer, writer->commit_delay, 0);
+		ev_timer_start(loop(), &writer->commit_timer);
+	}
 	/**
 	 * It's not safe to spuriously wakeup this fiber
 	 * since in that case it will ignore a possible
@@ -1112,3 +1307,9 @@ wal_atfork()
 	if (xlog_is_open(&vy_log_writer.xlog))
 		xlog_atfork(&vy_log_writer.xlog);
 }
+
+struct wal_mem *
+wal_get_mem(void)
+{
+	return &wal_writer_singleton.mem;
+}
@@ -35,11 +35,14 @@
 #include "small/rlist.h"
 #include "cbus.h"
 #include "journal.h"
+#include "latency.h"
 
 struct fiber;
 struct vclock;
 struct wal_writer;
+struct wal_mem;
 struct tt_uuid;
+struct info_handler;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
@@ -48,6 +51,24 @@ extern const char *wal_mode_STRS[];
 
 extern int wal_dir_lock;
 
+/** WAL write statistics, maintained in tx. */
+struct wal_stat {
+	/** The number of batches written to the log. */
+	int64_t batches;
+	/** The number of rows in those batches. */
+	int64_t rows;
+	/** The number of bytes written for them. */
+	int64_t bytes;
+	/** The number of times the log was synced to disk. */
+	int64_t syncs;
+	/** Time a batch waits in tx and in the WAL queue. */
+	struct latency queue_latency;
+	/** Time it takes to write a batch, including sync. */
+	struct latency write_latency;
+	/** Time it takes to sync the log to disk. */
+	struct latency sync_latency;
+};
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -60,6 +81,20 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 	 const struct tt_uuid *instance_uuid, struct vclock *vclock,
 	 int64_t wal_max_rows, int64_t wal_max_size);
 
+/**
+ * Configure group commit: a batch of WAL requests is held
+ * in tx for up to @a delay seconds to let more requests join
+ * it, unless it reaches @a max_rows rows or @a max_size bytes
+ * earlier. The batch is then written and, in fsync mode,
+ * synced at once. A zero @a delay disables waiting.
+ */
+void
+wal_set_group_commit(double delay, int64_t max_rows, int64_t max_size);
+
+/** WAL statistics (box.stat.wal()). */
+void
+wal_stat(struct info_handler *h);
+
 void
 wal_thread_stop();
 
@@ -141,6 +176,13 @@ wal_clear_watcher(struct wal_watcher *watcher,
 void
 wal_atfork();
 
+/**
+ * Return the buffer of rows recently written to WAL.
+ * Used by relays, see wal_mem.h.
+ */
+struct wal_mem *
+wal_get_mem(void);
+
 enum wal_mode
 wal_mode();
 
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "wal_mem.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <small/region.h>
+#include <trivia/util.h>
+
+#include "diag.h"
+#include "tt_pthread.h"
+#include "xrow.h"
+
+enum {
+	/** Default size of a block of rows. */
+	WAL_MEM_BLOCK_SIZE = 256 * 1024,
+};
+
+/** A chunk of memory storing consecutive rows. */
+struct wal_mem_block {
+	/** Link in wal_mem::blocks. */
+	struct rlist in_mem;
+	/** Sequence number of the first row of the block. */
+	int64_t first_row;
+	/** Number of rows stored in the block. */
+	int row_count;
+	/** Size of the data area. */
+	size_t size;
+	/** Size of the used part of the data area. */
+	size_t used;
+	/**
+	 * Rows. Each row is stored as struct xrow_header
+	 * followed by the row body, padded to 8 bytes.
+	 */
+	char data[0];
+};
+
+/** Size of a row with the given body size in a block. */
+static inline size_t
+wal_mem_entry_size(size_t body_size)
+{
+	size_t size = sizeof(struct xrow_header) + body_size;
+	return (size + 7) & ~(size_t)7;
+}
+
+/** Size of a row stored in a block at the given offset. */
+static inline size_t
+wal_mem_block_entry_size(struct wal_mem_block *block, size_t offset)
+{
+	struct xrow_header *row = (struct xrow_header *)(block->data + offset);
+	return wal_mem_entry_size(row->bodycnt > 0 ? row->body[0].iov_len : 0);
+}
+
+void
+wal_mem_create(struct wal_mem *mem, size_t max_size,
+	       const struct vclock *vclock)
+{
+	tt_pthread_mutex_init(&mem->mutex, NULL);
+	rlist_create(&mem->blocks);
+	mem->size = 0;
+	mem->max_size = max_size;
+	vclock_copy(&mem->vclock, vclock);
+	vclock_copy(&mem->last_vclock, vclock);
+	mem->first_row = 0;
+	mem->next_row = 0;
+}
+
+/**
+ * Discard the oldest block of the buffer and advance the
+ * buffer vclock past its rows.
+ */
+static void
+wal_mem_discard_first_block(struct wal_mem *mem)
+{
+	assert(!rlist_empty(&mem->blocks));
+	struct wal_mem_block *block = rlist_first_entry(&mem->blocks,
+					struct wal_mem_block, in_mem);
+	for (size_t offset = 0; offset < block->used;
+	     offset += wal_mem_block_entry_size(block, offset)) {
+		struct xrow_header *row =
+			(struct xrow_header *)(block->data + offset);
+		vclock_follow(&mem->vclock, row->replica_id, row->lsn);
+	}
+	mem->first_row += block->row_count;
+	mem->size -= block->size;
+	rlist_del_entry(block, in_mem);
+	free(block);
+}
+
+void
+wal_mem_destroy(struct wal_mem *mem)
+{
+	struct wal_mem_block *block, *tmp;
+	rlist_foreach_entry_safe(block, &mem->blocks, in_mem, tmp)
+		free(block);
+	tt_pthread_mutex_destroy(&mem->mutex);
+}
+
+/** Append a row to the buffer. */
+static int
+wal_mem_append(struct wal_mem *mem, struct xrow_header *row)
+{
+	size_t body_size = 0;
+	for (int i = 0; i < row->bodycnt; i++)
+		body_size += row->body[i].iov_len;
+	size_t entry_size = wal_mem_entry_size(body_size);
+
+	struct wal_mem_block *block = NULL;
+	if (!rlist_empty(&mem->blocks)) {
+		block = rlist_last_entry(&mem->blocks,
+					 struct wal_mem_block, in_mem);
+	}
+	if (block == NULL || block->size - block->used < entry_size) {
+		size_t size = MAX((size_t)WAL_MEM_BLOCK_SIZE, entry_size);
+		block = (struct wal_mem_block *)malloc(sizeof(*block) + size);
+		if (block == NULL) {
+			diag_set(OutOfMemory, sizeof(*block) + size,
+				 "malloc", "struct wal_mem_block");
+			return -1;
+		}
+		block->first_row = mem->next_row;
+		block->row_count = 0;
+		block->size = size;
+		block->used = 0;
+		rlist_add_tail_entry(&mem->blocks, block, in_mem);
+		mem->size += size;
+	}
+
+	char *data = block->data + block->used;
+	struct xrow_header *copy = (struct xrow_header *)data;
+	*copy = *row;
+	/* Client request attributes are not replicated. */
+	copy->sync = 0;
+	copy->stream_id = 0;
+	copy->bodycnt = body_size > 0 ? 1 : 0;
+	copy->body[0].iov_base = NULL;
+	copy->body[0].iov_len = body_size;
+	data += sizeof(*copy);
+	for (int i = 0; i < row->bodycnt; i++) {
+		memcpy(data, row->body[i].iov_base, row->body[i].iov_len);
+		data += row->body[i].iov_len;
+	}
+	block->used += entry_size;
+	block->row_count++;
+	return 0;
+}
+
+void
+wal_mem_write(struct wal_mem *mem, struct xrow_header **rows,
+	      struct xrow_header **end)
+{
+	tt_pthread_mutex_lock(&mem->mutex);
+	bool is_discarded = false;
+	for (struct xrow_header **row = rows; row < end; row++) {
+		if (!is_discarded && wal_mem_append(mem, *row) != 0) {
+			/*
+			 * Readers will have to use files
+			 * to get this row.
+			 */
+			diag_log();
+			diag_clear(diag_get());
+			is_discarded = true;
+		}
+		vclock_follow(&mem->last_vclock, (*row)->replica_id,
+			      (*row)->lsn);
+		mem->next_row++;
+	}
+	if (is_discarded) {
+		/* Discard everything to avoid a gap in rows. */
+		while (!rlist_empty(&mem->blocks))
+			wal_mem_discard_first_block(mem);
+		vclock_copy(&mem->vclock, &mem->last_vclock);
+		mem->first_row = mem->next_row;
+	}
+	/* Keep the newest block, it may be larger than the limit. */
+	while (mem->size > mem->max_size &&
+	       rlist_first(&mem->blocks) != rlist_last(&mem->blocks))
+		wal_mem_discard_first_block(mem);
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+int
+wal_mem_cursor_create(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		      const struct vclock *vclock)
+{
+	int rc = -1;
+	tt_pthread_mutex_lock(&mem->mutex);
+	int cmp = vclock_compare(&mem->vclock, vclock);
+	if (cmp == 0 || cmp == -1) {
+		cursor->row = mem->first_row;
+		cursor->block = NULL;
+		cursor->offset = 0;
+		rc = 0;
+	}
+	tt_pthread_mutex_unlock(&mem->mutex);
+	return rc;
+}
+
+/**
+ * Find the block and the offset of the row the cursor
+ * points to. The row must be stored in the buffer.
+ */
+static void
+wal_mem_cursor_locate(struct wal_mem *mem, struct wal_mem_cursor *cursor)
+{
+	assert(cursor->row >= mem->first_row && cursor->row < mem->next_row);
+	if (cursor->block != NULL)
+		return;
+	/* Readers usually lag a little, so look from the end. */
+	struct wal_mem_block *block;
+	rlist_foreach_entry_reverse(block, &mem->blocks, in_mem) {
+		if (block->first_row <= cursor->row)
+			break;
+	}
+	size_t offset = 0;
+	for (int64_t row = block->first_row; row < cursor->row; row++)
+		offset += wal_mem_block_entry_size(block, offset);
+	cursor->block = block;
+	cursor->offset = offset;
+}
+
+int
+wal_mem_cursor_next(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		    struct region *region, size_t max_size,
+		    struct xrow_header **rows, int *count)
+{
+	*rows = NULL;
+	*count = 0;
+	int rc = 0;
+	tt_pthread_mutex_lock(&mem->mutex);
+	if (cursor->row < mem->first_row) {
+		/* The rows have been discarded. */
+		rc = -1;
+		goto out;
+	}
+	if (cursor->row == mem->next_row)
+		goto out;
+	wal_mem_cursor_locate(mem, cursor);
+
+	/* Count rows to read. */
+	struct wal_mem_block *block = cursor->block;
+	size_t offset = cursor->offset;
+	size_t size = 0;
+	int n = 0;
+	while (cursor->row + n < mem->next_row && size < max_size) {
+		if (offset == block->used) {
+			block = rlist_next_entry(block, in_mem);
+			offset = 0;
+		}
+		size_t entry_size = wal_mem_block_entry_size(block, offset);
+		offset += entry_size;
+		size += entry_size;
+		n++;
+	}
+
+	struct xrow_header *copy = (struct xrow_header *)
+		region_aligned_alloc(region, sizeof(*copy) * n,
+				     alignof(struct xrow_header));
+	char *data = (char *)region_alloc(region, size);
+	if (copy == NULL || data == NULL) {
+		diag_set(OutOfMemory, size, "region", "wal_mem rows");
+		rc = -1;
+		goto out;
+	}
+	block = cursor->block;
+	offset = cursor->offset;
+	for (int i = 0; i < n; i++) {
+		if (offset == block->used) {
+			block = rlist_next_entry(block, in_mem);
+			offset = 0;
+		}
+		struct xrow_header *row =
+			(struct xrow_header *)(block->data + offset);
+		copy[i] = *row;
+		if (row->bodycnt > 0) {
+			size_t body_size = row->body[0].iov_len;
+			memcpy(data, row + 1, body_size);
+			copy[i].body[0].iov_base = data;
+			data += body_size;
+		}
+		offset += wal_mem_block_entry_size(block, offset);
+	}
+	cursor->row += n;
+	/*
+	 * Don't keep a pointer to a fully read block: it may
+	 * be discarded while the cursor still points past it.
+	 */
+	if (offset == block->used) {
+		cursor->block = NULL;
+		cursor->offset = 0;
+	} else {
+		cursor->block = block;
+		cursor->offset = offset;
+	}
+	*rows = copy;
+	*count = n;
+out:
+	tt_pthread_mutex_unlock(&mem->mutex);
+	return rc;
+}
@@ -0,0 +1,156 @@
+#ifndef TARANTOOL_BOX_WAL_MEM_H_INCLUDED
+#define TARANTOOL_BOX_WAL_MEM_H_INCLUDED
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "small/rlist.h"
+#include "vclock.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct region;
+struct xrow_header;
+struct wal_mem_block;
+
+/**
+ * In-memory buffer of rows recently written to WAL.
+ *
+ * The buffer is appended by the WAL thread after rows have been
+ * written to disk and read by relays, so that they don't have to
+ * re-read and decode xlog files to feed replicas which are not
+ * far behind. The buffer size is limited: when it is exceeded,
+ * the oldest rows are discarded, and relays which haven't sent
+ * them yet have to fall back on reading files.
+ *
+ * The buffer is shared between threads and protected by a mutex.
+ */
+struct wal_mem {
+	/** Protects all members below. */
+	pthread_mutex_t mutex;
+	/** List of blocks storing rows, oldest first. */
+	struct rlist blocks;
+	/** Total size of all blocks. */
+	size_t size;
+	/** Max total size of all blocks. */
+	size_t max_size;
+	/**
+	 * WAL vclock preceding the oldest row stored in
+	 * the buffer. The buffer has all rows written after
+	 * it.
+	 */
+	struct vclock vclock;
+	/** WAL vclock after the newest row of the buffer. */
+	struct vclock last_vclock;
+	/** Sequence number of the oldest row of the buffer. */
+	int64_t first_row;
+	/** Sequence number to be assigned to the next row. */
+	int64_t next_row;
+};
+
+/** Position of a reader in a WAL memory buffer. */
+struct wal_mem_cursor {
+	/** Sequence number of the next row to read. */
+	int64_t row;
+	/** Block containing the next row, NULL if unknown. */
+	struct wal_mem_block *block;
+	/** Offset of the next row in the block. */
+	size_t offset;
+};
+
+/**
+ * Create a WAL memory buffer.
+ * @param mem       Buffer to initialize.
+ * @param max_size  Max size of the buffer.
+ * @param vclock    WAL vclock.
+ */
+void
+wal_mem_create(struct wal_mem *mem, size_t max_size,
+	       const struct vclock *vclock);
+
+/** Destroy a WAL memory buffer. */
+void
+wal_mem_destroy(struct wal_mem *mem);
+
+/**
+ * Append rows written to WAL to the buffer. The rows must
+ * have LSNs assigned. Discards the oldest rows if the buffer
+ * size is exceeded. On memory allocation failure the buffer
+ * is emptied, which only makes relays read files. Never fails.
+ */
+void
+wal_mem_write(struct wal_mem *mem, struct xrow_header **rows,
+	      struct xrow_header **end);
+
+/**
+ * Position a cursor at the oldest row of the buffer so that
+ * a reader at @a vclock can continue from it, skipping rows
+ * it already has.
+ *
+ * @retval  0 Success.
+ * @retval -1 The buffer doesn't have all rows following
+ *            @a vclock, the reader must use WAL files.
+ */
+int
+wal_mem_cursor_create(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		      const struct vclock *vclock);
+
+/**
+ * Read rows following a cursor position. The rows and their
+ * bodies are copied to @a region, at least one row and about
+ * @a max_size bytes at most per call.
+ *
+ * @param mem       Buffer to read from.
+ * @param cursor    Cursor to advance.
+ * @param region    Region to copy rows to.
+ * @param max_size  Approximate max size of rows to copy.
+ * @param[out] rows Array of rows read.
+ * @param[out] count Number of rows read, 0 if the cursor is
+ *                  at the end of the buffer.
+ *
+ * @retval  0 Success.
+ * @retval -1 The rows following the cursor have been
+ *            discarded, the reader must use WAL files.
+ *            Or out of memory, diag is set in this case.
+ */
+int
+wal_mem_cursor_next(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		    struct region *region, size_t max_size,
+		    struct xrow_header **rows, int *count);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_WAL_MEM_H_INCLUDED */
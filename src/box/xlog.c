@@ -76,6 +76,12 @@ enum {
 	 * Maybe this should be a configuration option.
 	 */
 	XLOG_TX_COMPRESS_THRESHOLD = 2 * 1024,
+	/**
+	 * The maximum number of blocks a log may have queued
+	 * for compression in the coio thread pool, see
+	 * xlog::compress_is_async.
+	 */
+	XLOG_ZQUEUE_MAX = 8,
 };
 
 /* {{{ struct xlog_meta */
@@ -94,6 +100,7 @@ enum {
 #define VCLOCK_KEY "VClock"
 #define VERSION_KEY "Version"
 #define PREV_VCLOCK_KEY "PrevVClock"
+#define PREALLOCATED_KEY "Preallocated"
 
 static const char v13[] = "0.13";
 static const char v12[] = "0.12";
@@ -114,6 +121,7 @@ xlog_meta_create(struct xlog_meta *meta, const char *filetype,
 		vclock_copy(&meta->prev_vclock, prev_vclock);
 	else
 		vclock_clear(&meta->prev_vclock);
+	meta->is_preallocated = false;
 }
 
 /**
@@ -155,6 +163,10 @@ xlog_meta_format(const struct xlog_meta *meta, char *buf, int size)
 			PREV_VCLOCK_KEY ": %s\n", vstr);
 		free(vstr);
 	}
+	if (meta->is_preallocated) {
+		SNPRINT(total, snprintf, buf, size,
+			PREALLOCATED_KEY ": true\n");
+	}
 	SNPRINT(total, snprintf, buf, size, "\n");
 	assert(total > 0);
 	return total;
@@ -289,6 +301,12 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 			 */
 			if (parse_vclock(val, val_end, &meta->prev_vclock) != 0)
 				return -1;
+		} else if (memcmp(key, PREALLOCATED_KEY, key_end - key) == 0) {
+			/*
+			 * Preallocated: true
+			 */
+			meta->is_preallocated = val_end - val == 4 &&
+						memcmp(val, "true", 4) == 0;
 		} else if (memcmp(key, VERSION_KEY, key_end - key) == 0) {
 			/* Ignore Version: for now */
 		} else {
@@ -330,6 +348,7 @@ xdir_create(struct xdir *dir, const char *dirname,
 		break;
 	case XLOG:
 		dir->sync_is_async = true;
+		dir->compress_is_async = true;
 		dir->filetype = "XLOG";
 		dir->filename_ext = ".xlog";
 		dir->suffix = NONE;
@@ -755,12 +774,19 @@ xlog_clear(struct xlog *l)
 	l->fd = -1;
 }
 
+struct xlog_zqueue;
+
+static void
+xlog_zqueue_delete(struct xlog_zqueue *queue);
+
 static void
 xlog_destroy(struct xlog *xlog)
 {
 	obuf_destroy(&xlog->obuf);
 	obuf_destroy(&xlog->zbuf);
 	ZSTD_freeCCtx(xlog->zctx);
+	if (xlog->zqueue != NULL)
+		xlog_zqueue_delete(xlog->zqueue);
 	TRASH(xlog);
 	xlog->fd = -1;
 }
@@ -946,6 +972,7 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	struct xlog_meta meta;
 	xlog_meta_create(&meta, dir->filetype, dir->instance_uuid,
 			 vclock, prev_vclock);
+	meta.is_preallocated = dir->prealloc_size > 0;
 
 	char *filename = xdir_format_filename(dir, signature, NONE);
 	if (xlog_create(xlog, filename, dir->open_wflags, &meta) != 0)
@@ -956,6 +983,7 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	/* free file cache if dir should be synced */
 	xlog->free_cache = dir->sync_interval != 0 ? true: false;
 	xlog->rate_limit = 0;
+	xlog->compress_is_async = dir->compress_is_async;
 
 	/* Rename xlog file */
 	if (dir->suffix != INPROGRESS && xlog_rename(xlog)) {
@@ -965,9 +993,43 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		return -1;
 	}
 
+	/* Failure to preallocate is not fatal. */
+	if (dir->prealloc_size > 0 &&
+	    xlog_fallocate(xlog, dir->prealloc_size) != 0)
+		diag_log();
 	return 0;
 }
 
+/**
+ * Populate a fixheader of an xlog_tx block: the block
+ * @a magic, length and checksum of the data following it.
+ * The fixheader is padded to XLOG_FIXHEADER_SIZE.
+ */
+static void
+xlog_fixheader_encode(char *fixheader, log_magic_t magic,
+		      size_t len, uint32_t crc32c)
+{
+	*(log_magic_t *)fixheader = magic;
+	char *data = fixheader + sizeof(log_magic_t);
+	data = mp_encode_uint(data, len);
+	/* Encode crc32 for previous row */
+	data = mp_encode_uint(data, 0);
+	/* Encode crc32 for current row */
+	data = mp_encode_uint(data, crc32c);
+	/*
+	 * Encode a padding, to ensure the resulting
+	 * fixheader always has the same size.
+	 */
+	ssize_t padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
+	if (padding > 0) {
+		data = mp_encode_strl(data, padding - 1);
+		if (padding > 1) {
+			memset(data, 0, padding - 1);
+			data += padding - 1;
+		}
+	}
+}
+
 /**
  * Write a sequence of uncompressed xrow objects.
  *
@@ -982,14 +1044,6 @@ xlog_tx_write_plain(struct xlog *log)
 	 * now populate it with data.
 	 */
 	char *fixheader = (char *)log->obuf.iov[0].iov_base;
-	*(log_magic_t *)fixheader = row_marker;
-	char *data = fixheader + sizeof(log_magic_t);
-
-	data = mp_encode_uint(data,
-			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE);
-	/* Encode crc32 for previous row */
-	data = mp_encode_uint(data, 0);
-	/* Encode crc32 for current row */
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	size_t offset = XLOG_FIXHEADER_SIZE;
@@ -999,19 +1053,9 @@ xlog_tx_write_plain(struct xlog *log)
 				    iov->iov_len - offset);
 		offset = 0;
 	}
-	data = mp_encode_uint(data, crc32c);
-	/*
-	 * Encode a padding, to ensure the resulting
-	 * fixheader always has the same size.
-	 */
-	ssize_t padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
-	if (padding > 0) {
-		data = mp_encode_strl(data, padding - 1);
-		if (padding > 1) {
-			memset(data, 0, padding - 1);
-			data += padding - 1;
-		}
-	}
+	xlog_fixheader_encode(fixheader, row_marker,
+			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE,
+			      crc32c);
 
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
@@ -1081,25 +1125,9 @@ xlog_tx_write_zstd(struct xlog *log)
 		offset = 0;
 	}
 
-	*(log_magic_t *)fixheader = zrow_marker;
-	char *data;
-	data = fixheader + sizeof(log_magic_t);
-	data = mp_encode_uint(data,
-			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE);
-	/* Encode crc32 for previous row */
-	data = mp_encode_uint(data, 0);
-	/* Encode crc32 for current row */
-	data = mp_encode_uint(data, crc32c);
-	/* Encode padding */
-	ssize_t padding;
-	padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
-	if (padding > 0) {
-		data = mp_encode_strl(data, padding - 1);
-		if (padding > 1) {
-			memset(data, 0, padding - 1);
-			data += padding - 1;
-		}
-	}
+	xlog_fixheader_encode(fixheader, zrow_marker,
+			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE,
+			      crc32c);
 
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
@@ -1203,6 +1231,344 @@ xlog_tx_write(struct xlog *log)
 	return written;
 }
 
+/* {{{ Background compression */
+
+/**
+ * A block of xlog rows compressed in the coio thread pool.
+ */
+struct xlog_zjob {
+	/** Link in xlog_zqueue::jobs or xlog_zqueue::cache. */
+	struct rlist in_queue;
+	/** Rows of the block, starting with a fixheader placeholder. */
+	struct obuf obuf;
+	/** The number of rows in the block. */
+	int64_t rows;
+	/** The context of zstd compression, reused for all blocks. */
+	ZSTD_CCtx *zctx;
+	/** A fixheader followed by the compressed rows. */
+	char *zbuf;
+	/** Size of memory allocated for zbuf. */
+	size_t zbuf_capacity;
+	/** Size of the compressed rows in zbuf. */
+	size_t zsize;
+	/** ZSTD error message, set if compression failed. */
+	const char *error;
+	/** Set once the block is compressed. */
+	bool is_done;
+	/** The fiber waiting for the block to be compressed. */
+	struct fiber *fiber;
+};
+
+/**
+ * Blocks of a log compressed in the coio thread pool, in
+ * the order they must be written to the file.
+ */
+struct xlog_zqueue {
+	/** Queued blocks. */
+	struct rlist jobs;
+	/** Length of the jobs list. */
+	int len;
+	/** Blocks available for reuse. */
+	struct rlist cache;
+	/**
+	 * Set when the first block is queued and cleared when
+	 * the queue is flushed. While it is set, the caller
+	 * hasn't been told about any of the queued blocks or
+	 * blocks already written from the queue, so they all
+	 * have to be rolled back together on error.
+	 */
+	bool has_svp;
+	/** File offset at the time the first block was queued. */
+	off_t svp_offset;
+	/** The number of rows in the file at the same time. */
+	int64_t svp_rows;
+};
+
+static struct xlog_zjob *
+xlog_zjob_new(void)
+{
+	struct xlog_zjob *job = (struct xlog_zjob *)calloc(1, sizeof(*job));
+	if (job == NULL) {
+		diag_set(OutOfMemory, sizeof(*job), "malloc",
+			 "struct xlog_zjob");
+		return NULL;
+	}
+	job->zctx = ZSTD_createCCtx();
+	if (job->zctx == NULL) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 "failed to create context");
+		free(job);
+		return NULL;
+	}
+	obuf_create(&job->obuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	return job;
+}
+
+static void
+xlog_zjob_delete(struct xlog_zjob *job)
+{
+	obuf_destroy(&job->obuf);
+	ZSTD_freeCCtx(job->zctx);
+	free(job->zbuf);
+	free(job);
+}
+
+/**
+ * Compress a block and populate its fixheader. Doesn't
+ * touch anything but the block itself, so can be run in
+ * any thread.
+ */
+static void
+xlog_zjob_compress(struct xlog_zjob *job)
+{
+	uint32_t crc32c = 0;
+	char *zdst = job->zbuf + XLOG_FIXHEADER_SIZE;
+	char *zend = job->zbuf + job->zbuf_capacity;
+	/* 3 is compression level. */
+	ZSTD_compressBegin(job->zctx, 3);
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (struct iovec *iov = job->obuf.iov; iov->iov_len; ++iov) {
+		size_t (*fcompress)(ZSTD_CCtx *, void *, size_t,
+				    const void *, size_t);
+		if (iov == job->obuf.iov + job->obuf.pos ||
+		    !(iov + 1)->iov_len) {
+			fcompress = ZSTD_compressEnd;
+		} else {
+			fcompress = ZSTD_compressContinue;
+		}
+		size_t zsize = fcompress(job->zctx, zdst, zend - zdst,
+					 (char *)iov->iov_base + offset,
+					 iov->iov_len - offset);
+		if (ZSTD_isError(zsize)) {
+			job->error = ZSTD_getErrorName(zsize);
+			return;
+		}
+		crc32c = crc32_calc(crc32c, zdst, zsize);
+		zdst += zsize;
+		offset = 0;
+	}
+	job->zsize = zdst - job->zbuf - XLOG_FIXHEADER_SIZE;
+	xlog_fixheader_encode(job->zbuf, zrow_marker, job->zsize, crc32c);
+}
+
+static void
+xlog_zjob_execute(eio_req *req)
+{
+	xlog_zjob_compress((struct xlog_zjob *)req->data);
+}
+
+static int
+xlog_zjob_complete(eio_req *req)
+{
+	struct xlog_zjob *job = (struct xlog_zjob *)req->data;
+	job->is_done = true;
+	if (job->fiber != NULL)
+		fiber_wakeup(job->fiber);
+	return 0;
+}
+
+/** Wait until a queued block is compressed. */
+static void
+xlog_zjob_wait(struct xlog_zjob *job)
+{
+	if (job->is_done)
+		return;
+	job->fiber = fiber();
+	do {
+		fiber_yield();
+	} while (!job->is_done);
+	job->fiber = NULL;
+	/*
+	 * While waiting, the fiber could have been woken up for
+	 * another reason, e.g. by a cbus endpoint it serves.
+	 * Reschedule it so that such a wakeup isn't lost.
+	 */
+	fiber_wakeup(fiber());
+}
+
+/**
+ * Move the rows accumulated in the log output buffer to a
+ * new block and queue it for compression. If @a in_thread
+ * is set, the block is compressed in the calling thread.
+ */
+static int
+xlog_zqueue_push(struct xlog *log, bool in_thread)
+{
+	struct xlog_zqueue *queue = log->zqueue;
+	if (queue == NULL) {
+		queue = (struct xlog_zqueue *)calloc(1, sizeof(*queue));
+		if (queue == NULL) {
+			diag_set(OutOfMemory, sizeof(*queue), "malloc",
+				 "struct xlog_zqueue");
+			return -1;
+		}
+		rlist_create(&queue->jobs);
+		rlist_create(&queue->cache);
+		log->zqueue = queue;
+	}
+	struct xlog_zjob *job;
+	if (!rlist_empty(&queue->cache)) {
+		job = rlist_first_entry(&queue->cache, struct xlog_zjob,
+					in_queue);
+		rlist_del_entry(job, in_queue);
+	} else {
+		job = xlog_zjob_new();
+		if (job == NULL)
+			return -1;
+	}
+	/* Estimate max output buffer size. */
+	size_t capacity = XLOG_FIXHEADER_SIZE;
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (struct iovec *iov = log->obuf.iov; iov->iov_len; ++iov) {
+		capacity += ZSTD_compressBound(iov->iov_len - offset);
+		offset = 0;
+	}
+	if (capacity > job->zbuf_capacity) {
+		char *zbuf = (char *)realloc(job->zbuf, capacity);
+		if (zbuf == NULL) {
+			diag_set(OutOfMemory, capacity, "malloc",
+				 "compression buffer");
+			rlist_add_entry(&queue->cache, job, in_queue);
+			return -1;
+		}
+		job->zbuf = zbuf;
+		job->zbuf_capacity = capacity;
+	}
+	/* Hand the rows over to the block. */
+	struct obuf obuf = job->obuf;
+	job->obuf = log->obuf;
+	log->obuf = obuf;
+	job->rows = log->tx_rows;
+	log->tx_rows = 0;
+	job->error = NULL;
+	job->is_done = false;
+
+	if (!queue->has_svp) {
+		queue->has_svp = true;
+		queue->svp_offset = log->offset;
+		queue->svp_rows = log->rows;
+	}
+	rlist_add_tail_entry(&queue->jobs, job, in_queue);
+	queue->len++;
+	if (in_thread || eio_custom(xlog_zjob_execute, 0,
+				    xlog_zjob_complete, job) == NULL) {
+		xlog_zjob_compress(job);
+		job->is_done = true;
+	}
+	return 0;
+}
+
+/** Remove the first block from the queue and recycle it. */
+static void
+xlog_zqueue_pop(struct xlog_zqueue *queue)
+{
+	struct xlog_zjob *job = rlist_first_entry(&queue->jobs,
+						  struct xlog_zjob, in_queue);
+	rlist_move_entry(&queue->cache, job, in_queue);
+	queue->len--;
+	obuf_reset(&job->obuf);
+}
+
+/**
+ * Drop all queued blocks and truncate the file back to the
+ * size it had before the first of them was queued.
+ */
+static void
+xlog_zqueue_discard(struct xlog *log)
+{
+	struct xlog_zqueue *queue = log->zqueue;
+	assert(queue != NULL && queue->has_svp);
+	while (queue->len > 0) {
+		/* The block memory is in use until it's compressed. */
+		xlog_zjob_wait(rlist_first_entry(&queue->jobs,
+						 struct xlog_zjob, in_queue));
+		xlog_zqueue_pop(queue);
+	}
+	if (lseek(log->fd, queue->svp_offset, SEEK_SET) < 0 ||
+	    ftruncate(log->fd, queue->svp_offset) != 0)
+		panic_syserror("failed to truncate xlog after write error");
+	log->offset = queue->svp_offset;
+	log->rows = queue->svp_rows;
+	queue->has_svp = false;
+}
+
+/**
+ * Write queued blocks to the file in order, waiting for
+ * them to be compressed, until no more than @a count blocks
+ * are left in the queue. On error the queue is discarded.
+ */
+static int
+xlog_zqueue_write(struct xlog *log, int count)
+{
+	struct xlog_zqueue *queue = log->zqueue;
+	while (queue->len > count) {
+		struct xlog_zjob *job = rlist_first_entry(&queue->jobs,
+							  struct xlog_zjob,
+							  in_queue);
+		xlog_zjob_wait(job);
+		if (job->error != NULL) {
+			diag_set(ClientError, ER_COMPRESSION, job->error);
+			goto error;
+		}
+		ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+			diag_set(ClientError, ER_INJECTION,
+				 "xlog write injection");
+			goto error;
+		});
+		size_t size = XLOG_FIXHEADER_SIZE + job->zsize;
+		if (fio_writen(log->fd, job->zbuf, size) < 0) {
+			diag_set(SystemError, "failed to write to '%s' file",
+				 log->filename);
+			goto error;
+		}
+		log->offset += size;
+		log->rows += job->rows;
+		xlog_zqueue_pop(queue);
+	}
+	return 0;
+error:
+	xlog_zqueue_discard(log);
+	return -1;
+}
+
+static void
+xlog_zqueue_delete(struct xlog_zqueue *queue)
+{
+	assert(queue->len == 0);
+	struct xlog_zjob *job, *tmp;
+	rlist_foreach_entry_safe(job, &queue->cache, in_queue, tmp)
+		xlog_zjob_delete(job);
+	free(queue);
+}
+
+/**
+ * Write a full xlog_tx block, or queue it for compression
+ * in the coio thread pool if the log allows it.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written, 0 if the block
+ *              was queued
+ */
+static ssize_t
+xlog_tx_submit(struct xlog *log)
+{
+	if (!log->compress_is_async && !log->sync_on_flush)
+		return xlog_tx_write(log);
+	if (xlog_zqueue_push(log, !log->compress_is_async) != 0) {
+		obuf_reset(&log->obuf);
+		log->tx_rows = 0;
+		if (log->zqueue != NULL && log->zqueue->has_svp)
+			xlog_zqueue_discard(log);
+		return -1;
+	}
+	/* Limit the amount of memory pinned by the queue. */
+	if (xlog_zqueue_write(log, XLOG_ZQUEUE_MAX) != 0)
+		return -1;
+	return 0;
+}
+
+/* }}} */
+
 /*
  * Add a row to a log and possibly flush the log.
  *
@@ -1259,7 +1625,7 @@ xlog_write_row(struct xlog *log, const struct xrow_header *packet)
 	size_t row_size = obuf_size(&log->obuf) - page_offset;
 	if (log->is_autocommit &&
 	    obuf_size(&log->obuf) >= XLOG_TX_AUTOCOMMIT_THRESHOLD &&
-	    xlog_tx_write(log) < 0)
+	    xlog_tx_submit(log) < 0)
 		return -1;
 
 	return row_size;
@@ -1289,7 +1655,7 @@ xlog_tx_commit(struct xlog *log)
 {
 	log->is_autocommit = true;
 	if (obuf_size(&log->obuf) >= XLOG_TX_AUTOCOMMIT_THRESHOLD) {
-		return xlog_tx_write(log);
+		return xlog_tx_submit(log);
 	}
 	return 0;
 }
@@ -1303,6 +1669,8 @@ xlog_tx_rollback(struct xlog *log)
 	log->is_autocommit = true;
 	log->tx_rows = 0;
 	obuf_reset(&log->obuf);
+	if (log->zqueue != NULL && log->zqueue->has_svp)
+		xlog_zqueue_discard(log);
 }
 
 /**
@@ -1313,9 +1681,53 @@ ssize_t
 xlog_flush(struct xlog *log)
 {
 	assert(log->is_autocommit);
-	if (log->obuf.used == 0)
-		return 0;
-	return xlog_tx_write(log);
+	struct xlog_zqueue *queue = log->zqueue;
+	off_t svp_offset = log->offset;
+	int64_t svp_rows = log->rows;
+	ssize_t written;
+	if (queue != NULL && queue->has_svp) {
+		svp_offset = queue->svp_offset;
+		svp_rows = queue->svp_rows;
+		/*
+		 * Compress the last block in this thread while
+		 * the queued ones are still being processed.
+		 */
+		if (obuf_size(&log->obuf) > XLOG_FIXHEADER_SIZE &&
+		    xlog_zqueue_push(log, true) != 0) {
+			xlog_tx_rollback(log);
+			return -1;
+		}
+		obuf_reset(&log->obuf);
+		if (xlog_zqueue_write(log, 0) != 0)
+			return -1;
+		queue->has_svp = false;
+		written = log->offset - svp_offset;
+	} else {
+		if (log->obuf.used == 0)
+			return 0;
+		written = xlog_tx_write(log);
+		if (written < 0)
+			return -1;
+	}
+	if (!log->sync_on_flush || written == 0)
+		return written;
+	double sync_start = ev_monotonic_time();
+	if (fdatasync(log->fd) < 0) {
+		diag_set(SystemError, "failed to sync '%s' file",
+			 log->filename);
+		/*
+		 * The data may or may not have reached the disk,
+		 * so the only safe way is to remove it.
+		 */
+		if (lseek(log->fd, svp_offset, SEEK_SET) < 0 ||
+		    ftruncate(log->fd, svp_offset) != 0)
+			panic_syserror("failed to truncate xlog after sync error");
+		log->offset = svp_offset;
+		log->rows = svp_rows;
+		return -1;
+	}
+	log->sync_time = ev_monotonic_time() - sync_start;
+	return written;
 }
 
 static int
@@ -1324,7 +1736,7 @@ sync_cb(eio_req *req)
 	int fd = (intptr_t) req->data;
 	if (req->result) {
 		errno = req->errorno;
-		say_syserror("%s: fsync() failed",
+		say_syserror("%s: fdatasync() failed",
 			     fio_filename(fd));
 		errno = 0;
 	}
@@ -1332,6 +1744,58 @@ sync_cb(eio_req *req)
 	return 0;
 }
 
+int
+xlog_fallocate(struct xlog *log, size_t size)
+{
+	assert(log->meta.is_preallocated);
+	if ((off_t)size <= log->offset || (off_t)size <= log->allocated_size)
+		return 0;
+	/*
+	 * Reserving space with fallocate() is not enough: the
+	 * blocks are allocated as unwritten extents, and
+	 * converting them on write makes the file system update
+	 * the extent tree anyway. Write the zeros for real.
+	 * Rows are written at the current file position, so
+	 * use pwrite() to keep it.
+	 */
+	enum { XLOG_ZERO_CHUNK = 1024 * 1024 };
+	char *zeros = (char *)calloc(1, XLOG_ZERO_CHUNK);
+	if (zeros == NULL) {
+		diag_set(OutOfMemory, XLOG_ZERO_CHUNK, "calloc", "zeros");
+		return -1;
+	}
+	off_t offset = log->offset;
+	while (offset < (off_t)size) {
+		size_t len = MIN((off_t)size - offset, XLOG_ZERO_CHUNK);
+		ssize_t written = pwrite(log->fd, zeros, len, offset);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			diag_set(SystemError, "%s: failed to preallocate file",
+				 log->filename);
+			free(zeros);
+			/* Give back the space written so far. */
+			if (ftruncate(log->fd, log->offset) != 0)
+				say_syserror("%s: ftruncate() failed",
+					     log->filename);
+			return -1;
+		}
+		offset += written;
+	}
+	free(zeros);
+	log->allocated_size = size;
+	/*
+	 * Make the new file size durable now so that syncing
+	 * rows does not have to.
+	 */
+	if (fdatasync(log->fd) != 0) {
+		diag_set(SystemError, "%s: fdatasync() failed",
+			 log->filename);
+		return -1;
+	}
+	return 0;
+}
+
 int
 xlog_sync(struct xlog *l)
 {
@@ -1341,9 +1805,9 @@ xlog_sync(struct xlog *l)
 			say_syserror("%s: dup() failed", l->filename);
 			return -1;
 		}
-		eio_fsync(fd, 0, sync_cb, (void *) (intptr_t) fd);
-	} else if (fsync(l->fd) < 0) {
-		say_syserror("%s: fsync failed", l->filename);
+		eio_fdatasync(fd, 0, sync_cb, (void *) (intptr_t) fd);
+	} else if (fdatasync(l->fd) < 0) {
+		say_syserror("%s: fdatasync failed", l->filename);
 		return -1;
 	}
 	return 0;
@@ -1366,11 +1830,26 @@ xlog_write_eof(struct xlog *l)
 int
 xlog_close(struct xlog *l, bool reuse_fd)
 {
+	/* Rows that were never flushed must not get to the file. */
+	if (l->zqueue != NULL && l->zqueue->has_svp)
+		xlog_zqueue_discard(l);
+
 	int rc = xlog_write_eof(l);
 	if (rc < 0)
 		say_error("%s: failed to write EOF marker: %s", l->filename,
 			  diag_last_error(diag_get())->errmsg);
 
+	/*
+	 * Cut off the zeros written by xlog_fallocate() and
+	 * left unused, so that a closed file ends with the
+	 * EOF marker.
+	 */
+	if (l->allocated_size > 0) {
+		off_t size = l->offset + (rc == 0 ? sizeof(eof_marker) : 0);
+		if (ftruncate(l->fd, size) != 0)
+			say_syserror("%s: ftruncate() failed", l->filename);
+	}
+
 	/*
 	 * Sync the file before closing, since
 	 * otherwise we can end up with a partially
@@ -1759,6 +2238,43 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
+/**
+ * Drop the data read ahead past the cursor position so that
+ * it is read from the file again. Used on reaching the zeros
+ * a preallocated file is filled with, since rows may be
+ * written over them later.
+ */
+static void
+xlog_cursor_discard_read_ahead(struct xlog_cursor *i)
+{
+	/* in-memory mode */
+	if (i->fd < 0)
+		return;
+	i->read_offset = xlog_cursor_pos(i);
+	ibuf_reset(&i->rbuf);
+}
+
+/**
+ * Check if a tx at the cursor position of a preallocated file
+ * that failed to decode hasn't been written completely yet or
+ * was torn by a crash, i.e. there are no more tx after it. The
+ * cursor position is kept.
+ *
+ * @retval 1 the tx is the last one in the file
+ * @retval 0 there are tx after it
+ * @retval -1 read error
+ */
+static int
+xlog_cursor_tx_is_last(struct xlog_cursor *i)
+{
+	assert(i->meta.is_preallocated && i->fd >= 0);
+	off_t pos = xlog_cursor_pos(i);
+	int rc = xlog_cursor_find_tx_magic(i);
+	i->read_offset = pos;
+	ibuf_reset(&i->rbuf);
+	return rc;
+}
+
 int
 xlog_cursor_next_tx(struct xlog_cursor *i)
 {
@@ -1771,10 +2287,19 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		return -1;
 	if (rc > 0)
 		return 1;
-	if (load_u32(i->rbuf.rpos) == eof_marker) {
+	log_magic_t magic = load_u32(i->rbuf.rpos);
+	if (magic == eof_marker) {
 		/* eof marker found */
 		goto eof_found;
 	}
+	if (magic == 0 && i->meta.is_preallocated) {
+		/*
+		 * The zeros of a preallocated file: no more
+		 * tx have been written so far.
+		 */
+		xlog_cursor_discard_read_ahead(i);
+		return 1;
+	}
 
 	ssize_t to_load;
 	while ((to_load = xlog_tx_cursor_create(&i->tx_cursor,
@@ -1787,8 +2312,19 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		if (rc > 0)
 			return 1;
 	}
-	if (to_load < 0)
-		return -1;
+	if (to_load < 0) {
+		/*
+		 * In a preallocated file a tx that is being
+		 * written or was torn by a crash is followed by
+		 * zeros rather than the file end. Treat it the
+		 * same way as a tx cut by the file end.
+		 */
+		if (!i->meta.is_preallocated || i->fd < 0 ||
+		    diag_last_error(diag_get())->type != &type_XlogError)
+			return -1;
+		rc = xlog_cursor_tx_is_last(i);
+		return rc != 0 ? rc : -1;
+	}
 
 	i->state = XLOG_CURSOR_TX;
 	return 0;
@@ -1801,6 +2337,21 @@ eof_found:
 
 	if (rc < 0)
 		return -1;
+	if (rc == 0 && i->meta.is_preallocated) {
+		/*
+		 * xlog_close() writes the marker over the zeros
+		 * and only then truncates the file, a reader may
+		 * get in between.
+		 */
+		rc = xlog_cursor_ensure(i, 2 * sizeof(log_magic_t));
+		if (rc < 0)
+			return -1;
+		if (rc == 0 && load_u32(i->rbuf.rpos +
+					sizeof(log_magic_t)) == 0)
+			rc = 1;
+		else
+			rc = 0;
+	}
 	if (rc == 0) {
 		diag_set(XlogError, "%s: has some data after "
 			  "eof marker at %lld", i->name,
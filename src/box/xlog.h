@@ -44,6 +44,7 @@
 
 struct iovec;
 struct xrow_header;
+struct xlog_zqueue;
 
 #if defined(__cplusplus)
 extern "C" {
@@ -96,6 +97,12 @@ struct xdir {
 	 * speed up sync of write ahead logs, but not snapshots).
 	 */
 	bool sync_is_async;
+	/**
+	 * true if big blocks of rows written to a log file in
+	 * this directory can be compressed in the coio thread
+	 * pool, @sa xlog::compress_is_async.
+	 */
+	bool compress_is_async;
 
 	/* Default filename suffix for a new file. */
 	enum log_suffix suffix;
@@ -140,6 +147,11 @@ struct xdir {
 	 * corresponding file cache will be marked as free
 	 */
 	uint64_t sync_interval;
+	/**
+	 * If not 0, a new file in this directory is zero-filled
+	 * up to this size on creation, see xlog_fallocate().
+	 */
+	int64_t prealloc_size;
 };
 
 /**
@@ -246,6 +258,13 @@ struct xlog_meta {
 	 * directory for missing WALs.
 	 */
 	struct vclock prev_vclock;
+	/**
+	 * Text file header: true if the file is zero-filled
+	 * in advance. Rows are written over the zeros, so
+	 * a zero magic marks the end of the data written so
+	 * far rather than corruption.
+	 */
+	bool is_preallocated;
 };
 
 /**
@@ -306,6 +325,11 @@ struct xlog {
 	bool is_autocommit;
 	/** The current offset in the log file, for writing. */
 	off_t offset;
+	/**
+	 * Size the file was zero-filled to with xlog_fallocate(),
+	 * 0 if the file wasn't preallocated.
+	 */
+	off_t allocated_size;
 	/**
 	 * Output buffer, works as row accumulator for
 	 * compression.
@@ -313,6 +337,26 @@ struct xlog {
 	struct obuf obuf;
 	/** The context of zstd compression */
 	ZSTD_CCtx *zctx;
+	/**
+	 * If true, blocks of rows that reach the autocommit
+	 * threshold are compressed in the coio thread pool
+	 * while the caller goes on adding rows. The blocks
+	 * are written to the file in order by xlog_flush(),
+	 * which must be called from a fiber that may yield.
+	 */
+	bool compress_is_async;
+	/** Blocks being compressed in background, or NULL. */
+	struct xlog_zqueue *zqueue;
+	/**
+	 * If true, xlog_flush() makes the data durable with
+	 * fdatasync(). Blocks filled up before the flush are
+	 * deferred until it, as with compress_is_async, so that
+	 * on sync failure everything written since the previous
+	 * flush is truncated from the file.
+	 */
+	bool sync_on_flush;
+	/** Time the last sync done by xlog_flush() took, seconds. */
+	double sync_time;
 	/**
 	 * Compressed output buffer
 	 */
@@ -465,6 +509,20 @@ ssize_t
 xlog_flush(struct xlog *log);
 
 
+/**
+ * Zero-fill a log file opened for writing up to @a size bytes
+ * so that appending rows overwrites blocks that are already
+ * allocated and written and syncing the file does not have to
+ * update the file size or the extent tree. Readers stop at the
+ * zeros, see xlog_meta::is_preallocated. The space left unused
+ * is released by xlog_close().
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_fallocate(struct xlog *log, size_t size);
+
 /**
  * Sync a log file. The exact action is defined
  * by xdir flags.
@@ -103,6 +103,9 @@ error:
 	if (mp_typeof(**pos) != MP_MAP)
 		goto error;
 
+	bool has_tsn = false;
+	uint64_t tsn_diff = 0;
+	uint32_t flags = 0;
 	uint32_t size = mp_decode_map(pos);
 	for (uint32_t i = 0; i < size; i++) {
 		if (mp_typeof(**pos) != MP_UINT)
@@ -130,14 +133,35 @@ error:
 		case IPROTO_TIMESTAMP:
 			header->tm = mp_decode_double(pos);
 			break;
+		case IPROTO_TSN:
+			has_tsn = true;
+			tsn_diff = mp_decode_uint(pos);
+			break;
+		case IPROTO_FLAGS:
+			flags = mp_decode_uint(pos);
+			break;
 		case IPROTO_SCHEMA_VERSION:
 			header->schema_version = mp_decode_uint(pos);
 			break;
+		case IPROTO_STREAM_ID:
+			header->stream_id = mp_decode_uint(pos);
+			break;
 		default:
 			/* unknown header */
 			mp_next(pos);
 		}
 	}
+	/*
+	 * A row without IPROTO_TSN is a single-statement
+	 * transaction, see xrow_header_encode().
+	 */
+	if (has_tsn) {
+		header->tsn = header->lsn - tsn_diff;
+		header->is_commit = (flags & IPROTO_FLAG_COMMIT) != 0;
+	} else {
+		header->tsn = header->lsn;
+		header->is_commit = true;
+	}
 	assert(*pos <= end);
 	if (*pos < end) {
 		const char *body = *pos;
@@ -222,6 +246,27 @@ xrow_header_encode(const struct xrow_header *header, uint64_t sync,
 		d = mp_encode_double(d, header->tm);
 		map_size++;
 	}
+
+	/*
+	 * Transaction boundaries are only encoded for rows of
+	 * multi-statement transactions, so that single-statement
+	 * ones look the same as before.
+	 */
+	if (header->tsn != 0 &&
+	    (header->tsn != header->lsn || !header->is_commit)) {
+		/*
+		 * Encode the offset of the row in the transaction
+		 * rather than the transaction id to save space.
+		 */
+		d = mp_encode_uint(d, IPROTO_TSN);
+		d = mp_encode_uint(d, header->lsn - header->tsn);
+		map_size++;
+		if (header->is_commit) {
+			d = mp_encode_uint(d, IPROTO_FLAGS);
+			d = mp_encode_uint(d, IPROTO_FLAG_COMMIT);
+			map_size++;
+		}
+	}
 	assert(d <= data + XROW_HEADER_LEN_MAX);
 	mp_encode_map(data, map_size);
 	out->iov_len = d - (char *) out->iov_base;
@@ -490,11 +535,19 @@ iproto_reply_map_key(struct obuf *buf, uint32_t size, uint8_t key)
 void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count)
+{
+	iproto_reply_select_ext(buf, svp, sync, schema_version, count, 0);
+}
+
+void
+iproto_reply_select_ext(struct obuf *buf, struct obuf_svp *svp,
+			uint64_t sync, uint32_t schema_version,
+			uint32_t count, size_t ext_size)
 {
 	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
 	iproto_header_encode(pos, IPROTO_OK, sync, schema_version,
 			        obuf_size(buf) - svp->used -
-				IPROTO_HEADER_LEN);
+				IPROTO_HEADER_LEN + ext_size);
 
 	struct iproto_body_bin body = iproto_body_bin;
 	body.v_data_len = mp_bswap_u32(count);
@@ -47,7 +47,7 @@ enum {
 	XROW_HEADER_IOVMAX = 1,
 	XROW_BODY_IOVMAX = 2,
 	XROW_IOVMAX = XROW_HEADER_IOVMAX + XROW_BODY_IOVMAX,
-	XROW_HEADER_LEN_MAX = 40,
+	XROW_HEADER_LEN_MAX = 52,
 	XROW_BODY_LEN_MAX = 128,
 	IPROTO_HEADER_LEN = 28,
 	/** 7 = sizeof(iproto_body_bin). */
@@ -74,9 +74,22 @@ struct xrow_header {
 	uint64_t sync;
 	int64_t lsn; /* LSN must be signed for correct comparison */
 	double tm;
+	/**
+	 * Transaction identifier: LSN of the first row of the
+	 * transaction the row belongs to. 0 if the row hasn't
+	 * been written to WAL yet.
+	 */
+	int64_t tsn;
+	/** True for the last row of a transaction. */
+	bool is_commit;
 
 	int bodycnt;
 	uint32_t schema_version;
+	/**
+	 * Id of the stream the request belongs to, 0 if none.
+	 * Only set in client requests, never written to xlog.
+	 */
+	uint64_t stream_id;
 	struct iovec body[XROW_BODY_IOVMAX];
 };
 
@@ -406,6 +419,16 @@ void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count);
 
+/**
+ * Same as iproto_reply_select(), but the result set includes
+ * @a ext_size bytes which follow the data stored in the buffer
+ * and are sent to the client bypassing the buffer.
+ */
+void
+iproto_reply_select_ext(struct obuf *buf, struct obuf_svp *svp,
+			uint64_t sync, uint32_t schema_version,
+			uint32_t count, size_t ext_size);
+
 /**
  * Write header of the key to a preallocated buffer by svp.
  * @param buf Buffer to write to.
@@ -41,6 +41,8 @@
 #include "assoc.h"
 #include "memory.h"
 #include "trigger.h"
+#include "clock.h"
+#include "say.h"
 
 #include "third_party/valgrind/memcheck.h"
 
@@ -154,6 +156,118 @@ fiber_recycle(struct fiber *fiber);
 static void
 fiber_destroy(struct cord *cord, struct fiber *f);
 
+/** Weight of the last period in clock_stat::average. */
+static const double CLOCK_STAT_EWMA_WEIGHT = 0.25;
+
+/**
+ * Charge the time passed since the previous switch to the
+ * fiber which is about to give up control.
+ */
+static inline void
+cord_clock_account(struct cord *cord, struct fiber *f)
+{
+	uint64_t now = clock_monotonic64();
+	uint64_t delta = now - cord->clock_last;
+	cord->clock_last = now;
+	f->clock_stat.total += delta;
+	f->clock_stat.delta += delta;
+	cord->clock_stat.total += delta;
+	cord->clock_stat.delta += delta;
+	if (cord->slice_warning > 0 && delta > cord->slice_warning &&
+	    f != &cord->sched) {
+		say_warn("fiber %u/%s ran for %.3f sec without yielding",
+			 f->fid, fiber_name(f), delta / 1e9);
+	}
+}
+
+static void
+clock_stat_update(struct clock_stat *stat, uint64_t period)
+{
+	stat->instant = stat->delta * 100.0 / period;
+	stat->average += (stat->instant - stat->average) *
+			 CLOCK_STAT_EWMA_WEIGHT;
+	stat->delta = 0;
+}
+
+static void
+clock_stat_reset(struct clock_stat *stat)
+{
+	memset(stat, 0, sizeof(*stat));
+}
+
+static void
+cord_clock_prepare_cb(struct ev_loop *loop, struct ev_prepare *watcher,
+		      int revents)
+{
+	(void) loop;
+	(void) watcher;
+	(void) revents;
+	struct cord *cord = cord();
+	cord_clock_account(cord, &cord->sched);
+}
+
+static void
+cord_clock_check_cb(struct ev_loop *loop, struct ev_check *watcher,
+		    int revents)
+{
+	(void) loop;
+	(void) watcher;
+	(void) revents;
+	/* Don't charge the time spent sleeping to anyone. */
+	cord()->clock_last = clock_monotonic64();
+}
+
+static void
+cord_clock_timer_cb(struct ev_loop *loop, struct ev_timer *watcher,
+		    int revents)
+{
+	(void) loop;
+	(void) watcher;
+	(void) revents;
+	struct cord *cord = cord();
+	cord_clock_account(cord, &cord->sched);
+	uint64_t period = cord->clock_last - cord->clock_period_start;
+	if (period == 0)
+		return;
+	cord->clock_period_start = cord->clock_last;
+	clock_stat_update(&cord->clock_stat, period);
+	clock_stat_update(&cord->sched.clock_stat, period);
+	struct fiber *fiber;
+	rlist_foreach_entry(fiber, &cord->alive, link)
+		clock_stat_update(&fiber->clock_stat, period);
+}
+
+void
+cord_top_enable(bool enable)
+{
+	struct cord *cord = cord();
+	if (cord->top_is_enabled == enable)
+		return;
+	cord->top_is_enabled = enable;
+	if (!enable) {
+		ev_prepare_stop(cord->loop, &cord->clock_prepare);
+		ev_check_stop(cord->loop, &cord->clock_check);
+		ev_timer_stop(cord->loop, &cord->clock_timer);
+		return;
+	}
+	clock_stat_reset(&cord->clock_stat);
+	clock_stat_reset(&cord->sched.clock_stat);
+	struct fiber *fiber;
+	rlist_foreach_entry(fiber, &cord->alive, link)
+		clock_stat_reset(&fiber->clock_stat);
+	cord->clock_last = clock_monotonic64();
+	cord->clock_period_start = cord->clock_last;
+	ev_prepare_start(cord->loop, &cord->clock_prepare);
+	ev_check_start(cord->loop, &cord->clock_check);
+	ev_timer_start(cord->loop, &cord->clock_timer);
+}
+
+void
+cord_set_slice_warning(double timeout)
+{
+	cord()->slice_warning = timeout * 1e9;
+}
+
 /**
  * Transfer control to callee fiber.
  */
@@ -176,6 +290,8 @@ fiber_call_impl(struct fiber *callee)
 	assert(caller);
 	assert(caller != callee);
 
+	if (cord->top_is_enabled)
+		cord_clock_account(cord, caller);
 	cord->fiber = callee;
 
 	callee->flags &= ~FIBER_IS_READY;
@@ -424,6 +540,8 @@ fiber_yield(void)
 
 	assert(callee->flags & FIBER_IS_READY || callee == &cord->sched);
 	assert(! (callee->flags & FIBER_IS_DEAD));
+	if (cord->top_is_enabled)
+		cord_clock_account(cord, caller);
 	cord->fiber = callee;
 	callee->csw++;
 	callee->flags &= ~FIBER_IS_READY;
@@ -806,6 +924,7 @@ fiber_new_ex(const char *name, const struct fiber_attr *fiber_attr,
 	}
 
 	fiber->f = f;
+	clock_stat_reset(&fiber->clock_stat);
 	/* fids from 0 to 100 are reserved */
 	if (++cord->max_fid < 100)
 		cord->max_fid = 101;
@@ -903,6 +1022,14 @@ cord_create(struct cord *cord, const char *name)
 	ev_async_init(&cord->wakeup_event, fiber_schedule_wakeup);
 
 	ev_idle_init(&cord->idle_event, fiber_schedule_idle);
+
+	cord->top_is_enabled = false;
+	cord->slice_warning = 0;
+	clock_stat_reset(&cord->clock_stat);
+	clock_stat_reset(&cord->sched.clock_stat);
+	ev_prepare_init(&cord->clock_prepare, cord_clock_prepare_cb);
+	ev_check_init(&cord->clock_check, cord_clock_check_cb);
+	ev_timer_init(&cord->clock_timer, cord_clock_timer_cb, 1, 1);
 	cord_set_name(name);
 
 #if ENABLE_ASAN
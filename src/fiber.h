@@ -342,6 +342,21 @@ struct credentials;
 struct lua_State;
 struct ipc_wait_pad;
 
+/**
+ * Time spent running by a fiber or a whole cord. Collected
+ * only while CPU accounting is enabled, see cord_top_enable().
+ */
+struct clock_stat {
+	/** Total time, in nanoseconds. */
+	uint64_t total;
+	/** Time accumulated in the current period. */
+	uint64_t delta;
+	/** Share of the last period, in percent. */
+	double instant;
+	/** Moving average of the share, in percent. */
+	double average;
+};
+
 struct fiber {
 	coro_context ctx;
 	/** Coro stack slab. */
@@ -361,6 +376,8 @@ struct fiber {
 	struct fiber *caller;
 	/** Number of context switches. */
 	int csw;
+	/** CPU time consumed by the fiber. */
+	struct clock_stat clock_stat;
 	/** Fiber id. */
 	uint32_t fid;
 	/** Fiber flags */
@@ -473,6 +490,28 @@ struct cord {
 	struct slab_cache slabc;
 	/** The "main" fiber of this cord, the scheduler. */
 	struct fiber sched;
+	/** Set if fibers' CPU time is being accounted. */
+	bool top_is_enabled;
+	/** Time of the last fiber switch, nanoseconds. */
+	uint64_t clock_last;
+	/** Start of the current accounting period. */
+	uint64_t clock_period_start;
+	/**
+	 * Time spent running fibers, which excludes the time
+	 * the event loop sleeps waiting for events.
+	 */
+	struct clock_stat clock_stat;
+	/**
+	 * Log a warning if a fiber runs longer than this without
+	 * yielding, in nanoseconds. 0 disables the warning.
+	 */
+	uint64_t slice_warning;
+	/** Accounts the scheduler time before the loop sleeps. */
+	ev_prepare clock_prepare;
+	/** Restarts the clock when the loop wakes up. */
+	ev_check clock_check;
+	/** Closes an accounting period every second. */
+	ev_timer clock_timer;
 	char name[FIBER_NAME_MAX];
 };
 
@@ -544,6 +583,23 @@ cord_join(struct cord *cord);
 void
 cord_set_name(const char *name);
 
+/**
+ * Enable or disable accounting of the time consumed by each
+ * fiber of the current cord. Switching it on resets the
+ * collected statistics. The shares in struct clock_stat are
+ * updated once a second.
+ */
+void
+cord_top_enable(bool enable);
+
+/**
+ * Warn if a fiber of the current cord runs longer than
+ * @a timeout seconds without yielding. Takes effect only while
+ * the accounting is enabled. 0 disables the warning.
+ */
+void
+cord_set_slice_warning(double timeout);
+
 static inline const char *
 cord_name(struct cord *cord)
 {
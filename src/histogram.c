@@ -131,15 +131,28 @@ histogram_discard(struct histogram *hist, int64_t val)
 	hist->total--;
 }
 
+void
+histogram_merge(struct histogram *dst, const struct histogram *src)
+{
+	assert(dst->n_buckets == src->n_buckets);
+	for (size_t i = 0; i < dst->n_buckets; i++) {
+		assert(dst->buckets[i].max == src->buckets[i].max);
+		dst->buckets[i].count += src->buckets[i].count;
+	}
+	dst->total += src->total;
+	if (dst->max < src->max)
+		dst->max = src->max;
+}
+
 int64_t
-histogram_percentile(struct histogram *hist, int pct)
+histogram_percentile(struct histogram *hist, double pct)
 {
 	size_t count = 0;
 
 	for (size_t i = 0; i < hist->n_buckets; i++) {
 		struct histogram_bucket *bucket = &hist->buckets[i];
 		count += bucket->count;
-		if (count * 100 > hist->total * pct)
+		if (count * 100.0 > hist->total * pct)
 			return bucket->max;
 	}
 	return hist->max;
@@ -70,11 +70,17 @@ latency_reset(struct latency *latency);
 void
 latency_collect(struct latency *latency, double value);
 
+/**
+ * Add observations collected by @src to @dst.
+ */
+void
+latency_merge(struct latency *dst, const struct latency *src);
+
 /**
  * Get accumulated latency value, in seconds.
  * Returns @pct-th percentile of all observations.
  */
 double
-latency_get(struct latency *latency, int pct);
+latency_get(struct latency *latency, double pct);
 
 #endif /* TARANTOOL_LATENCY_H_INCLUDED */
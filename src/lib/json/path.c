@@ -30,8 +30,10 @@
  */
 
 #include "path.h"
+#include <assert.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <string.h>
 #include <unicode/uchar.h>
 #include <unicode/utf8.h>
 #include "trivia/util.h"
@@ -217,10 +219,15 @@ json_path_next(struct json_path_parser *parser, struct json_path_node *node)
 		if (parser->offset == parser->src_len)
 			return parser->symbol_count;
 		c = json_current_char(parser);
-		if (c == '"' || c == '\'')
+		if (c == '"' || c == '\'') {
 			rc = json_parse_string(parser, node, c);
-		else
+		} else if (c == '*') {
+			json_skip_char(parser);
+			node->type = JSON_PATH_ANY;
+			rc = 0;
+		} else {
 			rc = json_parse_integer(parser, node);
+		}
 		if (rc != 0)
 			return rc;
 		/*
@@ -242,3 +249,107 @@ json_path_next(struct json_path_parser *parser, struct json_path_node *node)
 		return json_parse_identifier(parser, node);
 	}
 }
+
+int
+json_path_validate(const char *path, int path_len)
+{
+	if (path_len == 0)
+		return 1;
+	struct json_path_parser parser;
+	struct json_path_node node;
+	json_path_parser_create(&parser, path, path_len);
+	int rc;
+	do {
+		rc = json_path_next(&parser, &node);
+	} while (rc == 0 && node.type != JSON_PATH_END);
+	return rc;
+}
+
+/**
+ * Compare two path nodes. A path is greater than its prefix,
+ * numbers go before strings.
+ */
+static inline int
+json_path_node_cmp(const struct json_path_node *a,
+		   const struct json_path_node *b)
+{
+	if (a->type == JSON_PATH_END || b->type == JSON_PATH_END)
+		return (a->type != JSON_PATH_END) - (b->type != JSON_PATH_END);
+	if (a->type != b->type)
+		return a->type < b->type ? -1 : 1;
+	if (a->type == JSON_PATH_NUM)
+		return a->num < b->num ? -1 : a->num > b->num;
+	if (a->type == JSON_PATH_STR) {
+		if (a->len != b->len)
+			return a->len < b->len ? -1 : 1;
+		return memcmp(a->str, b->str, a->len);
+	}
+	return 0;
+}
+
+int
+json_path_cmp(const char *a, int a_len, const char *b, int b_len)
+{
+	struct json_path_parser parser_a, parser_b;
+	struct json_path_node node_a, node_b;
+	json_path_parser_create(&parser_a, a, a_len);
+	json_path_parser_create(&parser_b, b, b_len);
+	while (true) {
+		int rc_a = json_path_next(&parser_a, &node_a);
+		int rc_b = json_path_next(&parser_b, &node_b);
+		/* Paths are validated before comparison. */
+		assert(rc_a == 0 && rc_b == 0);
+		(void) rc_a;
+		(void) rc_b;
+		int rc = json_path_node_cmp(&node_a, &node_b);
+		if (rc != 0 || node_a.type == JSON_PATH_END)
+			return rc;
+	}
+}
+
+uint32_t
+json_path_hash(const char *path, int path_len)
+{
+	struct json_path_parser parser;
+	struct json_path_node node;
+	json_path_parser_create(&parser, path, path_len);
+	/* FNV-1a over the parsed nodes. */
+	uint32_t h = 2166136261U;
+	while (true) {
+		int rc = json_path_next(&parser, &node);
+		/* Paths are validated before hashing. */
+		assert(rc == 0);
+		(void) rc;
+		if (node.type == JSON_PATH_END)
+			return h;
+		h = (h ^ node.type) * 16777619U;
+		if (node.type == JSON_PATH_ANY) {
+			continue;
+		} else if (node.type == JSON_PATH_NUM) {
+			for (int i = 0; i < 8; i++)
+				h = (h ^ ((node.num >> (i * 8)) & 0xff)) *
+				    16777619U;
+		} else {
+			for (int i = 0; i < node.len; i++)
+				h = (h ^ (uint8_t) node.str[i]) * 16777619U;
+		}
+	}
+}
+
+int
+json_path_multikey_offset(const char *path, int path_len)
+{
+	struct json_path_parser parser;
+	struct json_path_node node;
+	json_path_parser_create(&parser, path, path_len);
+	while (true) {
+		int offset = parser.offset;
+		int rc = json_path_next(&parser, &node);
+		assert(rc == 0);
+		(void) rc;
+		if (node.type == JSON_PATH_END)
+			return -1;
+		if (node.type == JSON_PATH_ANY)
+			return offset;
+	}
+}
@@ -38,7 +38,8 @@ extern "C" {
 
 /**
  * Parser for JSON paths:
- * <field>, <.field>, <[123]>, <['field']> and their combinations.
+ * <field>, <.field>, <[123]>, <['field']>, <[*]> and their
+ * combinations.
  */
 struct json_path_parser {
 	/** Source string. */
@@ -54,6 +55,8 @@ struct json_path_parser {
 enum json_path_type {
 	JSON_PATH_NUM,
 	JSON_PATH_STR,
+	/** Any array item, [*]. */
+	JSON_PATH_ANY,
 	/** Parser reached end of path. */
 	JSON_PATH_END,
 };
@@ -61,7 +64,7 @@ enum json_path_type {
 /**
  * Element of a JSON path. It can be either string or number.
  * String idenfiers are in ["..."] and between dots. Numbers are
- * indexes in [...].
+ * indexes in [...]. [*] stands for any item of an array.
  */
 struct json_path_node {
 	enum json_path_type type;
@@ -105,6 +108,53 @@ json_path_parser_create(struct json_path_parser *parser, const char *src,
 int
 json_path_next(struct json_path_parser *parser, struct json_path_node *node);
 
+/**
+ * Check that a path is syntactically correct and not empty.
+ * @param path Path to check.
+ * @param path_len Length of @a path.
+ * @retval   0 Success.
+ * @retval > 0 Position of a syntax error, the same as returned
+ *             by json_path_next(). An empty path is reported
+ *             as an error on position 1.
+ */
+int
+json_path_validate(const char *path, int path_len);
+
+/**
+ * Compare two JSON paths node by node, so that different
+ * spellings of the same path, for example 'a.b' and
+ * '["a"]["b"]', are equal. Both paths must be valid.
+ * @param a Left path.
+ * @param a_len Length of @a a.
+ * @param b Right path.
+ * @param b_len Length of @a b.
+ * @retval 0 if the paths are equal.
+ * @retval <0 or >0 if they are not, which gives a stable
+ *         order of paths.
+ */
+int
+json_path_cmp(const char *a, int a_len, const char *b, int b_len);
+
+/**
+ * Calculate a hash of a JSON path. Different spellings of
+ * the same path have the same hash, @sa json_path_cmp().
+ * @param path Valid path.
+ * @param path_len Length of @a path.
+ * @retval Hash value.
+ */
+uint32_t
+json_path_hash(const char *path, int path_len);
+
+/**
+ * Find the first [*] node of a JSON path.
+ * @param path Valid path.
+ * @param path_len Length of @a path.
+ * @retval Offset of '[' of the first [*] node, or -1 if the
+ *         path has no [*] nodes.
+ */
+int
+json_path_multikey_offset(const char *path, int path_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -163,6 +163,12 @@
  * bool bps_tree_iterator_prev(tree, itr);
  * void bps_tree_iterator_freeze(tree, itr);
  * void bps_tree_iterator_destroy(tree, itr);
+ * // positional access, only if BPS_INNER_CARD is defined:
+ * struct bps_tree_iterator bps_tree_iterator_at(tree, offset);
+ * struct bps_tree_iterator bps_tree_lower_bound_get_offset(tree, key, exact,
+ *							     offset);
+ * struct bps_tree_iterator bps_tree_upper_bound_get_offset(tree, key, exact,
+ *							     offset);
  */
 /* }}} */
 
@@ -283,6 +289,28 @@
  * #define BPS_BLOCK_LINEAR_SEARCH
  */
 
+/**
+ * Function to check if two elements are the same element, not
+ * just equal in terms of BPS_TREE_COMPARE. Used only by debug
+ * checks. Must be defined if bps_tree_elem_t is a structure.
+ * Examples:
+ * #define BPS_TREE_IDENTICAL(a, b) ((a).ptr == (b).ptr)
+ */
+#ifndef BPS_TREE_IDENTICAL
+#define BPS_TREE_IDENTICAL(a, b) ((a) == (b))
+#endif
+
+/**
+ * A switch that makes inner blocks store the number of elements
+ * in each child subtree (child cardinality). It allows to find
+ * an element by its ordinal position and the position of a key
+ * in logarithmic time, see bps_tree_iterator_at() and
+ * bps_tree_lower_bound_get_offset(), at the cost of a smaller
+ * branching factor and a bit more work on each modification.
+ * To turn it on,
+ * #define BPS_INNER_CARD
+ */
+
 /**
  * A switch that enables collection of executions of different
  * branches of code. Used only for debug purposes, I hope you
@@ -370,6 +398,9 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_iterator_prev _api_name(iterator_prev)
 #define bps_tree_iterator_freeze _api_name(iterator_freeze)
 #define bps_tree_iterator_destroy _api_name(iterator_destroy)
+#define bps_tree_iterator_at _api_name(iterator_at)
+#define bps_tree_lower_bound_get_offset _api_name(lower_bound_get_offset)
+#define bps_tree_upper_bound_get_offset _api_name(upper_bound_get_offset)
 #define bps_tree_debug_check _api_name(debug_check)
 #define bps_tree_print _api_name(print)
 #define bps_tree_debug_check_internal_functions \
@@ -404,6 +435,10 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_collect_path _bps_tree(collect_path)
 #define bps_tree_touch_leaf_path_max_elem _bps_tree(touch_leaf_path_max_elem)
 #define bps_tree_touch_path _bps_tree(touch_path_max_elem)
+#define bps_tree_child_card _bps_tree(child_card)
+#define bps_tree_inner_card_sum _bps_tree(inner_card_sum)
+#define bps_tree_card_move _bps_tree(card_move)
+#define bps_tree_path_add_card _bps_tree(path_add_card)
 #define bps_tree_process_replace _bps_tree(process_replace)
 #define bps_tree_debug_memmove _bps_tree(debug_memmove)
 #define bps_tree_insert_into_leaf _bps_tree(insert_into_leaf)
@@ -834,6 +869,42 @@ bps_tree_iterator_freeze(struct bps_tree *tree, struct bps_tree_iterator *itr);
 static inline void
 bps_tree_iterator_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr);
 
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Get an iterator to the element at the given position.
+ *  Works in O(log(N)).
+ * @param tree - pointer to a tree
+ * @param offset - ordinal number of the element, starting from 0
+ * @return - Iterator to the element. Invalid if offset >= tree size.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset);
+
+/**
+ * @brief Same as bps_tree_lower_bound, but also calculates the
+ *  position of the found element in O(log(N)).
+ * @param offset - pointer to the position of the element
+ *  pointed by the resulting iterator, set to the tree size if
+ *  the iterator is invalid. Pass NULL if you don't need it.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also calculates the
+ *  position of the found element in O(log(N)).
+ * @param offset - pointer to the position of the element
+ *  pointed by the resulting iterator, set to the tree size if
+ *  the iterator is invalid. Pass NULL if you don't need it.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+#endif /* BPS_INNER_CARD */
+
 #ifndef BPS_TREE_NO_DEBUG
 
 /**
@@ -884,6 +955,22 @@ bps_tree_debug_check_internal_functions(bool assertme);
 /* Same as BPS_TREE_MEMMOVE but takes count of values instead of memory size */
 #define BPS_TREE_DATAMOVE(dst, src, num, dst_bck, src_bck) \
 	BPS_TREE_MEMMOVE(dst, src, (num) * sizeof((dst)[0]), dst_bck, src_bck)
+#ifdef BPS_INNER_CARD
+/* Move child cardinalities along with corresponding child IDs */
+#define BPS_TREE_CARDMOVE(dst_bck, dst_pos, src_bck, src_pos, num) do {	\
+	assert((dst_pos) >= 0 && (src_pos) >= 0);			\
+	assert((dst_pos) + (num) <= BPS_TREE_MAX_COUNT_IN_INNER);	\
+	assert((src_pos) + (num) <= BPS_TREE_MAX_COUNT_IN_INNER);	\
+	memmove((dst_bck)->child_cards + (dst_pos),			\
+		(src_bck)->child_cards + (src_pos),			\
+		(num) * sizeof(size_t));				\
+} while (0)
+/* Set cardinality of a child along with the child ID */
+#define BPS_TREE_CARDSET(bck, pos, card) ((bck)->child_cards[pos] = (card))
+#else
+#define BPS_TREE_CARDMOVE(dst_bck, dst_pos, src_bck, src_pos, num) ((void)0)
+#define BPS_TREE_CARDSET(bck, pos, card) ((void)(card))
+#endif
 
 /**
  * Types of a block
@@ -912,9 +999,18 @@ enum bps_tree_max_sizes {
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block)
 		 - 2 * sizeof(bps_tree_block_id_t) )
 		/ sizeof(bps_tree_elem_t),
+#ifdef BPS_INNER_CARD
+	/* Reserve space for alignment of the child_cards array. */
+	BPS_TREE_MAX_COUNT_IN_INNER =
+		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block)
+		 - 2 * sizeof(size_t))
+		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)
+		   + sizeof(size_t)),
+#else
 	BPS_TREE_MAX_COUNT_IN_INNER =
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block))
 		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)),
+#endif
 	BPS_TREE_MAX_DEPTH = 16
 };
 
@@ -960,6 +1056,10 @@ struct bps_inner {
 	bps_tree_elem_t elems[BPS_TREE_MAX_COUNT_IN_INNER - 1];
 	/* Corresponding child IDs */
 	bps_tree_block_id_t child_ids[BPS_TREE_MAX_COUNT_IN_INNER];
+#ifdef BPS_INNER_CARD
+	/* Number of elements in the corresponding child subtrees */
+	size_t child_cards[BPS_TREE_MAX_COUNT_IN_INNER];
+#endif
 };
 
 /**
@@ -1009,6 +1109,12 @@ struct bps_inner_path_elem {
 	bps_tree_block_id_t max_elem_block_id;
 	/* Holder of max_elem_copy (pos) */
 	bps_tree_pos_t max_elem_pos;
+	/*
+	 * Pointer to the cardinality of the subtree in the parent
+	 * block. NULL for root and if cardinalities are not
+	 * maintained (see BPS_INNER_CARD).
+	 */
+	size_t *card;
 };
 
 /**
@@ -1033,6 +1139,12 @@ struct bps_leaf_path_elem {
 	bps_tree_block_id_t max_elem_block_id;
 	/* Holder of max_elem_copy (pos) */
 	bps_tree_pos_t max_elem_pos;
+	/*
+	 * Pointer to the cardinality of the subtree in the parent
+	 * block. NULL for root and if cardinalities are not
+	 * maintained (see BPS_INNER_CARD).
+	 */
+	size_t *card;
 };
 
 /**
@@ -1170,6 +1282,8 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 			parents[i]->child_ids[parents[i]->header.size] =
 				insert_id;
+			BPS_TREE_CARDSET(parents[i], parents[i]->header.size,
+					 0);
 			if (new_id == (bps_tree_block_id_t)-1)
 				break;
 			if (i == depth - 2) {
@@ -1179,6 +1293,12 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 		}
 
+#ifdef BPS_INNER_CARD
+		for (bps_tree_block_id_t i = 0; i < depth - 1; i++)
+			parents[i]->child_cards[parents[i]->header.size] +=
+				leaf->header.size;
+#endif
+
 		bps_tree_elem_t insert_value = current[leaf->header.size - 1];
 		for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
 			parents[i]->header.size++;
@@ -2054,6 +2174,162 @@ bps_tree_iterator_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr)
 	matras_destroy_read_view(&tree->matras, &itr->view);
 }
 
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Get an iterator to the element at the given position.
+ *  Works in O(log(N)).
+ * @param tree - pointer to a tree
+ * @param offset - ordinal number of the element, starting from 0
+ * @return - Iterator to the element. Invalid if offset >= tree size.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	if (offset >= tree->size) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos = 0;
+		while (offset >= inner->child_cards[pos]) {
+			offset -= inner->child_cards[pos];
+			pos++;
+			assert(pos < inner->header.size);
+		}
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+	assert(offset < (size_t)block->size);
+	res.block_id = block_id;
+	res.pos = (bps_tree_pos_t)offset;
+	return res;
+}
+
+/**
+ * @brief Same as bps_tree_lower_bound, but also calculates the
+ *  position of the found element in O(log(N)).
+ * @param offset - pointer to the position of the element
+ *  pointed by the resulting iterator, set to the tree size if
+ *  the iterator is invalid. Pass NULL if you don't need it.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	size_t local_offset;
+	if (!offset)
+		offset = &local_offset;
+	*offset = 0;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, exact);
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_ins_point_key(tree, leaf->elems, leaf->header.size,
+					  key, exact);
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also calculates the
+ *  position of the found element in O(log(N)).
+ * @param offset - pointer to the position of the element
+ *  pointed by the resulting iterator, set to the tree size if
+ *  the iterator is invalid. Pass NULL if you don't need it.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	size_t local_offset;
+	if (!offset)
+		offset = &local_offset;
+	*offset = 0;
+	bool exact_test;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact_test);
+		if (exact_test)
+			*exact = true;
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						leaf->header.size,
+						key, &exact_test);
+	if (exact_test)
+		*exact = true;
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+#endif /* BPS_INNER_CARD */
+
 /**
  * @brief Find the first element that is equal to the key (comparator returns 0)
  * @param tree - pointer to a tree
@@ -2259,6 +2535,7 @@ bps_tree_collect_path(struct bps_tree *tree, bps_tree_elem_t new_elem,
 		path[i].max_elem_copy = max_elem_copy;
 		path[i].max_elem_block_id = max_elem_block_id;
 		path[i].max_elem_pos = max_elem_pos;
+		path[i].card = NULL;
 
 		if (pos < inner->header.size - 1) {
 			max_elem_copy = inner->elems + pos;
@@ -2288,6 +2565,7 @@ bps_tree_collect_path(struct bps_tree *tree, bps_tree_elem_t new_elem,
 	leaf_path_elem->max_elem_copy = max_elem_copy;
 	leaf_path_elem->max_elem_block_id = max_elem_block_id;
 	leaf_path_elem->max_elem_pos = max_elem_pos;
+	leaf_path_elem->card = NULL;
 }
 
 /**
@@ -2325,6 +2603,86 @@ bps_tree_touch_path(struct bps_tree *tree,
 	}
 }
 
+/**
+ * @brief Get a pointer to the cardinality of a child of an inner
+ * block. NULL if there's no parent or cardinalities are not
+ * maintained.
+ */
+static inline size_t *
+bps_tree_child_card(struct bps_inner_path_elem *parent, bps_tree_pos_t pos)
+{
+#ifdef BPS_INNER_CARD
+	if (parent != NULL)
+		return parent->block->child_cards + pos;
+#endif
+	(void)parent;
+	(void)pos;
+	return NULL;
+}
+
+/**
+ * @brief Get the total cardinality of a range of children of an
+ * inner block. 0 if cardinalities are not maintained.
+ */
+static inline size_t
+bps_tree_inner_card_sum(struct bps_inner *inner, bps_tree_pos_t pos,
+			bps_tree_pos_t num)
+{
+	size_t sum = 0;
+#ifdef BPS_INNER_CARD
+	for (bps_tree_pos_t i = pos; i < pos + num; i++)
+		sum += inner->child_cards[i];
+#else
+	(void)inner;
+	(void)pos;
+	(void)num;
+#endif
+	return sum;
+}
+
+/**
+ * @brief Account a number of elements moved from one subtree to
+ * another subtree of the same parent.
+ */
+static inline void
+bps_tree_card_move(size_t *from, size_t *to, size_t num)
+{
+	if (from != NULL)
+		*from -= num;
+	if (to != NULL)
+		*to += num;
+}
+
+/**
+ * @brief Touch inner blocks of the path, add delta to cardinalities
+ * of all subtrees on the path and set card pointers of the path.
+ * Called before insertion (delta = 1) or deletion (delta = -1) of
+ * an element, so that afterwards only elements moved between
+ * neighbour blocks must be accounted.
+ */
+static inline void
+bps_tree_path_add_card(struct bps_tree *tree,
+		       struct bps_leaf_path_elem *leaf_path_elem, int delta)
+{
+#ifdef BPS_INNER_CARD
+	struct bps_inner_path_elem *path;
+	for (path = leaf_path_elem->parent; path; path = path->parent) {
+		path->block = (struct bps_inner *)
+			bps_tree_touch_block(tree, path->block_id);
+		path->block->child_cards[path->insertion_point] += delta;
+	}
+	leaf_path_elem->card = bps_tree_child_card(leaf_path_elem->parent,
+						   leaf_path_elem->pos_in_parent);
+	for (path = leaf_path_elem->parent; path; path = path->parent)
+		path->card = bps_tree_child_card(path->parent,
+						 path->pos_in_parent);
+#else
+	(void)tree;
+	(void)leaf_path_elem;
+	(void)delta;
+#endif
+}
+
 /**
  * @brief Replace element by it's path and fill the *replaced argument
  */
@@ -2480,12 +2838,13 @@ bps_tree_insert_into_leaf(struct bps_tree *tree,
 
 /**
  * @breif Insert a child into inner block. There must be enough space.
+ * card is the number of elements in the subtree of the child.
  */
 static inline void
 bps_tree_insert_into_inner(struct bps_tree *tree,
 			   struct bps_inner_path_elem *inner_path_elem,
 			   bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-			   bps_tree_elem_t max_elem)
+			   bps_tree_elem_t max_elem, size_t card)
 {
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1)
@@ -2504,12 +2863,15 @@ bps_tree_insert_into_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->child_ids + pos + 1,
 				  inner->child_ids + pos,
 				  inner->header.size - pos, inner, inner);
+		BPS_TREE_CARDMOVE(inner, pos + 1, inner, pos,
+				  inner->header.size - pos);
 	} else {
 		if (pos > 0)
 			inner->elems[pos - 1] = *inner_path_elem->max_elem_copy;
 		*inner_path_elem->max_elem_copy = max_elem;
 	}
 	inner->child_ids[pos] = block_id;
+	BPS_TREE_CARDSET(inner, pos, card);
 
 	inner->header.size++;
 }
@@ -2568,6 +2930,8 @@ bps_tree_delete_from_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->child_ids + pos,
 				  inner->child_ids + pos + 1,
 				  inner->header.size - 1 - pos, inner, inner);
+		BPS_TREE_CARDMOVE(inner, pos, inner, pos + 1,
+				  inner->header.size - 1 - pos);
 	} else if (pos > 0) {
 		*inner_path_elem->max_elem_copy = inner->elems[pos - 1];
 	}
@@ -2602,6 +2966,8 @@ bps_tree_move_elems_to_right_leaf(struct bps_tree *tree,
 	BPS_TREE_DATAMOVE(b->elems + num, b->elems, b->header.size, b, b);
 	BPS_TREE_DATAMOVE(b->elems, a->elems + a->header.size - num, num,
 			  b, a);
+	bps_tree_card_move(a_leaf_path_elem->card, b_leaf_path_elem->card,
+			   num);
 
 	a->header.size -= num;
 	b->header.size += num;
@@ -2641,6 +3007,10 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 			  b->header.size, b, b);
 	BPS_TREE_DATAMOVE(b->child_ids, a->child_ids + a->header.size - num,
 			  num, b, a);
+	BPS_TREE_CARDMOVE(b, num, b, 0, b->header.size);
+	BPS_TREE_CARDMOVE(b, 0, a, a->header.size - num, num);
+	bps_tree_card_move(a_inner_path_elem->card, b_inner_path_elem->card,
+			   bps_tree_inner_card_sum(b, 0, num));
 
 	if (!move_to_empty)
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
@@ -2686,6 +3056,8 @@ bps_tree_move_elems_to_left_leaf(struct bps_tree *tree,
 	BPS_TREE_DATAMOVE(a->elems + a->header.size, b->elems, num, a, b);
 	BPS_TREE_DATAMOVE(b->elems, b->elems + num, b->header.size - num,
 			  b, b);
+	bps_tree_card_move(b_leaf_path_elem->card, a_leaf_path_elem->card,
+			   num);
 
 	a->header.size += num;
 	b->header.size -= num;
@@ -2721,6 +3093,10 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 			  num, a, b);
 	BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
 			  b->header.size - num, b, b);
+	BPS_TREE_CARDMOVE(a, a->header.size, b, 0, num);
+	BPS_TREE_CARDMOVE(b, 0, b, num, b->header.size - num);
+	bps_tree_card_move(b_inner_path_elem->card, a_inner_path_elem->card,
+			   bps_tree_inner_card_sum(a, a->header.size, num));
 
 	if (!move_to_empty)
 		a->elems[a->header.size - 1] =
@@ -2798,6 +3174,8 @@ bps_tree_insert_and_move_elems_to_right_leaf(struct bps_tree *tree,
 
 	a->header.size -= (num - 1);
 	b->header.size += num;
+	bps_tree_card_move(a_leaf_path_elem->card, b_leaf_path_elem->card,
+			   num);
 	if (!move_all)
 		*a_leaf_path_elem->max_elem_copy =
 			a->elems[a->header.size - 1];
@@ -2820,7 +3198,7 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		struct bps_inner_path_elem *a_inner_path_elem,
 		struct bps_inner_path_elem *b_inner_path_elem,
 		bps_tree_pos_t num, bps_tree_block_id_t block_id,
-		bps_tree_pos_t pos, bps_tree_elem_t max_elem)
+		bps_tree_pos_t pos, bps_tree_elem_t max_elem, size_t card)
 {
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1) {
@@ -2843,6 +3221,7 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	if (!move_to_empty) {
 		BPS_TREE_DATAMOVE(b->child_ids + num, b->child_ids,
 				  b->header.size, b, b);
+		BPS_TREE_CARDMOVE(b, num, b, 0, b->header.size);
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
 				  b->header.size - 1, b, b);
 	}
@@ -2853,9 +3232,12 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(b->child_ids,
 				  a->child_ids + a->header.size - num,
 				  num, b, a);
+		BPS_TREE_CARDMOVE(b, 0, a, a->header.size - num, num);
 		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
 				  mid_part_size - num, a, a);
+		BPS_TREE_CARDMOVE(a, pos + 1, a, pos, mid_part_size - num);
 		a->child_ids[pos] = block_id;
+		BPS_TREE_CARDSET(a, pos, card);
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + a->header.size - num,
 				  num - 1, b, a);
@@ -2875,9 +3257,12 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(b->child_ids,
 				  a->child_ids + a->header.size - num,
 				  num, b, a);
+		BPS_TREE_CARDMOVE(b, 0, a, a->header.size - num, num);
 		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
 				  mid_part_size - num, a, a);
+		BPS_TREE_CARDMOVE(a, pos + 1, a, pos, mid_part_size - num);
 		a->child_ids[pos] = block_id;
+		BPS_TREE_CARDSET(a, pos, card);
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + a->header.size - num,
 				  num - 1, b, a);
@@ -2894,9 +3279,12 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(b->child_ids,
 				  a->child_ids + a->header.size - num + 1,
 				  new_pos, b, a);
+		BPS_TREE_CARDMOVE(b, 0, a, a->header.size - num + 1, new_pos);
 		b->child_ids[new_pos] = block_id;
+		BPS_TREE_CARDSET(b, new_pos, card);
 		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
 				  a->child_ids + pos, mid_part_size, b, a);
+		BPS_TREE_CARDMOVE(b, new_pos + 1, a, pos, mid_part_size);
 
 		if (pos == a->header.size) {
 			/* +1 */
@@ -2941,6 +3329,8 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= (num - 1);
 	b->header.size += num;
+	bps_tree_card_move(a_inner_path_elem->card, b_inner_path_elem->card,
+			   bps_tree_inner_card_sum(b, 0, num));
 }
 
 /**
@@ -3003,6 +3393,8 @@ bps_tree_insert_and_move_elems_to_left_leaf(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= (num - 1);
+	bps_tree_card_move(b_leaf_path_elem->card, a_leaf_path_elem->card,
+			   num);
 	*a_leaf_path_elem->max_elem_copy = a->elems[a->header.size - 1];
 	if (!move_all)
 		*b_leaf_path_elem->max_elem_copy =
@@ -3023,7 +3415,7 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 		struct bps_inner_path_elem *a_inner_path_elem,
 		struct bps_inner_path_elem *b_inner_path_elem, bps_tree_pos_t num,
 		bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-		bps_tree_elem_t max_elem)
+		bps_tree_elem_t max_elem, size_t card)
 {
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1) {
@@ -3048,12 +3440,16 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 		bps_tree_pos_t new_pos = pos - num; /* Can be 0 */
 		BPS_TREE_DATAMOVE(a->child_ids + a->header.size, b->child_ids,
 				  num, a, b);
+		BPS_TREE_CARDMOVE(a, a->header.size, b, 0, num);
 		BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
 				  new_pos, b, b);
+		BPS_TREE_CARDMOVE(b, 0, b, num, new_pos);
 		b->child_ids[new_pos] = block_id;
+		BPS_TREE_CARDSET(b, new_pos, card);
 		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
 				  b->child_ids + pos,
 				  b->header.size - pos, b, b);
+		BPS_TREE_CARDMOVE(b, new_pos + 1, b, pos, b->header.size - pos);
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3089,12 +3485,18 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 		bps_tree_pos_t new_pos = a->header.size + pos; /* Can be 0 */
 		BPS_TREE_DATAMOVE(a->child_ids + a->header.size,
 				  b->child_ids, pos, a, b);
+		BPS_TREE_CARDMOVE(a, a->header.size, b, 0, pos);
 		a->child_ids[new_pos] = block_id;
+		BPS_TREE_CARDSET(a, new_pos, card);
 		BPS_TREE_DATAMOVE(a->child_ids + new_pos + 1,
 				  b->child_ids + pos, num - 1 - pos, a, b);
-		if (!move_all)
+		BPS_TREE_CARDMOVE(a, new_pos + 1, b, pos, num - 1 - pos);
+		if (!move_all) {
 			BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num - 1,
 					  b->header.size - num + 1, b, b);
+			BPS_TREE_CARDMOVE(b, 0, b, num - 1,
+					  b->header.size - num + 1);
+		}
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3139,6 +3541,9 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= (num - 1);
+	bps_tree_card_move(b_inner_path_elem->card, a_inner_path_elem->card,
+			   bps_tree_inner_card_sum(a, a->header.size - num,
+						   num));
 }
 
 /**
@@ -3199,6 +3604,8 @@ bps_tree_collect_left_path_elem_leaf(struct bps_tree *tree,
 		bps_tree_restore_block(tree, new_path_elem->block_id);
 	new_path_elem->max_elem_copy =
 		parent->block->elems + new_path_elem->pos_in_parent;
+	new_path_elem->card =
+		bps_tree_child_card(parent, new_path_elem->pos_in_parent);
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
 	return true;
 }
@@ -3226,6 +3633,8 @@ bps_tree_collect_left_path_elem_inner(struct bps_tree *tree,
 		bps_tree_restore_block(tree, new_path_elem->block_id);
 	new_path_elem->max_elem_copy = parent->block->elems +
 		new_path_elem->pos_in_parent;
+	new_path_elem->card =
+		bps_tree_child_card(parent, new_path_elem->pos_in_parent);
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
 	return true;
 }
@@ -3255,6 +3664,8 @@ bps_tree_collect_right_ext_leaf(struct bps_tree *tree,
 	else
 		new_path_elem->max_elem_copy = parent->block->elems +
 			new_path_elem->pos_in_parent;
+	new_path_elem->card =
+		bps_tree_child_card(parent, new_path_elem->pos_in_parent);
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
 	return true;
 }
@@ -3285,6 +3696,8 @@ bps_tree_collect_right_ext_inner(struct bps_tree *tree,
 	else
 		new_path_elem->max_elem_copy = parent->block->elems +
 			new_path_elem->pos_in_parent;
+	new_path_elem->card =
+		bps_tree_child_card(parent, new_path_elem->pos_in_parent);
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
 	return true;
 }
@@ -3297,13 +3710,14 @@ bps_tree_prepare_new_ext_leaf(struct bps_leaf_path_elem *path_elem,
 			      struct bps_leaf_path_elem *new_path_elem,
 			      struct bps_leaf* new_leaf,
 			      bps_tree_block_id_t new_leaf_id,
-			      bps_tree_elem_t *max_elem_copy)
+			      bps_tree_elem_t *max_elem_copy, size_t *card)
 {
 	new_path_elem->parent = path_elem->parent;
 	new_path_elem->pos_in_parent = path_elem->pos_in_parent + 1;
 	new_path_elem->block_id = new_leaf_id;
 	new_path_elem->block = new_leaf;
 	new_path_elem->max_elem_copy = max_elem_copy;
+	new_path_elem->card = card;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
 }
 
@@ -3315,13 +3729,14 @@ bps_tree_prepare_new_ext_inner(struct bps_inner_path_elem *path_elem,
 			       struct bps_inner_path_elem *new_path_elem,
 			       struct bps_inner* new_inner,
 			       bps_tree_block_id_t new_inner_id,
-			       bps_tree_elem_t *max_elem_copy)
+			       bps_tree_elem_t *max_elem_copy, size_t *card)
 {
 	new_path_elem->parent = path_elem->parent;
 	new_path_elem->pos_in_parent = path_elem->pos_in_parent + 1;
 	new_path_elem->block_id = new_inner_id;
 	new_path_elem->block = new_inner;
 	new_path_elem->max_elem_copy = max_elem_copy;
+	new_path_elem->card = card;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
 }
 
@@ -3332,7 +3747,7 @@ static int
 bps_tree_process_insert_inner(struct bps_tree *tree,
 			      struct bps_inner_path_elem *inner_path_elem,
 			      bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-			      bps_tree_elem_t max_elem);
+			      bps_tree_elem_t max_elem, size_t card);
 
 /**
  * Basic inserted into leaf, dealing with spliting, merging and moving data
@@ -3354,10 +3769,10 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	}
 	bps_tree_touch_path(tree, leaf_path_elem);
 
-	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+			right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+			left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+			right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0};
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_leaf(tree, leaf_path_elem,
 						     &left_ext);
@@ -3482,8 +3897,9 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	new_leaf->header.size = 0;
 	struct bps_leaf_path_elem new_path_elem;
 	bps_tree_elem_t new_max_elem = tree->max_elem;
+	size_t new_card = 0;
 	bps_tree_prepare_new_ext_leaf(leaf_path_elem, &new_path_elem, new_leaf,
-				      new_block_id, &new_max_elem);
+				      new_block_id, &new_max_elem, &new_card);
 	if (has_left_ext && has_right_ext) {
 		/*
 		 * The block has MAX elems and +1 elem is inserted,
@@ -3704,6 +4120,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+		BPS_TREE_CARDSET(new_root, 0, tree->size - new_card);
+		BPS_TREE_CARDSET(new_root, 1, new_card);
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -3720,7 +4138,7 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0xD);
 	return bps_tree_process_insert_inner(tree, leaf_path_elem->parent,
 			new_block_id, new_path_elem.pos_in_parent,
-			new_max_elem);
+			new_max_elem, new_card);
 }
 
 /**
@@ -3731,18 +4149,19 @@ static inline int
 bps_tree_process_insert_inner(struct bps_tree *tree,
 			      struct bps_inner_path_elem *inner_path_elem,
 			      bps_tree_block_id_t block_id,
-			      bps_tree_pos_t pos, bps_tree_elem_t max_elem)
+			      bps_tree_pos_t pos, bps_tree_elem_t max_elem,
+			      size_t card)
 {
 	if (bps_tree_inner_free_size(inner_path_elem->block)) {
 		bps_tree_insert_into_inner(tree, inner_path_elem,
-					   block_id, pos, max_elem);
+					   block_id, pos, max_elem, card);
 		BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x0);
 		return 0;
 	}
-	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0};
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_inner(tree, inner_path_elem,
 						      &left_ext);
@@ -3758,7 +4177,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(left_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem, move_count,
-					block_id, pos, max_elem);
+					block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x1);
 			return 0;
 		} else if (bps_tree_inner_free_size(right_ext.block) > 0) {
@@ -3766,7 +4185,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(right_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x2);
 			return 0;
 		}
@@ -3776,7 +4195,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(left_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x3);
 			return 0;
 		}
@@ -3792,7 +4211,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 			move_count = 1 + move_count / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem, move_count,
-					block_id, pos, max_elem);
+					block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x4);
 			return 0;
 		}
@@ -3802,7 +4221,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(right_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x5);
 			return 0;
 		}
@@ -3818,7 +4237,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 			move_count = 1 + move_count / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x6);
 			return 0;
 		}
@@ -3830,8 +4249,10 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 	new_inner->header.size = 0;
 	struct bps_inner_path_elem new_path_elem;
 	bps_tree_elem_t new_max_elem = tree->max_elem;
+	size_t new_card = 0;
 	bps_tree_prepare_new_ext_inner(inner_path_elem, &new_path_elem,
-				       new_inner, new_block_id, &new_max_elem);
+				       new_inner, new_block_id, &new_max_elem,
+				       &new_card);
 	if (has_left_ext && has_right_ext) {
 		/*
 		 * The block has MAX elems and +1 elem is inserted,
@@ -3858,7 +4279,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 		bps_tree_move_elems_to_left_inner(tree,
@@ -3893,7 +4314,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 		bps_tree_move_elems_to_right_inner(tree,
@@ -3927,7 +4348,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_left_inner(tree,
 				&new_path_elem, &right_ext, mc2);
 		bps_tree_move_elems_to_left_inner(tree,
@@ -3959,7 +4380,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 
@@ -3988,7 +4409,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_left_inner(tree,
 				&new_path_elem, &right_ext, mc2);
 
@@ -4016,7 +4437,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 
 		bps_tree_block_id_t new_root_id = (bps_tree_block_id_t)(-1);
 		struct bps_inner *new_root =
@@ -4024,6 +4445,8 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+		BPS_TREE_CARDSET(new_root, 0, tree->size - new_card);
+		BPS_TREE_CARDSET(new_root, 1, new_card);
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -4035,7 +4458,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 	BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0xD);
 	return bps_tree_process_insert_inner(tree, inner_path_elem->parent,
 			new_block_id, new_path_elem.pos_in_parent,
-			new_max_elem);
+			new_max_elem, new_card);
 }
 
 /**
@@ -4063,10 +4486,10 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 
 	bps_tree_touch_path(tree, leaf_path_elem);
 
-	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0};
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_leaf(tree, leaf_path_elem,
 						     &left_ext);
@@ -4249,10 +4672,10 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 		return;
 	}
 
-	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0},
+		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0, 0};
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_inner(tree, inner_path_elem,
 						      &left_ext);
@@ -4441,9 +4864,13 @@ bps_tree_insert(struct bps_tree *tree, bps_tree_elem_t new_elem,
 	} else {
 		bps_tree_block_id_t unused1;
 		bps_tree_pos_t unused2;
-		return bps_tree_process_insert_leaf(tree, &leaf_path_elem,
-						    new_elem, &unused1,
-						    &unused2);
+		bps_tree_path_add_card(tree, &leaf_path_elem, 1);
+		int rc = bps_tree_process_insert_leaf(tree, &leaf_path_elem,
+						      new_elem, &unused1,
+						      &unused2);
+		if (rc != 0)
+			bps_tree_path_add_card(tree, &leaf_path_elem, -1);
+		return rc;
 	}
 }
 
@@ -4476,10 +4903,13 @@ bps_tree_insert_get_iterator(struct bps_tree *tree, bps_tree_elem_t new_elem,
 					 replaced);
 		return 0;
 	} else {
+		bps_tree_path_add_card(tree, &leaf_path_elem, 1);
 		int rc = bps_tree_process_insert_leaf(tree, &leaf_path_elem,
 						      new_elem,
 						      &inserted_iterator->block_id,
 						      &inserted_iterator->pos);
+		if (rc != 0)
+			bps_tree_path_add_card(tree, &leaf_path_elem, -1);
 		matras_head_read_view(&inserted_iterator->view);
 		return rc;
 	}
@@ -4504,6 +4934,7 @@ bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem)
 	if (!exact)
 		return -1;
 
+	bps_tree_path_add_card(tree, &leaf_path_elem, -1);
 	bps_tree_process_delete_leaf(tree, &leaf_path_elem);
 	return 0;
 }
@@ -4592,7 +5023,8 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 						       inner->child_ids[i]);
 			bps_tree_elem_t calc_max_elem =
 				bps_tree_debug_find_max_elem(tree, tmp_block);
-			if (inner->elems[i] != calc_max_elem)
+			if (!BPS_TREE_IDENTICAL(inner->elems[i],
+						calc_max_elem))
 				result |= 0x4000;
 		}
 		if (block->size > 1) {
@@ -4619,13 +5051,21 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 				result |= 0x4000000;
 		}
 
-		for (bps_tree_pos_t i = 0; i < block->size; i++)
+		for (bps_tree_pos_t i = 0; i < block->size; i++) {
+			size_t count_before = *calc_count;
 			result |= bps_tree_debug_check_block(tree,
 				bps_tree_restore_block(tree,
 						       inner->child_ids[i]),
 				inner->child_ids[i], level - 1, calc_count,
 				expected_prev_id, expected_this_id,
 				check_fullness_next);
+#ifdef BPS_INNER_CARD
+			if (inner->child_cards[i] != *calc_count - count_before)
+				result |= 0x100000;
+#else
+			(void)count_before;
+#endif
+		}
 		return result;
 	}
 }
@@ -4651,7 +5091,9 @@ bps_tree_debug_check(const struct bps_tree *tree)
 		return result;
 	}
 	struct bps_block *root = bps_tree_root(tree);
-	if (tree->max_elem != bps_tree_debug_find_max_elem(tree, root))
+	bps_tree_elem_t calc_max_elem =
+		bps_tree_debug_find_max_elem(tree, root);
+	if (!BPS_TREE_IDENTICAL(tree->max_elem, calc_max_elem))
 		result |= 0x8;
 	size_t calc_count = 0;
 	bps_tree_block_id_t expected_prev_id = (bps_tree_block_id_t)(-1);
@@ -4867,6 +5309,7 @@ bps_tree_debug_check_insert_into_leaf(struct bps_tree *tree, bool assertme)
 			path_elem.block_id = 0;
 			path_elem.insertion_point = j;
 			path_elem.max_elem_copy = &max;
+			path_elem.card = NULL;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
 
@@ -4922,6 +5365,7 @@ bps_tree_debug_check_delete_from_leaf(struct bps_tree *tree, bool assertme)
 			path_elem.block_id = 0;
 			path_elem.insertion_point = j;
 			path_elem.max_elem_copy = &max;
+			path_elem.card = NULL;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
 
@@ -4994,10 +5438,12 @@ bps_tree_debug_check_move_to_right_leaf(struct bps_tree *tree, bool assertme)
 					b_path_elem;
 				a_path_elem.block = &a;
 				a_path_elem.max_elem_copy = &ma;
+				a_path_elem.card = NULL;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
+				b_path_elem.card = NULL;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
 				a_path_elem.block_id = 0;
@@ -5091,10 +5537,12 @@ bps_tree_debug_check_move_to_left_leaf(struct bps_tree *tree, bool assertme)
 					b_path_elem;
 				a_path_elem.block = &a;
 				a_path_elem.max_elem_copy = &ma;
+				a_path_elem.card = NULL;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
+				b_path_elem.card = NULL;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
 				a_path_elem.block_id = 0;
@@ -5196,10 +5644,12 @@ bps_tree_debug_check_insert_and_move_to_right_leaf(struct bps_tree *tree,
 						b_path_elem;
 					a_path_elem.block = &a;
 					a_path_elem.max_elem_copy = &ma;
+					a_path_elem.card = NULL;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
+					b_path_elem.card = NULL;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
 					a_path_elem.insertion_point = k;
@@ -5312,10 +5762,12 @@ bps_tree_debug_check_insert_and_move_to_left_leaf(struct bps_tree *tree,
 						b_path_elem;
 					a_path_elem.block = &a;
 					a_path_elem.max_elem_copy = &ma;
+					a_path_elem.card = NULL;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
+					b_path_elem.card = NULL;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
 					b_path_elem.insertion_point = k;
@@ -5408,6 +5860,7 @@ bps_tree_debug_check_insert_into_inner(struct bps_tree *tree, bool assertme)
 			path_elem.block = &block;
 			path_elem.block_id = 0;
 			path_elem.max_elem_copy = &max;
+			path_elem.card = NULL;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
 
@@ -5429,7 +5882,7 @@ bps_tree_debug_check_insert_into_inner(struct bps_tree *tree, bool assertme)
 
 			bps_tree_insert_into_inner(tree, &path_elem,
 				(bps_tree_block_id_t) j, (bps_tree_pos_t) j,
-				ins);
+				ins, 0);
 
 			for (unsigned int k = 0; k <= i; k++) {
 				if (bps_tree_debug_get_elem_inner(&path_elem, k)
@@ -5476,6 +5929,7 @@ bps_tree_debug_check_delete_from_inner(struct bps_tree *tree, bool assertme)
 			path_elem.block_id = 0;
 			path_elem.insertion_point = j;
 			path_elem.max_elem_copy = &max;
+			path_elem.card = NULL;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
 
@@ -5536,10 +5990,12 @@ bps_tree_debug_check_move_to_right_inner(struct bps_tree *tree, bool assertme)
 				struct bps_inner_path_elem a_path_elem, b_path_elem;
 				a_path_elem.block = &a;
 				a_path_elem.max_elem_copy = &ma;
+				a_path_elem.card = NULL;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
+				b_path_elem.card = NULL;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
 				a_path_elem.block_id = 0;
@@ -5636,10 +6092,12 @@ bps_tree_debug_check_move_to_left_inner(struct bps_tree *tree, bool assertme)
 				struct bps_inner_path_elem a_path_elem, b_path_elem;
 				a_path_elem.block = &a;
 				a_path_elem.max_elem_copy = &ma;
+				a_path_elem.card = NULL;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
+				b_path_elem.card = NULL;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
 				a_path_elem.block_id = 0;
@@ -5742,10 +6200,12 @@ bps_tree_debug_check_insert_and_move_to_right_inner(struct bps_tree *tree,
 						b_path_elem;
 					a_path_elem.block = &a;
 					a_path_elem.max_elem_copy = &ma;
+					a_path_elem.card = NULL;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
+					b_path_elem.card = NULL;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
 					a_path_elem.block_id = 0;
@@ -5784,7 +6244,7 @@ bps_tree_debug_check_insert_and_move_to_right_inner(struct bps_tree *tree,
 						tree, &a_path_elem,
 						&b_path_elem,
 						(bps_tree_pos_t) u, ikk,
-						(bps_tree_pos_t) k, ins);
+						(bps_tree_pos_t) k, ins, 0);
 
 					if (a.header.size
 						!= (bps_tree_pos_t) (i - u + 1)) {
@@ -5874,10 +6334,12 @@ bps_tree_debug_check_insert_and_move_to_left_inner(struct bps_tree *tree,
 						b_path_elem;
 					a_path_elem.block = &a;
 					a_path_elem.max_elem_copy = &ma;
+					a_path_elem.card = NULL;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
+					b_path_elem.card = NULL;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
 					a_path_elem.block_id = 0;
@@ -5911,7 +6373,7 @@ bps_tree_debug_check_insert_and_move_to_left_inner(struct bps_tree *tree,
 						tree, &a_path_elem,
 						&b_path_elem,
 						(bps_tree_pos_t) u, ikk,
-						(bps_tree_pos_t) k, ins);
+						(bps_tree_pos_t) k, ins, 0);
 
 					if (a.header.size
 						!= (bps_tree_pos_t) (i + u)) {
@@ -6001,6 +6463,8 @@ bps_tree_debug_check_internal_functions(bool assertme)
 
 #undef BPS_TREE_MEMMOVE
 #undef BPS_TREE_DATAMOVE
+#undef BPS_TREE_CARDMOVE
+#undef BPS_TREE_CARDSET
 #undef BPS_TREE_BRANCH_TRACE
 
 /* {{{ Macros for custom naming of structs and functions */
@@ -6043,6 +6507,9 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_iterator_prev
 #undef bps_tree_iterator_freeze
 #undef bps_tree_iterator_destroy
+#undef bps_tree_iterator_at
+#undef bps_tree_lower_bound_get_offset
+#undef bps_tree_upper_bound_get_offset
 #undef bps_tree_debug_check
 #undef bps_tree_print
 #undef bps_tree_debug_check_internal_functions
@@ -6076,6 +6543,10 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_collect_path
 #undef bps_tree_touch_leaf_path_max_elem
 #undef bps_tree_touch_path
+#undef bps_tree_child_card
+#undef bps_tree_inner_card_sum
+#undef bps_tree_card_move
+#undef bps_tree_path_add_card
 #undef bps_tree_process_replace
 #undef bps_tree_debug_memmove
 #undef bps_tree_insert_into_leaf
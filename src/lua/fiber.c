@@ -290,6 +290,81 @@ lbox_fiber_info(struct lua_State *L)
 	return 1;
 }
 
+static void
+lbox_push_clock_stat(struct lua_State *L, const struct clock_stat *stat)
+{
+	lua_createtable(L, 0, 3);
+	lua_pushnumber(L, stat->instant);
+	lua_setfield(L, -2, "instant");
+	lua_pushnumber(L, stat->average);
+	lua_setfield(L, -2, "average");
+	lua_pushnumber(L, stat->total / 1e9);
+	lua_setfield(L, -2, "time");
+}
+
+static int
+lbox_fiber_top_entry(struct fiber *f, void *cb_ctx)
+{
+	struct lua_State *L = (struct lua_State *) cb_ctx;
+	lua_pushfstring(L, "%d/%s", (int) f->fid, fiber_name(f));
+	lbox_push_clock_stat(L, &f->clock_stat);
+	lua_settable(L, -3);
+	return 0;
+}
+
+/**
+ * Return the share of the thread time consumed by each fiber,
+ * in percent, for the last second (instant) and on average,
+ * along with the total time in seconds.
+ */
+static int
+lbox_fiber_top(struct lua_State *L)
+{
+	struct cord *cord = cord();
+	if (!cord->top_is_enabled) {
+		return luaL_error(L, "fiber.top() is disabled, "
+				  "enable it with fiber.top_enable() first");
+	}
+	lua_createtable(L, 0, 2);
+	lbox_push_clock_stat(L, &cord->clock_stat);
+	lua_setfield(L, -2, "load");
+	lua_newtable(L);
+	lbox_fiber_top_entry(&cord->sched, L);
+	fiber_stat(lbox_fiber_top_entry, L);
+	lua_setfield(L, -2, "cpu");
+	return 1;
+}
+
+static int
+lbox_fiber_top_enable(struct lua_State *L)
+{
+	(void) L;
+	cord_top_enable(true);
+	return 0;
+}
+
+static int
+lbox_fiber_top_disable(struct lua_State *L)
+{
+	(void) L;
+	cord_top_enable(false);
+	return 0;
+}
+
+/**
+ * Warn about fibers running longer than the given number of
+ * seconds without yielding, 0 to disable.
+ */
+static int
+lbox_fiber_set_slice_warning(struct lua_State *L)
+{
+	if (lua_gettop(L) != 1 || !lua_isnumber(L, 1) ||
+	    lua_tonumber(L, 1) < 0)
+		luaL_error(L, "fiber.set_slice_warning(timeout): bad arguments");
+	cord_set_slice_warning(lua_tonumber(L, 1));
+	return 0;
+}
+
 static int
 lua_fiber_run_f(MAYBE_UNUSED va_list ap)
 {
@@ -687,6 +762,10 @@ static const struct luaL_Reg fiberlib[] = {
 	{"new", lbox_fiber_new},
 	{"status", lbox_fiber_status},
 	{"name", lbox_fiber_name},
+	{"top", lbox_fiber_top},
+	{"top_enable", lbox_fiber_top_enable},
+	{"top_disable", lbox_fiber_top_disable},
+	{"set_slice_warning", lbox_fiber_set_slice_warning},
 	{NULL, NULL}
 };
 
@@ -18,6 +18,9 @@ ffi.cdef[[
     extern void
     say_logrotate(struct ev_loop *, struct ev_signal *, int);
 
+    uint64_t
+    say_logger_dropped(void);
+
     enum say_level {
         S_FATAL,
         S_SYSERROR,
@@ -129,6 +132,10 @@ local function log_pid()
     return tonumber(ffi.C.log_pid)
 end
 
+local function log_dropped()
+    return tonumber(ffi.C.say_logger_dropped())
+end
+
 local compat_warning_said = false
 local compat_v16 = {
     logger_pid = function()
@@ -148,6 +155,7 @@ return setmetatable({
     error = say_closure(S_ERROR);
     rotate = log_rotate;
     pid = log_pid;
+    dropped = log_dropped;
     level = log_level;
     log_format = log_format;
 }, {
@@ -508,6 +508,12 @@ load_cfg()
 	if (background)
 		daemonize();
 
+	/* Threads do not survive fork(), start the logger after it. */
+	if (cfg_getb("log_async") == 1 && say_logger_start_async() != 0) {
+		diag_log();
+		panic("failed to start the logger thread");
+	}
+
 	/*
 	 * after (optional) daemonising to avoid confusing messages with
 	 * different pids
@@ -39,6 +39,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <syslog.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -234,9 +235,11 @@ say_format_by_name(const char *format)
 }
 
 static void
-write_to_file(struct log *log, int total);
+write_to_file(struct log *log, const char *buf, int total);
 static void
-write_to_syslog(struct log *log, int total);
+write_to_syslog(struct log *log, const char *buf, int total);
+static void
+say_logger_stop_async(void);
 
 /**
  * Rotate logs on SIGHUP
@@ -638,6 +641,7 @@ fail:
 void
 say_logger_free()
 {
+	say_logger_stop_async();
 	if (log_default == &log_std)
 		log_destroy(&log_std);
 }
@@ -913,7 +917,7 @@ say_default(int level, const char *filename, int line, const char *error,
  * File and pipe logger
  */
 static void
-write_to_file(struct log *log, int total)
+write_to_file(struct log *log, const char *buf, int total)
 {
 	assert(log->type == SAY_LOGGER_FILE ||
 	       log->type == SAY_LOGGER_PIPE ||
@@ -927,7 +931,7 @@ write_to_file(struct log *log, int total)
  * Syslog logger
  */
 static void
-write_to_syslog(struct log *log, int total)
+write_to_syslog(struct log *log, const char *buf, int total)
 {
 	assert(log->type == SAY_LOGGER_SYSLOG);
 	assert(total >= 0);
@@ -956,6 +960,224 @@ write_to_syslog(struct log *log, int total)
 
 /** Loggers }}} */
 
+/** {{{ Asynchronous logger */
+
+enum {
+	/** Number of records in the queue, must be a power of 2. */
+	SAY_QUEUE_SIZE = 256,
+};
+
+/** A formatted record waiting to be written. */
+struct say_record {
+	/**
+	 * Slot sequence number. Equals the producer position
+	 * when the slot is free and the position plus one when
+	 * the slot holds a record.
+	 */
+	unsigned seq;
+	/** Record length. */
+	int len;
+	/** Record text. */
+	char text[SAY_BUF_LEN_MAX];
+};
+
+/**
+ * A bounded multi-producer single-consumer queue of records
+ * feeding the logger thread.
+ */
+struct say_queue {
+	/** Position of the next record to push. */
+	unsigned head;
+	/** Position of the next record to pop, logger thread only. */
+	unsigned tail;
+	/** Number of records dropped because the queue was full. */
+	uint64_t dropped;
+	/**
+	 * Number of threads that have seen is_running set and
+	 * may be pushing a record. The logger thread isn't
+	 * stopped until it drops to 0.
+	 */
+	unsigned pushers;
+	/** Set while records must go to the logger thread. */
+	bool is_running;
+	/** Set to make the logger thread exit. */
+	bool is_stopping;
+	/** Logger thread. */
+	struct cord cord;
+	/** Used to wake up the logger thread. */
+	ev_async wakeup;
+	/**
+	 * SAY_QUEUE_SIZE record slots, allocated when the
+	 * logger thread is started so that pushing a record
+	 * never calls the allocator.
+	 */
+	struct say_record *records;
+};
+
+static struct say_queue say_queue;
+
+/**
+ * Try to put a record into the queue. May be called from any
+ * thread.
+ * @retval 0 success
+ * @retval -1 the queue is full
+ */
+static int
+say_queue_push(const char *buf, int len)
+{
+	struct say_queue *q = &say_queue;
+	struct say_record *record;
+	unsigned pos = pm_atomic_load_explicit(&q->head,
+					       pm_memory_order_relaxed);
+	for (;;) {
+		record = &q->records[pos & (SAY_QUEUE_SIZE - 1)];
+		unsigned seq = pm_atomic_load_explicit(&record->seq,
+						pm_memory_order_acquire);
+		int diff = (int)(seq - pos);
+		if (diff == 0) {
+			if (pm_atomic_compare_exchange_weak(&q->head,
+							    &pos, pos + 1))
+				break;
+		} else if (diff < 0) {
+			/* The logger thread lags behind. */
+			return -1;
+		} else {
+			pos = pm_atomic_load_explicit(&q->head,
+						pm_memory_order_relaxed);
+		}
+	}
+	/* The slot is ours now. */
+	assert(len <= SAY_BUF_LEN_MAX);
+	memcpy(record->text, buf, len);
+	record->len = len;
+	pm_atomic_store_explicit(&record->seq, pos + 1,
+				 pm_memory_order_release);
+	ev_async_send(q->cord.loop, &q->wakeup);
+	return 0;
+}
+
+/** Write all queued records. Logger thread only. */
+static void
+say_queue_flush(struct log *log)
+{
+	struct say_queue *q = &say_queue;
+	for (;;) {
+		struct say_record *record =
+			&q->records[q->tail & (SAY_QUEUE_SIZE - 1)];
+		unsigned seq = pm_atomic_load_explicit(&record->seq,
+						pm_memory_order_acquire);
+		if (seq != q->tail + 1)
+			break;
+		if (log->type == SAY_LOGGER_SYSLOG)
+			write_to_syslog(log, record->text, record->len);
+		else
+			write_to_file(log, record->text, record->len);
+		pm_atomic_store_explicit(&record->seq,
+					 q->tail + SAY_QUEUE_SIZE,
+					 pm_memory_order_release);
+		q->tail++;
+	}
+}
+
+static void
+say_queue_wakeup_cb(struct ev_loop *loop, struct ev_async *watcher,
+		    int events)
+{
+	(void) loop;
+	(void) events;
+	fiber_wakeup((struct fiber *) watcher->data);
+}
+
+static int
+say_logger_f(va_list ap)
+{
+	struct log *log = va_arg(ap, struct log *);
+	struct say_queue *q = &say_queue;
+	q->wakeup.data = fiber();
+	ev_async_start(loop(), &q->wakeup);
+	/*
+	 * Records pushed before the watcher was started did
+	 * not wake us up, so flush before going to sleep.
+	 */
+	while (!pm_atomic_load(&q->is_stopping)) {
+		say_queue_flush(log);
+		fiber_yield();
+	}
+	say_queue_flush(log);
+	ev_async_stop(loop(), &q->wakeup);
+	return 0;
+}
+
+int
+say_logger_start_async(void)
+{
+	struct say_queue *q = &say_queue;
+	struct log *log = log_default;
+	assert(!q->is_running);
+	if (log->type != SAY_LOGGER_FILE && log->type != SAY_LOGGER_PIPE &&
+	    log->type != SAY_LOGGER_SYSLOG) {
+		/*
+		 * Writing to stderr asynchronously would garble
+		 * interactive console output.
+		 */
+		return 0;
+	}
+	size_t size = SAY_QUEUE_SIZE * sizeof(*q->records);
+	q->records = (struct say_record *) malloc(size);
+	if (q->records == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "say_queue");
+		return -1;
+	}
+	q->head = q->tail = 0;
+	q->pushers = 0;
+	q->is_stopping = false;
+	for (unsigned i = 0; i < SAY_QUEUE_SIZE; i++)
+		q->records[i].seq = i;
+	ev_async_init(&q->wakeup, say_queue_wakeup_cb);
+	if (cord_costart(&q->cord, "logger", say_logger_f, log) != 0) {
+		free(q->records);
+		q->records = NULL;
+		return -1;
+	}
+	pm_atomic_store(&q->is_running, true);
+	return 0;
+}
+
+/**
+ * Stop the logger thread, if it is running, and write all
+ * records it has not written yet.
+ */
+static void
+say_logger_stop_async(void)
+{
+	struct say_queue *q = &say_queue;
+	if (!q->is_running)
+		return;
+	pm_atomic_store(&q->is_running, false);
+	/*
+	 * A thread that has seen is_running set may still be
+	 * pushing a record. Wait for it to finish, otherwise the
+	 * record would be lost and the wakeup would be sent to
+	 * the loop of a thread that has already exited.
+	 */
+	while (pm_atomic_load(&q->pushers) > 0)
+		sched_yield();
+	pm_atomic_store(&q->is_stopping, true);
+	ev_async_send(q->cord.loop, &q->wakeup);
+	if (cord_join(&q->cord) != 0)
+		diag_log();
+	free(q->records);
+	q->records = NULL;
+}
+
+uint64_t
+say_logger_dropped(void)
+{
+	return pm_atomic_load(&say_queue.dropped);
+}
+
+/** Asynchronous logger }}} */
+
 /*
  * Init string parser(s)
  */
@@ -1127,14 +1349,39 @@ log_vsay(struct log *log, int level, const char *filename, int line,
 	}
 	int total = log->format_func(log, buf, sizeof(buf), level,
 				     filename, line, error, format, ap);
+	/*
+	 * Fatal messages are written synchronously, the process
+	 * is likely to exit right after them.
+	 */
+	if (log == log_default && level != S_FATAL && total > 0 &&
+	    pm_atomic_load(&say_queue.is_running)) {
+		/*
+		 * Register as a pusher before checking is_running
+		 * once more: say_logger_stop_async() clears the
+		 * flag before waiting for pushers to leave.
+		 */
+		pm_atomic_fetch_add(&say_queue.pushers, 1);
+		bool is_pushed = false;
+		if (pm_atomic_load(&say_queue.is_running)) {
+			if (say_queue_push(buf, MIN(total,
+					SAY_BUF_LEN_MAX - 1)) != 0)
+				pm_atomic_fetch_add(&say_queue.dropped, 1);
+			is_pushed = true;
+		}
+		pm_atomic_fetch_sub(&say_queue.pushers, 1);
+		if (is_pushed) {
+			errno = errsv; /* Preserve the errno. */
+			return total;
+		}
+	}
 	switch (log->type) {
 	case SAY_LOGGER_FILE:
 	case SAY_LOGGER_PIPE:
 	case SAY_LOGGER_STDERR:
-		write_to_file(log, total);
+		write_to_file(log, buf, total);
 		break;
 	case SAY_LOGGER_SYSLOG:
-		write_to_syslog(log, total);
+		write_to_syslog(log, buf, total);
 		if (level == S_FATAL && log->fd != STDERR_FILENO)
 			(void) safe_write(STDERR_FILENO, buf, total);
 		break;
@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <errno.h>
 #include <sys/types.h> /* pid_t */
 #include <tarantool_ev.h>
@@ -244,6 +245,28 @@ say_logger_init(const char *init_str,
 void
 say_logger_free();
 
+/**
+ * Move the I/O of the default logger to a separate thread.
+ * Formatted records are passed to the thread through a
+ * bounded lock-free queue, so a stalled log device never
+ * blocks the thread that logs. A record which does not fit
+ * into the queue is dropped and counted, see
+ * say_logger_dropped(). Fatal messages and messages written
+ * to stderr are still written synchronously.
+ *
+ * Must be called after daemonizing: threads do not survive
+ * fork().
+ *
+ * @retval 0 success
+ * @retval -1 error, the diagnostics area is set
+ */
+int
+say_logger_start_async(void);
+
+/** Number of records dropped by the logger thread. */
+uint64_t
+say_logger_dropped(void);
+
 CFORMAT(printf, 5, 0) void
 vsay(int level, const char *filename, int line, const char *error,
      const char *format, va_list ap);
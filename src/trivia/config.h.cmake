@@ -70,15 +70,6 @@
  */
 #define MAP_ANONYMOUS MAP_ANON
 #endif
-/*
- * Defined if O_DSYNC mode exists for open(2).
- */
-#cmakedefine HAVE_O_DSYNC 1
-#if defined(HAVE_O_DSYNC)
-    #define WAL_SYNC_FLAG O_DSYNC
-#else
-    #define WAL_SYNC_FLAG O_SYNC
-#endif
 /*
  * Defined if fdatasync(2) call is present.
  */
@@ -593,3 +593,20 @@ con = require('net.box').connect(box.cfg.listen)
 pcall(con.eval, con, 'fiber.cancel(fiber.self())')
 con:eval('fiber.sleep(0) return "Ok"')
 box.schema.user.revoke('guest', 'execute', 'universe')
+
+-- fiber.top
+fiber.top()
+fiber.top_enable()
+f = fiber.create(function() while true do fiber.sleep(0.001) end end)
+fiber.sleep(1.1)
+top = fiber.top()
+top.cpu['1/sched'] ~= nil
+top.cpu[f:id() .. '/' .. f:name()].time > 0
+top.load.instant >= 0 and top.load.average >= 0
+f:cancel()
+fiber.set_slice_warning(-1)
+fiber.set_slice_warning(0.5)
+fiber.set_slice_warning(0)
+fiber.top_disable()
+fiber.top()
+top = nil
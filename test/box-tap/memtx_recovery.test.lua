@@ -0,0 +1,135 @@
+#!/usr/bin/env tarantool
+
+--
+-- Memtx snapshot recovery: rows are read ahead by a separate
+-- thread in batches, primary keys of different spaces are
+-- sorted in parallel.
+--
+local tap = require('tap')
+local fio = require('fio')
+local test = tap.test('memtx_recovery')
+test:plan(9)
+
+local tarantool_bin = arg[-1]
+local PANIC = 256
+local dir = fio.tempdir()
+
+local function run_script(code)
+    local script_path = fio.pathjoin(dir, 'script.lua')
+    local script = fio.open(script_path,
+        {'O_CREAT', 'O_WRONLY', 'O_TRUNC'}, tonumber('0777', 8))
+    script:write(code)
+    script:write("\nos.exit(0)")
+    script:close()
+    local cmd = [[/bin/sh -c 'cd "%s" && "%s" ./script.lua 2> /dev/null']]
+    return os.execute(string.format(cmd, dir, tarantool_bin))
+end
+
+local function read_log()
+    local f = fio.open(fio.pathjoin(dir, 'tarantool.log'), {'O_RDONLY'})
+    local log = f:read()
+    f:close()
+    return log
+end
+
+--
+-- Rows of system spaces refer to each other (_index rows to
+-- _space rows), so the schema is only recovered if rows are
+-- applied in snapshot order. Make _space rows large enough to
+-- be split across batches. Data rows take several times the
+-- memory of all batches in flight, so the reader has to reuse
+-- them, and are not compressible, so that corruption in the
+-- middle of the file hits data.
+--
+local cfg = [[
+box.cfg{
+    log = 'tarantool.log',
+    memtx_memory = 512 * 1024 * 1024,
+    memtx_sort_threads = 4,
+    force_recovery = %s,
+}
+]]
+local fill = string.format(cfg, 'false') .. [[
+local digest = require('digest')
+local format = {}
+for i = 1, 1000 do
+    table.insert(format, {name = string.format('field%04d', i)})
+end
+for i = 1, 200 do
+    box.schema.space.create('catalog' .. i, {format = format})
+end
+for i = 1, 8 do
+    local s = box.schema.space.create('test' .. i)
+    s:create_index('pk')
+    s:create_index('sk', {parts = {2, 'unsigned'}})
+    box.begin()
+    for j = 1, 5000 do
+        local data = digest.urandom(1000)
+        s:insert{j, 5000 - j, data, digest.crc32(data)}
+    end
+    box.commit()
+end
+box.snapshot()
+]]
+local check = [[
+local digest = require('digest')
+local row_count = 0
+for i = 1, 200 do
+    assert(#box.space['catalog' .. i]:format() == 1000)
+end
+for i = 1, 8 do
+    local s = box.space['test' .. i]
+    local prev = 0
+    for _, t in s:pairs() do
+        assert(t[1] > prev)
+        assert(s.index.sk:get(t[2]) == t)
+        assert(digest.crc32(t[3]) == t[4])
+        prev = t[1]
+    end
+    row_count = row_count + s:len()
+end
+os.exit((%s) and 0 or 1)
+]]
+
+test:is(run_script(fill), 0, 'fill the snapshot')
+test:is(run_script(string.format(cfg, 'false') ..
+                   string.format(check, 'row_count == 8 * 5000')), 0,
+        'all rows are recovered')
+local log = read_log()
+local space_count = log:match('sorting primary keys of (%d+) spaces ' ..
+                              'in 4 threads')
+test:ok(tonumber(space_count) >= 8, 'primary keys are sorted in parallel')
+
+--
+-- An error in the reader thread fails recovery.
+--
+local snap = fio.glob(fio.pathjoin(dir, '*.snap'))
+table.sort(snap)
+snap = snap[#snap]
+local size = fio.stat(snap).size
+test:ok(size > 32 * 1024 * 1024, 'the snapshot is larger than all batches')
+local f = fio.open(snap, {'O_WRONLY'})
+f:pwrite(string.rep('\0', 1024), math.floor(size * 3 / 4))
+f:close()
+test:is(run_script(string.format(cfg, 'false')), PANIC,
+        'corrupted snapshot fails recovery')
+log = read_log()
+local errmsg = log:match("can't initialize storage: ([^\n]*)")
+test:ok(errmsg ~= nil, 'the error is reported')
+test:ok(log:match('E> ' .. errmsg:gsub('%p', '%%%0')),
+        'the reader error is propagated to tx')
+
+--
+-- With force_recovery rows following the broken chunk are
+-- still recovered.
+--
+test:is(run_script(string.format(cfg, 'true') ..
+                   string.format(check, 'row_count > 7 * 5000 and ' ..
+                                        'row_count < 8 * 5000')), 0,
+        'force_recovery skips the broken chunk')
+log = read_log()
+test:ok(log:match("can't open tx: " .. errmsg:gsub('%p', '%%%0')),
+        'the broken chunk is logged')
+
+fio.rmtree(dir)
+os.exit(test:check() == true and 0 or 1)
@@ -484,3 +484,41 @@ validate_indexes()
 
 s:drop()
 box.internal.collation.drop('test')
+
+--
+-- Memtx secondary index is built in background: the build
+-- yields, changes made concurrently are propagated to the
+-- new index and the progress is reported in box.info.memtx().
+--
+fiber = require('fiber')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 5000 do s:insert{i, i} end
+box.info.memtx().build
+test_run:cmd("setopt delimiter ';'")
+done = false;
+_ = fiber.create(function()
+    s:create_index('sk', {parts = {2, 'unsigned'}})
+    done = true
+end);
+build = box.info.memtx().build;
+build.space, build.index, build.total;
+build.processed > 0 and build.processed < build.total;
+while not done do
+    local k = math.random(10000)
+    s:replace{k, k}
+    s:delete{math.random(10000)}
+    fiber.sleep(0)
+end;
+function check_sk()
+    for _, t in s:pairs() do
+        if s.index.sk:get(t[2]) ~= t then
+            return false
+        end
+    end
+    return s.index.sk:count() == s.index.pk:count()
+end;
+test_run:cmd("setopt delimiter ''");
+check_sk()
+box.info.memtx().build
+s:drop()
@@ -105,6 +105,23 @@ box.cfg{net_msg_max = 2}
 box.cfg{net_msg_max = old + 1000}
 box.cfg{net_msg_max = old}
 
+--
+-- memtx_sort_threads: secondary keys are sorted in multiple
+-- threads on ALTER.
+--
+box.cfg{memtx_sort_threads = -1}
+old = box.cfg.memtx_sort_threads
+box.cfg{memtx_sort_threads = 2}
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 1000 do s:insert{i, i % 100} end
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+s.index.sk:count()
+s.index.sk:select({42}, {limit = 2})
+s:create_index('uk', {parts = {2, 'unsigned'}})
+s:drop()
+box.cfg{memtx_sort_threads = old}
+
 --
 -- gh-3266: box.cfg{} still not optional on 2.0 brach
 --
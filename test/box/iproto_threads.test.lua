@@ -0,0 +1,73 @@
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server iproto_threads with script='box/iproto_threads.lua'")
+test_run:cmd("start server iproto_threads")
+test_run:cmd("switch iproto_threads")
+
+net = require('net.box')
+fiber = require('fiber')
+
+box.cfg.iproto_threads
+box.cfg{iproto_threads = 2}
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+function connections() local res = {} for i, t in ipairs(box.stat.net.thread()) do res[i] = t.CONNECTIONS.total end return res end
+before = connections()
+
+--
+-- Connections are spread over network threads. Check that
+-- requests sent over many connections concurrently are served.
+--
+conns = {}
+for i = 1, 20 do conns[i] = net.connect(box.cfg.listen) end
+ch = fiber.channel(20)
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 20 do
+    fiber.create(function()
+        for j = 1, 50 do
+            conns[i].space.test:replace{i * 100 + j, i}
+        end
+        ch:put(true)
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+for i = 1, 20 do ch:get() end
+s:count()
+conns[5].space.test:select({501})
+conns[20]:eval('return box.session.id() ~= nil')
+
+-- Statistics are summed over all threads.
+box.stat.net.SENT.total > 0
+box.stat.net.RECEIVED.total > 0
+-- Connections are handed over to network threads in turn.
+after = connections()
+for i = 1, #after do after[i] = after[i] - before[i] end
+after
+
+for i = 1, 20 do conns[i]:close() end
+
+--
+-- Connections are accepted on the new socket after
+-- box.cfg.listen is changed.
+--
+old_listen = box.cfg.listen
+box.cfg{listen = old_listen .. '.new'}
+conns = {}
+for i = 1, 20 do conns[i] = net.connect(box.cfg.listen) end
+ok = true
+for i = 1, 20 do ok = ok and conns[i]:ping() end
+ok
+for i = 1, 20 do conns[i]:close() end
+box.cfg{listen = old_listen}
+c = net.connect(box.cfg.listen)
+c:ping()
+c:close()
+
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+
+test_run:cmd("switch default")
+test_run:cmd("stop server iproto_threads")
+test_run:cmd("cleanup server iproto_threads")
@@ -0,0 +1,67 @@
+env = require('test_run')
+test_run = env.new()
+s = box.schema.space.create('withdata')
+pk = s:create_index('pk')
+--
+-- [*] in a path indexes every item of an array. Only one
+-- array can be indexed by a key.
+--
+s:create_index('idx', {parts = {{2, 'unsigned', path = '[*][*]'}}})
+s:create_index('idx', {parts = {{2, 'unsigned', path = '[*][1]'}, {2, 'string', path = '[1][*]'}}})
+s:create_index('idx', {parts = {{2, 'unsigned', path = '[*][1]'}, {3, 'string', path = '[*]'}}})
+--
+-- Only secondary memtx TREE indexes can be multikey.
+--
+s:create_index('idx', {type = 'hash', parts = {{2, 'unsigned', path = '[*][1]'}}})
+s2 = box.schema.space.create('test2')
+s2:create_index('pk', {parts = {{2, 'unsigned', path = '[*][1]'}}})
+s2:drop()
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+v:create_index('idx', {parts = {{2, 'unsigned', path = '[*][1]'}}})
+v:drop()
+--
+-- A tuple has an index entry per array item. Items with
+-- equal keys share an entry, an empty array has none.
+--
+idx = s:create_index('idx', {parts = {{2, 'unsigned', path = '[*][1]'}, {2, 'string', path = '[*][2]'}}})
+s:insert{1, {{1, 'a'}, {2, 'b'}}}
+s:insert{2, {{2, 'c'}}}
+s:insert{3, {}}
+s:insert{4, {{3, 'd'}, {3, 'd'}}}
+idx:select()
+idx:get{2, 'b'}
+idx:select({2}, {iterator = 'GE'})
+idx:select({3}, {iterator = 'LT'})
+idx:count()
+--
+-- Every item is checked.
+--
+s:insert{5, {{1, 'a'}}}
+s:insert{5, {{4, 'e'}, {4}}}
+s:insert{5, {{4, 'e'}, {4, 5}}}
+s:insert{5, 'abc'}
+s:get{5}
+--
+-- Replace and delete update entries of all items.
+--
+s:replace{1, {{5, 'e'}}}
+s:replace{2, {{2, 'c'}, {6, 'f'}}}
+s:delete{4}
+idx:select()
+--
+-- An index built over existing tuples.
+--
+s:insert{4, {{7, 'g'}, {7, 'g'}, {2, 'h'}}}
+idx2 = s:create_index('idx2', {parts = {{2, 'string', path = '[*][2]'}}, unique = false})
+idx2:select()
+s:create_index('idx3', {parts = {{2, 'unsigned', path = '[*][1]'}}})
+--
+-- The index is rebuilt on recovery.
+--
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.withdata
+s.index.idx:select()
+s.index.idx2:select({'g'}, {iterator = 'LE'})
+s:drop()
@@ -0,0 +1,70 @@
+env = require('test_run')
+test_run = env.new()
+s = box.schema.space.create('withdata')
+pk = s:create_index('pk')
+--
+-- Invalid paths.
+--
+s:create_index('test1', {parts = {{2, 'string', path = 'a..b'}}})
+s:create_index('test1', {parts = {{2, 'string', path = '[1'}}})
+s:create_index('test1', {parts = {{2, 'string', path = ''}}})
+s:create_index('test1', {parts = {{2, 'string', path = 5}}})
+--
+-- The root of a path must be a map or an array and can't be
+-- indexed as a whole at the same time.
+--
+s:format({{'id', 'unsigned'}, {'data', 'string'}})
+s:create_index('test1', {parts = {{2, 'string', path = 'a'}}})
+s:format({})
+s:create_index('test1', {parts = {{2, 'string', path = 'a'}, {2, 'scalar'}}})
+--
+-- Only memtx TREE and HASH indexes support paths.
+--
+s:create_index('test1', {type = 'bitset', parts = {{2, 'unsigned', path = 'a'}}, unique = false})
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+v:create_index('pk', {parts = {{1, 'unsigned', path = 'a'}}})
+v:drop()
+--
+-- Key parts are extracted from nested fields.
+--
+idx = s:create_index('test1', {parts = {{2, 'string', path = 'a.b'}, {3, 'unsigned', path = '[2]'}}})
+idx.parts[1].path, idx.parts[2].path
+s:insert{1, {a = {b = 'x'}}, {10, 20}}
+s:insert{2, {a = {b = 'y'}}, {11, 5}}
+s:insert{3, {a = {b = 'x'}}, {12, 7}}
+s:insert{4, {a = {b = 'x'}}, {13, 7}}
+s:insert{4, {a = {c = 'x'}}, {13, 8}}
+s:insert{4, {a = {b = 4}}, {13, 8}}
+s:insert{4, {a = {b = 'x'}}, {13, -8}}
+idx:select()
+idx:get{'x', 20}
+idx:select({'x'}, {iterator = 'GT'})
+s:replace{1, {a = {b = 'z'}}, {10, 20}}
+idx:select()
+--
+-- A nullable path may be absent. The index is built over
+-- tuples created before it.
+--
+idx2 = s:create_index('test2', {parts = {{3, 'unsigned', path = '[1]'}, {2, 'string', path = 'c', is_nullable = true}}, unique = false})
+s:insert{4, {a = {b = 'w'}, c = 'q'}, {0, 1}}
+idx2:select()
+idx2:select({10, box.NULL})
+s:insert{5, {a = {b = 'v'}, c = 1}, {1, 1}}
+idx2:drop()
+idx:drop()
+--
+-- An index built over existing data checks the indexed
+-- paths of every tuple.
+--
+s:replace{6, {a = {b = 5}}, {1, 1}}
+s:create_index('test3', {parts = {{2, 'string', path = 'a.b'}}})
+s:create_index('test3', {parts = {{2, 'string', path = 'a.b', is_nullable = true}}})
+s:replace{6, {a = {}}, {1, 1}}
+s:create_index('test3', {parts = {{2, 'string', path = 'a.b'}}})
+s:replace{6}
+s:create_index('test3', {parts = {{2, 'string', path = 'a.b'}}})
+s:replace{6, {a = {b = 'v'}}, {1, 1}}
+idx = s:create_index('test3', {parts = {{2, 'string', path = 'a.b'}}})
+idx:select()
+idx:drop()
+s:drop()
@@ -12,7 +12,7 @@ function x_select(cn, space_id, index_id, iterator, offset, limit, key, opts)
                             offset, limit, key)
     return ret
 end
-function x_fatal(cn) cn._transport.perform_request(nil, nil, 'inject', nil, nil, '\x80') end
+function x_fatal(cn) cn._transport.perform_request(nil, nil, 'inject', nil, nil, nil, '\x80') end
 test_run:cmd("setopt delimiter ''");
 
 LISTEN = require('uri').parse(box.cfg.listen)
@@ -991,7 +991,7 @@ c.space.test:delete{1}
 --
 -- Break a connection to test reconnect_after.
 --
-_ = c._transport.perform_request(nil, nil, 'inject', nil, nil, '\x80')
+_ = c._transport.perform_request(nil, nil, 'inject', nil, nil, nil, '\x80')
 c.state
 while not c:is_connected() do fiber.sleep(0.01) end
 c:ping()
@@ -1199,7 +1199,7 @@ finalize_long()
 --
 c = net:connect(box.cfg.listen, {reconnect_after = 0.01})
 future = c:call('long_function', {1, 2, 3}, {is_async = true})
-_ = c._transport.perform_request(nil, nil, 'inject', nil, nil, '\x80')
+_ = c._transport.perform_request(nil, nil, 'inject', nil, nil, nil, '\x80')
 while not c:is_connected() do fiber.sleep(0.01) end
 finalize_long()
 future:wait_result(100)
@@ -1248,7 +1248,7 @@ c:ping()
 -- new attempts to read any data - the connection is closed
 -- already.
 --
-f = fiber.create(c._transport.perform_request, nil, nil, 'call_17', nil, nil, 'long', {}) c._transport.perform_request(nil, nil, 'inject', nil, nil, '\x80')
+f = fiber.create(c._transport.perform_request, nil, nil, 'call_17', nil, nil, nil, 'long', {}) c._transport.perform_request(nil, nil, 'inject', nil, nil, nil, '\x80')
 while f:status() ~= 'dead' do fiber.sleep(0.01) end
 c:close()
 
@@ -1258,8 +1258,32 @@ c:close()
 --
 c = net:connect(box.cfg.listen)
 data = msgpack.encode(18400000000000000000)..'aaaaaaa'
-c._transport.perform_request(nil, nil, 'inject', nil, nil, data)
+c._transport.perform_request(nil, nil, 'inject', nil, nil, nil, data)
 c:close()
 test_run:grep_log('default', 'too big packet size in the header') ~= nil
 
+--
+-- Interactive transactions in iproto streams.
+--
+s = box.schema.space.create('test_stream', {engine = 'vinyl'})
+_ = s:create_index('pk')
+c = net.connect(box.cfg.listen)
+stream = c:new_stream()
+stream:begin()
+stream.space.test_stream:replace({1})
+stream.space.test_stream:replace({2})
+-- Changes are not visible outside the stream until commit.
+s:select()
+stream.space.test_stream:select()
+stream:commit()
+s:select()
+stream:begin()
+stream.space.test_stream:delete({1})
+stream:rollback()
+s:select()
+-- Transaction control requests are not accepted out of stream.
+c._transport.perform_request(nil, nil, 'begin', nil, nil, nil)
+c:close()
+s:drop()
+
 box.schema.user.revoke('guest', 'read,write,execute', 'universe')
@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+
+--
+-- Big SELECT result sets are sent to the client right from
+-- the tuple memory, bypassing the connection output buffer.
+--
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 200 do s:replace{i, string.rep(tostring(i % 10), 1000)} end
+c = net.connect(box.cfg.listen)
+res = c.space.test:select()
+#res
+res[1][1], #res[1][2], res[200][1], res[200][2] == s:get(200)[2]
+
+-- Small and big responses are interleaved correctly.
+ch = fiber.channel(10)
+ok = true
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 10 do
+    fiber.create(function()
+        for j = 1, 10 do
+            local r = c.space.test:select({}, {limit = 100 + i * j})
+            ok = ok and #r == 100 + i * j and
+                 r[#r][2] == s:get(#r)[2]
+            ok = ok and c.space.test:get(j)[1] == j
+            ok = ok and c:ping()
+        end
+        ch:put(true)
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+for i = 1, 10 do ch:get() end
+ok
+
+-- Small result sets are copied as usual.
+c.space.test:select({3}, {limit = 1})[1][2] == s:get(3)[2]
+
+-- A connection closed while a response is in progress.
+c2 = net.connect(box.cfg.listen)
+_ = fiber.create(function() pcall(c2.space.test.select, c2.space.test) end)
+c2:close()
+
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
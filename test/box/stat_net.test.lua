@@ -21,6 +21,12 @@ box.stat.net.RECEIVED.total > 0
 -- box.stat.net.EVENTS.total > 0
 -- box.stat.net.LOCKS.total > 0
 
+-- latency
+latency = box.stat.latency()
+latency.SELECT.p50 > 0 and latency.SELECT.p999 >= latency.SELECT.p50
+latency.tx.p99 > 0
+latency.INSERT ~= nil and latency.CALL ~= nil and latency.EVAL ~= nil
+
 -- reset
 box.stat.reset()
 box.stat.net.SENT.total
@@ -0,0 +1,39 @@
+--
+-- Tree index counts tuples and skips the select offset in
+-- logarithmic time using subtree sizes. Check the results
+-- against plain iteration.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 1000 do s:replace{i, i % 10} end
+
+function scan(index, key, it) local r = {} for _, t in index:pairs(key, {iterator = it}) do table.insert(r, t[1]) end return r end
+function check_count(index, key, it) local n = index:count(key, {iterator = it}) if n ~= #scan(index, key, it) then return {key, it, n} end end
+function check_offset(index, key, it, offset) local all = scan(index, key, it) local r = index:select(key, {iterator = it, offset = offset, limit = 3}) for i = 1, 3 do local t = r[i] and r[i][1] if t ~= all[offset + i] then return {key, it, offset} end end end
+iterators = {'ALL', 'EQ', 'REQ', 'GE', 'GT', 'LE', 'LT'}
+keys = {{}, {0}, {5}, {9}, {10}, {500}, {1001}}
+offsets = {0, 1, 7, 99, 100, 101, 550, 998, 999, 1000, 5000}
+function check(index) local errors = {} for _, it in ipairs(iterators) do for _, key in ipairs(keys) do table.insert(errors, check_count(index, key, it)) for _, o in ipairs(offsets) do table.insert(errors, check_offset(index, key, it, o)) end end end return errors end
+
+check(s.index.pk)
+check(sk)
+
+-- Delete some tuples to make the tree rebalance.
+for i = 1, 1000, 3 do s:delete{i} end
+check(s.index.pk)
+check(sk)
+
+-- Multipart key with a partial search key.
+s2 = box.schema.space.create('test2')
+_ = s2:create_index('pk', {parts = {1, 'unsigned', 2, 'unsigned'}})
+for i = 1, 20 do for j = 1, 30 do s2:replace{i, j} end end
+s2.index.pk:count({7})
+s2.index.pk:count({7}, {iterator = 'GT'})
+s2.index.pk:count({7, 10}, {iterator = 'LE'})
+s2.index.pk:select({7}, {offset = 28})
+s2.index.pk:select({7}, {iterator = 'REQ', offset = 28})
+s2.index.pk:select({7}, {offset = 30})
+
+s:drop()
+s2:drop()
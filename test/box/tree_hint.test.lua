@@ -0,0 +1,82 @@
+--
+-- Tree index stores a comparison hint next to each tuple.
+-- Check that the order defined by hints agrees with the order
+-- defined by full tuple comparison.
+--
+function check_order(index, expected) local i = 0 for _, t in index:pairs() do i = i + 1 if t[1] ~= expected[i] then return false end end return i == #expected end
+function fill(space, vals) for i = #vals, 1, -1 do space:replace{vals[i]} end end
+
+-- unsigned
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {parts = {1, 'unsigned'}})
+vals = {0, 1, 255, 256, 65536, 4294967296, 1099511627776}
+fill(s, vals)
+check_order(s.index.pk, vals)
+s:get{256}
+s:select({256}, {iterator = 'LT'})
+s:drop()
+
+-- integer
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {parts = {1, 'integer'}})
+vals = {-4294967296, -65536, -1, 0, 1, 65536, 4294967296}
+fill(s, vals)
+check_order(s.index.pk, vals)
+s:select({-1}, {iterator = 'GE', limit = 3})
+s:drop()
+
+-- number
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {parts = {1, 'number'}})
+vals = {-100.5, -100, -1.5, -1, -0.5, 0, 0.5, 1, 1.5, 100, 100.5}
+fill(s, vals)
+check_order(s.index.pk, vals)
+s:select({0.5}, {iterator = 'LE', limit = 3})
+s:drop()
+
+-- string, including strings with a common 8-byte prefix
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {parts = {1, 'string'}})
+vals = {'', 'a', 'abcdefgh', 'abcdefgh1', 'abcdefgh2', 'abcdefgi', 'b'}
+fill(s, vals)
+check_order(s.index.pk, vals)
+s:get{'abcdefgh1'}
+s:select({'abcdefgh'}, {iterator = 'GT', limit = 2})
+s:drop()
+
+-- scalar
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {parts = {1, 'scalar'}})
+vals = {false, true, -1.5, -1, 0, 0.5, 1, 100, 'a', 'b'}
+fill(s, vals)
+check_order(s.index.pk, vals)
+s:select({true}, {iterator = 'GT', limit = 3})
+s:drop()
+
+-- nullable secondary index
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {{2, 'unsigned', is_nullable = true}}, unique = false})
+s:replace{1, 10}
+s:replace{2}
+s:replace{3, 5}
+s:replace{4, box.NULL}
+sk:select{}
+sk:select{box.NULL}
+sk:select({5}, {iterator = 'GE'})
+s:drop()
+
+-- changing the type of the first key part rebuilds the index
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}})
+s:replace{1, 3}
+s:replace{2, 1}
+s:replace{3, 2}
+sk:alter{parts = {2, 'scalar'}}
+s:replace{4, 'x'}
+s:replace{5, -1}
+s:replace{6, false}
+sk:select{}
+sk:select({1}, {iterator = 'GE'})
+s:drop()
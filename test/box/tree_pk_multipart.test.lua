@@ -194,3 +194,75 @@ test_run:cmd("setopt delimiter ''");
 space:drop()
 
 space = nil
+
+--
+-- Precompiled comparators for integer, number and scalar keys
+-- and for secondary keys extended with an unsigned primary key.
+--
+space = box.schema.space.create('test')
+pk = space:create_index('primary', { type = 'tree', parts = {1, 'unsigned'} })
+i1 = space:create_index('i1', { type = 'tree', parts = {2, 'integer'}, unique = false })
+i2 = space:create_index('i2', { type = 'tree', parts = {3, 'number'}, unique = false })
+i3 = space:create_index('i3', { type = 'tree', parts = {4, 'scalar'}, unique = false })
+i4 = space:create_index('i4', { type = 'tree', parts = {2, 'integer', 4, 'scalar'} })
+space:insert{1, -5, 1.5, 'b'}
+space:insert{2, 3, -2, 10}
+space:insert{3, -5, 1, true}
+space:insert{4, 0, 1.5, 2.5}
+i1:select()
+i1:select({-5})
+i1:select({0}, {iterator = 'GE'})
+i2:select()
+i2:select({1.5})
+i3:select()
+i3:select({2}, {iterator = 'GT'})
+i4:select()
+i4:select({-5, 'a'}, {iterator = 'GE'})
+space:drop()
+
+s = box.schema.space.create('test')
+pk = s:create_index('primary', { type = 'tree', parts = {1, 'integer', 2, 'integer'} })
+s:insert{-1, 2}
+s:insert{-1, -2}
+s:insert{1, 0}
+s:insert{-10, 5}
+pk:select()
+pk:select({-1})
+pk:select({-1, 0}, {iterator = 'LT'})
+s:drop()
+
+--
+-- Precompiled comparators for nullable and collated keys.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('primary', { type = 'tree', parts = {1, 'unsigned'} })
+i1 = s:create_index('i1', { type = 'tree', parts = {{2, 'unsigned', is_nullable = true}} })
+s:insert{1, box.NULL}
+s:insert{2, 5}
+s:insert{3, box.NULL}
+s:insert{4, 3}
+s:insert{5, 3}
+i1:select()
+i1:select({box.NULL})
+i1:select({3}, {iterator = 'GT'})
+s:drop()
+s = box.schema.space.create('test')
+pk = s:create_index('primary', { type = 'tree', parts = {1, 'unsigned'} })
+i1 = s:create_index('i1', { type = 'tree', parts = {{2, 'string', collation = 'unicode_ci', is_nullable = true}}, unique = false })
+s:insert{1, 'b'}
+s:insert{2, 'A'}
+s:insert{3, box.NULL}
+s:insert{4, 'a'}
+s:insert{5, 'C'}
+i1:select()
+i1:select({'a'})
+i1:select({'b'}, {iterator = 'LT'})
+s:drop()
+s = box.schema.space.create('test')
+pk = s:create_index('primary', { type = 'tree', parts = {{1, 'string', collation = 'unicode_ci'}} })
+s:insert{'a'}
+s:insert{'B'}
+s:insert{'A'}
+pk:select()
+pk:get{'b'}
+s:drop()
@@ -0,0 +1,73 @@
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server tx_man with script='box/tx_man.lua'")
+test_run:cmd("start server tx_man")
+test_run:cmd("switch tx_man")
+
+txn_proxy = require('txn_proxy')
+
+s = box.schema.space.create('test')
+i1 = s:create_index('pk', {parts={1, 'uint'}})
+i2 = s:create_index('sec', {parts={2, 'uint'}})
+
+tx1 = txn_proxy.new()
+tx2 = txn_proxy.new()
+
+-- Changes are invisible to others until commit.
+tx1:begin()
+tx1('s:replace{1, 1}')
+s:select{}
+tx1('s:select{}')
+tx1:commit()
+s:select{}
+
+-- A transaction survives a yield.
+tx1:begin()
+tx1('s:replace{2, 2}')
+tx1('require("fiber").sleep(0)')
+tx1:commit()
+s:select{}
+
+-- First writer wins.
+tx1:begin()
+tx2:begin()
+tx1('s:replace{3, 3}')
+tx2('s:replace{3, 4}')
+tx1:commit()
+tx2:rollback()
+s:select{}
+
+-- A transaction that has read an overwritten tuple can't commit.
+tx1:begin()
+tx2:begin()
+tx1('s:get{1}')
+tx1('s:replace{4, 4}')
+tx2('s:replace{1, 10}')
+tx2:commit()
+tx1:commit()
+s:select{}
+
+-- Rollback restores the old versions in all indexes.
+tx1:begin()
+tx1('s:delete{2}')
+tx1('s:replace{5, 2}')
+s.index.sec:select{2}
+tx1('s.index.sec:select{2}')
+tx1:rollback()
+s.index.sec:select{2}
+s:count()
+
+-- DDL is not allowed while the space has uncommitted changes.
+tx1:begin()
+tx1('s:replace{6, 6}')
+s:create_index('third', {parts={2, 'uint'}, unique=false})
+tx1:rollback()
+s:create_index('third', {parts={2, 'uint'}, unique=false}) ~= nil
+
+tx1:close()
+tx2:close()
+s:drop()
+
+test_run:cmd("switch default")
+test_run:cmd("stop server tx_man")
+test_run:cmd("cleanup server tx_man")
@@ -0,0 +1,29 @@
+fiber = require('fiber')
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+box.cfg{wal_group_commit_delay = -1}
+box.cfg{wal_group_commit_max_rows = 0}
+
+-- A batch waits for more requests until it is full.
+box.cfg{wal_group_commit_delay = 10, wal_group_commit_max_rows = 5}
+stat = box.stat.wal()
+ch = fiber.channel(5)
+for i = 1, 5 do fiber.create(function() s:insert{i} ch:put(true) end) fiber.sleep(0.01) end
+for i = 1, 5 do ch:get() end
+box.stat.wal().batches - stat.batches
+box.stat.wal().rows - stat.rows
+box.stat.wal().bytes > stat.bytes
+s:count()
+stat = box.stat.wal()
+stat.write_latency.p50 > 0 and stat.write_latency.p999 >= stat.write_latency.p50
+stat.queue_latency.p99 > 0
+
+-- Without the delay a single request is written at once.
+box.cfg{wal_group_commit_delay = 0, wal_group_commit_max_rows = 10000}
+stat = box.stat.wal()
+s:insert{6}
+box.stat.wal().batches - stat.batches
+
+s:drop()
@@ -0,0 +1,11 @@
+#!/usr/bin/env tarantool
+
+-- Replicate from the master and from another replica of it.
+box.cfg({
+    listen              = os.getenv("LISTEN"),
+    replication         = {os.getenv("MASTER"), arg[1]},
+    memtx_memory        = 107374182,
+    replication_connect_timeout = 0.5,
+})
+
+require('console').listen(os.getenv('ADMIN'))
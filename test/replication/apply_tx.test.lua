@@ -0,0 +1,57 @@
+test_run = require('test_run').new()
+--
+-- A transaction received from the master is applied on a replica
+-- as a whole. If it has already been applied, it is skipped as a
+-- whole.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+marker = box.schema.space.create('marker')
+_ = marker:create_index('pk')
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+replica_uri = test_run:eval('replica', 'return box.cfg.listen')[1]
+-- The second replica gets master rows both directly and via the first one.
+test_run:cmd("create server replica2 with rpl_master=default, script='replication/apply_tx.lua'")
+test_run:cmd("start server replica2 with args='" .. replica_uri .. "'")
+-- Remember the id of the local transaction applying each row.
+test_run:cmd("switch replica")
+ffi = require('ffi')
+fiber = require('fiber')
+txns = {}
+_ = box.space.test:on_replace(function() table.insert(txns, tonumber(ffi.C.box_txn_id())) end)
+test_run:cmd("switch replica2")
+ffi = require('ffi')
+fiber = require('fiber')
+txns = {}
+_ = box.space.test:on_replace(function() table.insert(txns, tonumber(ffi.C.box_txn_id())) end)
+test_run:cmd("switch default")
+box.begin() s:insert{1} s:insert{2} s:insert{3} box.commit()
+_ = s:insert{4}
+-- The first replica applies the transaction in one go.
+test_run:cmd("switch replica")
+while box.space.test:count() < 4 do fiber.sleep(0.01) end
+#txns
+txns[1] == txns[2] and txns[2] == txns[3]
+txns[3] ~= txns[4]
+-- A row written on the first replica reaches the second one
+-- only after the master rows relayed by the first replica.
+_ = box.space.marker:insert{1}
+test_run:cmd("switch replica2")
+while box.space.marker:count() < 1 do fiber.sleep(0.01) end
+-- The copy that arrived second was skipped as a whole.
+box.space.test:select()
+#txns
+txns[1] == txns[2] and txns[2] == txns[3]
+txns[3] ~= txns[4]
+box.info.replication[1].upstream.status
+box.info.replication[2].upstream.status
+test_run:cmd("switch default")
+test_run:cmd("stop server replica2")
+test_run:cmd("cleanup server replica2")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+s:drop()
+marker:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,55 @@
+test_run = require('test_run').new()
+test_run:cmd('restart server default with cleanup=1')
+fiber = require('fiber')
+fio = require('fio')
+digest = require('digest')
+errinj = box.error.injection
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+--
+-- A replica which is in sync is fed from the buffer of rows
+-- recently written to WAL.
+--
+for i = 1, 10 do s:replace{i} end
+test_run:wait_lsn('replica', 'default')
+test_run:grep_log('default', 'sending rows from memory')
+test_run:grep_log('default', 'not in memory any more') == nil
+--
+-- A replica which falls behind the buffer is fed from xlog
+-- files until it catches up.
+--
+errinj.set('ERRINJ_RELAY_TIMEOUT', 0.1)
+for i = 1, 200 do s:replace{i % 10, digest.urandom(100 * 1024)} end
+while test_run:grep_log('default', 'not in memory any more') == nil do fiber.sleep(0.01) end
+errinj.set('ERRINJ_RELAY_TIMEOUT', 0)
+test_run:wait_lsn('replica', 'default')
+-- The relay switches back to the buffer on the next WAL write.
+_ = s:replace{0}
+test_run:wait_lsn('replica', 'default')
+tonumber(test_run:grep_log('default', 'sending rows from memory at lsn (%d+)')) == box.info.lsn - 1
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get(0)
+test_run:cmd("switch default")
+--
+-- Xlogs are collected while the relay sends rows from memory
+-- without reading them.
+--
+box.cfg{checkpoint_count = 1}
+function xlog_count() return #fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog')) end
+for i = 1, 3 do s:replace{i} box.snapshot() end
+_ = s:replace{4}
+test_run:wait_lsn('replica', 'default')
+while xlog_count() > 1 do fiber.sleep(0.01) end
+xlog_count()
+test_run:cmd("switch replica")
+box.space.test:get(4)
+test_run:cmd("switch default")
+box.cfg{checkpoint_count = 2}
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
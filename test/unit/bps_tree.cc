@@ -70,6 +70,27 @@ compare(type_t a, type_t b);
 #define bps_tree_key_t uint32_t
 #define bps_tree_arg_t int
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
+/* tree with subtree cardinalities for positional access test */
+#define BPS_TREE_NAME card
+#define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
+#define BPS_TREE_EXTENT_SIZE 2048 /* value is to low specially for tests */
+#define BPS_TREE_COMPARE(a, b, arg) compare(a, b)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare(a, b)
+#define bps_tree_elem_t type_t
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#define BPS_INNER_CARD
+#include "salad/bps_tree.h"
+#undef BPS_INNER_CARD
 
 #define bps_insert_and_check(tree_name, tree, elem, replaced) \
 {\
@@ -792,6 +813,104 @@ insert_get_iterator()
 	footer();
 }
 
+static void
+positional_access()
+{
+	header();
+	srand(0);
+
+	card tree;
+	card_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+
+	if (card_debug_check_internal_functions(false))
+		fail("internal functions check failed", "true");
+
+	const type_t range = 3000;
+	const int rounds = 30000;
+	const int check_period = 1000;
+	bool present[range];
+	for (type_t i = 0; i < range; i++)
+		present[i] = false;
+	size_t size = 0;
+	int err_count = 0;
+
+	for (int r = 1; r <= rounds; r++) {
+		type_t v = rand() % range;
+		/* Grow the tree during the first half, shrink later. */
+		bool ins = rand() % 100 < (r <= rounds / 2 ? 70 : 30);
+		if (ins && !present[v]) {
+			if (card_insert(&tree, v, NULL) != 0)
+				fail("insert failed", "true");
+			present[v] = true;
+			size++;
+		} else if (!ins && present[v]) {
+			if (card_delete(&tree, v) != 0)
+				fail("delete failed", "true");
+			present[v] = false;
+			size--;
+		}
+		if (r % check_period != 0)
+			continue;
+		if (card_debug_check(&tree))
+			fail("debug check nonzero", "true");
+		if (card_size(&tree) != size)
+			fail("size mismatch", "true");
+		size_t offset = 0;
+		for (type_t k = 0; k < range; k++) {
+			size_t lower, upper;
+			struct card_iterator itr;
+			itr = card_lower_bound_get_offset(&tree, k, NULL,
+							  &lower);
+			itr = card_upper_bound_get_offset(&tree, k, NULL,
+							  &upper);
+			(void)itr;
+			if (lower != offset)
+				err_count++;
+			if (!present[k])
+				goto next;
+			if (upper != offset + 1)
+				err_count++;
+			itr = card_iterator_at(&tree, offset);
+			if (card_iterator_is_invalid(&itr) ||
+			    *card_iterator_get_elem(&tree, &itr) != k)
+				err_count++;
+			offset++;
+			continue;
+next:
+			if (upper != offset)
+				err_count++;
+		}
+		struct card_iterator itr = card_iterator_at(&tree, size);
+		if (!card_iterator_is_invalid(&itr))
+			err_count++;
+	}
+	printf("Error count: %d\n", err_count);
+
+	card_destroy(&tree);
+
+	type_t arr[range];
+	for (type_t i = 0; i < range; i++)
+		arr[i] = i;
+	for (type_t i = 0; i <= range; i += 37) {
+		card_create(&tree, 0, extent_alloc, extent_free,
+			    &extents_count);
+		if (card_build(&tree, arr, i))
+			fail("building failed", "true");
+		if (card_debug_check(&tree))
+			fail("debug check nonzero", "true");
+		for (type_t j = 0; j < i; j++) {
+			struct card_iterator itr = card_iterator_at(&tree, j);
+			type_t *v = card_iterator_get_elem(&tree, &itr);
+			if (v == NULL || *v != j)
+				fail("wrong positional access after build",
+				     "true");
+		}
+		card_destroy(&tree);
+	}
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -806,4 +925,7 @@ main(void)
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 	insert_get_iterator();
+	positional_access();
+	if (extents_count != 0)
+		fail("memory leak!", "true");
 }
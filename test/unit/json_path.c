@@ -26,7 +26,7 @@ void
 test_basic()
 {
 	header();
-	plan(71);
+	plan(77);
 	const char *path;
 	int len;
 	struct json_path_parser parser;
@@ -75,6 +75,12 @@ test_basic()
 	is_next_key("привет中国world");
 	is_next_key("中国a");
 
+	/* Any array item. */
+	reset_to_new_path("[*].a");
+	is(json_path_next(&parser, &node), 0, "parse <[*]>");
+	is(node.type, JSON_PATH_ANY, "<[*]> is any");
+	is_next_key("a");
+
 	check_plan();
 	footer();
 }
@@ -94,7 +100,7 @@ void
 test_errors()
 {
 	header();
-	plan(20);
+	plan(22);
 	const char *path;
 	int len;
 	struct json_path_parser parser;
@@ -126,6 +132,9 @@ test_errors()
 		{".[123]", 2},
 		/* Misc. */
 		{"[.]", 2},
+		/* Unfinished [*]. */
+		{"[*", 3},
+		{"[**]", 3},
 		/* Invalid UNICODE */
 		{"['aaa\xc2\xc2']", 6},
 		{".\xc2\xc2", 2},
@@ -159,14 +168,60 @@ test_errors()
 	footer();
 }
 
+void
+test_cmp()
+{
+	header();
+	plan(11);
+	const char *a = "a.b[1]";
+	int a_len = strlen(a);
+	const struct {
+		const char *path;
+		int rc;
+	} cases[] = {
+		{"a.b[1]", 0},
+		{".a.b[1]", 0},
+		{"['a'][\"b\"][1]", 0},
+		{"a.b[2]", -1},
+		{"a.b", 1},
+		{"a.b[1].c", -1},
+		{"a.ba[1]", -1},
+		{"[1].b[1]", 1},
+	};
+	for (size_t i = 0; i < lengthof(cases); ++i) {
+		const char *b = cases[i].path;
+		int rc = json_path_cmp(a, a_len, b, strlen(b));
+		rc = rc < 0 ? -1 : rc > 0;
+		is(rc, cases[i].rc, "<%s> vs <%s>: %d", a, b, cases[i].rc);
+	}
+	ok(json_path_validate("a.b[1]", strlen("a.b[1]")) == 0 &&
+	   json_path_validate("a.[1]", strlen("a.[1]")) == 3 &&
+	   json_path_validate("", 0) == 1, "validate");
+	uint32_t hash = json_path_hash(a, a_len);
+	const char *b = "['a'][\"b\"][1]";
+	ok(json_path_hash(".a.b[1]", strlen(".a.b[1]")) == hash &&
+	   json_path_hash(b, strlen(b)) == hash &&
+	   json_path_hash("a.b[2]", strlen("a.b[2]")) != hash, "hash");
+	b = "['a'][*].b";
+	ok(json_path_multikey_offset(b, strlen(b)) == 5 &&
+	   json_path_multikey_offset(a, a_len) == -1 &&
+	   json_path_cmp("a[*].b", strlen("a[*].b"), b, strlen(b)) == 0 &&
+	   json_path_cmp("a[*].b", strlen("a[*].b"), "a[0].b",
+			 strlen("a[0].b")) != 0, "multikey");
+
+	check_plan();
+	footer();
+}
+
 int
 main()
 {
 	header();
-	plan(2);
+	plan(3);
 
 	test_basic();
 	test_errors();
+	test_cmp();
 
 	int rc = check_plan();
 	footer();
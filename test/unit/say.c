@@ -9,6 +9,17 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 
+enum { ASYNC_COUNT = 100, ASYNC_THREADS = 4 };
+
+static void *
+async_writer_f(void *arg)
+{
+	(void) arg;
+	for (int i = 0; i < ASYNC_COUNT; i++)
+		say_info("async record %d", i);
+	return NULL;
+}
+
 int
 parse_logger_type(const char *input)
 {
@@ -162,7 +173,7 @@ int main()
 	fiber_init(fiber_c_invoke);
 	say_logger_init("/dev/null", S_INFO, 0, "plain", 0);
 
-	plan(33);
+	plan(35);
 
 #define PARSE_LOGGER_TYPE(input, rc) \
 	ok(parse_logger_type(input) == rc, "%s", input)
@@ -263,6 +274,32 @@ int main()
 		ok(strstr(line, "<131>") != NULL, "syslog line");
 	}
 	log_destroy(&test_log);
+	fclose(fd);
+
+	/* Records written by the logger thread. */
+	say_logger_free();
+	sprintf(tmp_filename, "%s/async.log", tmp_dir);
+	say_logger_init(tmp_filename, S_INFO, 0, "plain", 0);
+	ok(say_logger_start_async() == 0, "start logger thread");
+	/* Records are pushed from several threads at once. */
+	pthread_t writers[ASYNC_THREADS];
+	for (int i = 0; i < ASYNC_THREADS; i++)
+		pthread_create(&writers[i], NULL, async_writer_f, NULL);
+	async_writer_f(NULL);
+	for (int i = 0; i < ASYNC_THREADS; i++)
+		pthread_join(writers[i], NULL);
+	/* Waits for the logger thread to write all records. */
+	say_logger_free();
+	int written = 0;
+	fd = fopen(tmp_filename, "r");
+	while (fd != NULL && fgets(line, len, fd) != NULL) {
+		if (strstr(line, "async record") != NULL)
+			written++;
+	}
+	if (fd != NULL)
+		fclose(fd);
+	ok(written + (int) say_logger_dropped() ==
+	   ASYNC_COUNT * (ASYNC_THREADS + 1), "async records");
 	fiber_free();
 	memory_free();
 	return check_plan();
@@ -0,0 +1,81 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Check that REPLACE and DELETE in a space with deferred DELETEs
+-- don't look up old tuples and stale statements left in secondary
+-- indexes are skipped on read and purged by compaction.
+--
+s = box.schema.space.create('test', {engine = 'vinyl', defer_deletes = true})
+pk = s:create_index('pk', {run_count_per_level = 10})
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false, run_count_per_level = 10})
+for i = 1, 10 do s:replace{i, i} end
+box.snapshot()
+
+lookup = pk:stat().lookup
+for i = 1, 10, 2 do s:delete{i} end
+for i = 2, 10, 2 do s:replace{i, i * 10} end
+pk:stat().lookup - lookup -- 0
+
+pk:select()
+sk:select()
+sk:select({4})
+sk:select({40})
+sk:stat().rows -- 15
+
+-- Deferred DELETEs are generated by primary index compaction.
+box.snapshot()
+pk:compact()
+while pk:stat().run_count > 1 do fiber.sleep(0.01) end
+sk:stat().memory.rows -- 10
+sk:select()
+
+box.snapshot()
+sk:compact()
+while sk:stat().run_count > 1 do fiber.sleep(0.01) end
+sk:stat().rows -- 5
+sk:select()
+
+-- The old tuple is still looked up if it is needed by a trigger.
+old_tuple = nil
+_ = s:on_replace(function(old, new) old_tuple = old end)
+s:replace{2, 200}
+old_tuple
+s:on_replace(nil, s:on_replace()[1])
+
+-- The flag can't be changed.
+box.space._space:update(s.id, {{'=', 6, {group_id = 0}}})
+
+s:drop()
+
+--
+-- Deferred DELETEs are not written to WAL so they are lost on
+-- restart unless dumped. Check that major compaction of a
+-- secondary index drops statements left stale in this case.
+--
+s = box.schema.space.create('test', {engine = 'vinyl', defer_deletes = true})
+pk = s:create_index('pk', {run_count_per_level = 10})
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false, run_count_per_level = 10})
+for i = 1, 10 do s:replace{i, i} end
+box.snapshot()
+for i = 1, 10, 2 do s:delete{i} end
+for i = 2, 10, 2 do s:replace{i, i * 10} end
+box.snapshot()
+pk:compact()
+while pk:stat().run_count > 1 do fiber.sleep(0.01) end
+sk:stat().memory.rows -- 10
+
+test_run:cmd('restart server default')
+fiber = require('fiber')
+s = box.space.test
+sk = s.index.sk
+sk:stat().memory.rows -- 0
+sk:stat().rows -- 15
+sk:select()
+
+sk:compact()
+while sk:stat().run_count > 1 do fiber.sleep(0.01) end
+sk:stat().rows -- 5
+sk:select()
+
+s:drop()
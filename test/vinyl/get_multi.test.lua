@@ -0,0 +1,67 @@
+test_run = require('test_run').new()
+--
+-- Batched multi-key point lookups.
+--
+-- Disable the tuple cache so that all lookups go to disk.
+tuple_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024})
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, page_size = 1024})
+pad = string.rep('x', 100)
+for i = 1, 1000 do s:replace{i, i * 10, pad} end
+box.snapshot()
+-- Keys stored in memory shadow keys stored on disk.
+s:replace{1001, 10010, pad}
+s:delete{500}
+s:update({700}, {{'=', 3, 'y'}})
+function key(t) return t ~= nil and t[1] or 'nil' end
+function keys(r, n) local k = {} for i = 1, n do k[i] = key(r[i]) end return k end
+r = s:get_multi({1, 500, 700, 1001, 2000, 999})
+keys(r, 6)
+r[3][3]
+-- Keys can be passed as tables, too.
+keys(s.index.pk:get_multi({{2}, {3}}), 2)
+s:get_multi({})
+-- Each page is read only once.
+read_pages = s.index.pk:stat().disk.iterator.read.pages
+keys(s:get_multi({10, 10, 10}), 3)
+s.index.pk:stat().disk.iterator.read.pages - read_pages
+read_pages = s.index.pk:stat().disk.iterator.read.pages
+keys(s:get_multi({1, 1000}), 2)
+s.index.pk:stat().disk.iterator.read.pages - read_pages
+-- Secondary index lookups.
+keys(s.index.sk:get_multi({10, 5000, 7000, 10010, 1}), 5)
+-- Secondary index keys are looked up in a batch, too.
+read_pages = s.index.sk:stat().disk.iterator.read.pages
+keys(s.index.sk:get_multi({20, 5010, 9990}), 3)
+s.index.sk:stat().disk.iterator.read.pages - read_pages
+read_pages = s.index.sk:stat().disk.iterator.read.pages
+keys(s.index.sk:get_multi({20, 20, 20}), 3)
+s.index.sk:stat().disk.iterator.read.pages - read_pages
+-- Errors.
+s:get_multi(1)
+s:get_multi({{1, 2}})
+s.index.pk:get_multi({'a'})
+s:drop()
+-- Transactions see their own changes.
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+box.begin()
+s:delete{1}
+s:replace{11}
+keys(s:get_multi({1, 2, 11}), 3)
+box.rollback()
+keys(s:get_multi({1, 2, 11}), 3)
+s:drop()
+-- Memtx falls back on a loop over get().
+s = box.schema.space.create('test', {engine = 'memtx'})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 10 do s:replace{i, i % 2} end
+keys(s:get_multi({1, 20, 10}), 3)
+s.index.sk:get_multi({1})
+s:drop()
+box.cfg{vinyl_cache = tuple_cache}
@@ -77,13 +77,17 @@ end;
 
 -- Return global statistics.
 --
--- Note, quota watermark checking is beyond the scope of this
--- test so we just filter out related statistics.
+-- Note, quota watermark and throttling checking is beyond the
+-- scope of this test so we just filter out related statistics.
+-- The page cache is checked by page_cache.test.lua.
 function gstat()
     local st = box.stat.vinyl()
     st.quota.use_rate = nil
     st.quota.dump_bandwidth = nil
     st.quota.watermark = nil
+    st.quota.throttle_count = nil
+    st.quota.throttle_time = nil
+    st.page_cache = nil
     return st
 end;
 
@@ -0,0 +1,40 @@
+test_run = require('test_run').new()
+--
+-- Shared cache of decompressed run pages.
+--
+-- Disable the tuple cache so that all lookups go to disk.
+tuple_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+-- The page cache is disabled by default.
+box.cfg.vinyl_page_cache
+st = box.stat.vinyl().page_cache
+st.limit, st.used, st.pages
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024})
+pad = string.rep('x', 100)
+for i = 1, 100 do s:replace{i, pad} end
+box.snapshot()
+-- Nothing is cached while the cache is disabled.
+s:get{1}[1]
+st2 = box.stat.vinyl().page_cache
+st2.hit - st.hit, st2.miss - st.miss, st2.pages
+box.cfg{vinyl_page_cache = 1024 * 1024}
+box.stat.vinyl().page_cache.limit
+-- The first lookup reads the page from disk.
+st = box.stat.vinyl().page_cache
+s:get{1}[1]
+st2 = box.stat.vinyl().page_cache
+st2.hit - st.hit, st2.miss - st.miss, st2.pages
+st2.used > 0
+-- Lookups of other keys stored in the same page hit the cache.
+s:get{2}[1]
+s:get{3}[1]
+st3 = box.stat.vinyl().page_cache
+st3.hit - st2.hit, st3.miss - st2.miss, st3.pages
+s.index.pk:stat().disk.iterator.read.pages
+-- Pages that don't fit in the cache are evicted.
+box.cfg{vinyl_page_cache = 0}
+st = box.stat.vinyl().page_cache
+st.used, st.pages
+s:drop()
+box.cfg{vinyl_cache = tuple_cache}
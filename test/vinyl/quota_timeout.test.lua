@@ -98,6 +98,26 @@ _ = s2:auto_increment{pad}
 while s1.index.pk:stat().disk.dump.count == 0 do fiber.sleep(0.01) end
 s1.index.pk:stat().memory.bytes == 0
 
+--
+-- Check that transactions are throttled once memory
+-- consumption exceeds the watermark.
+--
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_TIMEOUT', 0.1)
+pad = string.rep('x', 1024)
+test_run:cmd("setopt delimiter ';'")
+repeat
+    _ = s1:auto_increment{pad}
+    q = box.stat.vinyl().quota
+until q.used >= q.watermark;
+test_run:cmd("setopt delimiter ''");
+throttle_count = q.throttle_count
+c = fiber.channel(10)
+for i = 1, 10 do fiber.create(function() c:put((pcall(s1.replace, s1, {100000 + i, pad}))) end) end
+for i = 1, 10 do assert(c:get()) end
+box.stat.vinyl().quota.throttle_count > throttle_count
+box.stat.vinyl().quota.throttle_time > 0
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_TIMEOUT', 0)
+
 test_run:cmd('switch default')
 test_run:cmd("stop server test")
 test_run:cmd("cleanup server test")
@@ -0,0 +1,31 @@
+test_run = require('test_run').new()
+--
+-- Read-ahead for range scans.
+--
+-- Disable the tuple cache so that all reads go to disk.
+tuple_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024})
+pad = string.rep('x', 100)
+for i = 1, 1000 do s:replace{i, pad} end
+box.snapshot()
+pages = s.index.pk:stat().disk.pages
+pages > 10
+-- Every page is read once, whatever the direction.
+read_pages = s.index.pk:stat().disk.iterator.read.pages
+#s:select({}, {iterator = 'GE'})
+s.index.pk:stat().disk.iterator.read.pages - read_pages == pages
+read_pages = s.index.pk:stat().disk.iterator.read.pages
+#s:select({}, {iterator = 'LE'})
+s.index.pk:stat().disk.iterator.read.pages - read_pages == pages
+-- Pages are returned in order.
+function key(t) return t[1] end
+s:pairs({500}, {iterator = 'GT'}):take(3):map(key):totable()
+s:pairs({500}, {iterator = 'LT'}):take(3):map(key):totable()
+-- Pending reads are dropped if a scan stops early.
+for _, t in s:pairs() do if t[1] == 100 then break end end
+collectgarbage('collect')
+s:count()
+s:drop()
+box.cfg{vinyl_cache = tuple_cache}
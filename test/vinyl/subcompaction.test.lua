@@ -0,0 +1,62 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+digest = require('digest')
+
+box.cfg{vinyl_max_subcompactions = 0}
+box.cfg.vinyl_max_subcompactions
+
+--
+-- Major compaction of a large range is split between worker
+-- threads, each of which writes its own run and range.
+--
+box.cfg{vinyl_max_subcompactions = 2}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 100, page_size = 128, range_size = 1024})
+
+test_run:cmd("setopt delimiter ';'")
+function dump()
+    for i = 1, 10 do
+        s:replace{i, digest.urandom(1000)}
+    end
+    box.snapshot()
+end;
+function info()
+    local info = s.index.pk:stat()
+    return {range_count = info.range_count, run_count = info.run_count}
+end
+function compact()
+    s.index.pk:compact()
+    repeat
+        fiber.sleep(0.001)
+        local info = s.index.pk:stat()
+    until info.range_count == info.run_count
+end;
+test_run:cmd("setopt delimiter ''");
+
+dump()
+dump()
+dump()
+info() -- 1 range, 3 runs
+
+compact()
+info() -- 2 ranges, 2 runs
+s.index.pk:stat().disk.compact.count -- 1
+
+#s:select() -- 10
+s:get(5) ~= nil
+s:get(6) ~= nil
+
+-- Subcompaction is disabled by default.
+box.cfg{vinyl_max_subcompactions = 1}
+
+dump()
+dump()
+info() -- 2 ranges, 4 runs
+
+compact()
+info() -- 4 ranges, 4 runs
+
+#s:select() -- 10
+
+s:drop()
@@ -3,9 +3,18 @@ digest = require('digest')
 
 _ = box.schema.space.create('big_tx'):create_index('pk')
 t = box.space.big_tx:insert({1, digest.urandom(512 * 1024)})
+
+-- Many big transactions written to WAL in one batch.
+fiber = require('fiber')
+ch = fiber.channel(20)
+for i = 2, 21 do fiber.create(function() box.space.big_tx:insert({i, string.rep(tostring(i), 128 * 1024)}) ch:put(true) end) end
+for i = 2, 21 do ch:get() end
 env:cmd('restart server default')
 
 #box.space.big_tx:select()
+ok = true
+for i = 2, 21 do ok = ok and box.space.big_tx:get(i)[2] == string.rep(tostring(i), 128 * 1024) end
+ok
 
 box.space.big_tx:drop()
 
@@ -28,6 +28,23 @@ row.HEADER.sync
 row.BODY
 box.space._schema:delete('test')
 
+--
+-- Check that rows of a multi-statement transaction carry
+-- the transaction id and the commit flag.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.begin() s:insert{1} s:insert{2} s:insert{3} box.commit()
+_ = s:insert{4}
+box.snapshot()
+rows = {}
+for _, path in ipairs(fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))) do for _, row in xlog.pairs(path) do if row.BODY and row.BODY.space_id == s.id then table.insert(rows, row.HEADER) end end end
+tsn = rows[1].lsn
+result = {}
+for _, h in ipairs(rows) do table.insert(result, {h.lsn - tsn, h.tsn and h.tsn - tsn, h.commit}) end
+result
+s:drop()
+
 --
 -- Clean up
 --
@@ -0,0 +1,42 @@
+test_run = require('test_run').new()
+--
+-- WAL files are zero-filled up to wal_max_size and the unused
+-- tail is released when a file is closed.
+--
+test_run:cmd("create server prealloc with script='xlog/preallocate.lua'")
+test_run:cmd("start server prealloc")
+test_run:cmd("switch prealloc")
+fio = require('fio')
+function xlogs() return fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog')) end
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+-- The current WAL is as large as wal_max_size.
+path = xlogs()[#xlogs()]
+fio.stat(path).size == box.cfg.wal_max_size
+-- The tail is released when the WAL is closed by a checkpoint.
+box.snapshot()
+fio.stat(path).size < box.cfg.wal_max_size
+-- The same happens when the WAL is rotated because of its size.
+count = #xlogs()
+digest = require('digest')
+for i = 1, 15 do s:replace{i, digest.urandom(100 * 1024)} end
+#xlogs() == count + 2
+path = xlogs()[#xlogs() - 1]
+fio.stat(path).size > box.cfg.wal_max_size
+path = xlogs()[#xlogs()]
+fio.stat(path).size == box.cfg.wal_max_size
+--
+-- Recovery stops at the zeros of the last WAL.
+--
+test_run:cmd("switch default")
+test_run:cmd("stop server prealloc")
+test_run:cmd("start server prealloc")
+test_run:cmd("switch prealloc")
+s = box.space.test
+s:len()
+#s:get{15}[2]
+s:replace{16}
+test_run:cmd("switch default")
+test_run:cmd("stop server prealloc")
+test_run:cmd("cleanup server prealloc")
@@ -219,9 +219,19 @@ loop:SWAPINIT(a, es);
  * open MP.
  */
 void qsort_arg_mt(void *a, size_t n, size_t es,
-		  int (*cmp)(const void *, const void *, void *), void *arg);
+		  int (*cmp)(const void *, const void *, void *), void *arg,
+		  int thread_count);
 #endif
 
+/** Max number of threads used by qsort_arg(), 0 for default. */
+static int qsort_arg_thread_count = 0;
+
+void
+qsort_arg_set_thread_count(int count)
+{
+	qsort_arg_thread_count = count;
+}
+
 /**
  * General version of qsort that calls single-threaded of multi-threaded
  * qsort depending on open MP availability and given array size.
@@ -231,8 +241,8 @@ qsort_arg(void *a, size_t n, size_t es,
 	  int (*cmp)(const void *a, const void *b, void *arg), void *arg)
 {
 #ifdef HAVE_OPENMP
-	if (n >= MULTITHREAD_SIZE_THRESHOLD)
-		qsort_arg_mt(a, n, es, cmp, arg);
+	if (n >= MULTITHREAD_SIZE_THRESHOLD && qsort_arg_thread_count != 1)
+		qsort_arg_mt(a, n, es, cmp, arg, qsort_arg_thread_count);
 	else
 		qsort_arg_st(a, n, es, cmp, arg);
 #else
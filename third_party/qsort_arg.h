@@ -15,6 +15,14 @@ extern "C" {
 void qsort_arg(void *a, size_t n, size_t es,
 	       int (*cmp)(const void *a, const void *b, void *arg), void *arg);
 
+/**
+ * Set the number of threads qsort_arg() may use to sort a large
+ * array. 0 means the OpenMP default (the number of CPU cores),
+ * 1 disables multi-threaded sorting. Has no effect if open MP
+ * is not available.
+ */
+void qsort_arg_set_thread_count(int count);
+
 #if defined(__cplusplus)
 }
 #endif /* defined(__cplusplus) */
@@ -49,6 +49,7 @@
 
 #include <third_party/qsort_arg.h>
 #include <stdint.h>
+#include <omp.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -223,9 +224,12 @@ qsort_arg_mt_internal(void *a, size_t n, intptr_t es,
 
 void
 qsort_arg_mt(void *a, size_t n, size_t es,
-	     int (*cmp)(const void *a, const void *b, void *arg), void *arg)
+	     int (*cmp)(const void *a, const void *b, void *arg), void *arg,
+	     int thread_count)
 {
-#pragma omp parallel
+	if (thread_count <= 0)
+		thread_count = omp_get_max_threads();
+#pragma omp parallel num_threads(thread_count)
 	{
 #pragma omp single
 		qsort_arg_mt_internal(a, n, es, cmp, arg);